@@ -822,6 +822,26 @@ None
 """
 
 
+%feature("docstring") Program::write_binary_ir
+""" Writes the kernels of the program, as they are now, to a binary IR file, which read_binary_ir and the BinaryReader pass can load again.
+
+Parameters
+----------
+arg1 : str
+    path of the binary IR file
+"""
+
+
+%feature("docstring") Program::read_binary_ir
+""" Replaces the kernels of the program by those in a binary IR file, which must have been written for the same platform.
+
+Parameters
+----------
+arg1 : str
+    path of the binary IR file
+"""
+
+
 %feature("docstring") Program::qasm
 """ Generates and returns program QASM
 
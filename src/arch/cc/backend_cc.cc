@@ -25,6 +25,7 @@
 
 #include <utils/str.h>
 #include <utils/filesystem.h>
+#include <utils/ptr.h>
 #include <options.h>
 #include <platform.h>
 #include <ir.h>
@@ -71,6 +72,17 @@ void Backend::compile(quantum_program *program, const quantum_platform &platform
     codegen.init(platform);
     bundleIdx = 0;
 
+    // stream program to file while it is generated
+    Str file_name(options::get("output_dir") + "/" + program->unique_name + ".vq1asm");
+    QL_IOUT("Writing Central Controller program to " << file_name);
+    // NB: the sink shares ownership of the file, so it remains valid if code generation throws
+    Ptr<OutFile> outFile;
+    outFile.emplace(file_name);
+    codegen.setOutput([outFile](const char *data, UInt size) mutable {
+        outFile->unwrap().write(data, size);
+        outFile->check();
+    });
+
     // generate program header
     codegen.programStart(program->unique_name);
 
@@ -89,7 +101,7 @@ void Backend::compile(quantum_program *program, const quantum_platform &platform
 
         circuit &circuit = kernel.c;
         if (!circuit.empty()) {
-            ir::bundles_t bundles = ir::bundler(circuit, platform.cycle_time);
+            const ir::bundles_t &bundles = kernel.get_bundles();
             codegen.kernelStart();
             codegenBundles(bundles, platform);
             codegen.kernelFinish(kernel.name, bundles.back().start_cycle+bundles.back().duration_in_cycles);
@@ -101,11 +113,7 @@ void Backend::compile(quantum_program *program, const quantum_platform &platform
     }
 
     codegen.programFinish(program->unique_name);
-
-    // write program to file
-    Str file_name(options::get("output_dir") + "/" + program->unique_name + ".vq1asm");
-    QL_IOUT("Writing Central Controller program to " << file_name);
-    OutFile(file_name).write(codegen.getProgram());
+    outFile->close();
 
     // write instrument map to file (unless we were using input file)
     Str map_input_file = options::get("backend_cc_map_input_file");
@@ -243,7 +251,7 @@ void Backend::codegenKernelEpilogue(quantum_kernel &k) {
 
 
 // based on cc_light_eqasm_compiler.h::bundles2qisa()
-void Backend::codegenBundles(ir::bundles_t &bundles, const quantum_platform &platform) {
+void Backend::codegenBundles(const ir::bundles_t &bundles, const quantum_platform &platform) {
     QL_IOUT("Generating .vq1asm for bundles");
 
     for (const auto &bundle : bundles) {
@@ -258,13 +266,13 @@ void Backend::codegenBundles(ir::bundles_t &bundles, const quantum_platform &pla
         // and if a non-zero duration is specified that duration is reflected in 'start_cycle' of the subsequent instruction
 
         // generate code for this bundle
-        for (auto section = bundle.parallel_sections.begin(); section != bundle.parallel_sections.end(); ++section ) {
+        for (auto section : bundles.sections(bundle)) {
             // check whether section defines classical gate
-            gate *firstInstr = *section->begin();
+            gate *firstInstr = section.front();
             auto firstInstrType = firstInstr->type();
             if (firstInstrType == __classical_gate__) {
                 QL_DOUT(QL_SS2S("Classical bundle: instr='" << firstInstr->name << "'"));
-                if (section->size() != 1) {
+                if (section.size() != 1) {
                     QL_FATAL("Inconsistency detected in bundle contents: classical gate with parallel sections");
                 }
                 codegenClassicalInstruction(firstInstr);
@@ -273,7 +281,7 @@ void Backend::codegenBundles(ir::bundles_t &bundles, const quantum_platform &pla
                  * NB: our strategy differs from cc_light_eqasm_compiler, we have no special treatment of first instruction
                  * and don't require all instructions to be identical
                  */
-                for (auto instr : *section) {
+                for (auto instr : section) {
                     gate_type_t itype = instr->type();
                     Str iname = instr->name;
                     QL_DOUT(QL_SS2S("Bundle section: instr='" << iname << "'"));
@@ -291,7 +299,7 @@ void Backend::codegenBundles(ir::bundles_t &bundles, const quantum_platform &pla
                             QL_DOUT(QL_SS2S("Custom gate: instr='" << iname << "'" << ", duration=" << instr->duration) << " ns");
                             codegen.customGate(
                                 iname,
-                                instr->operands,            // qubit operands (FKA qops)
+                                instr->operands.to_vec(),   // qubit operands (FKA qops)
                                 instr->creg_operands,        // classic operands (FKA cops)
                                 instr->breg_operands,         // bit operands e.g. assigned to by measure
                                 instr->condition,
@@ -351,7 +359,7 @@ void Backend::loadHwSettings(const quantum_platform &platform) {
     UInt i = 0;
     try {
         for (i = 0; i < ELEM_CNT(hw_settings); i++) {
-            UInt val = platform.hardware_settings[hw_settings[i].name].get<UInt>();
+            UInt val = (*platform.hardware_settings)[hw_settings[i].name].get<UInt>();
             *hw_settings[i].var = val;
         }
     } catch (Json::exception &e) {
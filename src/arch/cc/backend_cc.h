@@ -31,7 +31,7 @@ private:
     void codegenClassicalInstruction(gate *classical_ins);
     void codegenKernelPrologue(quantum_kernel &k);
     void codegenKernelEpilogue(quantum_kernel &k);
-    void codegenBundles(ir::bundles_t &bundles, const quantum_platform &platform);
+    void codegenBundles(const ir::bundles_t &bundles, const quantum_platform &platform);
     void loadHwSettings(const quantum_platform &platform);
 
 private: // vars
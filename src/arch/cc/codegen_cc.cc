@@ -44,7 +44,7 @@ void Codegen::init(const quantum_platform &platform) {
 #if OPT_FEEDBACK
     // iterate over instruments
     for (UInt instrIdx = 0; instrIdx < settings.getInstrumentsSize(); instrIdx++) {
-        const Settings::InstrumentControl ic = settings.getInstrumentControl(instrIdx);
+        const Settings::InstrumentControl &ic = settings.getInstrumentControl(instrIdx);
         if (QL_JSON_EXISTS(ic.controlMode, "result_bits")) {  // this instrument mode produces results (i.e. it is a measurement device)
             QL_IOUT("instrument '" << ic.ii.instrumentName << "' (index " << instrIdx << ") is used for feedback");
         }
@@ -52,12 +52,12 @@ void Codegen::init(const quantum_platform &platform) {
 #endif
 }
 
+void Codegen::setOutput(const Emitter::Sink &sink) {
+    codeSection.setSink(sink);
+}
+
 Str Codegen::getProgram() {
-#if OPT_FEEDBACK
-    return codeSection.str() + dp.getDatapathSection();
-#else
-    return codeSection.str();
-#endif
+    return codeSection.getContents();
 }
 
 Str Codegen::getMap() {
@@ -86,6 +86,10 @@ void Codegen::programFinish(const Str &progName) {
     emitProgramFinish();
 
     dp.programFinish();
+#if OPT_FEEDBACK
+    codeSection.put(dp.getDatapathSection());
+#endif
+    codeSection.setSink(nullptr);   // flushes, and releases the sink, which refers to the output file of this program
 
     vcd.programFinish(progName);
 }
@@ -128,7 +132,7 @@ void Codegen::bundleStart(const Str &cmnt) {
     bundleInfo.clear();
     BundleInfo empty;
     for (UInt instrIdx = 0; instrIdx < settings.getInstrumentsSize(); instrIdx++) {
-        const Settings::InstrumentControl ic = settings.getInstrumentControl(instrIdx);
+        const Settings::InstrumentControl &ic = settings.getInstrumentControl(instrIdx);
         bundleInfo.emplace_back(
             ic.controlModeGroupCnt,     // one BundleInfo per group in the control mode selected for instrument
             empty                       // empty BundleInfo
@@ -273,7 +277,7 @@ Codegen::CodeGenMap Codegen::collectCodeGenInfo(
     // iterate over instruments
     for (UInt instrIdx = 0; instrIdx < settings.getInstrumentsSize(); instrIdx++) {
         // get control info from instrument settings
-        const Settings::InstrumentControl ic = settings.getInstrumentControl(instrIdx);
+        const Settings::InstrumentControl &ic = settings.getInstrumentControl(instrIdx);
         if (ic.ii.slot >= MAX_SLOTS) {
             QL_JSON_FATAL(
                 "illegal slot " << ic.ii.slot
@@ -528,7 +532,7 @@ void Codegen::customGate(
     // find instruction (gate definition)
     const Json &instruction = platform->find_instruction(iname);
     // find signal vector definition for instruction
-    Settings::SignalDef sd = settings.findSignalDefinition(instruction, iname);
+    const Settings::SignalDef &sd = settings.findSignalDefinition(instruction, iname);
 
     // scatter signals defined for instruction (e.g. several operands and/or types) to instruments & groups
     for (UInt s = 0; s < sd.signal.size(); s++) {
@@ -548,7 +552,7 @@ void Codegen::customGate(
             } else {
                 showCodeSoFar();
                 QL_FATAL(
-                    "Signal conflict on instrument='" << csv.si.ic.ii.instrumentName
+                    "Signal conflict on instrument='" << csv.si.ic->ii.instrumentName
                     << "', group=" << csv.si.group
                     << ", between '" << bi.signalValue
                     << "' and '" << csv.signalValueString << "'"
@@ -700,25 +704,45 @@ void Codegen::comment(const Str &c) {
 
 void Codegen::emit(const Str &labelOrComment, const Str &instr) {
     if (labelOrComment.empty()) {                       // no label
-        codeSection << "        " << instr << std::endl;
+        codeSection.putLeft("", 0, 8);
+        codeSection.put(instr);
     } else if (labelOrComment.length() < 8) {           // label fits before instr
-        codeSection << std::setw(8) << labelOrComment << instr << std::endl;
+        codeSection.putLeft(labelOrComment, 8);
+        codeSection.put(instr);
     } else if (instr.empty()) {                         // no instr
-        codeSection << labelOrComment << std::endl;
+        codeSection.put(labelOrComment);
     } else {
-        codeSection << labelOrComment << std::endl << "        " << instr << std::endl;
+        codeSection.put(labelOrComment);
+        codeSection.newline();
+        codeSection.putLeft("", 0, 8);
+        codeSection.put(instr);
     }
+    codeSection.newline();
 }
 
 
 // @param   labelOrSel      label must include trailing ":"
 // @param   comment         must include leading "#"
 void Codegen::emit(const Str &labelOrSel, const Str &instr, const Str &ops, const Str &comment) {
-    codeSection << std::setw(16) << labelOrSel << std::setw(16) << instr << std::setw(24) << ops << comment << std::endl;
+    emitFields(labelOrSel.data(), labelOrSel.size(), instr, ops, comment);
 }
 
 void Codegen::emit(Int slot, const Str &instr, const Str &ops, const Str &comment) {
-    emit(QL_SS2S("[" << slot << "]"), instr, ops, comment);
+    // format selector "[<slot>]" without allocating
+    char sel[FORMAT_INT_SIZE+2];
+    UInt size = 0;
+    sel[size++] = '[';
+    size += formatInt(sel+size, slot);
+    sel[size++] = ']';
+    emitFields(sel, size, instr, ops, comment);
+}
+
+void Codegen::emitFields(const char *labelOrSel, UInt labelOrSelSize, const Str &instr, const Str &ops, const Str &comment) {
+    codeSection.putLeft(labelOrSel, labelOrSelSize, 16);
+    codeSection.putLeft(instr, 16);
+    codeSection.putLeft(ops, 24);
+    codeSection.put(comment);
+    codeSection.newline();
 }
 
 /************************************************************************\
@@ -726,18 +750,30 @@ void Codegen::emit(Int slot, const Str &instr, const Str &ops, const Str &commen
 \************************************************************************/
 
 void Codegen::showCodeSoFar() {
-    // provide context to help finding reason. FIXME: limit # lines
-    QL_EOUT("Code so far:\n" << codeSection.str());
+    // provide context to help finding reason. NB: the code is streamed, so we can only show the last part
+    QL_EOUT("Code so far (last part):\n" << codeSection.getTail());
+}
+
+// format "# cycle <from>-<to>: <what> on '<instrumentName>'" into commentBuf
+void Codegen::formatCycleComment(UInt fromCycle, UInt toCycle, const char *what, const Str &instrumentName) {
+    commentBuf = "# cycle ";
+    appendUInt(commentBuf, fromCycle);
+    commentBuf += "-";
+    appendUInt(commentBuf, toCycle);
+    commentBuf += ": ";
+    commentBuf += what;
+    commentBuf += " on '";
+    commentBuf += instrumentName;
+    commentBuf += "'";
 }
 
 void Codegen::emitProgramStart(const Str &progName) {
     // emit program header
-    codeSection << std::left;    // assumed by emit()
-    codeSection << "# Program: '" << progName << "'" << std::endl;   // NB: put on top so it shows up in internal CC logging
-    codeSection << "# CC_BACKEND_VERSION " << CC_BACKEND_VERSION_STRING << std::endl;
-    codeSection << "# OPENQL_VERSION " << OPENQL_VERSION_STRING << std::endl;
-    codeSection << "# Note:    generated by OpenQL Central Controller backend" << std::endl;
-    codeSection << "#" << std::endl;
+    codeSection.put("# Program: '" + progName + "'\n");   // NB: put on top so it shows up in internal CC logging
+    codeSection.put("# CC_BACKEND_VERSION " CC_BACKEND_VERSION_STRING "\n");
+    codeSection.put("# OPENQL_VERSION " OPENQL_VERSION_STRING "\n");
+    codeSection.put("# Note:    generated by OpenQL Central Controller backend\n");
+    codeSection.put("#\n");
 
 #if OPT_FEEDBACK
     emit(".CODE");   // start .CODE section
@@ -794,24 +830,26 @@ void Codegen::emitFeedback(
         // emit code for slot input
         UInt sizeTag = Datapath::getSizeTag(feedbackMap.size());        // compute DSM transfer size tag (for 'seq_in_sm' instruction)
         UInt smAddr = Datapath::getMuxSmAddr(feedbackMap);
-        emit(
-            slot,
-            "seq_in_sm",
-            QL_SS2S("S" << smAddr << ","  << mux << "," << sizeTag),
-            QL_SS2S("# cycle " << lastEndCycle[instrIdx] << "-" << lastEndCycle[instrIdx]+1 << ": feedback on '" << instrumentName+"'")
-        );
+        opsBuf = "S";
+        appendUInt(opsBuf, smAddr);
+        opsBuf += ",";
+        appendUInt(opsBuf, mux);
+        opsBuf += ",";
+        appendUInt(opsBuf, sizeTag);
+        formatCycleComment(lastEndCycle[instrIdx], lastEndCycle[instrIdx]+1, "feedback", instrumentName);
+        emit(slot, "seq_in_sm", opsBuf, commentBuf);
         lastEndCycle[instrIdx]++;
     } else {    // this instrument does not perform readout for feedback now
         // emit code for non-participating instrument
         // FIXME: may invalidate DSM that ust arrived dependent on individual SEQBAR counts
         UInt smAddr = 0;
         UInt smTotalSize = 1;    // FIXME: inexact, but me must not invalidate memory that we will not write
-        emit(
-            slot,
-            "seq_inv_sm",
-            QL_SS2S("S" << smAddr << ","  << smTotalSize),
-            QL_SS2S("# cycle " << lastEndCycle[instrIdx] << "-" << lastEndCycle[instrIdx]+1 << ": invalidate SM on '" << instrumentName+"'")
-        );
+        opsBuf = "S";
+        appendUInt(opsBuf, smAddr);
+        opsBuf += ",";
+        appendUInt(opsBuf, smTotalSize);
+        formatCycleComment(lastEndCycle[instrIdx], lastEndCycle[instrIdx]+1, "invalidate SM", instrumentName);
+        emit(slot, "seq_inv_sm", opsBuf, commentBuf);
         lastEndCycle[instrIdx]++;
     }
 }
@@ -826,36 +864,40 @@ void Codegen::emitOutput(
     Int slot,
     const Str &instrumentName
 ) {
-    comment(QL_SS2S(
-        "  # slot=" << slot
-        << ", instrument='" << instrumentName << "'"
-        << ": lastEndCycle=" << lastEndCycle[instrIdx]
-        << ", startCycle=" << startCycle
-        << ", instrMaxDurationInCycles=" << instrMaxDurationInCycles
-    ));
+    if (verboseCode) {
+        comment(QL_SS2S(
+            "  # slot=" << slot
+            << ", instrument='" << instrumentName << "'"
+            << ": lastEndCycle=" << lastEndCycle[instrIdx]
+            << ", startCycle=" << startCycle
+            << ", instrMaxDurationInCycles=" << instrMaxDurationInCycles
+        ));
+    }
 
     emitPadToCycle(instrIdx, startCycle, slot, instrumentName);
 
     // emit code for slot output
     if (condGateMap.empty()) {    // all groups unconditional
-        emit(
-            slot,
-            "seq_out",
-            QL_SS2S("0x" << std::hex << std::setfill('0') << std::setw(8) << digOut << std::dec << "," << instrMaxDurationInCycles),
-            QL_SS2S("# cycle " << startCycle << "-" << startCycle + instrMaxDurationInCycles << ": code word/mask on '" << instrumentName + "'")
-        );
+        opsBuf = "0x";
+        appendHex(opsBuf, digOut, 8);
+        opsBuf += ",";
+        appendUInt(opsBuf, instrMaxDurationInCycles);
+        formatCycleComment(startCycle, startCycle + instrMaxDurationInCycles, "code word/mask", instrumentName);
+        emit(slot, "seq_out", opsBuf, commentBuf);
     } else {    // at least one group conditional
         // configure datapath PL
         UInt pl = dp.getOrAssignPl(instrIdx, condGateMap);
         UInt smAddr = dp.emitPl(pl, condGateMap, instrIdx, slot);
 
         // emit code for conditional gate
-        emit(
-            slot,
-            "seq_out_sm",
-            QL_SS2S("S" << smAddr << "," << pl << "," << instrMaxDurationInCycles),
-            QL_SS2S("# cycle " << startCycle << "-" << startCycle + instrMaxDurationInCycles << ": conditional code word/mask on '" << instrumentName << "'")
-        );
+        opsBuf = "S";
+        appendUInt(opsBuf, smAddr);
+        opsBuf += ",";
+        appendUInt(opsBuf, pl);
+        opsBuf += ",";
+        appendUInt(opsBuf, instrMaxDurationInCycles);
+        formatCycleComment(startCycle, startCycle + instrMaxDurationInCycles, "conditional code word/mask", instrumentName);
+        emit(slot, "seq_out_sm", opsBuf, commentBuf);
     }
 
     // update lastEndCycle
@@ -921,12 +963,10 @@ void Codegen::emitPadToCycle(UInt instrIdx, UInt startCycle, Int slot, const Str
     }
 
     if (prePadding > 0) {     // we need to align
-        emit(
-            slot,
-            "seq_wait",
-            QL_SS2S(prePadding),
-            QL_SS2S("# cycle " << lastEndCycle[instrIdx] << "-" << startCycle << ": padding on '" << instrumentName+"'")
-        );
+        opsBuf.clear();
+        appendInt(opsBuf, prePadding);
+        formatCycleComment(lastEndCycle[instrIdx], startCycle, "padding", instrumentName);
+        emit(slot, "seq_wait", opsBuf, commentBuf);
     }
 
     // update lastEndCycle
@@ -964,26 +1004,24 @@ Codegen::CalcSignalValue Codegen::calcSignalValue(
     const Json instructionSignalValue = json_get<const Json>(sd.signal[s], "value", signalSPath);   // NB: json_get<const Json&> unavailable
     Str sv = QL_SS2S(instructionSignalValue);   // serialize/stream instructionSignalValue into std::string
 
-    // get instruction signal type (e.g. "mw", "flux", etc)
-    // NB: instructionSignalType is different from "instruction/type" provided by find_instruction_type, although some identical strings are used). NB: that key is no longer used by the 'core' of OpenQL
-    Str instructionSignalType = json_get<Str>(sd.signal[s], "type", signalSPath);
-
     /************************************************************************\
     | map signal type for qubit to instrument & group
     \************************************************************************/
 
-    // find signalInfo, i.e. perform the mapping
-    ret.si = settings.findSignalInfoForQubit(instructionSignalType, qubit);
+    // find signalInfo, i.e. perform the mapping. The instruction signal type (e.g. "mw", "flux", etc) was
+    // resolved to its row in the signal table when the settings were loaded
+    // NB: instructionSignalType is different from "instruction/type" provided by find_instruction_type, although some identical strings are used). NB: that key is no longer used by the 'core' of OpenQL
+    ret.si = settings.findSignalInfoForQubit(sd, s, qubit);
 
     if (instructionSignalValue.empty()) {    // allow empty signal
         ret.signalValueString = "";
     } else {
         // verify signal dimensions
-        UInt channelsPergroup = ret.si.ic.controlModeGroupSize;
+        UInt channelsPergroup = ret.si.ic->controlModeGroupSize;
         if (instructionSignalValue.size() != channelsPergroup) {
             QL_JSON_FATAL(
                 "signal dimension mismatch on instruction '" << iname
-                << "' : control mode '" << ret.si.ic.refControlMode
+                << "' : control mode '" << ret.si.ic->refControlMode
                 << "' requires " <<  channelsPergroup
                 << " signals, but signal '" << signalSPath+"/value"
                 << "' provides " << instructionSignalValue.size()
@@ -993,7 +1031,7 @@ Codegen::CalcSignalValue Codegen::calcSignalValue(
         // expand macros
         sv = replace_all(sv, "\"", "");   // get rid of quotes
         sv = replace_all(sv, "{gateName}", iname);
-        sv = replace_all(sv, "{instrumentName}", ret.si.ic.ii.instrumentName);
+        sv = replace_all(sv, "{instrumentName}", ret.si.ic->ii.instrumentName);
         sv = replace_all(sv, "{instrumentGroup}", to_string(ret.si.group));
         // FIXME: allow using all qubits involved (in same signalType?, or refer to signal: qubitOfSignal[n]), e.g. qubit[0], qubit[1], qubit[2]
         sv = replace_all(sv, "{qubit}", to_string(qubit));
@@ -1002,12 +1040,14 @@ Codegen::CalcSignalValue Codegen::calcSignalValue(
         // FIXME: note that the actual contents of the signalValue only become important when we'll do automatic codeword assignment and provide codewordTable to downstream software to assign waveforms to the codewords
     }
 
-    comment(QL_SS2S(
-        "  # slot=" << ret.si.ic.ii.slot
-        << ", instrument='" << ret.si.ic.ii.instrumentName << "'"
-        << ", group=" << ret.si.group
-        << "': signalValue='" << ret.signalValueString << "'"
-    ));
+    if (verboseCode) {
+        comment(QL_SS2S(
+            "  # slot=" << ret.si.ic->ii.slot
+            << ", instrument='" << ret.si.ic->ii.instrumentName << "'"
+            << ", group=" << ret.si.group
+            << "': signalValue='" << ret.signalValueString << "'"
+        ));
+    }
 
     return ret;
 }
@@ -13,6 +13,7 @@
 #include "options_cc.h"
 #include "bundle_info.h"
 #include "datapath_cc.h"
+#include "emitter_cc.h"
 #include "settings_cc.h"
 #include "vcd_cc.h"
 #include "platform.h"
@@ -28,7 +29,8 @@ public: //  functions
 
     // Generic
     void init(const quantum_platform &platform);
-    Str getProgram();                           // return the CC source code that was created
+    void setOutput(const Emitter::Sink &sink);  // stream the CC source code to sink while it is created
+    Str getProgram();                           // return the CC source code that was created (if no output sink was set)
     Str getMap();                               // return a map of codeword assignments, useful for configuring AWGs
 
     // Compile support
@@ -105,7 +107,9 @@ private:    // vars
 
     // codegen state, program scope
     Json codewordTable;                                         // codewords versus signals per instrument group
-    StrStrm codeSection;                                        // the code generated
+    Emitter codeSection;                                        // the code generated
+    Str opsBuf;                                                 // scratch space for formatting operands, reused to prevent allocations
+    Str commentBuf;                                             // idem for comments
 
     // codegen state, kernel scope FIXME: create class
     UInt lastEndCycle[MAX_INSTRS];                              // vector[instrIdx], maintain where we got per slot
@@ -122,9 +126,11 @@ private:    // funcs
     void emit(const Str &labelOrComment, const Str &instr="");
     void emit(const Str &label, const Str &instr, const Str &ops, const Str &comment="");
     void emit(Int slot, const Str &instr, const Str &ops, const Str &comment="");
+    void emitFields(const char *labelOrSel, UInt labelOrSelSize, const Str &instr, const Str &ops, const Str &comment);
 
     // code generation helpers
     void showCodeSoFar();
+    void formatCycleComment(UInt fromCycle, UInt toCycle, const char *what, const Str &instrumentName);
     void emitProgramStart(const Str &progName);
     void emitProgramFinish();
     void emitFeedback(const FeedbackMap &feedbackMap, UInt instrIdx, UInt startCycle, Int slot, const Str &instrumentName);
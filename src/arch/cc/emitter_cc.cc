@@ -0,0 +1,154 @@
+/**
+ * @file    arch/cc/emitter_cc.cc
+ * @date    20210301
+ * @author  Wouter Vlothuizen (wouter.vlothuizen@tno.nl)
+ * @brief   buffered, streaming output of Central Controller assembly code
+ * @note
+ */
+
+#include "emitter_cc.h"
+
+#include <algorithm>
+
+namespace ql {
+namespace arch {
+namespace cc {
+
+/************************************************************************\
+| Formatting helpers
+\************************************************************************/
+
+UInt formatUInt(char *buf, UInt val) {
+    char tmp[FORMAT_INT_SIZE];
+    UInt n = 0;
+    do {
+        tmp[n++] = static_cast<char>('0' + val % 10);
+        val /= 10;
+    } while (val != 0);
+    for (UInt i = 0; i < n; i++) {
+        buf[i] = tmp[n-1-i];
+    }
+    return n;
+}
+
+UInt formatInt(char *buf, Int val) {
+    if (val < 0) {
+        buf[0] = '-';
+        // NB: negate in unsigned domain to also handle the most negative value
+        return 1 + formatUInt(buf+1, -static_cast<UInt>(val));
+    }
+    return formatUInt(buf, static_cast<UInt>(val));
+}
+
+UInt formatHex(char *buf, UInt val, UInt width) {
+    static const char digits[] = "0123456789abcdef";
+    char tmp[FORMAT_INT_SIZE];
+    UInt n = 0;
+    do {
+        tmp[n++] = digits[val & 0xF];
+        val >>= 4;
+    } while (val != 0);
+    UInt pad = width > n ? width - n : 0;
+    for (UInt i = 0; i < pad; i++) {
+        buf[i] = '0';
+    }
+    for (UInt i = 0; i < n; i++) {
+        buf[pad+i] = tmp[n-1-i];
+    }
+    return pad + n;
+}
+
+void appendInt(Str &s, Int val) {
+    char buf[FORMAT_INT_SIZE];
+    s.append(buf, formatInt(buf, val));
+}
+
+void appendUInt(Str &s, UInt val) {
+    char buf[FORMAT_INT_SIZE];
+    s.append(buf, formatUInt(buf, val));
+}
+
+void appendHex(Str &s, UInt val, UInt width) {
+    // NB: width is limited to what we actually use (i.e. 8 for a Digital)
+    char buf[FORMAT_INT_SIZE];
+    s.append(buf, formatHex(buf, val, std::min<UInt>(width, FORMAT_INT_SIZE-1)));
+}
+
+/************************************************************************\
+| Emitter
+\************************************************************************/
+
+Emitter::Emitter(UInt bufferSize) : bufferSize(bufferSize) {
+    buffer.reserve(bufferSize);
+}
+
+void Emitter::setSink(const Sink &sink) {
+    flush();
+    this->sink = sink;
+}
+
+void Emitter::flush() {
+    if (!buffer.empty()) {
+        drain();
+    }
+}
+
+Str Emitter::getContents() {
+    flush();
+    return memory;
+}
+
+Str Emitter::getTail() const {
+    return tail + buffer;
+}
+
+void Emitter::put(const char *data, UInt size) {
+    while (size > 0) {
+        if (buffer.size() == bufferSize) {
+            drain();
+        }
+        UInt n = std::min(size, bufferSize - buffer.size());
+        buffer.append(data, n);
+        data += n;
+        size -= n;
+    }
+}
+
+void Emitter::put(char c) {
+    if (buffer.size() == bufferSize) {
+        drain();
+    }
+    buffer.push_back(c);
+}
+
+void Emitter::putLeft(const char *data, UInt size, UInt width) {
+    put(data, size);
+    for (UInt i = size; i < width; i++) {
+        put(' ');
+    }
+}
+
+void Emitter::putInt(Int val) {
+    char buf[FORMAT_INT_SIZE];
+    put(buf, formatInt(buf, val));
+}
+
+void Emitter::putUInt(UInt val) {
+    char buf[FORMAT_INT_SIZE];
+    put(buf, formatUInt(buf, val));
+}
+
+// pass the buffer to the sink (or memory), and keep a copy as tail
+void Emitter::drain() {
+    if (sink) {
+        sink(buffer.data(), buffer.size());
+    } else {
+        memory.append(buffer);
+    }
+    tail.swap(buffer);      // NB: both strings keep their capacity, so no allocation in steady state
+    buffer.clear();
+}
+
+} // namespace cc
+} // namespace arch
+} // namespace ql
@@ -0,0 +1,68 @@
+/**
+ * @file    arch/cc/emitter_cc.h
+ * @date    20210301
+ * @author  Wouter Vlothuizen (wouter.vlothuizen@tno.nl)
+ * @brief   buffered, streaming output of Central Controller assembly code
+ * @note    the output is passed to a sink in chunks of at most the buffer size,
+ *          so the memory used does not depend on the size of the program
+ */
+
+#pragma once
+
+#include <functional>
+
+#include "types_cc.h"
+
+namespace ql {
+namespace arch {
+namespace cc {
+
+// allocation-free formatting helpers, return the number of characters written to buf
+static const UInt FORMAT_INT_SIZE = 24;                         // enough for any 64 bit integer including sign
+UInt formatInt(char *buf, Int val);                             // decimal, like operator<<(Int)
+UInt formatUInt(char *buf, UInt val);                           // decimal, like operator<<(UInt)
+UInt formatHex(char *buf, UInt val, UInt width);                // lower case hexadecimal, zero padded to width
+
+// append to a string, which does not allocate once the string has grown to its steady state capacity
+void appendInt(Str &s, Int val);
+void appendUInt(Str &s, UInt val);
+void appendHex(Str &s, UInt val, UInt width);
+
+class Emitter {
+public:     // types
+    using Sink = std::function<void(const char *data, UInt size)>;
+
+public:     // funcs
+    explicit Emitter(UInt bufferSize = DEFAULT_BUFFER_SIZE);
+    ~Emitter() = default;
+
+    void setSink(const Sink &sink);                             // direct output to sink instead of memory
+    void flush();                                               // pass buffered output to sink
+    Str getContents();                                          // return output collected in memory (i.e. no sink set)
+    Str getTail() const;                                        // return (approximately) the last bufferSize characters, for error reporting
+
+    void put(const char *data, UInt size);
+    void put(const Str &s) { put(s.data(), s.size()); }
+    void put(char c);
+    void putLeft(const char *data, UInt size, UInt width);      // left aligned, padded with spaces to width, like std::setw with std::left
+    void putLeft(const Str &s, UInt width) { putLeft(s.data(), s.size(), width); }
+    void putInt(Int val);
+    void putUInt(UInt val);
+    void newline() { put('\n'); }
+
+private:    // vars
+    static const UInt DEFAULT_BUFFER_SIZE = 64*1024;
+
+    Str buffer;                                                 // pending output, never grows beyond its initial capacity
+    UInt bufferSize;
+    Sink sink;                                                  // empty: collect output in memory
+    Str memory;                                                 // output collected if no sink set
+    Str tail;                                                   // last flushed output
+
+private:    // funcs
+    void drain();
+};
+
+} // namespace cc
+} // namespace arch
+} // namespace ql
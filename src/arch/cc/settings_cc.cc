@@ -18,8 +18,8 @@ void Settings::loadBackendSettings(const quantum_platform &platform) {
     this->platform = &platform;
 
     // remind some main JSON areas
-    QL_JSON_ASSERT(platform.hardware_settings, "eqasm_backend_cc", "hardware_settings");  // NB: json_get<const json &> unavailable
-    const Json &jsonBackendSettings = platform.hardware_settings["eqasm_backend_cc"];
+    QL_JSON_ASSERT(*platform.hardware_settings, "eqasm_backend_cc", "hardware_settings");  // NB: json_get<const json &> unavailable
+    const Json &jsonBackendSettings = (*platform.hardware_settings)["eqasm_backend_cc"];
 
     QL_JSON_ASSERT(jsonBackendSettings, "instrument_definitions", "eqasm_backend_cc");
     jsonInstrumentDefinitions = &jsonBackendSettings["instrument_definitions"];
@@ -33,6 +33,14 @@ void Settings::loadBackendSettings(const quantum_platform &platform) {
     QL_JSON_ASSERT(jsonBackendSettings, "signals", "eqasm_backend_cc");
     jsonSignals = &jsonBackendSettings["signals"];
 
+    // pre-parse instruments
+    instrumentControls.clear();
+    for (UInt instrIdx = 0; instrIdx < jsonInstruments->size(); instrIdx++) {
+        instrumentControls.push_back(loadInstrumentControl(instrIdx));
+    }
+    buildSignalInfoTable();
+    buildSignalDefs();
+
 #if 0   // FIXME: print some info, which also helps detecting errors early on
     // read instrument definitions
     // FIXME: the following requires json>v3.1.0: (NB: we now moved to 3.9!) for(auto& id : jsonInstrumentDefinitions->items()) {
@@ -114,8 +122,19 @@ UInt Settings::getReadoutWait() {
 }
 
 
-// find JSON signal definition for instruction, either inline or via 'ref_signal'
-Settings::SignalDef Settings::findSignalDefinition(const Json &instruction, const Str &iname) const {
+// find JSON signal definition for instruction, as resolved by loadBackendSettings
+const Settings::SignalDef &Settings::findSignalDefinition(const Json &instruction, const Str &iname) const {
+    auto it = signalDefs.find(iname);
+    if (it == signalDefs.end()) {
+        loadSignalDefinition(instruction, iname);                               // reports what is wrong with the definition
+        QL_FATAL("instruction '" << iname << "': no signal definition");        // not reached
+    }
+    return it->second;
+}
+
+
+// load JSON signal definition for instruction, either inline or via 'ref_signal'
+Settings::SignalDef Settings::loadSignalDefinition(const Json &instruction, const Str &iname) const {
     SignalDef ret;
 
     Str instructionPath = "instructions/" + iname;
@@ -136,6 +155,18 @@ Settings::SignalDef Settings::findSignalDefinition(const Json &instruction, cons
         QL_DOUT("signal for '" << instruction << "': " << ret.signal);
         ret.path = instructionPath + "/cc/signal";
     }
+
+    // resolve the signal types. Types that are missing or not provided by any instrument are reported on use
+    for (UInt s = 0; s < ret.signal.size(); s++) {
+        UInt typeIdx = NO_SIGNAL_TYPE;
+        if (QL_JSON_EXISTS(ret.signal[s], "type") && ret.signal[s]["type"].is_string()) {
+            auto it = signalTypeIdx.find(ret.signal[s]["type"].get<Str>());
+            if (it != signalTypeIdx.end()) {
+                typeIdx = it->second;
+            }
+        }
+        ret.typeIdx.push_back(typeIdx);
+    }
     return ret;
 }
 
@@ -168,7 +199,16 @@ Settings::InstrumentInfo Settings::getInstrumentInfo(UInt instrIdx) const {
 }
 
 
-Settings::InstrumentControl Settings::getInstrumentControl(UInt instrIdx) const {
+// get the control information for an instrument, as pre-parsed by loadBackendSettings
+const Settings::InstrumentControl &Settings::getInstrumentControl(UInt instrIdx) const {
+    if (instrIdx >= instrumentControls.size()) {
+        QL_JSON_FATAL("node not defined: " << QL_SS2S("instruments[" << instrIdx << "]"));  // probably an internal backend error
+    }
+    return instrumentControls[instrIdx];
+}
+
+
+Settings::InstrumentControl Settings::loadInstrumentControl(UInt instrIdx) const {
     InstrumentControl ret;
 
     ret.ii = getInstrumentInfo(instrIdx);
@@ -222,63 +262,110 @@ Int Settings::getResultBit(const InstrumentControl &ic, Int group) {
 }
 
 
-// find instrument&group given instructionSignalType for qubit
+// build the table that maps signal type and qubit onto instrument&group, see findSignalInfoForQubit
 // NB: this implies that we map signal *vectors* to groups, i.e. it is not possible to map individual channels
 // Conceptually, this is were we map an abstract signal definition, eg: {"flux", q3} (which may also be
 // interpreted as port "q3.flux") onto an instrument & group
-Settings::SignalInfo Settings::findSignalInfoForQubit(const Str &instructionSignalType, UInt qubit) const {
-    SignalInfo ret;
-    Bool signalTypeFound = false;
-    Bool qubitFound = false;
+void Settings::buildSignalInfoTable() {
+    signalTypeIdx.clear();
+    signalInfoTable.clear();
 
     // iterate over instruments
-    for (UInt instrIdx = 0; instrIdx < jsonInstruments->size() && !qubitFound; instrIdx++) {
-        InstrumentControl ic = getInstrumentControl(instrIdx);
+    for (UInt instrIdx = 0; instrIdx < instrumentControls.size(); instrIdx++) {
+        const InstrumentControl &ic = instrumentControls[instrIdx];
         Str instrumentSignalType = json_get<Str>(*ic.ii.instrument, "signal_type", ic.ii.instrumentName);
-        if (instrumentSignalType == instructionSignalType) {
-            signalTypeFound = true;
-            const Json qubits = json_get<const Json>(*ic.ii.instrument, "qubits", ic.ii.instrumentName);   // NB: json_get<const json&> unavailable
-
-            // verify group size: qubits vs. control mode
-            UInt qubitGroupCnt = qubits.size();                                  // NB: JSON key qubits is a 'matrix' of [groups*qubits]
-            if (qubitGroupCnt != ic.controlModeGroupCnt) {
-                QL_JSON_FATAL(
-                    "instrument " << ic.ii.instrumentName
-                    << ": number of qubit groups " << qubitGroupCnt
-                    << " does not match number of control_bits groups " << ic.controlModeGroupCnt
-                    << " of selected control mode '" << ic.refControlMode << "'"
-                );
-            }
+        const Json qubits = json_get<const Json>(*ic.ii.instrument, "qubits", ic.ii.instrumentName);   // NB: json_get<const json&> unavailable
 
-            // anyone connected to qubit?
-            for (UInt group = 0; group < qubitGroupCnt && !qubitFound; group++) {
-                for (UInt idx = 0; idx < qubits[group].size() && !qubitFound; idx++) {
-                    if (qubits[group][idx].get<UInt>() == qubit) {
-                        qubitFound = true;                                      // also: stop searching
-
-                        QL_DOUT(
-                            "qubit " << qubit
-                            << " signal type '" << instructionSignalType
-                            << "' driven by instrument '" << ic.ii.instrumentName
-                            << "' group " << group
-                        );
-
-                        ret.ic = ic;
-                        ret.instrIdx = instrIdx;
-                        ret.group = group;
-                    }
+        // verify group size: qubits vs. control mode
+        UInt qubitGroupCnt = qubits.size();                                  // NB: JSON key qubits is a 'matrix' of [groups*qubits]
+        if (qubitGroupCnt != ic.controlModeGroupCnt) {
+            QL_JSON_FATAL(
+                "instrument " << ic.ii.instrumentName
+                << ": number of qubit groups " << qubitGroupCnt
+                << " does not match number of control_bits groups " << ic.controlModeGroupCnt
+                << " of selected control mode '" << ic.refControlMode << "'"
+            );
+        }
+
+        // get the table row for the signal type
+        auto it = signalTypeIdx.find(instrumentSignalType);
+        if (it == signalTypeIdx.end()) {
+            it = signalTypeIdx.emplace(instrumentSignalType, signalInfoTable.size()).first;
+            signalInfoTable.emplace_back();
+        }
+        Vec<SignalInfo> &row = signalInfoTable[it->second];
+
+        // register the qubits connected, the first instrument&group found for a qubit wins
+        for (UInt group = 0; group < qubitGroupCnt; group++) {
+            for (UInt idx = 0; idx < qubits[group].size(); idx++) {
+                UInt qubit = qubits[group][idx].get<UInt>();
+                if (qubit >= row.size()) {
+                    row.resize(qubit + 1, SignalInfo{nullptr, 0, 0});
+                }
+                if (!row[qubit].ic.has_value()) {
+                    QL_DOUT(
+                        "qubit " << qubit
+                        << " signal type '" << instrumentSignalType
+                        << "' driven by instrument '" << ic.ii.instrumentName
+                        << "' group " << group
+                    );
+                    row[qubit] = SignalInfo{&ic, instrIdx, (Int)group};
                 }
             }
         }
     }
-    if (!signalTypeFound) {
+}
+
+
+// resolve the signal definitions of all instructions that have one, such that code generation can use
+// the signal type indices. Definitions that do not resolve are reported when the instruction is used
+void Settings::buildSignalDefs() {
+    signalDefs.clear();
+    for (const auto &instruction : platform->instruction_settings->items()) {
+        if (!QL_JSON_EXISTS(instruction.value(), "cc")) {
+            continue;
+        }
+        const Json &cc = instruction.value()["cc"];
+        Bool resolves;
+        if (QL_JSON_EXISTS(cc, "ref_signal")) {
+            resolves = cc["ref_signal"].is_string()
+                && QL_JSON_EXISTS(*jsonSignals, cc["ref_signal"].get<Str>())
+                && !(*jsonSignals)[cc["ref_signal"].get<Str>()].empty();
+        } else {
+            resolves = QL_JSON_EXISTS(cc, "signal");
+        }
+        if (resolves) {
+            signalDefs.set(instruction.key()) = loadSignalDefinition(instruction.value(), instruction.key());
+        }
+    }
+}
+
+
+// find instrument&group for signal s of a signal definition, for qubit
+const Settings::SignalInfo &Settings::findSignalInfoForQubit(const SignalDef &sd, UInt s, UInt qubit) const {
+    UInt typeIdx = sd.typeIdx[s];
+    if (typeIdx != NO_SIGNAL_TYPE) {
+        const Vec<SignalInfo> &row = signalInfoTable[typeIdx];
+        if (qubit < row.size() && row[qubit].ic.has_value()) {
+            return row[qubit];
+        }
+    }
+    // report the problem
+    return findSignalInfoForQubit(json_get<Str>(sd.signal[s], "type", QL_SS2S(sd.path << "[" << s << "]")), qubit);
+}
+
+
+// find instrument&group given instructionSignalType for qubit
+const Settings::SignalInfo &Settings::findSignalInfoForQubit(const Str &instructionSignalType, UInt qubit) const {
+    auto it = signalTypeIdx.find(instructionSignalType);
+    if (it == signalTypeIdx.end()) {
         QL_JSON_FATAL("No instruments found providing signal type '" << instructionSignalType << "'");
     }
-    if (!qubitFound) {
+    const Vec<SignalInfo> &row = signalInfoTable[it->second];
+    if (qubit >= row.size() || !row[qubit].ic.has_value()) {
         QL_JSON_FATAL("No instruments found driving qubit " << qubit << " for signal type '" << instructionSignalType << "'");
     }
-
-    return ret;
+    return row[qubit];
 }
 
 /************************************************************************\
@@ -21,6 +21,7 @@ public: // types
     struct SignalDef {
         Json signal;        // a copy of the signal node found
         Str path;           // path of the node, for reporting purposes
+        Vec<UInt> typeIdx;  // per signal: row of its "type" in signalInfoTable, or NO_SIGNAL_TYPE if unresolved
     };
 
     struct InstrumentInfo {         // information from key 'instruments'
@@ -41,12 +42,13 @@ public: // types
     };
 
     struct SignalInfo {
-        InstrumentControl ic;
+        RawPtr<const InstrumentControl> ic;     // points into the instrument controls pre-parsed by loadBackendSettings
         UInt instrIdx;              // the index into JSON "eqasm_backend_cc/instruments" that provides the signal
         Int group;                  // the group of channels within the instrument that provides the signal
     };
 
     static const Int NO_STATIC_CODEWORD_OVERRIDE = -1;
+    static const UInt NO_SIGNAL_TYPE = utils::MAX;
 
 public: // functions
     Settings() = default;
@@ -58,13 +60,15 @@ public: // functions
     Bool isPragma(const Str &iname);
     RawPtr<const Json> getPragma(const Str &iname);
     UInt getReadoutWait();
-    SignalDef findSignalDefinition(const Json &instruction, const Str &iname) const;
+    const SignalDef &findSignalDefinition(const Json &instruction, const Str &iname) const;
     InstrumentInfo getInstrumentInfo(UInt instrIdx) const;
-    InstrumentControl getInstrumentControl(UInt instrIdx) const;
+    const InstrumentControl &getInstrumentControl(UInt instrIdx) const;
     static Int getResultBit(const InstrumentControl &ic, Int group) ;
 
     // find instrument/group providing instructionSignalType for qubit
-    SignalInfo findSignalInfoForQubit(const Str &instructionSignalType, UInt qubit) const;
+    const SignalInfo &findSignalInfoForQubit(const Str &instructionSignalType, UInt qubit) const;
+    // same, for signal s of a signal definition, using the type index resolved when the definition was loaded
+    const SignalInfo &findSignalInfoForQubit(const SignalDef &sd, UInt s, UInt qubit) const;
 
     static Int findStaticCodewordOverride(const Json &instruction, UInt operandIdx, const Str &iname);
 
@@ -78,6 +82,18 @@ private:    // vars
     RawPtr<const Json> jsonControlModes;
     RawPtr<const Json> jsonInstruments;
     RawPtr<const Json> jsonSignals;
+
+    // lookup tables built by loadBackendSettings, such that code generation does not need to walk the JSON
+    Vec<InstrumentControl> instrumentControls;              // vector[instrIdx]
+    Map<Str, UInt> signalTypeIdx;                           // signal type -> index into signalInfoTable
+    Vec<Vec<SignalInfo>> signalInfoTable;                   // matrix[signalTypeIdx][qubit], ic is nullptr if no instrument drives the qubit
+    Map<Str, SignalDef> signalDefs;                         // instruction name -> its signal definition, with types resolved
+
+private:    // funcs
+    InstrumentControl loadInstrumentControl(UInt instrIdx) const;
+    void buildSignalInfoTable();
+    void buildSignalDefs();
+    SignalDef loadSignalDefinition(const Json &instruction, const Str &iname) const;
 }; // class
 
 } // namespace cc
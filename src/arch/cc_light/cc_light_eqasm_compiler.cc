@@ -4,180 +4,195 @@
 
 #include "cc_light_eqasm_compiler.h"
 
+#include <algorithm>
+#include <mutex>
+
 #include "scheduler.h"
 #include "mapper.h"
 #include "clifford.h"
-#include "latency_compensation.h"
 #include "buffer_insertion.h"
 #include "qsoverlay.h"
 #include "utils/filesystem.h"
+#include "binary_ir.h"
+#include "utils/opt.h"
+#include "utils/thread_pool.h"
 
 namespace ql {
 namespace arch {
 
 using namespace utils;
 
-UInt CurrSRegCount;
-UInt CurrTRegCount;
+template <class M>
+MaskRegisterFile<M>::MaskRegisterFile(UInt size) : size(size) {
+}
+
+template <class M>
+UInt MaskRegisterFile<M>::get(const M &mask, UInt stamp, Bool &reloaded) {
+    reloaded = false;
 
-Mask::Mask(const qubit_set_t &qs) : squbits(qs) {
-    if (CurrSRegCount < MAX_S_REG) {
-        regNo = CurrSRegCount++;
-        regName = "s" + to_string(regNo);
-    } else {
-        QL_COUT(" !!!! Handle cases requiring more registers");
+    // reuse the register if the mask is live already
+    auto it = live_regs.find(mask);
+    if (it != live_regs.end()) {
+        last_use[it->second] = stamp;
+        return it->second;
     }
-}
 
-Mask::Mask(const Str &rn, const qubit_set_t &qs) : regName(rn), squbits(qs) {
-    if (CurrSRegCount < MAX_S_REG) {
-        regNo = CurrSRegCount++;
-    } else {
-        QL_COUT(" !!!! Handle cases requiring more registers");
+    // allocate a static register while they last
+    UInt reg = static_masks.size();
+    if (reg < size) {
+        static_masks.push_back(mask);
+        live_masks.push_back(mask);
+        last_use.push_back(stamp);
+        live_regs.set(mask) = reg;
+        return reg;
     }
-}
 
-Mask::Mask(const qubit_pair_set_t &qps) : dqubits(qps) {
-    if (CurrTRegCount < MAX_T_REG) {
-        regNo = CurrTRegCount++;
-        regName = "t" + to_string(regNo);
-    } else {
-        QL_COUT(" !!!! Handle cases requiring more registers");
+    // reload the least recently used register not used by this bundle
+    reg = MAX;
+    for (UInt r = 0; r < size; r++) {
+        if (last_use[r] != stamp && (reg == MAX || last_use[r] < last_use[reg])) {
+            reg = r;
+        }
+    }
+    if (reg == MAX) {
+        QL_FATAL("a single bundle requires more than " << size << " different masks");
     }
+    live_regs.erase(live_masks[reg]);
+    live_masks[reg] = mask;
+    live_regs.set(mask) = reg;
+    last_use[reg] = stamp;
+    reloaded = true;
+    return reg;
 }
 
-MaskManager::MaskManager() {
-    // add pre-defined smis
-    for (UInt i = 0; i < 7; ++i) {
-        qubit_set_t qs;
-        qs.push_back(i);
-        Mask m(qs);
-        QS2Mask.set(qs) = m;
-        SReg2Mask.set(m.regNo) = m;
-    }
+template <class M>
+UInt MaskRegisterFile<M>::get_static_count() const {
+    return static_masks.size();
+}
 
-    // add some common single qubit masks
-    {
-        qubit_set_t qs;
-        for(auto i=0; i<7; i++) qs.push_back(i);
-        Mask m(qs); // TODO add proper support for:  Mask m(qs, "all_qubits");
-        QS2Mask.set(qs) = m;
-        SReg2Mask.set(m.regNo) = m;
-    }
+template <class M>
+const M &MaskRegisterFile<M>::get_static_mask(UInt reg) const {
+    return static_masks[reg];
+}
 
-    {
-        qubit_set_t qs;
-        qs.push_back(0); qs.push_back(1); qs.push_back(5); qs.push_back(6);
-        Mask m(qs); // TODO add proper support for:  Mask m(qs, "data_qubits");
-        QS2Mask.set(qs) = m;
-        SReg2Mask.set(m.regNo) = m;
+template <class M>
+Vec<UInt> MaskRegisterFile<M>::restore() {
+    Vec<UInt> regs;
+    for (UInt r = 0; r < static_masks.size(); r++) {
+        if (live_masks[r] != static_masks[r]) {
+            live_masks[r] = static_masks[r];
+            regs.push_back(r);
+        }
     }
-
-    {
-        qubit_set_t qs;
-        qs.push_back(2); qs.push_back(3); qs.push_back(4);
-        Mask m(qs); // TODO add proper support for:  Mask m(qs, "ancilla_qubits");
-        QS2Mask.set(qs) = m;
-        SReg2Mask.set(m.regNo) = m;
+    if (!regs.empty()) {
+        live_regs.clear();
+        for (UInt r = 0; r < static_masks.size(); r++) {
+            live_regs.set(static_masks[r]) = r;
+        }
     }
+    return regs;
+}
 
-    // qubit_pair_set_t pre_defined_edges = { {2,0}, {0,3}, {3,1}, {1,4}, {2,5}, {5,3}, {3,6}, {6,4},
-    //                                {0,2}, {3,0}, {1,3}, {4,1}, {5,2}, {3,5}, {6,3}, {4,6} };
-    // // add smit
-    // for(auto & p : pre_defined_edges)
-    // {
-    //     qubit_pair_set_t qps;
-    //     qps.push_back(p);
-    //     Mask m(qps);
-    //     QPS2Mask[qps] = m;
-    //     TReg2Mask[m.regNo] = m;
-    // }
+template class MaskRegisterFile<smask_t>;
+template class MaskRegisterFile<tmask_t>;
 
+static smask_t make_smask(const Vec<UInt> &qubits) {
+    smask_t mask;
+    for (auto q : qubits) {
+        mask.set(q);
+    }
+    return mask;
+}
+
+static Str smis_instruction(UInt reg, const smask_t &mask) {
+    StrStrm ss;
+    ss << "smis s" << reg << ", {";
+    auto qubits = mask.bits();
+    for (auto it = qubits.begin(); it != qubits.end(); ++it) {
+        ss << *it;
+        if (std::next(it) != qubits.end()) {
+            ss << ", ";
+        }
+    }
+    ss << "} ";
+    return ss.str();
 }
 
-MaskManager::~MaskManager() {
-    CurrSRegCount=0;
-    CurrTRegCount=0;
+static Str smit_instruction(UInt reg, const tmask_t &mask) {
+    StrStrm ss;
+    ss << "smit t" << reg << ", {";
+    auto pairs = mask.bits();
+    for (auto it = pairs.begin(); it != pairs.end(); ++it) {
+        ss << "(" << *it / MAX_MASK_QUBITS << ", " << *it % MAX_MASK_QUBITS << ")";
+        if (std::next(it) != pairs.end()) {
+            ss << ", ";
+        }
+    }
+    ss << "} ";
+    return ss.str();
 }
 
-UInt MaskManager::getRegNo(qubit_set_t &qs) {
-    // sort qubit operands to avoid variation in order
-    sort(qs.begin(), qs.end());
+MaskManager::MaskManager() : sregs(MAX_S_REG), tregs(MAX_T_REG) {
+    Bool reloaded;
 
-    auto it = QS2Mask.find(qs);
-    if (it == QS2Mask.end()) {
-        Mask m(qs);
-        QS2Mask.set(qs) = m;
-        SReg2Mask.set(m.regNo) = m;
+    // add pre-defined smis
+    for (UInt i = 0; i < 7; ++i) {
+        sregs.get(make_smask({i}), stamp, reloaded);
     }
-    return QS2Mask.at(qs).regNo;
+
+    // add some common single qubit masks
+    sregs.get(make_smask({0, 1, 2, 3, 4, 5, 6}), stamp, reloaded); // TODO add proper support for: "all_qubits"
+    sregs.get(make_smask({0, 1, 5, 6}), stamp, reloaded);          // TODO add proper support for: "data_qubits"
+    sregs.get(make_smask({2, 3, 4}), stamp, reloaded);             // TODO add proper support for: "ancilla_qubits"
 }
 
-UInt MaskManager::getRegNo(qubit_pair_set_t &qps) {
-    // sort qubit operands pair to avoid variation in order
-    sort(qps.begin(), qps.end());
+void MaskManager::beginBundle() {
+    stamp++;
+}
 
-    auto it = QPS2Mask.find(qps);
-    if (it == QPS2Mask.end()) {
-        Mask m(qps);
-        QPS2Mask.set(qps) = m;
-        TReg2Mask.set(m.regNo) = m;
+Str MaskManager::getRegName(const smask_t &qs) {
+    Bool reloaded;
+    UInt reg = sregs.get(qs, stamp, reloaded);
+    if (reloaded) {
+        loads << "    " << smis_instruction(reg, qs) << std::endl;
     }
-    return QPS2Mask.at(qps).regNo;
+    return "s" + to_string(reg);
 }
 
-Str MaskManager::getRegName(qubit_set_t &qs) {
-    // sort qubit operands to avoid variation in order
-    sort(qs.begin(), qs.end());
-
-    auto it = QS2Mask.find(qs);
-    if (it == QS2Mask.end()) {
-        Mask m(qs);
-        QS2Mask.set(qs) = m;
-        SReg2Mask.set(m.regNo) = m;
+Str MaskManager::getRegName(const tmask_t &qps) {
+    Bool reloaded;
+    UInt reg = tregs.get(qps, stamp, reloaded);
+    if (reloaded) {
+        loads << "    " << smit_instruction(reg, qps) << std::endl;
     }
-    return QS2Mask.at(qs).regName;
+    return "t" + to_string(reg);
 }
 
-Str MaskManager::getRegName(qubit_pair_set_t &qps) {
-    // sort qubit operands pair to avoid variation in order
-    sort(qps.begin(), qps.end());
+Str MaskManager::getLoadInstructions() {
+    Str result = loads.str();
+    loads.str("");
+    return result;
+}
 
-    auto it = QPS2Mask.find(qps);
-    if (it == QPS2Mask.end()) {
-        Mask m(qps);
-        QPS2Mask.set(qps) = m;
-        TReg2Mask.set(m.regNo) = m;
+Str MaskManager::getRestoreInstructions() {
+    StrStrm ssmasks;
+    for (auto r : sregs.restore()) {
+        ssmasks << "    " << smis_instruction(r, sregs.get_static_mask(r)) << std::endl;
+    }
+    for (auto r : tregs.restore()) {
+        ssmasks << "    " << smit_instruction(r, tregs.get_static_mask(r)) << std::endl;
     }
-    return QPS2Mask.at(qps).regName;
+    return ssmasks.str();
 }
 
 Str MaskManager::getMaskInstructions() {
     StrStrm ssmasks;
-    for (UInt r = 0; r < CurrSRegCount; ++r) {
-        auto &m = SReg2Mask.at(r);
-        ssmasks << "smis " << m.regName << ", {";
-        for (auto it = m.squbits.begin(); it != m.squbits.end(); ++it) {
-            ssmasks << *it;
-            if (std::next(it) != m.squbits.end()) {
-                ssmasks << ", ";
-            }
-        }
-        ssmasks << "} " << std::endl;
+    for (UInt r = 0; r < sregs.get_static_count(); ++r) {
+        ssmasks << smis_instruction(r, sregs.get_static_mask(r)) << std::endl;
     }
-
-    for (UInt r = 0; r < CurrTRegCount; ++r) {
-        auto &m = TReg2Mask.at(r);
-        ssmasks << "smit " << m.regName << ", {";
-        for (auto it = m.dqubits.begin(); it != m.dqubits.end(); ++it) {
-            ssmasks << "(" << it->first << ", " << it->second << ")";
-            if (std::next(it) != m.dqubits.end()) {
-                ssmasks << ", ";
-            }
-        }
-        ssmasks << "} " << std::endl;
+    for (UInt r = 0; r < tregs.get_static_count(); ++r) {
+        ssmasks << smit_instruction(r, tregs.get_static_mask(r)) << std::endl;
     }
-
     return ssmasks.str();
 }
 
@@ -230,25 +245,23 @@ classical_cc::classical_cc(
     QL_DOUT("adding classical_cc [DONE]");
 }
 
-instruction_t classical_cc::qasm() const {
-    Str iopers;
-    Int sz = creg_operands.size();
-    for (Int i = 0; i < sz; ++i) {
-        if (i == sz - 1) {
-            iopers += " r" + to_string(creg_operands[i]);
-        } else {
-            iopers += " r" + to_string(creg_operands[i]) + ",";
+void classical_cc::write_qasm(std::ostream &os) const {
+    if (name == "fmr") {
+        os << name << " r" << creg_operands[0] << ", q" << operands[0];
+        return;
+    }
+
+    os << name;
+    UInt sz = creg_operands.size();
+    for (UInt i = 0; i < sz; ++i) {
+        os << " r" << creg_operands[i];
+        if (i != sz - 1) {
+            os << ",";
         }
     }
 
     if (name == "ldi") {
-        iopers += ", " + to_string(int_operand);
-        return "ldi" + iopers;
-    } else if (name == "fmr") {
-        return name + " r" + to_string(creg_operands[0]) +
-               ", q" + to_string(operands[0]);
-    } else {
-        return name + iopers;
+        os << ", " << int_operand;
     }
 }
 
@@ -261,6 +274,14 @@ cmat_t classical_cc::mat() const {
     return m;
 }
 
+// tag of classical_cc in binary IR files; it has the type() of the generic
+// classical gates, but is printed differently
+static const UInt BINARY_IR_TAG_CLASSICAL_CC = BINARY_IR_FIRST_BACKEND_TAG;
+
+UInt classical_cc::binary_ir_tag() const {
+    return BINARY_IR_TAG_CLASSICAL_CC;
+}
+
 Str classical_instruction2qisa(classical_cc *classical_ins) {
     StrStrm ssclassical;
     auto &iname = classical_ins->name;
@@ -309,14 +330,22 @@ Str classical_instruction2qisa(classical_cc *classical_ins) {
 // FIXME HvS cc_light_instr is name of attribute in json file, in gate: arch_operation_name, here in instruction_map?
 // FIXME HvS attribute of gate or just in json? Generalization to arch_operation_name is unnecessary
 Str get_cc_light_instruction_name(
-    const Str &id,
+    gate *g,
     const quantum_platform &platform
 ) {
+    // fast path through the attributes compiled by the platform;
+    // the instruction_map lookup below also covers gates whose name differs from the instruction_settings key
+    const instruction_attributes_t *attr = platform.find_instruction_attributes(g);
+    if (attr && attr->has_cc_light_instr && !attr->cc_light_instr.empty()) {
+        return attr->cc_light_instr;
+    }
+
+    const Str &id = g->name;
     Str cc_light_instr_name;
-    auto it = platform.instruction_map.find(id);
-    if (it != platform.instruction_map.end()) {
-        custom_gate* g = it->second;
-        cc_light_instr_name = g->arch_operation_name;
+    auto it = platform.instruction_map->find(id);
+    if (it != platform.instruction_map->end()) {
+        custom_gate* cg = it->second;
+        cc_light_instr_name = cg->definition->arch_operation_name;
         if (cc_light_instr_name.empty()) {
             QL_FATAL("cc_light_instr not defined for instruction: " << id << " !");
         }
@@ -334,99 +363,92 @@ Str ir2qisa(
 ) {
     QL_IOUT("Generating CC-Light QISA");
 
-    ir::bundles_t bundles1;
     QL_ASSERT(kernel.cycles_valid);
-    bundles1 = ir::bundler(kernel.c, platform.cycle_time);
-
-    QL_IOUT("Combining parallel sections...");
-    // combine parallel instructions of same type from different sections into a single section
-    // this prepares for SIMD; each section will be a SIMD; of a quantum SIMD all operands are combined in a mask
-    ir::DebugBundles("Before combining parallel sections", bundles1);
-    for (ir::bundle_t &abundle : bundles1) {
-        auto secIt1 = abundle.parallel_sections.begin();
-
-        for (; secIt1 != abundle.parallel_sections.end(); ++secIt1) {
-            for (auto secIt2 = std::next(secIt1); secIt2 != abundle.parallel_sections.end(); ++secIt2) {
-                auto insIt1 = secIt1->begin();
-                auto insIt2 = secIt2->begin();
-                if (insIt1 != secIt1->end() && insIt2 != secIt2->end()) {
-                    auto id1 = (*insIt1)->name;
-                    auto id2 = (*insIt2)->name;
-                    auto itype1 = (*insIt1)->type();
-                    auto itype2 = (*insIt2)->type();
-                    if (itype1 == __classical_gate__ || itype2 == __classical_gate__) {
-                        QL_DOUT("Not splicing " << id1 << " and " << id2);
-                        continue;
-                    }
-
-                    auto n1 = get_cc_light_instruction_name(id1, platform);
-                    auto n2 = get_cc_light_instruction_name(id2, platform);
-                    if (n1 == n2) {
-                        QL_DOUT("Splicing " << id1 << "/" << n1 << " and " << id2 << "/" << n2);
-                        (*secIt1).splice(insIt1, (*secIt2));
-                    } else {
-                        QL_DOUT("Not splicing " << id1 << "/" << n1 << " and " << id2 << "/" << n2);
-                    }
-                }
-            }
-        }
-    }
-    ir::DebugBundles("After combining", bundles1);
-    QL_IOUT("Removing empty sections...");
-    // remove empty sections
-    ir::bundles_t bundles2;
-    for (ir::bundle_t &abundle1 : bundles1) {
-        ir::bundle_t abundle2;
-        abundle2.start_cycle = abundle1.start_cycle;
-        abundle2.duration_in_cycles = abundle1.duration_in_cycles;
-        for (auto &sec : abundle1.parallel_sections) {
-            if (!sec.empty()) {
-                abundle2.parallel_sections.push_back(sec);
-            }
-        }
-        bundles2.push_back(abundle2);
-    }
-    bundles1.clear();
-    ir::DebugBundles("After removing empty sections", bundles2);
-
-    // sort sections to get consistent output across multiple runs. The output
-    // is correct even without this sorting. Sorting is important to test the similarity
-    // of generated qisa against golden qisa files. For example, without sorting
-    // any of the following can be generated, which is correct but there will be
-    // differences reported by file_compare used for testing:
-    // x s0 | y s1
-    // OR
-    // y s1 | x s0
-    // However, with sorting it will always generate:
-    // x s0 | y s1
-    //
-    QL_IOUT("Sorting sections alphabetically according to instruction name ...");
-    for (ir::bundle_t &abundle : bundles2) {
-        // sorts instructions alphabetically
-        abundle.parallel_sections.sort(
-            [](const ir::section_t &sec1, const ir::section_t &sec2) -> Bool {
-                auto i1 = sec1.begin();
-                auto iname1 = (*(i1))->name;
-                auto i2 = sec2.begin();
-                auto iname2 = (*(i2))->name;
-                return iname2 < iname1;
-            }
-        );
-    }
+    const ir::bundles_t &bundles = kernel.get_bundles();
+    ir::DebugBundles("Before combining parallel sections", bundles);
 
     // And now generate qisa
-    // each section of a bundle will become a SIMD (all operations in a section are the same, see above)
+    // each group of sections of a bundle will become a SIMD (all operations in a group are the same, see below)
     // for the operands of the SIMD, a mask will be used
     //
     // kernel prologue (start label) and epilogue are generated by the caller or ir2qisa
     StrStrm ssqisa;   // output qisa in here
     UInt curr_cycle = 0; // first instruction should be with pre-interval 1, 'bs 1' FIXME HvS start in cycle 0
-    for (ir::bundle_t &abundle : bundles2) {
+    Vec<ir::section_t> sections;    // sections of the current bundle
+    Vec<Vec<UInt>> group_sections;  // per group, its sections in bundle order; kept allocated across bundles
+    Vec<UInt> group_front;          // per group, the section of which the first gate represents the group
+    Vec<UInt> group_order;          // groups in the order in which they are generated
+    for (const ir::bundle_t &abundle : bundles) {
+        // combine parallel instructions of same type from different sections into a single group
+        // this prepares for SIMD; each group will be a SIMD; of a quantum SIMD all operands are combined in a mask
+        // sections are grouped on their cc_light instruction name in a single pass over the bundle;
+        // classical sections are not combined; the last section that joined a group represents it
+        sections.clear();
+        for (auto &gs : group_sections) {
+            gs.clear();
+        }
+        group_front.clear();
+        Map<Str, UInt> group_by_name;
+        auto new_group = [&](UInt sec) {
+            if (group_sections.size() <= group_front.size()) {
+                group_sections.emplace_back();
+            }
+            group_sections[group_front.size()].push_back(sec);
+            group_front.push_back(sec);
+        };
+        for (auto section : bundles.sections(abundle)) {
+            if (section.empty()) {
+                continue;
+            }
+            UInt sec = sections.size();
+            sections.push_back(section);
+            gate *first = section.front();
+            if (first->type() == __classical_gate__) {
+                QL_DOUT("Not combining " << first->name);
+                new_group(sec);
+                continue;
+            }
+
+            auto n = get_cc_light_instruction_name(first, platform);
+            auto it = group_by_name.find(n);
+            if (it == group_by_name.end()) {
+                group_by_name.set(n) = group_front.size();
+                new_group(sec);
+            } else {
+                QL_DOUT("Combining " << sections[group_front[it->second]].front()->name << " and " << first->name << "/" << n);
+                group_sections[it->second].push_back(sec);
+                group_front[it->second] = sec;
+            }
+        }
+
+        // sort groups to get consistent output across multiple runs. The output
+        // is correct even without this sorting. Sorting is important to test the similarity
+        // of generated qisa against golden qisa files. For example, without sorting
+        // any of the following can be generated, which is correct but there will be
+        // differences reported by file_compare used for testing:
+        // x s0 | y s1
+        // OR
+        // y s1 | x s0
+        // However, with sorting it will always generate:
+        // x s0 | y s1
+        //
+        group_order.resize(group_front.size());
+        for (UInt g = 0; g < group_order.size(); g++) {
+            group_order[g] = g;
+        }
+        std::stable_sort(
+            group_order.begin(), group_order.end(),
+            [&](UInt g1, UInt g2) -> Bool {
+                return sections[group_front[g2]].front()->name < sections[group_front[g1]].front()->name;
+            }
+        );
+
         Str iname;
         StrStrm sspre, ssinst;
         auto bcycle = abundle.start_cycle;
         auto delta = bcycle - curr_cycle;
         Bool classical_bundle=false;
+        gMaskManager.beginBundle();
         if (delta < 8) {
             sspre << "    " << delta << "    ";
         } else {
@@ -434,33 +456,41 @@ Str ir2qisa(
                   << "    1    ";
         }
 
-        for (auto secIt = abundle.parallel_sections.begin(); secIt != abundle.parallel_sections.end(); ++secIt) {
-            qubit_set_t squbits;
-            qubit_pair_set_t dqubits;
-            auto firstInsIt = secIt->begin();
-            iname = (*(firstInsIt))->name;
-            auto itype = (*(firstInsIt))->type();
+        for (auto groupIt = group_order.begin(); groupIt != group_order.end(); ++groupIt) {
+            smask_t squbits;
+            tmask_t dqubits;
+            gate *firstIns = sections[group_front[*groupIt]].front();
+            iname = firstIns->name;
+            auto itype = firstIns->type();
 
             if (itype == __classical_gate__) {
                 classical_bundle = true;
-                ssinst << classical_instruction2qisa( (classical_cc *)(*firstInsIt) );
+                ssinst << classical_instruction2qisa( (classical_cc *)firstIns );
             } else {
                 QL_DOUT("get cclight instr name for : " << iname);
-                Str cc_light_instr_name = get_cc_light_instruction_name(iname, platform);
-                auto nOperands = ((*firstInsIt)->operands).size();
+                Str cc_light_instr_name = get_cc_light_instruction_name(firstIns, platform);
+                auto nOperands = (firstIns->operands).size();
                 if (itype == __nop_gate__) {
                     ssinst << cc_light_instr_name;
                 } else {
-                    for (auto insIt = secIt->begin(); insIt != secIt->end(); ++insIt) {
-                        if (nOperands == 1) {
-                            auto &op = (*insIt)->operands[0];
-                            squbits.push_back(op);
-                        } else if (nOperands == 2) {
-                            auto &op1 = (*insIt)->operands[0];
-                            auto &op2 = (*insIt)->operands[1];
-                            dqubits.push_back(qubit_pair_t(op1, op2));
-                        } else {
-                            throw Exception("Error : only 1 and 2 operand instructions are supported by cc light masks !", false);
+                    for (UInt sec : group_sections[*groupIt]) {
+                        for (auto gp : sections[sec]) {
+                            if (nOperands == 1) {
+                                auto &op = gp->operands[0];
+                                if (op >= MAX_MASK_QUBITS) {
+                                    throw Exception("Error : qubit " + to_string(op) + " can not be represented in a cc light mask !", false);
+                                }
+                                squbits.set(op);
+                            } else if (nOperands == 2) {
+                                auto &op1 = gp->operands[0];
+                                auto &op2 = gp->operands[1];
+                                if (op1 >= MAX_MASK_QUBITS || op2 >= MAX_MASK_QUBITS) {
+                                    throw Exception("Error : qubit pair (" + to_string(op1) + ", " + to_string(op2) + ") can not be represented in a cc light mask !", false);
+                                }
+                                dqubits.set(op1 * MAX_MASK_QUBITS + op2);
+                            } else {
+                                throw Exception("Error : only 1 and 2 operand instructions are supported by cc light masks !", false);
+                            }
                         }
                     }
 
@@ -477,10 +507,12 @@ Str ir2qisa(
                 }
             }
 
-            if (std::next(secIt) != abundle.parallel_sections.end()) {
+            if (std::next(groupIt) != group_order.end()) {
                 ssinst << " | ";
             }
         }
+        // masks not in a register yet are loaded in-line before the bundle using them
+        ssqisa << gMaskManager.getLoadInstructions();
         if (classical_bundle) {
             if (iname == "fmr") {
                 // based on cclight requirements (section 4.7 eqasm manual),
@@ -506,12 +538,15 @@ Str ir2qisa(
         curr_cycle+=delta;
     }
 
-    auto & lastBundle = bundles2.back();
+    auto & lastBundle = bundles.back();
     Int lbduration = lastBundle.duration_in_cycles;
     if (lbduration > 1) {
         ssqisa << "    qwait " << lbduration << std::endl;
     }
 
+    // leave the mask registers as the next kernel expects them
+    ssqisa << gMaskManager.getRestoreInstructions();
+
     QL_IOUT("Generating CC-Light QISA [Done]");
     return ssqisa.str();
 }
@@ -610,9 +645,9 @@ void cc_light_eqasm_compiler::ccl_decompose_pre_schedule(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    for (auto &kernel : programp->kernels) {
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
         ccl_decompose_pre_schedule_kernel(kernel, platform);
-    }
+    });
 
     report_statistics(programp, platform, "out", passname, "# ");
     report_qasm(programp, platform, "out", passname);
@@ -626,26 +661,24 @@ void cc_light_eqasm_compiler::ccl_decompose_post_schedule(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    for (auto &kernel : programp->kernels) {
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
         QL_IOUT("Decomposing meta-instructions kernel after post-scheduling: " << kernel.name);
         if (!kernel.c.empty()) {
             QL_ASSERT(kernel.cycles_valid);
-            ir::bundles_t bundles = ir::bundler(kernel.c, platform.cycle_time);
+            const ir::bundles_t &bundles = kernel.get_bundles();
             ccl_decompose_post_schedule_bundles(bundles, platform);
             kernel.c = ir::circuiter(bundles);
             QL_ASSERT(kernel.cycles_valid);
         }
-    }
+    });
     report_statistics(programp, platform, "out", passname, "# ");
     report_qasm(programp, platform, "out", passname);
 }
 
 void cc_light_eqasm_compiler::ccl_decompose_post_schedule_bundles(
-    ir::bundles_t &bundles_dst,
+    const ir::bundles_t &bundles,
     const quantum_platform &platform
 ) {
-    auto bundles_src = bundles_dst;
-
     QL_IOUT("Post scheduling decomposition ...");
     if (options::get("cz_mode") == "auto") {
         QL_DOUT("Automatically expanding cz to cz_park ...");
@@ -656,10 +689,10 @@ void cc_light_eqasm_compiler::ccl_decompose_post_schedule_bundles(
 
         // initialize qubitpair2edge map from json description; this is a constant map
         // QL_DOUT("... reading edge definitions from topology");
-        if (platform.topology.count("edges") <= 0) {
+        if (platform.topology->count("edges") <= 0) {
             QL_FATAL("topology[\"edges\"] not defined in configuration file");
         }
-        for (auto &anedge : platform.topology["edges"]) {
+        for (auto &anedge : (*platform.topology)["edges"]) {
             // QL_DOUT("... reading edge definitions from topology src");
             UInt s = anedge["src"];
             // QL_DOUT("... reading edge definitions from topology dst");
@@ -680,7 +713,7 @@ void cc_light_eqasm_compiler::ccl_decompose_post_schedule_bundles(
 
         // initialize edge_detunes_qubits map from json description; this is a constant map
         // QL_DOUT("... initializing internal edge_detunes_qubits map from detuned_qubits resource");
-        auto &constraints = platform.resources["detuned_qubits"]["connection_map"];
+        auto &constraints = (*platform.resources)["detuned_qubits"]["connection_map"];
         for (auto it = constraints.begin(); it != constraints.end(); ++it) {
             UInt edgeNo = stoi(it.key());
             auto &detuned_qubits = it.value();
@@ -690,34 +723,19 @@ void cc_light_eqasm_compiler::ccl_decompose_post_schedule_bundles(
         }
 
         // QL_DOUT("... reading bundles to find candidate two-qubit flux gates");
-        for (
-            auto bundles_src_it = bundles_src.begin(), bundles_dst_it = bundles_dst.begin();
-            bundles_src_it != bundles_src.end() && bundles_dst_it != bundles_dst.end();
-            ++bundles_src_it, ++bundles_dst_it
-        ) {
-            for (
-                auto sec_src_it = bundles_src_it->parallel_sections.begin();
-                sec_src_it != bundles_src_it->parallel_sections.end();
-                ++sec_src_it
-            ) {
-                for (
-                    auto ins_src_it = sec_src_it->begin();
-                    ins_src_it != sec_src_it->end();
-                    ++ins_src_it
-                ) {
-                    auto gp = *ins_src_it;
+        for (const auto &abundle : bundles) {
+            for (auto section : bundles.sections(abundle)) {
+                for (auto gp : section) {
                     // QL_DOUT("... checking gate: " << gp->qasm());
                     Str id = gp->name;
                     Str operation_type{};
                     UInt nOperands = gp->operands.size();
                     if (nOperands == 2) {
                         // QL_DOUT("... is two-qubit gate: " << gp->qasm());
-                        auto it = platform.instruction_map.find(id);
-                        if (it != platform.instruction_map.end()) {
-                            if (platform.instruction_settings[id].count("type") > 0) {
-                                operation_type = platform.instruction_settings[id]["type"].get<Str>();
-                            }
-                        } else {
+                        const instruction_attributes_t *attr = platform.find_instruction_attributes(gp);
+                        if (attr) {
+                            operation_type = attr->type;
+                        } else if (platform.instruction_map->find(id) == platform.instruction_map->end()) {
                             QL_FATAL("custom instruction not found for : " << id << " !");
                         }
 
@@ -748,6 +766,8 @@ void cc_light_eqasm_compiler::ccl_decompose_post_schedule_bundles(
                                     }
                                     id.append("_park");
                                     gp->name = id;
+                                    gp->instruction_id = utils::MAX;
+                                    gp->opcode = NO_OPCODE;
                                     QL_DOUT("Post scheduling decomposition, added parked qubits: " << gp->qasm());
                                 }
                             }
@@ -775,17 +795,36 @@ void cc_light_eqasm_compiler::map(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    mapper::Mapper mapper;  // virgin mapper creation; for role of Init functions, see comment at top of mapper.h
-    mapper.Init(&platform); // platform specifies number of real qubits, i.e. locations for virtual qubits
-
     auto rf = ReportFile(programp, "out", passname);
 
     UInt total_swaps = 0;        // for reporting, data is mapper specific
     UInt total_moves = 0;        // for reporting, data is mapper specific
     Real total_timetaken = 0.0;  // total over kernels of time taken by mapper
-    for (auto &kernel : programp->kernels) {
+    std::mutex totals_mutex;
+
+    // the grid (with its path cache) and the threads to evaluate alternatives with are shared by the mappers
+    // of all kernels; these only read the grid, apart from its path cache, which is thread-safe
+    mapper::Grid grid;
+    grid.Init(&platform);
+    Opt<ThreadPool> selectpool;
+    UInt nselectthreads = mapper::Mapper::SelectThreads();
+    if (nselectthreads > 1) {
+        selectpool.emplace(nselectthreads);
+    }
+    UInt seed = mapper::Mapper::RandomSeed();
+
+    // kernels are mapped independently, each by its own mapper, so that they can be mapped in parallel;
+    // each gets its own seed, so that their random generators don't draw the same numbers
+    Str kernelStatistics = programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &ss) {
         QL_IOUT("Mapping kernel: " << kernel.name);
 
+        mapper::Mapper mapper;  // virgin mapper creation; for role of Init functions, see comment at top of mapper.h
+        mapper.Init(            // platform specifies number of real qubits, i.e. locations for virtual qubits
+            &platform, &grid,
+            selectpool.has_value() ? &*selectpool : nullptr,
+            seed + (&kernel - &programp->kernels[0])
+        );
+
         // compute timetaken, start interval timer here
         Real timetaken = 0.0;
         using namespace std::chrono;
@@ -794,15 +833,12 @@ void cc_light_eqasm_compiler::map(
         mapper.Map(kernel);
         // kernel.qubit_count starts off as number of virtual qubits, i.e. highest indexed qubit minus 1
         // kernel.qubit_count is updated by Map to highest index of real qubits used minus -1
-        programp->qubit_count = platform.qubit_number;
-        // program.qubit_count is updated to platform.qubit_number
 
         // computing timetaken, stop interval timer
         high_resolution_clock::time_point t2 = high_resolution_clock::now();
         duration<Real> time_span = t2 - t1;
         timetaken = time_span.count();
 
-        StrStrm ss;
         report_kernel_statistics(ss, kernel, platform, "# ");
         ss << "# ----- swaps added: " << mapper.nswapsadded << std::endl;
         ss << "# ----- of which moves added: " << mapper.nmovesadded << std::endl;
@@ -812,14 +848,17 @@ void cc_light_eqasm_compiler::map(
         ss << "# ----- realqubit states before mapper:" << mapper.rs_in << std::endl;
         ss << "# ----- realqubit states after mapper:" << mapper.rs_out << std::endl;
         ss << "# ----- time taken: " << timetaken << std::endl;
-        rf << ss.str();
 
+        std::lock_guard<std::mutex> lock(totals_mutex);
         total_swaps += mapper.nswapsadded;
         total_moves += mapper.nmovesadded;
         total_timetaken += timetaken;
+    });
+    programp->qubit_count = platform.qubit_number;
+    // program.qubit_count is updated to platform.qubit_number
+    rf << kernelStatistics;
+    *mapStatistics += kernelStatistics;
 
-        *mapStatistics += ss.str();
-    }
     StrStrm ss;
     report_totals_statistics(ss, programp->kernels, platform, "# ");
     ss << "# Total no. of swaps: " << total_swaps << std::endl;
@@ -838,7 +877,7 @@ void cc_light_eqasm_compiler::ccl_prep_code_generation(
     const quantum_platform &platform,
     const Str &passname
 ) {
-    const Json &instruction_settings = platform.instruction_settings;
+    const Json &instruction_settings = *platform.instruction_settings;
     for (const Json &i : instruction_settings) {
         if (i.count("cc_light_instr") <= 0) {
             QL_FATAL("cc_light_instr not found for " << i);
@@ -932,9 +971,8 @@ void cc_light_eqasm_compiler::compile(quantum_program *programp, const quantum_p
 
     rcschedule(programp, platform, "rcscheduler");
 
-    latency_compensation(programp, platform, "ccl_latency_compensation");
-
-    insert_buffer_delays(programp, platform, "ccl_insert_buffer_delays");
+    // latency compensation and buffer delay insertion, in one pass over each kernel
+    compensate_latency_and_insert_buffer_delays(programp, platform, "ccl_latency_compensation_buffer_delays");
 
     // decompose meta-instructions after scheduling
     ccl_decompose_post_schedule(programp, platform, "ccl_decompose_post_schedule");
@@ -966,6 +1004,13 @@ void cc_light_eqasm_compiler::compile(quantum_program *programp, const quantum_p
     QL_DOUT("Compiling CCLight eQASM [Done]");
 }
 
+gate *cc_light_eqasm_compiler::make_binary_ir_gate(UInt tag, Arena &arena) const {
+    if (tag == BINARY_IR_TAG_CLASSICAL_CC) {
+        return arena.make<classical_cc>("nop", Vec<UInt>());
+    }
+    return nullptr;
+}
+
 /**
  * decompose
  */
@@ -999,29 +1044,29 @@ void cc_light_eqasm_compiler::ccl_decompose_pre_schedule_kernel(
                 (iname == "not") || (iname == "nop")
             ) {
                 // decomp_ckt.push_back(ins);
-                decomp_ckt.push_back(new classical_cc(iname, icopers));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>(iname, icopers));
                 QL_DOUT("    classical instruction decomposed: " << decomp_ckt.back()->qasm());
             } else if (
                 (iname == "eq") || (iname == "ne") || (iname == "lt") ||
                 (iname == "gt") || (iname == "le") || (iname == "ge")
             ) {
-                decomp_ckt.push_back(new classical_cc("cmp", {icopers[1], icopers[2]}));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("cmp", Vec<UInt>{icopers[1], icopers[2]}));
                 QL_DOUT("    classical instruction decomposed: " << decomp_ckt.back()->qasm());
-                decomp_ckt.push_back(new classical_cc("nop", {}));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("nop", Vec<UInt>()));
                 QL_DOUT("                                      " << decomp_ckt.back()->qasm());
-                decomp_ckt.push_back(new classical_cc("fbr_"+iname, {icopers[0]}));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("fbr_"+iname, Vec<UInt>{icopers[0]}));
                 QL_DOUT("                                      " << decomp_ckt.back()->qasm());
             } else if (iname == "mov") {
                 // r28 is used as temp, TODO use creg properly to create temporary
-                decomp_ckt.push_back(new classical_cc("ldi", {28}, 0));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("ldi", Vec<UInt>{28}, 0));
                 QL_DOUT("    classical instruction decomposed: " << decomp_ckt.back()->qasm());
-                decomp_ckt.push_back(new classical_cc("add", {icopers[0], icopers[1], 28}));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("add", Vec<UInt>{icopers[0], icopers[1], 28}));
                 QL_DOUT("                                      " << decomp_ckt.back()->qasm());
             } else if (iname == "ldi") {
                 // auto imval = ((classical_cc*)ins)->int_operand;
                 auto imval = ((classical*)ins)->int_operand;
                 QL_DOUT("    classical instruction decomposed: imval=" << imval);
-                decomp_ckt.push_back(new classical_cc("ldi", {icopers[0]}, imval));
+                decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("ldi", Vec<UInt>{icopers[0]}, imval));
                 QL_DOUT("    classical instruction decomposed: " << decomp_ckt.back()->qasm());
             } else {
                 QL_EOUT("Unknown decomposition of classical operation '" << iname << "' with '" << icopers_count << "' operands!");
@@ -1032,10 +1077,13 @@ void cc_light_eqasm_compiler::ccl_decompose_pre_schedule_kernel(
                 QL_DOUT("    wait instruction ");
                 decomp_ckt.push_back(ins);
             } else {
-                const Json &instruction_settings = platform.instruction_settings;
+                const instruction_attributes_t *attr = platform.find_instruction_attributes(ins);
                 Str operation_type;
-                if (instruction_settings.find(iname) != instruction_settings.end()) {
-                    operation_type = instruction_settings[iname]["type"].get<Str>();
+                if (attr) {
+                    if (!attr->has_type) {
+                        QL_FATAL("JSON file: field 'type' not defined for instruction '" << iname << "'");
+                    }
+                    operation_type = attr->type;
                 } else {
                     QL_EOUT("instruction settings not found for '" << iname << "' with '" << iqopers_count << "' operands!");
                     throw Exception("instruction settings not found for '" + iname + "' with'" + to_string(iqopers_count) + "' operands!", false);
@@ -1050,7 +1098,7 @@ void cc_light_eqasm_compiler::ccl_decompose_pre_schedule_kernel(
                         auto &coperands = ins->creg_operands;
                         if (!coperands.empty()) {
                             auto cop = coperands[0];
-                            decomp_ckt.push_back(new classical_cc("fmr", {cop, qop}));
+                            decomp_ckt.push_back(kernel.gate_arena->make<classical_cc>("fmr", Vec<UInt>{cop, qop}));
                         } else {
                             // WOUT("Unknown classical operand for measure/readout operation: '" << iname <<
                             //     ". This will soon be depricated in favour of measure instruction with fmr" <<
@@ -1216,7 +1264,7 @@ void cc_light_eqasm_compiler::write_quantumsim_program(
         QL_EOUT("relaxation_times is not specified in the hardware config file !");
         throw Exception("[x] error: quantumsim_compiler: relaxation_times is not specified in the hardware config file !", false);
     }
-    UInt count = platform.hardware_settings["qubit_number"];
+    UInt count = (*platform.hardware_settings)["qubit_number"];
 
     // want to ignore unused qubits below
     QL_ASSERT(programp->kernels.size() <= 1);
@@ -1266,22 +1314,22 @@ void cc_light_eqasm_compiler::write_quantumsim_program(
     for (auto &kernel : programp->kernels) {
         QL_DOUT("... adding gates, a new kernel");
         QL_ASSERT(kernel.cycles_valid);
-        ir::bundles_t bundles = ir::bundler(kernel.c, platform.cycle_time);
+        const ir::bundles_t &bundles = kernel.get_bundles();
 
         if (bundles.empty()) {
             QL_IOUT("No bundles for adding gates");
         } else {
-            for (ir::bundle_t &abundle : bundles) {
+            for (const ir::bundle_t &abundle : bundles) {
                 QL_DOUT("... adding gates, a new bundle");
                 auto bcycle = abundle.start_cycle;
 
                 StrStrm ssqs;
-                for(auto secIt = abundle.parallel_sections.begin(); secIt != abundle.parallel_sections.end(); ++secIt) {
+                for (auto section : bundles.sections(abundle)) {
                     QL_DOUT("... adding gates, a new section in a bundle");
-                    for (auto insIt = secIt->begin(); insIt != secIt->end(); ++insIt) {
-                        auto & iname = (*insIt)->name;
-                        auto & operands = (*insIt)->operands;
-                        auto duration = (*insIt)->duration;     // duration in nano-seconds
+                    for (auto gp : section) {
+                        auto & iname = gp->name;
+                        auto & operands = gp->operands;
+                        auto duration = gp->duration;     // duration in nano-seconds
                         // UInt operation_duration = ceil(static_cast<Real>(duration) / platform.cycle_time);
                         if (iname == "measure") {
                             QL_DOUT("... adding gates, a measure");
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include "utils/num.h"
 #include "utils/str.h"
 #include "utils/pair.h"
@@ -21,44 +22,107 @@ namespace arch {
 // eqasm code : set of cc_light_eqasm instructions
 typedef utils::Vec<cc_light_eqasm_instr_t> eqasm_t;
 
-typedef utils::Vec<utils::UInt> qubit_set_t;
-typedef utils::Pair<utils::UInt, utils::UInt> qubit_pair_t;
-typedef utils::Vec<qubit_pair_t> qubit_pair_set_t;
-
 const utils::UInt MAX_S_REG = 32;
 const utils::UInt MAX_T_REG = 64;
 
-QL_GLOBAL extern utils::UInt CurrSRegCount;
-QL_GLOBAL extern utils::UInt CurrTRegCount;
+// qubit indices that can be represented in a mask; two-qubit masks use
+// MAX_MASK_QUBITS^2 bits, one for each ordered pair
+const utils::UInt MAX_MASK_QUBITS = 64;
 
-class Mask {
+/**
+ * Fixed-width bit set representing the operands of a SIMD instruction. Bit i
+ * of a single-qubit mask represents qubit i, bit q1*MAX_MASK_QUBITS+q2 of a
+ * two-qubit mask represents the pair (q1,q2). Set bits are enumerated in
+ * ascending order, which gives the sorted operand lists used by smis/smit.
+ */
+template <utils::UInt N>
+class MaskBits {
 public:
-    utils::UInt regNo = 0;
-    utils::Str regName;
-    qubit_set_t squbits;
-    qubit_pair_set_t dqubits;
-
-    Mask() = default;
-    explicit Mask(const qubit_set_t &qs);
-    Mask(const utils::Str &rn, const qubit_set_t &qs);
-    explicit Mask(const qubit_pair_set_t &qps);
+    static const utils::UInt NUM_WORDS = (N + 63) / 64;
+
+    void set(utils::UInt bit) {
+        words[bit / 64] |= (utils::UInt)1 << (bit % 64);
+    }
+
+    utils::Vec<utils::UInt> bits() const {
+        utils::Vec<utils::UInt> result;
+        for (utils::UInt w = 0; w < NUM_WORDS; w++) {
+            for (utils::UInt word = words[w], bit = w * 64; word; word >>= 1, bit++) {
+                if (word & 1) {
+                    result.push_back(bit);
+                }
+            }
+        }
+        return result;
+    }
+
+    utils::Bool operator<(const MaskBits &rhs) const {
+        return words < rhs.words;
+    }
+
+    utils::Bool operator==(const MaskBits &rhs) const {
+        return words == rhs.words;
+    }
+
+    utils::Bool operator!=(const MaskBits &rhs) const {
+        return words != rhs.words;
+    }
+
+private:
+    std::array<utils::UInt, NUM_WORDS> words{};
 };
 
-class MaskManager {
+typedef MaskBits<MAX_MASK_QUBITS> smask_t;
+typedef MaskBits<MAX_MASK_QUBITS * MAX_MASK_QUBITS> tmask_t;
+
+/**
+ * Contents of one file of mask registers (S or T).
+ *
+ * Masks get a register of their own for as long as there are free registers;
+ * these registers are loaded once at the start of the program. When all
+ * registers are taken, the least recently used register that is not used by
+ * the current bundle is reloaded in-line. Registers reloaded that way are
+ * restored at the end of the kernel, so each kernel starts with the registers
+ * holding their static masks, regardless of the control flow leading to it.
+ */
+template <class M>
+class MaskRegisterFile {
 private:
-    utils::Map<utils::UInt,Mask> SReg2Mask;
-    utils::Map<qubit_set_t,Mask> QS2Mask;
+    utils::UInt size;
+    utils::Vec<M> static_masks;         // indexed by register number
+    utils::Vec<M> live_masks;           // indexed by register number
+    utils::Vec<utils::UInt> last_use;   // bundle stamp of last use per register
+    utils::Map<M, utils::UInt> live_regs;
 
-    utils::Map<utils::UInt,Mask> TReg2Mask;
-    utils::Map<qubit_pair_set_t,Mask> QPS2Mask;
+public:
+    explicit MaskRegisterFile(utils::UInt size);
+
+    // returns the register holding the given mask; sets reloaded when the
+    // register had to be reloaded in-line to do so
+    utils::UInt get(const M &mask, utils::UInt stamp, utils::Bool &reloaded);
+
+    utils::UInt get_static_count() const;
+    const M &get_static_mask(utils::UInt reg) const;
+
+    // restores all registers to their static masks, and returns the
+    // registers that needed it
+    utils::Vec<utils::UInt> restore();
+};
+
+class MaskManager {
+private:
+    MaskRegisterFile<smask_t> sregs;
+    MaskRegisterFile<tmask_t> tregs;
+    utils::UInt stamp = 0;
+    utils::StrStrm loads;
 
 public:
     MaskManager();
-    ~MaskManager();
-    utils::UInt getRegNo(qubit_set_t &qs);
-    utils::UInt getRegNo(qubit_pair_set_t &qps);
-    utils::Str getRegName(qubit_set_t &qs);
-    utils::Str getRegName(qubit_pair_set_t &qps);
+    void beginBundle();
+    utils::Str getRegName(const smask_t &qs);
+    utils::Str getRegName(const tmask_t &qps);
+    utils::Str getLoadInstructions();
+    utils::Str getRestoreInstructions();
     utils::Str getMaskInstructions();
 };
 
@@ -67,16 +131,17 @@ public:
     cmat_t m;
     // utils::Int imm_value;
     classical_cc(const utils::Str &operation, const utils::Vec<utils::UInt> &opers, utils::Int ivalue = 0);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
+    utils::UInt binary_ir_tag() const override;
 };
 
 utils::Str classical_instruction2qisa(classical_cc *classical_in);
 
 // FIXME HvS cc_light_instr is name of attribute in json file, in gate: arch_operation_name, here in instruction_map?
 // FIXME HvS attribute of gate or just in json? Generalization to arch_operation_name is unnecessary
-utils::Str get_cc_light_instruction_name(const utils::Str &id, const quantum_platform &platform);
+utils::Str get_cc_light_instruction_name(gate *g, const quantum_platform &platform);
 
 utils::Str ir2qisa(quantum_kernel &kernel, const quantum_platform &platform, MaskManager &gMaskManager);
 
@@ -97,7 +162,7 @@ public:
 
     void ccl_decompose_pre_schedule(quantum_program *programp, const quantum_platform &platform, const utils::Str &passname);
     void ccl_decompose_post_schedule(quantum_program *programp, const quantum_platform &platform, const utils::Str &passname);
-    static void ccl_decompose_post_schedule_bundles(ir::bundles_t &bundles_dst, const quantum_platform &platform);
+    static void ccl_decompose_post_schedule_bundles(const ir::bundles_t &bundles, const quantum_platform &platform);
     static void map(quantum_program *programp, const quantum_platform &platform, const utils::Str &passname, utils::Str *mapStatistics);
 
     // cc_light_instr is needed by some cc_light backend passes and by cc_light resource_management:
@@ -125,6 +190,9 @@ public:
     // kernel level compilation
     void compile(quantum_program *programp, const quantum_platform &platform) override;
 
+    // recreates the classical_cc gates in binary IR files
+    gate *make_binary_ir_gate(utils::UInt tag, utils::Arena &arena) const override;
+
     /**
      * decompose
      */
@@ -15,25 +15,169 @@ UInt ccl_get_operation_duration(gate *ins, const quantum_platform &platform) {
     return ceil( static_cast<Real>(ins->duration) / platform.cycle_time);
 }
 
+// attributes of the instruction of the gate, compiled by the platform from the configuration file
+static const instruction_attributes_t &ccl_get_attributes(gate *ins, const quantum_platform &platform) {
+    const instruction_attributes_t *attr = platform.find_instruction_attributes(ins);
+    if (!attr) {
+        QL_FATAL("JSON file: instruction not found: '" << ins->name << "'");
+    }
+    return *attr;
+}
+
 // operation type is "mw" (for microwave), "flux", "readout", or "extern" (used for inter-core)
 // it reflects the different resources used to implement the various gates and that resource management must distinguish
 Str ccl_get_operation_type(gate *ins, const quantum_platform &platform) {
-    Str operation_type("cc_light_type");
-    QL_JSON_ASSERT(platform.instruction_settings, ins->name, ins->name);
-    if (!platform.instruction_settings[ins->name]["type"].is_null()) {
-        operation_type = platform.instruction_settings[ins->name]["type"].get<Str>();
-    }
-    return operation_type;
+    const instruction_attributes_t &attr = ccl_get_attributes(ins, platform);
+    return attr.has_type ? attr.type : "cc_light_type";
 }
 
 // operation name is used to know which operations are the same when one qwg steers several qubits using the vsm
 Str ccl_get_operation_name(gate *ins, const quantum_platform &platform) {
-    Str operation_name(ins->name);
-    QL_JSON_ASSERT(platform.instruction_settings, ins->name, ins->name);
-    if (!platform.instruction_settings[ins->name]["cc_light_instr"].is_null()) {
-        operation_name = platform.instruction_settings[ins->name]["cc_light_instr"].get<Str>();
+    const instruction_attributes_t &attr = ccl_get_attributes(ins, platform);
+    return attr.has_cc_light_instr ? attr.cc_light_instr : ins->name;
+}
+
+// interned operation type from the type string in the configuration file
+static ccl_operation_type_t ccl_intern_operation_type(const Str &operation_type) {
+    if (operation_type == "mw") return ccl_type_mw;
+    if (operation_type == "flux") return ccl_type_flux;
+    if (operation_type == "readout") return ccl_type_readout;
+    if (operation_type == "extern") return ccl_type_extern;
+    return ccl_type_other;
+}
+
+const UInt ccl_operation_table_t::NO_NAME;
+const UInt ccl_edge_table_t::NO_EDGE;
+
+ccl_operation_table_t::ccl_operation_table_t(const quantum_platform &platform) {
+    Map<Str, UInt> name_ids;
+    name_ids.set("") = NO_NAME;
+    for (const auto &attr : platform.instruction_attributes) {
+        Str operation_type = attr.has_type ? attr.type : "cc_light_type";
+        const Str &operation_name = attr.has_cc_light_instr ? attr.cc_light_instr : attr.name;
+
+        auto id_it = name_ids.find(operation_name);
+        UInt name_id;
+        if (id_it != name_ids.end()) {
+            name_id = id_it->second;
+        } else {
+            name_id = name_ids.size();
+            name_ids.set(operation_name) = name_id;
+        }
+        info.push_back({ccl_intern_operation_type(operation_type), name_id});
+    }
+}
+
+const ccl_operation_info_t &ccl_operation_table_t::get(gate *ins, const quantum_platform &platform) const {
+    UInt id = platform.find_instruction_id(ins);
+    if (id >= info.size()) {
+        QL_FATAL("JSON file: instruction not found: '" << ins->name << "'");
+    }
+    return info[id];
+}
+
+ccl_edge_table_t::ccl_edge_table_t(const quantum_platform &platform) {
+    if (platform.topology->count("edges") <= 0) {
+        QL_FATAL("topology[\"edges\"] not defined in configuration file");
+    }
+    nqubits = platform.qubit_number;
+    for (auto &anedge : (*platform.topology)["edges"]) {
+        UInt s = anedge["src"];
+        UInt d = anedge["dst"];
+        nqubits = max(nqubits, max(s, d) + 1);
+    }
+    edges.assign(nqubits * nqubits, NO_EDGE);
+    for (auto &anedge : (*platform.topology)["edges"]) {
+        UInt s = anedge["src"];
+        UInt d = anedge["dst"];
+        UInt e = anedge["id"];
+
+        if (edges[s*nqubits + d] != NO_EDGE) {
+            QL_EOUT("re-defining edge " << s << "->" << d << " !");
+            throw Exception("[x] Error : re-defining edge !", false);
+        } else {
+            edges[s*nqubits + d] = e;
+        }
+    }
+}
+
+// dense version of the "connection_map" of a resource mapping a qubit to a qwg/meas unit
+static std::shared_ptr<const Vec<UInt>> ccl_qubit_connection_map(const quantum_platform &platform, const Str &name) {
+    auto qubit2unit = std::make_shared<Vec<UInt>>();
+    auto &constraints = (*platform.resources)[name]["connection_map"];
+    for (auto it = constraints.cbegin(); it != constraints.cend(); ++it) {
+        UInt unitNo = stoi( it.key() );
+        auto & connected_qubits = it.value();
+        for (auto &q_json : connected_qubits) {
+            UInt q = q_json;
+            if (q >= qubit2unit->size()) {
+                qubit2unit->resize(q + 1, MAX);
+            }
+            (*qubit2unit)[q] = unitNo;
+        }
+    }
+    return qubit2unit;
+}
+
+// lookup in a table built by ccl_qubit_connection_map
+static UInt ccl_qubit_connection(const Vec<UInt> &qubit2unit, UInt q, const Str &name) {
+    if (q >= qubit2unit.size() || qubit2unit[q] == MAX) {
+        throw Exception("qubit " + to_string(q) + " does not exist in connection_map of resource " + name);
+    }
+    return qubit2unit[q];
+}
+
+// dense version of a "connection_map" mapping an edge to a list of edges or qubits
+static std::shared_ptr<const Vec<Vec<UInt>>> ccl_edge_connection_map(const quantum_platform &platform, const Str &name, Bool invert) {
+    auto edge2list = std::make_shared<Vec<Vec<UInt>>>();
+    auto &constraints = (*platform.resources)[name]["connection_map"];
+    for (auto it = constraints.cbegin(); it != constraints.cend(); ++it) {
+        // COUT(it.key() << " : " << it.value() << "\n");
+        UInt keyNo = stoi( it.key() );
+        for (auto &v_json : it.value()) {
+            UInt v = v_json;
+            UInt from = invert ? v : keyNo;
+            UInt to = invert ? keyNo : v;
+            if (from >= edge2list->size()) {
+                edge2list->resize(from + 1);
+            }
+            (*edge2list)[from].push_back(to);
+        }
+    }
+    return edge2list;
+}
+
+// entry of a table built by ccl_edge_connection_map, empty if not there
+static const Vec<UInt> &ccl_edge_connection(const Vec<Vec<UInt>> &edge2list, UInt e) {
+    static const Vec<UInt> none;
+    return e < edge2list.size() ? edge2list[e] : none;
+}
+
+// helpers for next_available:
+// first cycle from op_start_cycle on at which an operation of the given duration can start
+// on a resource that is busy till cycle bound (forward), or from cycle bound (backward)
+static UInt ccl_free_at(scheduling_direction_t dir, UInt op_start_cycle, UInt operation_duration, UInt bound) {
+    if (forward_scheduling == dir) {
+        return max(op_start_cycle, bound);
+    }
+    if (op_start_cycle + operation_duration <= bound) {
+        return op_start_cycle;
     }
-    return operation_name;
+    return bound >= operation_duration ? bound - operation_duration : 0;
+}
+
+// the later of two cycles in the scheduling direction
+static UInt ccl_later(scheduling_direction_t dir, UInt cycle1, UInt cycle2) {
+    return forward_scheduling == dir ? max(cycle1, cycle2) : min(cycle1, cycle2);
+}
+
+// bound of a resource that is busy from fromcycle to tocycle with an operation,
+// and that can be shared by a new operation with the same operation
+static UInt ccl_busy_bound(scheduling_direction_t dir, UInt fromcycle, UInt tocycle, Bool same_operation) {
+    if (forward_scheduling == dir) {
+        return same_operation ? fromcycle : max(fromcycle, tocycle);
+    }
+    return same_operation ? tocycle : min(fromcycle, tocycle);
 }
 
 ccl_qubit_resource_t::ccl_qubit_resource_t(
@@ -43,7 +187,7 @@ ccl_qubit_resource_t::ccl_qubit_resource_t(
     resource_t("qubits", dir)
 {
     // QL_DOUT("... creating " << name << " resource");
-    count = platform.resources[name]["count"];
+    count = (*platform.resources)[name]["count"];
     state.resize(count);
     for (UInt q = 0; q < count; q++) {
         state[q] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
@@ -66,7 +210,6 @@ Bool ccl_qubit_resource_t::available(
     const quantum_platform &platform
 ) {
     UInt operation_duration = ccl_get_operation_duration(ins, platform);
-    Str operation_type = ccl_get_operation_type(ins, platform);
 
     for (auto q : ins->operands) {
         if (forward_scheduling == direction) {
@@ -87,12 +230,24 @@ Bool ccl_qubit_resource_t::available(
     return true;
 }
 
+UInt ccl_qubit_resource_t::next_available(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    UInt operation_duration = ccl_get_operation_duration(ins, platform);
+    UInt cycle = op_start_cycle;
+    for (auto q : ins->operands) {
+        cycle = ccl_later(direction, cycle, ccl_free_at(direction, op_start_cycle, operation_duration, state[q]));
+    }
+    return cycle;
+}
+
 void ccl_qubit_resource_t::reserve(
     UInt op_start_cycle,
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
     UInt operation_duration = ccl_get_operation_duration(ins, platform);
 
     for (auto q : ins->operands) {
@@ -105,28 +260,24 @@ ccl_qwg_resource_t::ccl_qwg_resource_t(
     const quantum_platform &platform,
     scheduling_direction_t dir
 ) :
-    resource_t("qwgs", dir)
+    ccl_qwg_resource_t(platform, dir, std::make_shared<const ccl_operation_table_t>(platform))
 {
-    // QL_DOUT("... creating " << name << " resource");
-    count = platform.resources[name]["count"];
-    fromcycle.resize(count);
-    tocycle.resize(count);
-    operations.resize(count);
+}
 
-    for (UInt i = 0; i < count; i++) {
-        fromcycle[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-        tocycle[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-        operations[i] = "";
-    }
-    auto & constraints = platform.resources[name]["connection_map"];
-    for (auto it = constraints.cbegin(); it != constraints.cend(); ++it) {
-        // COUT(it.key() << " : " << it.value() );
-        UInt qwgNo = stoi( it.key() );
-        auto & connected_qubits = it.value();
-        for (auto &q : connected_qubits) {
-            qubit2qwg.set(q) = qwgNo;
-        }
-    }
+ccl_qwg_resource_t::ccl_qwg_resource_t(
+    const quantum_platform &platform,
+    scheduling_direction_t dir,
+    const std::shared_ptr<const ccl_operation_table_t> &operation_table
+) :
+    resource_t("qwgs", dir),
+    operation_table(operation_table)
+{
+    // QL_DOUT("... creating " << name << " resource");
+    count = (*platform.resources)[name]["count"];
+    fromcycle.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
+    tocycle.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
+    operations.assign(count, ccl_operation_table_t::NO_NAME);
+    qubit2qwg = ccl_qubit_connection_map(platform, name);
 }
 
 ccl_qwg_resource_t *ccl_qwg_resource_t::clone() const & {
@@ -144,26 +295,25 @@ Bool ccl_qwg_resource_t::available(
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    Str operation_name = ccl_get_operation_name(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    Bool is_mw = (operation_type == "mw");
-    if (is_mw) {
+    if (operation.type == ccl_type_mw) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         for (auto q : ins->operands) {
-            QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << "  qwg: " << qubit2qwg.at(q) << " is busy from cycle: " << fromcycle[qubit2qwg.at(q)] << " to cycle: " << tocycle[qubit2qwg.at(q)] << " for operation: " << operations[qubit2qwg.at(q)]);
+            UInt qwg = ccl_qubit_connection(*qubit2qwg, q, name);
+            QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << "  qwg: " << qwg << " is busy from cycle: " << fromcycle[qwg] << " to cycle: " << tocycle[qwg] << " for operation: " << operations[qwg]);
             if (direction == forward_scheduling) {
                 if (
-                    op_start_cycle < fromcycle[qubit2qwg.at(q)]
-                    || (op_start_cycle < tocycle[qubit2qwg.at(q)] && operations[qubit2qwg.at(q)] != operation_name)
+                    op_start_cycle < fromcycle[qwg]
+                    || (op_start_cycle < tocycle[qwg] && operations[qwg] != operation.name_id)
                 ) {
                     QL_DOUT("    " << name << " resource busy ...");
                     return false;
                 }
             } else {
                 if (
-                    op_start_cycle + operation_duration > tocycle[qubit2qwg.at(q)]
-                    || ( op_start_cycle + operation_duration > fromcycle[qubit2qwg.at(q)] && operations[qubit2qwg.at(q)] != operation_name)
+                    op_start_cycle + operation_duration > tocycle[qwg]
+                    || ( op_start_cycle + operation_duration > fromcycle[qwg] && operations[qwg] != operation.name_id)
                 ) {
                     QL_DOUT("    " << name << " resource busy ...");
                     return false;
@@ -175,36 +325,54 @@ Bool ccl_qwg_resource_t::available(
     return true;
 }
 
+UInt ccl_qwg_resource_t::next_available(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+    UInt cycle = op_start_cycle;
+
+    if (operation.type == ccl_type_mw) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
+        for (auto q : ins->operands) {
+            UInt qwg = ccl_qubit_connection(*qubit2qwg, q, name);
+            UInt bound = ccl_busy_bound(direction, fromcycle[qwg], tocycle[qwg], operations[qwg] == operation.name_id);
+            cycle = ccl_later(direction, cycle, ccl_free_at(direction, op_start_cycle, operation_duration, bound));
+        }
+    }
+    return cycle;
+}
+
 void ccl_qwg_resource_t::reserve(
     UInt op_start_cycle,
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    Str operation_name = ccl_get_operation_name(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    Bool is_mw = operation_type == "mw";
-    if (is_mw) {
+    if (operation.type == ccl_type_mw) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         for (auto q : ins->operands) {
+            UInt qwg = ccl_qubit_connection(*qubit2qwg, q, name);
             if (direction == forward_scheduling) {
-                if (operations[qubit2qwg.at(q)] == operation_name) {
-                    tocycle[qubit2qwg.at(q)] = max(tocycle[qubit2qwg.at(q)], op_start_cycle + operation_duration);
+                if (operations[qwg] == operation.name_id) {
+                    tocycle[qwg] = max(tocycle[qwg], op_start_cycle + operation_duration);
                 } else {
-                    fromcycle[qubit2qwg.at(q)] = op_start_cycle;
-                    tocycle[qubit2qwg.at(q)] = op_start_cycle + operation_duration;
-                    operations[qubit2qwg.at(q)] = operation_name;
+                    fromcycle[qwg] = op_start_cycle;
+                    tocycle[qwg] = op_start_cycle + operation_duration;
+                    operations[qwg] = operation.name_id;
                 }
             } else {
-                if (operations[qubit2qwg.at(q)] == operation_name) {
-                    fromcycle[qubit2qwg.at(q)] = min(fromcycle[qubit2qwg.at(q)], op_start_cycle);
+                if (operations[qwg] == operation.name_id) {
+                    fromcycle[qwg] = min(fromcycle[qwg], op_start_cycle);
                 } else {
-                    fromcycle[qubit2qwg.at(q)] = op_start_cycle;
-                    tocycle[qubit2qwg.at(q)] = op_start_cycle + operation_duration;
-                    operations[qubit2qwg.at(q)] = operation_name;
+                    fromcycle[qwg] = op_start_cycle;
+                    tocycle[qwg] = op_start_cycle + operation_duration;
+                    operations[qwg] = operation.name_id;
                 }
             }
-            QL_DOUT("reserved " << name << ". op_start_cycle: " << op_start_cycle << " qwg: " << qubit2qwg.at(q) << " reserved from cycle: " << fromcycle[qubit2qwg.at(q)] << " to cycle: " << tocycle[qubit2qwg.at(q)] << " for operation: " << operations[qubit2qwg.at(q)]);
+            QL_DOUT("reserved " << name << ". op_start_cycle: " << op_start_cycle << " qwg: " << qwg << " reserved from cycle: " << fromcycle[qwg] << " to cycle: " << tocycle[qwg] << " for operation: " << ins->name);
         }
     }
 }
@@ -213,26 +381,23 @@ ccl_meas_resource_t::ccl_meas_resource_t(
     const quantum_platform &platform,
     scheduling_direction_t dir
 ) :
-    resource_t("meas_units", dir)
+    ccl_meas_resource_t(platform, dir, std::make_shared<const ccl_operation_table_t>(platform))
+{
+}
+
+ccl_meas_resource_t::ccl_meas_resource_t(
+    const quantum_platform &platform,
+    scheduling_direction_t dir,
+    const std::shared_ptr<const ccl_operation_table_t> &operation_table
+) :
+    resource_t("meas_units", dir),
+    operation_table(operation_table)
 {
     // QL_DOUT("... creating " << name << " resource");
-    count = platform.resources[name]["count"];
-    fromcycle.resize(count);
-    tocycle.resize(count);
-
-    for (UInt i=0; i<count; i++) {
-        fromcycle[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-        tocycle[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-    }
-    auto &constraints = platform.resources[name]["connection_map"];
-    for (auto it = constraints.begin(); it != constraints.end(); ++it) {
-        // COUT(it.key() << " : " << it.value());
-        UInt measUnitNo = stoi( it.key() );
-        auto & connected_qubits = it.value();
-        for (auto &q : connected_qubits) {
-            qubit2meas.set(q) = measUnitNo;
-        }
-    }
+    count = (*platform.resources)[name]["count"];
+    fromcycle.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
+    tocycle.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
+    qubit2meas = ccl_qubit_connection_map(platform, name);
 }
 
 ccl_meas_resource_t *ccl_meas_resource_t::clone() const & {
@@ -250,27 +415,27 @@ Bool ccl_meas_resource_t::available(
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    Bool is_measure = (operation_type == "readout");
-    if (is_measure) {
+    if (operation.type == ccl_type_readout) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         for (auto q : ins->operands) {
-            QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << "  meas: " << qubit2meas.at(q) << " is busy from cycle: " << fromcycle[qubit2meas.at(q)] << " to cycle: " << tocycle[qubit2meas.at(q)] );
+            UInt meas = ccl_qubit_connection(*qubit2meas, q, name);
+            QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << "  meas: " << meas << " is busy from cycle: " << fromcycle[meas] << " to cycle: " << tocycle[meas] );
             if (direction == forward_scheduling) {
-                if (op_start_cycle != fromcycle[qubit2meas.at(q)]) {
+                if (op_start_cycle != fromcycle[meas]) {
                     // If current measurement on same measurement-unit does not start in the
                     // same cycle, then it should wait for current measurement to finish
-                    if (op_start_cycle < tocycle[qubit2meas.at(q)]) {
+                    if (op_start_cycle < tocycle[meas]) {
                         QL_DOUT("    " << name << " resource busy ...");
                         return false;
                     }
                 }
             } else {
-                if (op_start_cycle != fromcycle[qubit2meas.at(q)]) {
+                if (op_start_cycle != fromcycle[meas]) {
                     // If current measurement on same measurement-unit does not start in the
                     // same cycle, then it should wait until it would finish at start of or earlier than current measurement
-                    if (op_start_cycle + operation_duration > fromcycle[qubit2meas.at(q)]) {
+                    if (op_start_cycle + operation_duration > fromcycle[meas]) {
                         QL_DOUT("    " << name << " resource busy ...");
                         return false;
                     }
@@ -282,20 +447,49 @@ Bool ccl_meas_resource_t::available(
     return true;
 }
 
+// a measurement unit is available at the start cycle of the current measurement and from its end on,
+// so when busy, the next cycle at which it is available is the former when that still is to come
+UInt ccl_meas_resource_t::next_available(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+    UInt cycle = op_start_cycle;
+
+    if (operation.type == ccl_type_readout) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
+        for (auto q : ins->operands) {
+            UInt meas = ccl_qubit_connection(*qubit2meas, q, name);
+            if (op_start_cycle == fromcycle[meas]) {
+                continue;
+            }
+            UInt next_cycle;
+            if (direction == forward_scheduling) {
+                next_cycle = (op_start_cycle < fromcycle[meas] && fromcycle[meas] < tocycle[meas]) ? fromcycle[meas] : max(op_start_cycle, tocycle[meas]);
+            } else {
+                next_cycle = op_start_cycle > fromcycle[meas] ? fromcycle[meas] : ccl_free_at(direction, op_start_cycle, operation_duration, fromcycle[meas]);
+            }
+            cycle = ccl_later(direction, cycle, next_cycle);
+        }
+    }
+    return cycle;
+}
+
 void ccl_meas_resource_t::reserve(
     UInt op_start_cycle,
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    Bool is_measure = (operation_type == "readout");
-    if (is_measure) {
+    if (operation.type == ccl_type_readout) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         for (auto q : ins->operands) {
-            fromcycle[qubit2meas.at(q)] = op_start_cycle;
-            tocycle[qubit2meas.at(q)] = op_start_cycle + operation_duration;
-            QL_DOUT("reserved " << name << ". op_start_cycle: " << op_start_cycle << " meas: " << qubit2meas.at(q) << " reserved from cycle: " << fromcycle[qubit2meas.at(q)] << " to cycle: " << tocycle[qubit2meas.at(q)]);
+            UInt meas = ccl_qubit_connection(*qubit2meas, q, name);
+            fromcycle[meas] = op_start_cycle;
+            tocycle[meas] = op_start_cycle + operation_duration;
+            QL_DOUT("reserved " << name << ". op_start_cycle: " << op_start_cycle << " meas: " << meas << " reserved from cycle: " << fromcycle[meas] << " to cycle: " << tocycle[meas]);
         }
     }
 }
@@ -304,46 +498,29 @@ ccl_edge_resource_t::ccl_edge_resource_t(
     const quantum_platform &platform,
     scheduling_direction_t dir
 ) :
-    resource_t("edges", dir)
+    ccl_edge_resource_t(platform, dir, std::make_shared<const ccl_operation_table_t>(platform))
 {
-    // QL_DOUT("... creating " << name << " resource");
-    count = platform.resources[name]["count"];
-    state.resize(count);
-
-    for (UInt i = 0; i < count; i++) {
-        state[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-    }
+}
 
-    if (platform.topology.count("edges") <= 0) {
-        QL_FATAL("topology[\"edges\"] not defined in configuration file");
-    }
-    for (auto &anedge : platform.topology["edges"]) {
-        UInt s = anedge["src"];
-        UInt d = anedge["dst"];
-        UInt e = anedge["id"];
+ccl_edge_resource_t::ccl_edge_resource_t(
+    const quantum_platform &platform,
+    scheduling_direction_t dir,
+    const std::shared_ptr<const ccl_operation_table_t> &operation_table
+) :
+    resource_t("edges", dir),
+    operation_table(operation_table)
+{
+    // QL_DOUT("... creating " << name << " resource");
+    count = (*platform.resources)[name]["count"];
+    state.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
 
-        qubits_pair_t aqpair(s,d);
-        auto it = qubits2edge.find(aqpair);
-        if (it != qubits2edge.end()) {
-            QL_EOUT("re-defining edge " << s << "->" << d << " !");
-            throw Exception("[x] Error : re-defining edge !", false);
-        } else {
-            qubits2edge.set(aqpair) = e;
-        }
-    }
+    qubits2edge = std::make_shared<const ccl_edge_table_t>(platform);
 
-    if (platform.resources[name].count("connection_map") <= 0) {
+    if ((*platform.resources)[name].count("connection_map") <= 0) {
         QL_FATAL("resources[[\"edges\"][\"connection_map\"] not defined in configuration file");
     }
-    auto &constraints = platform.resources[name]["connection_map"];
-    for (auto it = constraints.cbegin(); it != constraints.cend(); ++it) {
-        // COUT(it.key() << " : " << it.value() << "\n");
-        UInt edgeNo = stoi( it.key() );
-        auto &connected_edges = it.value();
-        for (auto &e : connected_edges) {
-            edge2edges.set(e).push_back(edgeNo);
-        }
-    }
+    // NB: the connection map lists for each edge the edges that it blocks, so it is inverted here
+    edge2edges = ccl_edge_connection_map(platform, name, true);
 }
 
 ccl_edge_resource_t *ccl_edge_resource_t::clone() const & {
@@ -361,12 +538,10 @@ Bool ccl_edge_resource_t::available(
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    auto gname = ins->name;
-    Bool is_flux = (operation_type == "flux");
-    if (is_flux) {
+    if (operation.type == ccl_type_flux) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         auto nopers = ins->operands.size();
         if (nopers == 1) {
             // single qubit flux operation does not reserve an edge resource
@@ -374,16 +549,14 @@ Bool ccl_edge_resource_t::available(
         } else if (nopers == 2) {
             auto q0 = ins->operands[0];
             auto q1 = ins->operands[1];
-            qubits_pair_t aqpair(q0, q1);
-            auto it = qubits2edge.find(aqpair);
-            if (it != qubits2edge.end()) {
-                auto edge_no = qubits2edge.at(aqpair);
-
+            UInt edge_no = qubits2edge->get(q0, q1);
+            if (edge_no != ccl_edge_table_t::NO_EDGE) {
                 QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << ", edge: " << edge_no << " is busy till/from cycle : " << state[edge_no] << " for operation: " << ins->name);
 
-                Vec<UInt> edges2check(edge2edges.get(edge_no));
-                edges2check.push_back(edge_no);
-                for (auto &e : edges2check) {
+                // check the edges that edge_no blocks, and edge_no itself
+                const Vec<UInt> &edges2check = ccl_edge_connection(*edge2edges, edge_no);
+                for (UInt i = 0; i <= edges2check.size(); i++) {
+                    UInt e = i < edges2check.size() ? edges2check[i] : edge_no;
                     if (direction == forward_scheduling) {
                         if (op_start_cycle < state[e]) {
                             QL_DOUT("    " << name << " resource busy ...");
@@ -407,35 +580,52 @@ Bool ccl_edge_resource_t::available(
     return true;
 }
 
-void ccl_edge_resource_t::reserve(
+UInt ccl_edge_resource_t::next_available(
     UInt op_start_cycle,
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+    if (operation.type != ccl_type_flux) {
+        return op_start_cycle;
+    }
+    if (ins->operands.size() != 2 || qubits2edge->get(ins->operands[0], ins->operands[1]) == ccl_edge_table_t::NO_EDGE) {
+        // let available report what is wrong, or accept single qubit flux operations
+        return resource_t::next_available(op_start_cycle, ins, platform);
+    }
+
     UInt operation_duration = ccl_get_operation_duration(ins, platform);
+    UInt edge_no = qubits2edge->get(ins->operands[0], ins->operands[1]);
+    UInt cycle = ccl_later(direction, op_start_cycle, ccl_free_at(direction, op_start_cycle, operation_duration, state[edge_no]));
+    for (auto e : ccl_edge_connection(*edge2edges, edge_no)) {
+        cycle = ccl_later(direction, cycle, ccl_free_at(direction, op_start_cycle, operation_duration, state[e]));
+    }
+    return cycle;
+}
 
-    auto gname = ins->name;
-    Bool is_flux = (operation_type == "flux");
-    if (is_flux) {
+void ccl_edge_resource_t::reserve(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+
+    if (operation.type == ccl_type_flux) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         auto nopers = ins->operands.size();
         if (nopers == 1) {
             // single qubit flux operation does not reserve an edge resource
         } else if (nopers == 2) {
             auto q0 = ins->operands[0];
             auto q1 = ins->operands[1];
-            qubits_pair_t aqpair(q0, q1);
-            auto edge_no = qubits2edge.at(aqpair);
-            if (direction == forward_scheduling) {
-                state[edge_no] = op_start_cycle + operation_duration;
-                for (auto &e : edge2edges.get(edge_no)) {
-                    state[e] = op_start_cycle + operation_duration;
-                }
-            } else {
-                state[edge_no] = op_start_cycle;
-                for (auto &e : edge2edges.get(edge_no)) {
-                    state[e] = op_start_cycle;
-                }
+            UInt edge_no = qubits2edge->get(q0, q1);
+            if (edge_no == ccl_edge_table_t::NO_EDGE) {
+                QL_FATAL("Use of illegal edge: " << q0 << "->" << q1 << " in operation: " << ins->name << " !");
+            }
+            UInt cycle = (direction == forward_scheduling ? op_start_cycle + operation_duration : op_start_cycle);
+            state[edge_no] = cycle;
+            for (auto e : ccl_edge_connection(*edge2edges, edge_no)) {
+                state[e] = cycle;
             }
             QL_DOUT("reserved " << name << ". op_start_cycle: " << op_start_cycle << " edge: " << edge_no << " reserved till cycle: " << state[ edge_no ] << " for operation: " << ins->name);
         } else {
@@ -448,53 +638,34 @@ ccl_detuned_qubits_resource_t::ccl_detuned_qubits_resource_t(
     const quantum_platform &platform,
     scheduling_direction_t dir
 ) :
-    resource_t("detuned_qubits", dir)
+    ccl_detuned_qubits_resource_t(platform, dir, std::make_shared<const ccl_operation_table_t>(platform))
+{
+}
+
+ccl_detuned_qubits_resource_t::ccl_detuned_qubits_resource_t(
+    const quantum_platform &platform,
+    scheduling_direction_t dir,
+    const std::shared_ptr<const ccl_operation_table_t> &operation_table
+) :
+    resource_t("detuned_qubits", dir),
+    operation_table(operation_table)
 {
     // QL_DOUT("... creating " << name << " resource");
-    count = platform.resources[name]["count"];
-    fromcycle.resize(count);
-    tocycle.resize(count);
-    operations.resize(count);
+    count = (*platform.resources)[name]["count"];
 
     // initialize resource state machine to be free for all qubits
-    for (UInt i = 0; i < count; i++) {
-        fromcycle[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-        tocycle[i] = (forward_scheduling == dir ? 0 : MAX_CYCLE);
-        operations[i] = "";
-    }
+    fromcycle.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
+    tocycle.assign(count, forward_scheduling == dir ? 0 : MAX_CYCLE);
+    operations.assign(count, ccl_type_none);
 
     // initialize qubitpair2edge map from json description; this is a constant map
-    if (platform.topology.count("edges") <= 0) {
-        QL_FATAL("topology[\"edges\"] not defined in configuration file");
-    }
-    for (auto &anedge : platform.topology["edges"]) {
-        UInt s = anedge["src"];
-        UInt d = anedge["dst"];
-        UInt e = anedge["id"];
-
-        qubits_pair_t aqpair(s,d);
-        auto it = qubitpair2edge.find(aqpair);
-        if (it != qubitpair2edge.end()) {
-            QL_EOUT("re-defining edge " << s << "->" << d << " !");
-            throw Exception("[x] Error : re-defining edge !", false);
-        } else {
-            qubitpair2edge.set(aqpair) = e;
-        }
-    }
+    qubitpair2edge = std::make_shared<const ccl_edge_table_t>(platform);
 
     // initialize edge_detunes_qubits map from json description; this is a constant map
-    if (platform.resources[name].count("connection_map") <= 0) {
+    if ((*platform.resources)[name].count("connection_map") <= 0) {
         QL_FATAL("resources[[\"detuned_qubits\"][\"connection_map\"] not defined in configuration file");
     }
-    auto &constraints = platform.resources[name]["connection_map"];
-    for (auto it = constraints.cbegin(); it != constraints.cend(); ++it) {
-        // COUT(it.key() << " : " << it.value() << "\n");
-        UInt edgeNo = stoi( it.key() );
-        auto & detuned_qubits = it.value();
-        for (auto & q : detuned_qubits) {
-            edge_detunes_qubits.set(edgeNo).push_back(q);
-        }
-    }
+    edge_detunes_qubits = ccl_edge_connection_map(platform, name, false);
 }
 
 ccl_detuned_qubits_resource_t *ccl_detuned_qubits_resource_t::clone() const & {
@@ -514,11 +685,16 @@ Bool ccl_detuned_qubits_resource_t::available(
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+    UInt operation_type = operation.type;
+
+    Bool is_flux = operation.type == ccl_type_flux;
+    Bool is_mw = operation.type == ccl_type_mw;
+    if (!is_flux && !is_mw) {
+        return true;
+    }
+    UInt operation_duration = ccl_get_operation_duration(ins, platform);
 
-    auto gname = ins->name;
-    Bool is_flux = operation_type == "flux";
     if (is_flux) {
         auto nopers = ins->operands.size();
         if (nopers == 1) {
@@ -527,12 +703,9 @@ Bool ccl_detuned_qubits_resource_t::available(
         } else if (nopers == 2) {
             auto q0 = ins->operands[0];
             auto q1 = ins->operands[1];
-            qubits_pair_t aqpair(q0, q1);
-            auto it = qubitpair2edge.find(aqpair);
-            if (it != qubitpair2edge.end()) {
-                auto edge_no = qubitpair2edge.at(aqpair);
-
-                for (auto &q : edge_detunes_qubits.get(edge_no)) {
+            UInt edge_no = qubitpair2edge->get(q0, q1);
+            if (edge_no != ccl_edge_table_t::NO_EDGE) {
+                for (auto &q : ccl_edge_connection(*edge_detunes_qubits, edge_no)) {
                     QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << ", edge: " << edge_no << " detuning qubit: " << q << " for operation: " << ins->name << " busy from: " << fromcycle[q] << " till: " << tocycle[q] << " with operation_type: " << operation_type);
                     if (direction == forward_scheduling) {
                         if (
@@ -561,7 +734,6 @@ Bool ccl_detuned_qubits_resource_t::available(
         }
     }
 
-    Bool is_mw = operation_type == "mw";
     if (is_mw) {
         for (auto q : ins->operands) {
             QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle << ", qubit: " << q << " for operation: " << ins->name << " busy from: " << fromcycle[q] << " till: " << tocycle[q] << " with operation_type: " << operation_type);
@@ -586,10 +758,63 @@ Bool ccl_detuned_qubits_resource_t::available(
             }
         }
     }
-    if (is_flux || is_mw) QL_DOUT("    " << name << " resource available ...");
+    QL_DOUT("    " << name << " resource available ...");
     return true;
 }
 
+UInt ccl_detuned_qubits_resource_t::next_available(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+    UInt operation_type = operation.type;
+    UInt operation_duration = ccl_get_operation_duration(ins, platform);
+    UInt cycle = op_start_cycle;
+
+    if (operation.type == ccl_type_flux) {
+        if (ins->operands.size() == 1) {
+            return op_start_cycle;
+        }
+        if (ins->operands.size() != 2 || qubitpair2edge->get(ins->operands[0], ins->operands[1]) == ccl_edge_table_t::NO_EDGE) {
+            // let available report what is wrong
+            return resource_t::next_available(op_start_cycle, ins, platform);
+        }
+        UInt edge_no = qubitpair2edge->get(ins->operands[0], ins->operands[1]);
+        for (auto q : ccl_edge_connection(*edge_detunes_qubits, edge_no)) {
+            UInt bound = ccl_busy_bound(direction, fromcycle[q], tocycle[q], operations[q] == operation_type);
+            cycle = ccl_later(direction, cycle, ccl_free_at(direction, op_start_cycle, operation_duration, bound));
+        }
+    } else if (operation.type == ccl_type_mw) {
+        for (auto q : ins->operands) {
+            UInt bound = ccl_busy_bound(direction, fromcycle[q], tocycle[q], operations[q] == operation_type);
+            cycle = ccl_later(direction, cycle, ccl_free_at(direction, op_start_cycle, operation_duration, bound));
+        }
+    }
+    return cycle;
+}
+
+// reserve qubit q of detuned_qubits for an operation of the given (interned) type
+void ccl_detuned_qubits_resource_t::reserve_qubit(UInt q, UInt op_start_cycle, UInt operation_duration, UInt operation_type) {
+    if (direction == forward_scheduling) {
+        if (operations[q] == operation_type) {
+            tocycle[q] = max(tocycle[q], op_start_cycle + operation_duration);
+        } else {
+            fromcycle[q] = op_start_cycle;
+            tocycle[q] = op_start_cycle + operation_duration;
+            operations[q] = operation_type;
+        }
+    } else {
+        if (operations[q] == operation_type) {
+            fromcycle[q] = min(fromcycle[q], op_start_cycle);
+        } else {
+            fromcycle[q] = op_start_cycle;
+            tocycle[q] = op_start_cycle + operation_duration;
+            operations[q] = operation_type;
+        }
+    }
+}
+
 // A two-qubit flux gate must set the qubits it would detune to detuned, busy with a flux gate.
 // A one-qubit rotation gate must set its operand qubit to busy, busy with a rotation.
 void ccl_detuned_qubits_resource_t::reserve(
@@ -597,73 +822,32 @@ void ccl_detuned_qubits_resource_t::reserve(
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    auto gname = ins->name;
-    Bool is_flux = operation_type == "flux";
-    if (is_flux) {
+    if (operation.type == ccl_type_flux) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         auto nopers = ins->operands.size();
         if (nopers == 1) {
             // single qubit flux operation does not reserve a detuned qubits resource
         } else if (nopers == 2) {
             auto q0 = ins->operands[0];
             auto q1 = ins->operands[1];
-            qubits_pair_t aqpair(q0, q1);
-            auto edge_no = qubitpair2edge.at(aqpair);
+            UInt edge_no = qubitpair2edge->get(q0, q1);
+            if (edge_no == ccl_edge_table_t::NO_EDGE) {
+                QL_FATAL("Use of illegal edge: " << q0 << "->" << q1 << " in operation: " << ins->name << " !");
+            }
 
-            for (auto &q : edge_detunes_qubits.get(edge_no)) {
-                if (direction == forward_scheduling) {
-                    if (operations[q] == operation_type) {
-                        tocycle[q] = max(tocycle[q], op_start_cycle + operation_duration);
-                        QL_DOUT("reserving " << name << ". for qubit: " << q << " reusing cycle: " << fromcycle[q] << " to extending tocycle: " << tocycle[q] << " for old operation: " << ins->name);
-                    } else {
-                        fromcycle[q] = op_start_cycle;
-                        tocycle[q] = op_start_cycle + operation_duration;
-                        operations[q] = operation_type;
-                        QL_DOUT("reserving " << name << ". for qubit: " << q << " from fromcycle: " << fromcycle[q] << " to new tocycle: " << tocycle[q] << " for new operation: " << ins->name);
-                    }
-                } else {
-                    if (operations[q] == operation_type) {
-                        fromcycle[q] = min(fromcycle[q], op_start_cycle);
-                        QL_DOUT("reserving " << name << ". for qubit: " << q << " from extended cycle: " << fromcycle[q] << " reusing tocycle: " << tocycle[q] << " for old operation: " << ins->name);
-                    } else {
-                        fromcycle[q] = op_start_cycle;
-                        tocycle[q] = op_start_cycle + operation_duration;
-                        operations[q] = operation_type;
-                        QL_DOUT("reserving " << name << ". for qubit: " << q << " from new cycle: " << fromcycle[q] << " to tocycle: " << tocycle[q] << " for new operation: " << ins->name);
-                    }
-                }
+            for (auto &q : ccl_edge_connection(*edge_detunes_qubits, edge_no)) {
+                reserve_qubit(q, op_start_cycle, operation_duration, operation.type);
                 QL_DOUT("reserved " << name << ". op_start_cycle: " << op_start_cycle << " edge: " << edge_no << " detunes qubit: " << q << " reserved from cycle: " << fromcycle[q] << " till cycle: " << tocycle[q] << " for operation: " << ins->name);
             }
         } else {
             QL_FATAL("Incorrect number of operands used in operation: " << ins->name << " !");
         }
-    }
-    Bool is_mw = operation_type == "mw";
-    if (is_mw) {
+    } else if (operation.type == ccl_type_mw) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         for (auto q : ins->operands) {
-            if (direction == forward_scheduling) {
-                if (operations[q] == operation_type) {
-                    tocycle[q] = max(tocycle[q], op_start_cycle + operation_duration);
-                    QL_DOUT("reserving " << name << ". for qubit: " << q << " reusing cycle: " << fromcycle[q] << " to extending tocycle: " << tocycle[q] << " for old operation: " << ins->name);
-                } else {
-                    fromcycle[q] = op_start_cycle;
-                    tocycle[q] = op_start_cycle + operation_duration;
-                    operations[q] = operation_type;
-                    QL_DOUT("reserving " << name << ". for qubit: " << q << " from fromcycle: " << fromcycle[q] << " to new tocycle: " << tocycle[q] << " for new operation: " << ins->name);
-                }
-            } else {
-                if (operations[q] == operation_type) {
-                    fromcycle[q] = min(fromcycle[q], op_start_cycle);
-                    QL_DOUT("reserving " << name << ". for qubit: " << q << " from extended cycle: " << fromcycle[q] << " reusing tocycle: " << tocycle[q] << " for old operation: " << ins->name);
-                } else {
-                    fromcycle[q] = op_start_cycle;
-                    tocycle[q] = op_start_cycle + operation_duration;
-                    operations[q] = operation_type;
-                    QL_DOUT("reserving " << name << ". for qubit: " << q << " from new cycle: " << fromcycle[q] << " to tocycle: " << tocycle[q] << " for new operation: " << ins->name);
-                }
-            }
+            reserve_qubit(q, op_start_cycle, operation_duration, operation.type);
             QL_DOUT("... reserved " << name << ". op_start_cycle: " << op_start_cycle << " for qubit: " << q << " reserved from cycle: " << fromcycle[q] << " till cycle: " << tocycle[q] << " for operation: " << ins->name);
         }
     }
@@ -673,16 +857,26 @@ ccl_channel_resource_t::ccl_channel_resource_t(
     const quantum_platform &platform,
     scheduling_direction_t dir
 ) :
-    resource_t("channels", dir)
+    ccl_channel_resource_t(platform, dir, std::make_shared<const ccl_operation_table_t>(platform))
+{
+}
+
+ccl_channel_resource_t::ccl_channel_resource_t(
+    const quantum_platform &platform,
+    scheduling_direction_t dir,
+    const std::shared_ptr<const ccl_operation_table_t> &operation_table
+) :
+    resource_t("channels", dir),
+    operation_table(operation_table)
 {
     QL_DOUT("... creating " << name << " resource");
 
     // ncores = topology.number_of_cores: total number of cores
-    if (platform.topology.count("number_of_cores") <= 0) {
+    if (platform.topology->count("number_of_cores") <= 0) {
         ncores = 1;
         QL_DOUT("Number of cores (topology[\"number_of_cores\"] not defined; assuming: " << ncores);
     } else {
-        ncores = platform.topology["number_of_cores"];
+        ncores = (*platform.topology)["number_of_cores"];
         if (ncores <= 0) {
             QL_FATAL("Number of cores (topology[\"number_of_cores\"]) is not a positive value: " << ncores);
         }
@@ -690,11 +884,11 @@ ccl_channel_resource_t::ccl_channel_resource_t(
     QL_DOUT("Number of cores = " << ncores);
 
     // nchannels = resources.channels.count: number of channels in each core
-    if (platform.resources[name].count("count") <= 0) {
+    if ((*platform.resources)[name].count("count") <= 0) {
 	    nchannels = platform.qubit_number/ncores;   // i.e. as many as there are qubits in a core
         QL_DOUT("Number of channels per core (resources[\"channels\"][\"count\"]) not defined; assuming: " << nchannels);
     } else {
-	    nchannels = platform.resources[name]["count"];
+	    nchannels = (*platform.resources)[name]["count"];
 	    if (nchannels <= 0) {
 	        QL_DOUT("Number of channels per core (resources[\"channels\"][\"count\"]) is not a positive value: " << nchannels);
 	        nchannels = platform.qubit_number/ncores;   // i.e. as many as there are qubits in a core
@@ -705,8 +899,7 @@ ccl_channel_resource_t::ccl_channel_resource_t(
     }
     QL_DOUT("Number of channels per core= " << nchannels);
 
-    state.resize(ncores);
-    for (UInt i=0; i<ncores; i++) state[i].resize(nchannels, (forward_scheduling == dir ? 0 : MAX_CYCLE));
+    state.assign(ncores * nchannels, forward_scheduling == dir ? 0 : MAX_CYCLE);
 }
 
 ccl_channel_resource_t *ccl_channel_resource_t::clone() const & {
@@ -723,57 +916,36 @@ Bool ccl_channel_resource_t::available(
     gate *ins,
     const quantum_platform &platform
 ) {
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    Bool is_ic = (operation_type == "extern");
-    if (is_ic) {
+    if (operation.type == ccl_type_extern) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         QL_DOUT(" available " << name << "? op_start_cycle: " << op_start_cycle  << " for: " << ins->qasm());
-        if (direction == forward_scheduling) {
-            for (auto q : ins->operands) {
-                UInt core = q/(platform.qubit_number/ncores);
-                Bool is_avail = false;
-                // fwd: channel c is busy till cycle=state[core][c],
-                // when reserving state[core][c] = start_cycle + duration
-                // i.e. all cycles < state[core][c] it is busy, i.e. available when start_cycle >= state[core][c]
-                QL_DOUT(" available " << name << "? ... q=" << q << " core=" << core);
-                for (UInt c=0; c<nchannels; c++) {
-                    QL_DOUT(" available " << name << "? ... c=" << c);
-                    if (
-                        op_start_cycle >= state[core][c]
-                    ) {
-                        QL_DOUT(" available " << name << "! for qubit: " << q << " in core: " << core << " channel: " << c << " available");
-                        is_avail = true;
-                        break;
-                    }
-                }
-                if (!is_avail) {
-                     QL_DOUT(" busy " << name << "! for qubit: " << q << " in core: " << core << " all channels busy");
-                     return false;
+        for (auto q : ins->operands) {
+            UInt core = q/(platform.qubit_number/ncores);
+            const UInt *core_state = &state[core*nchannels];
+            Bool is_avail = false;
+            // fwd: channel c is busy till cycle=state[core][c],
+            // when reserving state[core][c] = start_cycle + duration
+            // i.e. all cycles < state[core][c] it is busy, i.e. available when start_cycle >= state[core][c]
+            // bwd: channel c is busy from cycle=state[core][c],
+            // when reserving state[core][c] = start_cycle
+            // i.e. all cycles >= state[core][c] it is busy, i.e. available when start_cycle + duration <= state[core][c]
+            QL_DOUT(" available " << name << "? ... q=" << q << " core=" << core);
+            for (UInt c=0; c<nchannels; c++) {
+                if (
+                    direction == forward_scheduling
+                    ? op_start_cycle >= core_state[c]
+                    : op_start_cycle + operation_duration <= core_state[c]
+                ) {
+                    QL_DOUT(" available " << name << "! for qubit: " << q << " in core: " << core << " channel: " << c << " available");
+                    is_avail = true;
+                    break;
                 }
             }
-        } else {
-            for (auto q : ins->operands) {
-                UInt core = q/(platform.qubit_number/ncores);
-                Bool is_avail = false;
-                // bwd: channel c is busy from cycle=state[core][c],
-                // when reserving state[core][c] = start_cycle
-                // i.e. all cycles >= state[core][c] it is busy, i.e. available when start_cycle + duration <= state[core][c]
-                QL_DOUT(" available " << name << "? ... q=" << q << " core=" << core);
-                for (UInt c=0; c<nchannels; c++) {
-                    QL_DOUT(" available " << name << "? ... c=" << c);
-                    if (
-                        op_start_cycle + operation_duration <= state[core][c]
-                    ) {
-                        QL_DOUT(" available " << name << "! for qubit: " << q << " in core: " << core << " channel: " << c << " available");
-                        is_avail = true;
-                        break;
-                    }
-                }
-                if (!is_avail) {
-                    QL_DOUT(" busy " << name << "! for qubit: " << q << " in core: " << core << " all channels busy");
-                    return false;
-                }
+            if (!is_avail) {
+                QL_DOUT(" busy " << name << "! for qubit: " << q << " in core: " << core << " all channels busy");
+                return false;
             }
         }
         QL_DOUT(" available " << name << " resource available for: " << ins->qasm());
@@ -781,6 +953,33 @@ Bool ccl_channel_resource_t::available(
     return true;
 }
 
+// each operand needs one channel of its core, so the one that gets free first
+UInt ccl_channel_resource_t::next_available(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
+    UInt cycle = op_start_cycle;
+
+    if (operation.type == ccl_type_extern) {
+        if (nchannels == 0) {
+            return resource_t::next_available(op_start_cycle, ins, platform);
+        }
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
+        for (auto q : ins->operands) {
+            UInt core = q/(platform.qubit_number/ncores);
+            const UInt *core_state = &state[core*nchannels];
+            UInt first_free = core_state[0];
+            for (UInt c = 1; c < nchannels; c++) {
+                first_free = direction == forward_scheduling ? min(first_free, core_state[c]) : max(first_free, core_state[c]);
+            }
+            cycle = ccl_later(direction, cycle, ccl_free_at(direction, op_start_cycle, operation_duration, first_free));
+        }
+    }
+    return cycle;
+}
+
 void ccl_channel_resource_t::reserve(
     UInt op_start_cycle,
     gate *ins,
@@ -789,52 +988,33 @@ void ccl_channel_resource_t::reserve(
     // for each operand:
     //     find a free channel c and then do
     //     state[core][c] = (forward_scheduling == direction ?  op_start_cycle + operation_duration : op_start_cycle );
-    Str operation_type = ccl_get_operation_type(ins, platform);
-    UInt      operation_duration = ccl_get_operation_duration(ins, platform);
+    const ccl_operation_info_t &operation = operation_table->get(ins, platform);
 
-    Bool is_ic = (operation_type == "extern");
-    if (is_ic) {
+    if (operation.type == ccl_type_extern) {
+        UInt operation_duration = ccl_get_operation_duration(ins, platform);
         QL_DOUT(" reserve " << name << "? op_start_cycle: " << op_start_cycle  << " for: " << ins->qasm());
-        if (direction == forward_scheduling) {
-            for (auto q : ins->operands) {
-                UInt core = q/(platform.qubit_number/ncores);
-                Bool is_avail = false;
-                // fwd: channel c is busy till cycle=state[core][c],
-                // when reserving state[core][c] = start_cycle + duration
-                // i.e. all cycles < state[core][c] it is busy, i.e. available when start_cycle >= state[core][c]
-                for (UInt c=0; c<nchannels; c++) {
-                    if (
-                        op_start_cycle >= state[core][c]
-                    ) {
-                        state[core][c] = op_start_cycle + operation_duration;
-                        QL_DOUT(" reserved " << name << "? for qubit: " << q << " in core: " << core << " channel: " << c << "till cycle: " << state[core][c]);
+        for (auto q : ins->operands) {
+            UInt core = q/(platform.qubit_number/ncores);
+            UInt *core_state = &state[core*nchannels];
+            Bool is_avail = false;
+            for (UInt c=0; c<nchannels; c++) {
+                if (direction == forward_scheduling) {
+                    if (op_start_cycle >= core_state[c]) {
+                        core_state[c] = op_start_cycle + operation_duration;
+                        QL_DOUT(" reserved " << name << "? for qubit: " << q << " in core: " << core << " channel: " << c << "till cycle: " << core_state[c]);
                         is_avail = true;
                         break;
                     }
-                }
-                QL_ASSERT(is_avail);
-            }
-        } else {
-            // bwd: channel c is busy from cycle=state[core][c],
-            // i.e. all cycles >= state[core][c] it is busy, i.e. available when start_cycle <= state[core][c]
-            for (auto q : ins->operands) {
-                UInt core = q/(platform.qubit_number/ncores);
-                Bool is_avail = false;
-                // bwd: channel c is busy from cycle=state[core][c],
-                // when reserving state[core][c] = start_cycle
-                // i.e. all cycles >= state[core][c] it is busy, i.e. available when start_cycle <= state[core][c]
-                for (UInt c=0; c<nchannels; c++) {
-                    if (
-                        op_start_cycle + operation_duration <= state[core][c]
-                    ) {
-                        state[core][c] = op_start_cycle;
-                        QL_DOUT(" reserved " << name << "? for qubit: " << q << " in core: " << core << " channel: " << c << " from cycle: " << state[core][c]);
+                } else {
+                    if (op_start_cycle + operation_duration <= core_state[c]) {
+                        core_state[c] = op_start_cycle;
+                        QL_DOUT(" reserved " << name << "? for qubit: " << q << " in core: " << core << " channel: " << c << " from cycle: " << core_state[c]);
                         is_avail = true;
                         break;
                     }
                 }
-                QL_ASSERT(is_avail);
             }
+            QL_ASSERT(is_avail);
         }
     }
 }
@@ -849,8 +1029,9 @@ cc_light_resource_manager_t::cc_light_resource_manager_t(
     platform_resource_manager_t(platform, dir)
 {
     QL_DOUT("Constructing (platform,dir) parameterized platform_resource_manager_t");
-    QL_DOUT("New one for direction " << dir << " with no of resources : " << platform.resources.size() );
-    for (auto it = platform.resources.cbegin(); it != platform.resources.cend(); ++it) {
+    QL_DOUT("New one for direction " << dir << " with no of resources : " << platform.resources->size() );
+    auto operation_table = std::make_shared<const ccl_operation_table_t>(platform);
+    for (auto it = platform.resources->cbegin(); it != platform.resources->cend(); ++it) {
         // COUT(it.key() << " : " << it.value() << "\n");
         Str n = it.key();
 
@@ -859,19 +1040,19 @@ cc_light_resource_manager_t::cc_light_resource_manager_t(
             resource_t * ares = new ccl_qubit_resource_t(platform, dir);
             resource_ptrs.push_back( ares );
         } else if (n == "qwgs") {
-            resource_t * ares = new ccl_qwg_resource_t(platform, dir);
+            resource_t * ares = new ccl_qwg_resource_t(platform, dir, operation_table);
             resource_ptrs.push_back( ares );
         } else if (n == "meas_units") {
-            resource_t * ares = new ccl_meas_resource_t(platform, dir);
+            resource_t * ares = new ccl_meas_resource_t(platform, dir, operation_table);
             resource_ptrs.push_back( ares );
         } else if (n == "edges") {
-            resource_t * ares = new ccl_edge_resource_t(platform, dir);
+            resource_t * ares = new ccl_edge_resource_t(platform, dir, operation_table);
             resource_ptrs.push_back( ares );
         } else if (n == "detuned_qubits") {
-            resource_t * ares = new ccl_detuned_qubits_resource_t(platform, dir);
+            resource_t * ares = new ccl_detuned_qubits_resource_t(platform, dir, operation_table);
             resource_ptrs.push_back( ares );
         } else if (n == "channels") {
-            resource_t * ares = new ccl_channel_resource_t(platform, dir);
+            resource_t * ares = new ccl_channel_resource_t(platform, dir, operation_table);
             resource_ptrs.push_back( ares );
         } else {
             QL_FATAL("Error : Un-modelled resource, i.e. resource not supported by implementation: '" << n << "'");
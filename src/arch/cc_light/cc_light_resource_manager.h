@@ -5,10 +5,12 @@
 #pragma once
 
 #include <fstream>
+#include <memory>
 #include "utils/num.h"
 #include "utils/str.h"
 #include "utils/pair.h"
 #include "utils/vec.h"
+#include "utils/map.h"
 #include "utils/json.h"
 #include "resource_manager.h"
 
@@ -29,9 +31,60 @@ utils::Str ccl_get_operation_type(gate *ins, const quantum_platform &platform);
 // operation name is used to know which operations are the same when one qwg steers several qubits using the vsm
 utils::Str ccl_get_operation_name(gate *ins, const quantum_platform &platform);
 
+// the operation types that the resources below distinguish
+typedef enum {
+    ccl_type_none = 0,      // initial value of resource state, different from all others
+    ccl_type_other,
+    ccl_type_mw,
+    ccl_type_flux,
+    ccl_type_readout,
+    ccl_type_extern
+} ccl_operation_type_t;
+
+// operation type and name of an instruction, the latter interned to an integer id
+struct ccl_operation_info_t {
+    ccl_operation_type_t type;
+    utils::UInt name_id;
+};
+
+// Constant table with the operation type and name of each instruction in the configuration file,
+// indexed by the platform's instruction id, so that resource checks don't need string lookups and compares.
+// It is shared by all resources of a resource manager and its clones.
+class ccl_operation_table_t {
+public:
+    static const utils::UInt NO_NAME = 0;   // interned id of operation name "", the initial value of resource state
+
+    explicit ccl_operation_table_t(const quantum_platform &platform);
+
+    const ccl_operation_info_t &get(gate *ins, const quantum_platform &platform) const;
+
+private:
+    utils::Vec<ccl_operation_info_t> info;     // instruction id to operation info
+};
+
+// Constant dense table from a pair of qubits to the edge between them, from the topology section of the configuration file.
+class ccl_edge_table_t {
+public:
+    static const utils::UInt NO_EDGE = utils::MAX;
+
+    explicit ccl_edge_table_t(const quantum_platform &platform);
+
+    // edge from q0 to q1, or NO_EDGE when there is no such edge
+    utils::UInt get(utils::UInt q0, utils::UInt q1) const {
+        return (q0 < nqubits && q1 < nqubits) ? edges[q0*nqubits + q1] : NO_EDGE;
+    }
+
+private:
+    utils::UInt nqubits;
+    utils::Vec<utils::UInt> edges;          // edge of (q0,q1) at index q0*nqubits+q1
+};
+
 
 // ============ classes of resources that _may_ appear in a configuration file
 // these are a superset of those allocated by the cc_light_resource_manager_t constructor below
+//
+// The state of each resource is kept in flat integer vectors, and the tables that are constant after construction
+// are shared between clones, so that cloning a resource (which the mapper does a lot) is little more than a memcpy.
 
 // Each qubit can be used by only one gate at a time.
 class ccl_qubit_resource_t : public resource_t {
@@ -47,6 +100,7 @@ public:
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
 };
 
 // Single-qubit rotation gates (instructions of 'mw' type) are controlled by qwgs.
@@ -62,16 +116,19 @@ public:
     // but a new y must wait until the last x has finished;
     // the bug was that a new x was always ok (so also when starting earlier than cycle i)
 
-    utils::Vec<utils::Str> operations;    // with operation_name==operations[qwg]
-    utils::Map<utils::UInt,utils::UInt> qubit2qwg;      // on qwg==qubit2qwg[q]
+    utils::Vec<utils::UInt> operations;         // with operation_name (interned) ==operations[qwg]
+    std::shared_ptr<const utils::Vec<utils::UInt>> qubit2qwg;   // on qwg==qubit2qwg[q]
+    std::shared_ptr<const ccl_operation_table_t> operation_table;
 
     ccl_qwg_resource_t(const quantum_platform & platform, scheduling_direction_t dir);
+    ccl_qwg_resource_t(const quantum_platform & platform, scheduling_direction_t dir, const std::shared_ptr<const ccl_operation_table_t> &operation_table);
 
     ccl_qwg_resource_t *clone() const & override;
     ccl_qwg_resource_t *clone() && override;
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
 };
 
 // Single-qubit measurements (instructions of 'readout' type) are controlled by measurement units.
@@ -81,15 +138,18 @@ class ccl_meas_resource_t : public resource_t {
 public:
     utils::Vec<utils::UInt> fromcycle;  // last measurement start cycle
     utils::Vec<utils::UInt> tocycle;    // is busy till cycle
-    utils::Map<utils::UInt,utils::UInt> qubit2meas;
+    std::shared_ptr<const utils::Vec<utils::UInt>> qubit2meas;
+    std::shared_ptr<const ccl_operation_table_t> operation_table;
 
     ccl_meas_resource_t(const quantum_platform & platform, scheduling_direction_t dir);
+    ccl_meas_resource_t(const quantum_platform & platform, scheduling_direction_t dir, const std::shared_ptr<const ccl_operation_table_t> &operation_table);
 
     ccl_meas_resource_t *clone() const & override;
     ccl_meas_resource_t *clone() && override;
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
 };
 
 // Two-qubit flux gates only operate on neighboring qubits, i.e. qubits connected by an edge.
@@ -107,17 +167,19 @@ public:
     // fwd: edge is busy till cycle=state[edge], i.e. all cycles < state[edge] it is busy, i.e. start_cycle must be >= state[edge]
     // bwd: edge is busy from cycle=state[edge], i.e. all cycles >= state[edge] it is busy, i.e. start_cycle+duration must be <= state[edge]
     utils::Vec<utils::UInt> state;                          // machine state recording the cycles that given edge is free/busy
-    typedef utils::Pair<utils::UInt, utils::UInt> qubits_pair_t;
-    utils::Map<qubits_pair_t, utils::UInt> qubits2edge;      // constant helper table to find edge between a pair of qubits
-    utils::Map<utils::UInt, utils::Vec<utils::UInt>> edge2edges;  // constant "edges" table from configuration file
+    std::shared_ptr<const ccl_edge_table_t> qubits2edge;    // constant helper table to find edge between a pair of qubits
+    std::shared_ptr<const utils::Vec<utils::Vec<utils::UInt>>> edge2edges;    // constant "edges" table from configuration file
+    std::shared_ptr<const ccl_operation_table_t> operation_table;
 
     ccl_edge_resource_t(const quantum_platform &platform, scheduling_direction_t dir);
+    ccl_edge_resource_t(const quantum_platform &platform, scheduling_direction_t dir, const std::shared_ptr<const ccl_operation_table_t> &operation_table);
 
     ccl_edge_resource_t *clone() const & override;
     ccl_edge_resource_t *clone() && override;
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
     void reserve(utils::UInt op_start_cycle, gate * ins, const quantum_platform & platform) override;
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
 };
 
 // A two-qubit flux gate lowers the frequency of its source qubit to get near the freq of its target qubit.
@@ -146,19 +208,24 @@ class ccl_detuned_qubits_resource_t : public resource_t {
 public:
     utils::Vec<utils::UInt> fromcycle;                              // qubit q is busy from cycle fromcycle[q]
     utils::Vec<utils::UInt> tocycle;                                // till cycle tocycle[q]
-    utils::Vec<utils::Str> operations;                        // with an operation of operation_type==operations[q]
+    utils::Vec<utils::UInt> operations;                             // with an operation of operation_type==operations[q]
 
-    typedef utils::Pair<utils::UInt, utils::UInt> qubits_pair_t;
-    utils::Map<qubits_pair_t, utils::UInt> qubitpair2edge;           // map: pair of qubits to edge (from grid configuration)
-    utils::Map<utils::UInt, utils::Vec<utils::UInt>> edge_detunes_qubits; // map: edge to vector of qubits that edge detunes (resource desc.)
+    std::shared_ptr<const ccl_edge_table_t> qubitpair2edge;          // map: pair of qubits to edge (from grid configuration)
+    std::shared_ptr<const utils::Vec<utils::Vec<utils::UInt>>> edge_detunes_qubits;  // map: edge to vector of qubits that edge detunes (resource desc.)
+    std::shared_ptr<const ccl_operation_table_t> operation_table;
 
     ccl_detuned_qubits_resource_t(const quantum_platform &platform, scheduling_direction_t dir);
+    ccl_detuned_qubits_resource_t(const quantum_platform &platform, scheduling_direction_t dir, const std::shared_ptr<const ccl_operation_table_t> &operation_table);
 
     ccl_detuned_qubits_resource_t *clone() const & override;
     ccl_detuned_qubits_resource_t *clone() && override;
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
+
+private:
+    void reserve_qubit(utils::UInt q, utils::UInt op_start_cycle, utils::UInt operation_duration, utils::UInt operation_type);
 };
 
 // Inter-core communication gates use channels between cores.
@@ -176,15 +243,19 @@ public:
     // i.e. all cycles < state[core][c] it is busy, i.e. start_cycle must be >= state[core][c]
     // bwd: channel c is busy from cycle=state[core][c],
     // i.e. all cycles >= state[core][c] it is busy, i.e. start_cycle+duration must be <= state[core][c]
-    utils::Vec<utils::Vec<utils::UInt>> state;
+    // state[core][c] is stored at state[core*nchannels+c]
+    utils::Vec<utils::UInt> state;
+    std::shared_ptr<const ccl_operation_table_t> operation_table;
 
     ccl_channel_resource_t(const quantum_platform & platform, scheduling_direction_t dir);
+    ccl_channel_resource_t(const quantum_platform & platform, scheduling_direction_t dir, const std::shared_ptr<const ccl_operation_table_t> &operation_table);
 
     ccl_channel_resource_t *clone() const & override;
     ccl_channel_resource_t *clone() && override;
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) override;
 };
 
 // ============ platform specific resource_manager matching config file resources sections with resource classes above
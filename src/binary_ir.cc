@@ -0,0 +1,556 @@
+/** \file
+ * Binary serialization of the intermediate representation of a program, to
+ * checkpoint a compilation and resume it later without reparsing cQASM.
+ *
+ * Layout of a file:
+ *  - the 8 magic bytes "OQLBIR\r\n" (which also detect files that went through
+ *    newline translation), followed by BINARY_IR_VERSION as 4 bytes, least
+ *    significant first;
+ *  - a table of all strings in the file (gate, kernel and program names, ...),
+ *    each as its length and its bytes; strings are referred to by their index
+ *    in this table, so each distinct gate name is stored and read only once;
+ *  - the platform's name, number of qubits and cycle time, to check that the
+ *    file is read for the same platform;
+ *  - the program's name, qubit/creg/breg counts, sweep points and kernels;
+ *  - per kernel, its name, iterations, counts, control-flow type, branch
+ *    condition, preset gate condition and gates;
+ *  - per gate, a tag (its gate::binary_ir_tag(), which is its gate_type_t or
+ *    a tag of the backend), its name and all attributes of the gate interface,
+ *    and for wait gates their duration in cycles.
+ * Unsigned integers are stored as LEB128 varints, signed integers zigzag
+ * encoded as varints, and reals as the 8 bytes of their IEEE representation,
+ * least significant first. The layout doesn't contain pointers or offsets, so
+ * a file is read into memory at once and decoded with a single forward scan.
+ */
+
+#include "binary_ir.h"
+
+#include <cstring>
+#include "utils/map.h"
+#include "utils/vec.h"
+#include "utils/filesystem.h"
+#include "gate.h"
+#include "classical.h"
+#include "kernel.h"
+#include "eqasm_compiler.h"
+
+namespace ql {
+
+using namespace utils;
+
+namespace {
+
+const char BINARY_IR_MAGIC[] = "OQLBIR\r\n";
+const UInt BINARY_IR_MAGIC_SIZE = 8;
+
+class binary_ir_writer_t {
+public:
+    void put_uint(UInt v) {
+        while (v >= 0x80) {
+            body.push_back((char)((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        body.push_back((char)v);
+    }
+
+    void put_int(Int v) {
+        UInt u = (UInt)v;
+        put_uint(v < 0 ? ~(u << 1) : u << 1);
+    }
+
+    void put_real(Real v) {
+        UInt u;
+        std::memcpy(&u, &v, sizeof(u));
+        for (UInt i = 0; i < 8; i++) {
+            body.push_back((char)((u >> (8 * i)) & 0xFF));
+        }
+    }
+
+    void put_str(const Str &s) {
+        auto it = string_ids.find(s);
+        if (it != string_ids.end()) {
+            put_uint(it->second);
+            return;
+        }
+        UInt id = strings.size();
+        string_ids.set(s) = id;
+        strings.push_back(&s);
+        put_uint(id);
+    }
+
+    template <class C>
+    void put_uints(const C &vs) {
+        put_uint(vs.size());
+        for (auto v : vs) {
+            put_uint(v);
+        }
+    }
+
+    // the file contents: header, string table and body
+    Str finish() {
+        binary_ir_writer_t table;
+        table.put_uint(strings.size());
+        for (auto s : strings) {
+            table.put_uint(s->size());
+            table.body += *s;
+        }
+
+        Str contents(BINARY_IR_MAGIC, BINARY_IR_MAGIC_SIZE);
+        for (UInt i = 0; i < 4; i++) {
+            contents.push_back((char)((BINARY_IR_VERSION >> (8 * i)) & 0xFF));
+        }
+        contents += table.body;
+        contents += body;
+        return contents;
+    }
+
+private:
+    Str body;
+    Map<Str, UInt> string_ids;
+    Vec<const Str*> strings;    // in the order of their ids; point into the program
+};
+
+class binary_ir_reader_t {
+public:
+    binary_ir_reader_t(const Str &fname, const Str &contents) : fname(fname), contents(contents) {
+        if (
+            contents.size() < BINARY_IR_MAGIC_SIZE + 4
+            || contents.compare(0, BINARY_IR_MAGIC_SIZE, BINARY_IR_MAGIC) != 0
+        ) {
+            QL_FATAL("'" << fname << "' is not a binary IR file");
+        }
+        pos = BINARY_IR_MAGIC_SIZE;
+        UInt version = 0;
+        for (UInt i = 0; i < 4; i++) {
+            version |= (UInt)(unsigned char)contents[pos++] << (8 * i);
+        }
+        if (version != BINARY_IR_VERSION) {
+            QL_FATAL("binary IR file '" << fname << "' has format version " << version
+                     << ", but this version of OpenQL reads version " << BINARY_IR_VERSION);
+        }
+
+        UInt nstrings = get_count();
+        strings.reserve(nstrings);
+        for (UInt i = 0; i < nstrings; i++) {
+            UInt size = get_uint();
+            if (size > contents.size() - pos) {
+                fail();
+            }
+            strings.push_back(contents.substr(pos, size));
+            pos += size;
+        }
+    }
+
+    [[noreturn]] void fail() const {
+        QL_FATAL("binary IR file '" << fname << "' is truncated or corrupt");
+    }
+
+    UInt get_uint() {
+        UInt v = 0;
+        for (UInt shift = 0; shift < 64; shift += 7) {
+            if (pos == contents.size()) {
+                fail();
+            }
+            UInt byte = (unsigned char)contents[pos++];
+            v |= (byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return v;
+            }
+        }
+        fail();
+    }
+
+    Int get_int() {
+        UInt u = get_uint();
+        return (u & 1) ? (Int)~(u >> 1) : (Int)(u >> 1);
+    }
+
+    Real get_real() {
+        if (contents.size() - pos < 8) {
+            fail();
+        }
+        UInt u = 0;
+        for (UInt i = 0; i < 8; i++) {
+            u |= (UInt)(unsigned char)contents[pos++] << (8 * i);
+        }
+        Real v;
+        std::memcpy(&v, &u, sizeof(v));
+        return v;
+    }
+
+    // a number of items that follow, each taking at least min_size bytes;
+    // checked against the remaining bytes, so that it can be used to reserve space
+    UInt get_count(UInt min_size = 1) {
+        UInt count = get_uint();
+        if (count > (contents.size() - pos) / min_size) {
+            fail();
+        }
+        return count;
+    }
+
+    const Str &get_str() {
+        UInt id = get_uint();
+        if (id >= strings.size()) {
+            fail();
+        }
+        return strings[id];
+    }
+
+    Vec<UInt> get_uints() {
+        UInt size = get_count();
+        Vec<UInt> vs(size);
+        for (UInt i = 0; i < size; i++) {
+            vs[i] = get_uint();
+        }
+        return vs;
+    }
+
+    Bool at_end() const {
+        return pos == contents.size();
+    }
+
+private:
+    const Str &fname;
+    const Str &contents;
+    UInt pos;
+    Vec<Str> strings;
+};
+
+// whether all registers are below count
+Bool all_below(const Vec<UInt> &registers, UInt count) {
+    for (auto r : registers) {
+        if (r >= count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void put_gate(binary_ir_writer_t &w, const gate *g) {
+    UInt tag = g->binary_ir_tag();
+    if (tag == __composite_gate__ || tag == __display_binary__) {
+        QL_FATAL("binary IR: gate '" << g->name << "' of type " << tag << " cannot be written");
+    }
+    w.put_uint(tag);
+    w.put_str(g->name);
+    w.put_uints(g->operands);
+    w.put_uints(g->creg_operands);
+    w.put_uints(g->breg_operands);
+    w.put_uint(g->condition);
+    w.put_uints(g->cond_operands);
+    w.put_int(g->int_operand);
+    w.put_uint(g->duration);
+    w.put_real(g->angle);
+    w.put_uint(g->cycle + 1);   // so that MAX_CYCLE takes a single byte
+    w.put_uint(g->swap_params.part_of_swap);
+    if (g->swap_params.part_of_swap) {
+        w.put_int(g->swap_params.r0);
+        w.put_int(g->swap_params.r1);
+        w.put_int(g->swap_params.v0);
+        w.put_int(g->swap_params.v1);
+    }
+    w.put_str(g->visual_type);
+    if (tag == __wait_gate__) {
+        w.put_uint(static_cast<const wait *>(g)->duration_in_cycles);
+    }
+}
+
+gate *get_gate(binary_ir_reader_t &r, quantum_kernel &k, const eqasm_compiler *backend) {
+    UInt tag = r.get_uint();
+    const Str &name = r.get_str();
+    Vec<UInt> operands = r.get_uints();
+    Vec<UInt> creg_operands = r.get_uints();
+    Vec<UInt> breg_operands = r.get_uints();
+    UInt condition = r.get_uint();
+    Vec<UInt> cond_operands = r.get_uints();
+    Int int_operand = r.get_int();
+    UInt duration = r.get_uint();
+    Real angle = r.get_real();
+    UInt cycle = r.get_uint() - 1;
+    swap_parameters swap_params;
+    if (r.get_uint()) {
+        swap_params.part_of_swap = true;
+        swap_params.r0 = r.get_int();
+        swap_params.r1 = r.get_int();
+        swap_params.v0 = r.get_int();
+        swap_params.v1 = r.get_int();
+    }
+    const Str &visual_type = r.get_str();
+
+    if (condition > cond_nxor || !gate::is_valid_cond((cond_type_t)condition, cond_operands)) {
+        r.fail();
+    }
+
+    // the operands are within the registers of the kernel, as was checked when
+    // the gate was created; those of the classical gates are cregs, and those of
+    // the gates of a backend are its own registers, which only it knows
+    Bool backend_gate = tag >= BINARY_IR_FIRST_BACKEND_TAG;
+    if (
+        (!backend_gate && !all_below(operands, tag == __classical_gate__ ? k.creg_count : k.qubit_count))
+        || (!backend_gate && !all_below(creg_operands, k.creg_count))
+        || !all_below(breg_operands, k.breg_count)
+        || !all_below(cond_operands, k.breg_count)
+    ) {
+        r.fail();
+    }
+
+    UInt nqubits = 0;
+    switch (tag) {
+        case __cnot_gate__: case __cphase_gate__: case __swap_gate__:
+            nqubits = 2;
+            break;
+        case __toffoli_gate__:
+            nqubits = 3;
+            break;
+        case __custom_gate__: case __display__: case __nop_gate__: case __dummy_gate__:
+        case __wait_gate__: case __classical_gate__:
+            break;
+        default:
+            nqubits = backend_gate ? 0 : 1;
+            break;
+    }
+    if (operands.size() < nqubits) {
+        r.fail();
+    }
+
+    Arena &arena = *k.gate_arena;
+    gate *g = nullptr;
+    switch (tag) {
+        case __identity_gate__: g = arena.make<identity>(operands[0]); break;
+        case __hadamard_gate__: g = arena.make<hadamard>(operands[0]); break;
+        case __pauli_x_gate__:  g = arena.make<pauli_x>(operands[0]); break;
+        case __pauli_y_gate__:  g = arena.make<pauli_y>(operands[0]); break;
+        case __pauli_z_gate__:  g = arena.make<pauli_z>(operands[0]); break;
+        case __phase_gate__:    g = arena.make<phase>(operands[0]); break;
+        case __phasedag_gate__: g = arena.make<phasedag>(operands[0]); break;
+        case __t_gate__:        g = arena.make<t>(operands[0]); break;
+        case __tdag_gate__:     g = arena.make<tdag>(operands[0]); break;
+        case __rx90_gate__:     g = arena.make<rx90>(operands[0]); break;
+        case __mrx90_gate__:    g = arena.make<mrx90>(operands[0]); break;
+        case __rx180_gate__:    g = arena.make<rx180>(operands[0]); break;
+        case __ry90_gate__:     g = arena.make<ry90>(operands[0]); break;
+        case __mry90_gate__:    g = arena.make<mry90>(operands[0]); break;
+        case __ry180_gate__:    g = arena.make<ry180>(operands[0]); break;
+        case __rx_gate__:       g = arena.make<rx>(operands[0], angle); break;
+        case __ry_gate__:       g = arena.make<ry>(operands[0], angle); break;
+        case __rz_gate__:       g = arena.make<rz>(operands[0], angle); break;
+        case __prepz_gate__:    g = arena.make<prepz>(operands[0]); break;
+        case __measure_gate__:  g = arena.make<measure>(operands[0]); break;
+        case __cnot_gate__:     g = arena.make<cnot>(operands[0], operands[1]); break;
+        case __cphase_gate__:   g = arena.make<cphase>(operands[0], operands[1]); break;
+        case __swap_gate__:     g = arena.make<swap>(operands[0], operands[1]); break;
+        case __toffoli_gate__:  g = arena.make<toffoli>(operands[0], operands[1], operands[2]); break;
+        case __display__:       g = arena.make<display>(); break;
+        case __nop_gate__:      g = arena.make<nop>(); break;
+        case __wait_gate__:     g = arena.make<wait>(operands, duration, r.get_uint()); break;
+        case __classical_gate__: g = arena.make<classical>("nop"); break;
+        case __dummy_gate__:
+            if (name == "SOURCE") {
+                g = arena.make<SOURCE>();
+            } else {
+                g = arena.make<SINK>();
+            }
+            break;
+        case __custom_gate__: {
+            // the definition in the platform provides what the gate interface doesn't
+            auto it = k.instruction_map->find(name);
+            if (it == k.instruction_map->end()) {
+                QL_FATAL("binary IR: gate '" << name << "' is not defined by platform");
+            }
+            g = arena.make<custom_gate>(*it->second);
+            break;
+        }
+        default:
+            if (backend_gate && backend) {
+                g = backend->make_binary_ir_gate(tag, arena);
+            }
+            if (!g) {
+                r.fail();
+            }
+            break;
+    }
+
+    g->name = name;
+    g->operands = operands;
+    g->creg_operands = creg_operands;
+    g->breg_operands = breg_operands;
+    g->condition = (cond_type_t)condition;
+    g->cond_operands = cond_operands;
+    g->int_operand = int_operand;
+    g->duration = duration;
+    g->angle = angle;
+    g->cycle = cycle;
+    g->swap_params = swap_params;
+    g->visual_type = visual_type;
+    return g;
+}
+
+void put_kernel(binary_ir_writer_t &w, const quantum_kernel &k) {
+    w.put_str(k.name);
+    w.put_uint(k.iterations);
+    w.put_uint(k.qubit_count);
+    w.put_uint(k.creg_count);
+    w.put_uint(k.breg_count);
+    w.put_uint((UInt)k.type);
+    w.put_uint(k.cycles_valid);
+    w.put_uint(k.br_condition ? 1 : 0);
+    if (k.br_condition) {
+        w.put_str(k.br_condition->operation_name);
+        w.put_str(k.br_condition->inv_operation_name);
+        w.put_uint((UInt)k.br_condition->operation_type);
+        w.put_uint(k.br_condition->operands.size());
+        for (auto op : k.br_condition->operands) {
+            w.put_uint((UInt)op->type());
+            if (op->type() == operand_type_t::CREG) {
+                w.put_uint(op->as_creg().id);
+            } else {
+                w.put_int(op->as_cval().value);
+            }
+        }
+    }
+    w.put_uint(k.condition);
+    w.put_uints(k.cond_operands);
+    w.put_uint(k.c.size());
+    for (auto g : k.c) {
+        put_gate(w, g);
+    }
+}
+
+quantum_kernel get_kernel(binary_ir_reader_t &r, const quantum_platform &platform, const eqasm_compiler *backend) {
+    const Str &name = r.get_str();
+    UInt iterations = r.get_uint();
+    UInt qubit_count = r.get_uint();
+    UInt creg_count = r.get_uint();
+    UInt breg_count = r.get_uint();
+    if (qubit_count > platform.qubit_number) {
+        r.fail();
+    }
+    quantum_kernel k(name, platform, qubit_count, creg_count, breg_count);
+    k.iterations = iterations;
+
+    UInt type = r.get_uint();
+    if (type > (UInt)kernel_type_t::ELSE_END) {
+        r.fail();
+    }
+    k.type = (kernel_type_t)type;
+    k.cycles_valid = r.get_uint();
+    if (r.get_uint()) {
+        k.br_condition.emplace(creg(0));
+        operation &cond = *k.br_condition;
+        cond.operation_name = r.get_str();
+        cond.inv_operation_name = r.get_str();
+        UInt operation_type = r.get_uint();
+        if (operation_type > (UInt)operation_type_t::BITWISE) {
+            r.fail();
+        }
+        cond.operation_type = (operation_type_t)operation_type;
+        for (auto op : cond.operands) {
+            delete op;
+        }
+        cond.operands.clear();
+        UInt noperands = r.get_count();
+        for (UInt i = 0; i < noperands; i++) {
+            if ((operand_type_t)r.get_uint() == operand_type_t::CREG) {
+                UInt id = r.get_uint();
+                if (id >= creg_count) {
+                    r.fail();
+                }
+                cond.operands.push_back(new creg(id));
+            } else {
+                cond.operands.push_back(new cval(r.get_int()));
+            }
+        }
+    }
+    UInt condition = r.get_uint();
+    k.cond_operands = r.get_uints();
+    if (
+        condition > cond_nxor
+        || !gate::is_valid_cond((cond_type_t)condition, k.cond_operands)
+        || !all_below(k.cond_operands, breg_count)
+    ) {
+        r.fail();
+    }
+    k.condition = (cond_type_t)condition;
+
+    UInt ngates = r.get_count();
+    k.c.reserve(ngates);
+    for (UInt i = 0; i < ngates; i++) {
+        k.c.push_back(get_gate(r, k, backend));
+    }
+    return k;
+}
+
+} // anonymous namespace
+
+void write_binary_ir(const quantum_program *programp, const Str &fname) {
+    QL_DOUT("writing binary IR of program " << programp->name << " to '" << fname << "'");
+    binary_ir_writer_t w;
+
+    const quantum_platform &platform = programp->platform;
+    w.put_str(platform.name);
+    w.put_uint(platform.qubit_number);
+    w.put_uint(platform.cycle_time);
+
+    w.put_str(programp->name);
+    w.put_uint(programp->qubit_count);
+    w.put_uint(programp->creg_count);
+    w.put_uint(programp->breg_count);
+    w.put_uint(programp->sweep_points.size());
+    for (auto sp : programp->sweep_points) {
+        w.put_real(sp);
+    }
+    w.put_uint(programp->kernels.size());
+    for (auto &k : programp->kernels) {
+        put_kernel(w, k);
+    }
+
+    OutFile(fname, true).write(w.finish());
+}
+
+void read_binary_ir(quantum_program *programp, const Str &fname) {
+    QL_DOUT("reading binary IR of program " << programp->name << " from '" << fname << "'");
+    Str contents = InFile(fname, true).read();
+    binary_ir_reader_t r(fname, contents);
+
+    const quantum_platform &platform = programp->platform;
+    const Str &platform_name = r.get_str();
+    UInt qubit_number = r.get_uint();
+    UInt cycle_time = r.get_uint();
+    if (platform_name != platform.name || qubit_number != platform.qubit_number || cycle_time != platform.cycle_time) {
+        QL_FATAL("binary IR file '" << fname << "' was written for platform '" << platform_name
+                 << "' with " << qubit_number << " qubits and cycle time " << cycle_time
+                 << ", not for platform '" << platform.name << "' with " << platform.qubit_number
+                 << " qubits and cycle time " << platform.cycle_time);
+    }
+
+    r.get_str();    // name of the program that was written, which may differ
+    UInt qubit_count = r.get_uint();
+    UInt creg_count = r.get_uint();
+    UInt breg_count = r.get_uint();
+    if (qubit_count > platform.qubit_number) {
+        r.fail();
+    }
+    UInt nsweep_points = r.get_count(8);
+    Vec<Real> sweep_points;
+    sweep_points.reserve(nsweep_points);
+    for (UInt i = 0; i < nsweep_points; i++) {
+        sweep_points.push_back(r.get_real());
+    }
+    UInt nkernels = r.get_count();
+    Vec<quantum_kernel> kernels;
+    for (UInt i = 0; i < nkernels; i++) {
+        kernels.push_back(get_kernel(r, platform, programp->backend_compiler));
+    }
+    if (!r.at_end()) {
+        r.fail();
+    }
+
+    programp->qubit_count = qubit_count;
+    programp->creg_count = creg_count;
+    programp->breg_count = breg_count;
+    programp->sweep_points = sweep_points;
+    programp->kernels = kernels;
+    QL_DOUT("read " << nkernels << " kernels from binary IR file '" << fname << "'");
+}
+
+} // namespace ql
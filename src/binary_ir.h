@@ -0,0 +1,43 @@
+/** \file
+ * Binary serialization of the intermediate representation of a program, to
+ * checkpoint a compilation and resume it later without reparsing cQASM.
+ */
+
+#pragma once
+
+#include "utils/num.h"
+#include "utils/str.h"
+#include "program.h"
+
+namespace ql {
+
+/**
+ * Version of the binary IR format. It is stored in the header of each file and
+ * must be incremented whenever the layout changes; files of another version
+ * are rejected when read.
+ */
+const utils::UInt BINARY_IR_VERSION = 1;
+
+/**
+ * First gate::binary_ir_tag() of the gates that a backend defines itself. The
+ * tags below it are gate_type_t values; gates with a tag from here on are
+ * recreated by the backend of the program when read, see
+ * eqasm_compiler::make_binary_ir_gate().
+ */
+const utils::UInt BINARY_IR_FIRST_BACKEND_TAG = 0x100;
+
+/**
+ * Writes the kernels of the program to the given file: their control-flow type
+ * and condition, and their gates with operands, conditions, cycles and the
+ * swap parameters set by the mapper.
+ */
+void write_binary_ir(const quantum_program *programp, const utils::Str &fname);
+
+/**
+ * Replaces the kernels of the program by those in the given file, which must
+ * have been written for the same platform. Gates that are defined by the
+ * platform configuration are recreated from their definition.
+ */
+void read_binary_ir(quantum_program *programp, const utils::Str &fname);
+
+} // namespace ql
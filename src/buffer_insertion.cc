@@ -8,19 +8,18 @@
  * a previous bundle and the current bundle are checked for a pair of operations
  * but the intended delay could be required between a bundler farther back
  * because the duration is longer so the current implementation may not do what
- * it intends. Below, the code is updated to modularity, but it is an exact copy
- * of what it was, with creating bundles from the circuit and updating the
- * circuit from the bundles around it. Once clarity is gained on intended
+ * it intends. Below, the code streams over the circuit and forms the bundles
+ * on the fly from the gates with equal cycle, but computes the same delays as
+ * the original bundle-based code did. Once clarity is gained on intended
  * functionality and use, it can be rewritten and corrected.
  */
 
+#include <algorithm>
 #include "utils/str.h"
-#include "utils/map.h"
 #include "utils/vec.h"
-#include "utils/pair.h"
 #include "kernel.h"
 #include "circuit.h"
-#include "ir.h"
+#include "latency_compensation.h"
 #include "report.h"
 
 #include "buffer_insertion.h"
@@ -29,78 +28,132 @@ namespace ql {
 
 using namespace utils;
 
-/*
-*/
-static void insert_buffer_delays_kernel(
-    quantum_kernel &kernel,
-    const quantum_platform &platform
-) {
+buffer_delays_t::buffer_delays_t(const quantum_platform &platform) :
+    platform(platform),
+    ntypes(platform.instruction_types.size()),
+    cycles(ntypes * ntypes, 0)
+{
     QL_DOUT("Loading buffer settings ...");
-    Map<Pair<Str, Str>, UInt> buffer_cycles_map;
 
-    // populate buffer map
+    // populate buffer table
     // 'none' type is the default type in case a gate doesn't specify one in the config file
     // it a dummy type and 0 buffer cycles will be inserted for instructions of type 'none'
     // for pairs of instructions not represented in the buffer settings in the config file, 0 is inserted as well
     //
     // this has nothing to do with dependence graph generation but with scheduling
     // so should be in resource-constrained scheduler constructor
-
     Vec<Str> optype_names = {"none", "mw", "flux", "readout", "extern"};
-    for (auto &buf1 : optype_names) {
-        for (auto &buf2 : optype_names) {
+    auto type_name = [&](UInt type_id) {
+        return type_id == quantum_platform::NO_TYPE ? Str("none") : platform.instruction_types[type_id];
+    };
+    for (UInt prev = 0; prev < ntypes; prev++) {
+        Str buf1 = type_name(prev);
+        if (std::find(optype_names.begin(), optype_names.end(), buf1) == optype_names.end()) {
+            continue;
+        }
+        for (UInt curr = 0; curr < ntypes; curr++) {
+            Str buf2 = type_name(curr);
+            if (std::find(optype_names.begin(), optype_names.end(), buf2) == optype_names.end()) {
+                continue;
+            }
             auto bname = buf1 + "_" + buf2 + "_buffer";
-            if (platform.hardware_settings.count(bname) > 0) {
-                buffer_cycles_map.set({buf1, buf2}) = UInt(ceil(
-                    static_cast<float>(platform.hardware_settings[bname]) /
+            if (platform.hardware_settings->count(bname) > 0) {
+                cycles[prev * ntypes + curr] = UInt(ceil(
+                    static_cast<float>((*platform.hardware_settings)[bname]) /
                     platform.cycle_time));
-            } else {
-                buffer_cycles_map.set({buf1, buf2}) = 0;
             }
-            QL_DOUT("Initializing " << bname << ": "<< buffer_cycles_map.get({buf1, buf2}));
+            QL_DOUT("Initializing " << bname << ": "<< cycles[prev * ntypes + curr]);
         }
     }
+}
+
+UInt buffer_delays_t::type_of(gate *gp) const {
+    const instruction_attributes_t *attr = platform.find_instruction_attributes(gp);
+    if (attr && attr->has_type) {
+        // so gate is specified in config file and it has a type attribute
+        return attr->type_id;
+    }
+    return quantum_platform::NO_TYPE;
+}
 
-    QL_DOUT("Buffer-buffer delay insertion ... ");
+UInt buffer_delays_t::get(UInt prev_type, UInt curr_type) const {
+    return cycles[prev_type * ntypes + curr_type];
+}
 
-    circuit *circp = &kernel.c;
-    ir::bundles_t bundles = ir::bundler(*circp, platform.cycle_time);
-
-    Vec<Str> optypes_prev_bundle;
-    UInt buffer_cycles_accum = 0;
-    for (ir::bundle_t &abundle : bundles) {
-        Vec<Str> optypes_curr_bundle;    // map of all gates in this bundle to their types
-        for (auto secIt = abundle.parallel_sections.begin(); secIt != abundle.parallel_sections.end(); ++secIt) {
-            for (auto insIt = secIt->begin(); insIt != secIt->end(); ++insIt) {
-                auto &id = (*insIt)->name;
-                Str op_type("none");    // default type attribute
-                if (platform.instruction_settings.count(id) > 0) {
-                    // so gate is specified in config file
-                    if (platform.instruction_settings[id].count("type") > 0) {
-                        // and it has a type attribute
-                        op_type = platform.instruction_settings[id]["type"].get<Str>();
-                    }
-                }
-                optypes_curr_bundle.push_back(op_type);
-            }
+buffer_inserter_t::buffer_inserter_t(
+    const buffer_delays_t &delays,
+    circuit &out
+) :
+    delays(delays),
+    out(out)
+{
+}
+
+void buffer_inserter_t::push(gate *gp) {
+    if (gp->type() == gate_type_t::__wait_gate__ ||    // FIXME HvS: wait must be written as well
+        gp->type() == gate_type_t::__dummy_gate__
+    ) {
+        QL_DOUT("... ignoring: " << gp->qasm());
+        return;
+    }
+    if (in_bundle && gp->cycle != bundle_cycle) {
+        if (gp->cycle < bundle_cycle) {
+            QL_FATAL("Error: circuit not ordered by cycle value");
         }
+        finish_bundle();
+    }
+    if (!in_bundle) {
+        in_bundle = true;
+        bundle_cycle = gp->cycle;
+        bundle_begin = out.size();
+    }
+    out.push_back(gp);
+    UInt type = delays.type_of(gp);
+    if (std::find(curr_types.begin(), curr_types.end(), type) == curr_types.end()) {
+        curr_types.push_back(type);
+    }
+}
 
-        UInt buffer_cycles = 0; // max of buffer_cycles for all combinations of optypes in current and previous bundle
-        for (auto &op_prev : optypes_prev_bundle) {
-            for (auto &op_curr : optypes_curr_bundle) {
-                auto temp_buf_cycles = buffer_cycles_map.get({op_prev, op_curr}, 0);
-                QL_DOUT("... considering buffer_" << op_prev << "_" << op_curr
-                                                  << ": " << temp_buf_cycles);
-                buffer_cycles = max(temp_buf_cycles, buffer_cycles);
-            }
+void buffer_inserter_t::finish_bundle() {
+    UInt buffer_cycles = 0; // max of buffer_cycles for all combinations of optypes in current and previous bundle
+    for (auto op_prev : prev_types) {
+        for (auto op_curr : curr_types) {
+            auto temp_buf_cycles = delays.get(op_prev, op_curr);
+            QL_DOUT("... considering buffer between types " << op_prev << " and " << op_curr
+                                                            << ": " << temp_buf_cycles);
+            buffer_cycles = max(temp_buf_cycles, buffer_cycles);
         }
-        QL_DOUT("... inserting buffer : " << buffer_cycles);
-        buffer_cycles_accum += buffer_cycles;
-        abundle.start_cycle = abundle.start_cycle + buffer_cycles_accum;
-        optypes_prev_bundle = optypes_curr_bundle;
     }
+    QL_DOUT("... inserting buffer : " << buffer_cycles);
+    buffer_cycles_accum += buffer_cycles;
+    for (UInt i = bundle_begin; i < out.size(); i++) {
+        out[i]->cycle = bundle_cycle + buffer_cycles_accum;
+    }
+    std::swap(prev_types, curr_types);
+    curr_types.clear();
+    in_bundle = false;
+}
 
-    *circp = ir::circuiter(bundles);
+void buffer_inserter_t::finish() {
+    if (in_bundle) {
+        finish_bundle();
+    }
+}
+
+void insert_buffer_delays_kernel(
+    quantum_kernel &kernel,
+    const buffer_delays_t &delays
+) {
+    QL_DOUT("Buffer-buffer delay insertion ... ");
+
+    circuit out;
+    out.reserve(kernel.c.size());
+    buffer_inserter_t inserter(delays, out);
+    for (auto gp : kernel.c) {
+        inserter.push(gp);
+    }
+    inserter.finish();
+    kernel.c.swap(out);
 
     QL_DOUT("Buffer-buffer delay insertion [DONE] ");
 }
@@ -113,10 +166,71 @@ void insert_buffer_delays(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    for (auto &kernel : programp->kernels) {
-        insert_buffer_delays_kernel(kernel, platform);
+    buffer_delays_t delays(platform);
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
+        insert_buffer_delays_kernel(kernel, delays);
+    });
+
+    report_statistics(programp, platform, "out", passname, "# ");
+    report_qasm(programp, platform, "out", passname);
+}
+
+/*
+ * Streams the gates of the kernel through the latency compensation window
+ * right into buffer insertion, so that each gate is visited once. The window
+ * needs the circuit ordered by cycle, as the scheduler leaves it; other
+ * circuits take the two steps one after the other.
+ */
+static void compensate_latency_and_insert_buffer_delays_kernel(
+    quantum_kernel &kernel,
+    const quantum_platform &platform,
+    const buffer_delays_t &delays
+) {
+    QL_DOUT("Latency compensation and buffer-buffer delay insertion ...");
+
+    circuit &circ = kernel.c;
+    auto ordered = std::is_sorted(circ.begin(), circ.end(), [](gate *gp1, gate *gp2) {
+        return gp1->cycle < gp2->cycle;
+    });
+    if (!ordered) {
+        latency_compensation_kernel(kernel, platform);
+        insert_buffer_delays_kernel(kernel, delays);
+        return;
     }
 
+    circuit out;
+    out.reserve(circ.size());
+    latency_window_t window(platform);
+    buffer_inserter_t inserter(delays, out);
+    for (auto gp : circ) {
+        window.push(gp);
+        while (window.ready()) {
+            inserter.push(window.pop());
+        }
+    }
+    window.finish();
+    while (window.ready()) {
+        inserter.push(window.pop());
+    }
+    inserter.finish();
+    circ.swap(out);
+
+    QL_DOUT("Latency compensation and buffer-buffer delay insertion [DONE]");
+}
+
+void compensate_latency_and_insert_buffer_delays(
+    quantum_program *programp,
+    const quantum_platform &platform,
+    const Str &passname
+) {
+    report_statistics(programp, platform, "in", passname, "# ");
+    report_qasm(programp, platform, "in", passname);
+
+    buffer_delays_t delays(platform);
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
+        compensate_latency_and_insert_buffer_delays_kernel(kernel, platform, delays);
+    });
+
     report_statistics(programp, platform, "out", passname, "# ");
     report_qasm(programp, platform, "out", passname);
 }
@@ -6,12 +6,71 @@
 
 #pragma once
 
+#include "utils/num.h"
 #include "utils/str.h"
+#include "utils/vec.h"
+#include "gate.h"
+#include "circuit.h"
 #include "program.h"
 #include "platform.h"
 
 namespace ql {
 
+/**
+ * Buffer delays in cycles between the operation types of a platform, from the
+ * <type1>_<type2>_buffer hardware settings, as a table indexed by the type ids
+ * of the instructions (see quantum_platform::instruction_types) so that no
+ * strings need to be compared per gate. Instructions without type are of type
+ * "none"; types other than none, mw, flux, readout and extern have no buffers.
+ */
+class buffer_delays_t {
+public:
+    explicit buffer_delays_t(const quantum_platform &platform);
+
+    // type id of the instruction of gp, quantum_platform::NO_TYPE when it has none
+    utils::UInt type_of(gate *gp) const;
+
+    // buffer cycles between a gate of type prev_type and a later one of type curr_type
+    utils::UInt get(utils::UInt prev_type, utils::UInt curr_type) const;
+
+private:
+    const quantum_platform &platform;
+    utils::UInt ntypes;
+    utils::Vec<utils::UInt> cycles;
+};
+
+/**
+ * Inserts buffer delays in a stream of gates arriving in non-decreasing cycle
+ * order, appending them to a circuit. The gates with the same cycle form a
+ * bundle; each bundle is delayed by the largest buffer between a type in the
+ * previous bundle and a type in this one, on top of the delays of the bundles
+ * before it. Wait and dummy gates are dropped, as bundling did.
+ */
+class buffer_inserter_t {
+public:
+    buffer_inserter_t(const buffer_delays_t &delays, circuit &out);
+
+    void push(gate *gp);
+    void finish();
+
+private:
+    void finish_bundle();
+
+    const buffer_delays_t &delays;
+    circuit &out;
+    utils::Bool in_bundle = false;
+    utils::UInt bundle_cycle = 0;           // cycle of the gates of the current bundle as pushed
+    utils::UInt bundle_begin = 0;           // index in out of the first gate of the current bundle
+    utils::UInt buffer_cycles_accum = 0;
+    utils::Vec<utils::UInt> prev_types;     // distinct type ids in the previous bundle
+    utils::Vec<utils::UInt> curr_types;     // distinct type ids in the current bundle
+};
+
+void insert_buffer_delays_kernel(
+    quantum_kernel &kernel,
+    const buffer_delays_t &delays
+);
+
 // buffer_delay_insertion pass
 void insert_buffer_delays(
     quantum_program *programp,
@@ -19,4 +78,12 @@ void insert_buffer_delays(
     const utils::Str &passname
 );
 
+// latency compensation followed by buffer delay insertion, as one pass over
+// each kernel; the result is the same as that of the two passes in sequence
+void compensate_latency_and_insert_buffer_delays(
+    quantum_program *programp,
+    const quantum_platform &platform,
+    const utils::Str &passname
+);
+
 } // namespace ql
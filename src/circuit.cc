@@ -24,7 +24,8 @@ void print(const circuit &c) {
 Str qasm(const circuit& c) {
     StrStrm ss;
     for (auto gate : c) {
-        ss << gate->qasm() << "\n";
+        gate->write_qasm(ss);
+        ss << "\n";
     }
     return ss.str();
 }
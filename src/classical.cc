@@ -184,21 +184,18 @@ classical::classical(const Str &operation) {
     }
 }
 
-instruction_t classical::qasm() const {
-    Str iopers;
-    Int sz = creg_operands.size();
-    for (Int i = 0; i < sz; ++i) {
-        if (i == sz - 1) {
-            iopers += " r" + to_string(creg_operands[i]);
-        } else {
-            iopers += " r" + to_string(creg_operands[i]) + ",";
+void classical::write_qasm(std::ostream &os) const {
+    os << name;
+    UInt sz = creg_operands.size();
+    for (UInt i = 0; i < sz; ++i) {
+        os << " r" << creg_operands[i];
+        if (i != sz - 1) {
+            os << ",";
         }
     }
 
     if (name == "ldi") {
-        return "ldi" + iopers + ", " + to_string(int_operand);
-    } else {
-        return name + iopers;
+        os << ", " << int_operand;
     }
 }
 
@@ -80,7 +80,7 @@ public:
 
     classical(const creg &dest, const operation &oper);
     classical(const utils::Str &operation);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
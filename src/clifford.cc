@@ -295,10 +295,10 @@ void clifford_optimize(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    Clifford cliff;
-    for (auto &kernel : programp->kernels) {
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
+        Clifford cliff;
         cliff.clifford_optimize_kernel(kernel, platform, passname);
-    }
+    });
 
     report_statistics(programp, platform, "out", passname, "# ");
     report_qasm(programp, platform, "out", passname);
@@ -6,10 +6,18 @@
 
 #include "commute_variation.h"
 
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include "utils/num.h"
 #include "utils/list.h"
 #include "utils/map.h"
+#include "utils/opt.h"
+#include "utils/arena.h"
 #include "utils/filesystem.h"
+#include "utils/thread_pool.h"
 #include "scheduler.h"
 #include "options.h"
 #include "report.h"
@@ -53,24 +61,139 @@ using namespace utils;
       - and in any case then the added dependences are deleted so that the depgraph is restored to its original state.
     One of the variations with the least depth is stored in the current circuit as result of this variation search.
     Also, the scheduler_commute option is turned off so that future schedulers will respect the found order.
+
+    The number of variations is the product of the factorials of the sizes of the commutable sets,
+    so enumerating all of them (vary_commutations=yes) is only feasible for small circuits.
+    With vary_commutations=bounded, the variations are instead searched by branch and bound:
+    - the search orders the gates of the commutable sets one by one, depth first,
+      adding the ZAZ/XAX dependence from the previously ordered gate of the set to the gate when doing so,
+      and removing it again when backtracking; the choices made are kept along the way, instead of the
+      variation number, since the number of variations easily exceeds what fits in a VarCode
+    - before adding such a dependence, it is checked whether the gate already reaches the previously ordered one;
+      then the dependence would close a cycle and the whole subtree of variations is rejected
+    - each time a set has been completely ordered, the critical path length of the partially ordered dependence graph
+      is computed; it is a lower bound of the depth of the schedule of all variations in the subtree,
+      since dependences are only added in the subtree and the resource-constrained scheduler respects all of them;
+      when it exceeds the least depth found so far, the subtree is pruned
+    - only the complete variations that remain are scheduled; the least depth is kept with the lowest variation
+      (in the order of the variation numbers) having it, so that the result is that of the exhaustive enumeration
+    The search can be given a budget in number of scheduled variations (vary_commutations_max_variations)
+    and in wall-clock time (vary_commutations_max_time); when exhausted, the best variation found until then is taken.
+    The search is split on the first choices it makes into independent subtrees, which are searched
+    using vary_commutations_threads threads, each on its own copy of the dependence graph and of the gates,
+    since scheduling sets the cycle of the gates.
+    Since subtrees are only pruned when they cannot contain a variation with the least depth,
+    the result does not depend on the number of threads, unless the budget is exhausted.
 */
 
 // each variation is encoded in a number
 typedef UInt VarCode;
 
+// number of variations when it doesn't fit in a VarCode
+static const VarCode TOO_MANY_VARIATIONS = std::numeric_limits<VarCode>::max();
+
+// a variation as the choices that encode it: for each commutable set in turn, the indices of its gates
+// in the order that they are taken, each index counting only the gates not taken yet, so 0 <= index < number left
+typedef Vec<UInt> VarChoices;
+
+// whether variation a has a lower variation number than variation b with the same number of choices;
+// the first choice is the least significant digit of the variation number
+static Bool lower_variation(const VarChoices &a, const VarChoices &b) {
+    for (UInt i = a.size(); i-- > 0; ) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    return false;
+}
+
+// state of the bounded search of a kernel, shared by the threads searching its subtrees
+class SearchState {
+private:
+    std::mutex mutex;
+    UInt max_variations;                        // budget in number of scheduled variations
+    Bool has_deadline;
+    std::chrono::steady_clock::time_point deadline;   // budget in wall-clock time, when has_deadline
+    Bool found;                                 // whether a variation was scheduled
+    UInt best_depth;                            // least depth found so far, MAX_CYCLE when none
+    VarChoices best_choices;                    // lowest variation with best_depth
+
+public:
+    std::atomic<Bool> exhausted;                // whether the budget was exhausted
+    UInt scheduled;                             // number of variations scheduled
+    std::atomic<UInt> pruned;                   // number of subtrees pruned by the lower bound
+    std::atomic<UInt> cyclic;                   // number of subtrees rejected because of a dependence cycle
+
+    SearchState(UInt max_variations, Real max_seconds) :
+        max_variations(max_variations), has_deadline(max_seconds < INF), found(false),
+        best_depth(MAX_CYCLE), exhausted(false), scheduled(0), pruned(0), cyclic(0)
+    {
+        if (has_deadline) {
+            deadline = std::chrono::steady_clock::now()
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<Real>(max_seconds));
+        }
+    }
+
+    // whether the search must stop because the wall-clock budget was exhausted (or the other one before)
+    Bool out_of_time() {
+        if (!exhausted && has_deadline && std::chrono::steady_clock::now() >= deadline) {
+            exhausted = true;
+        }
+        return exhausted;
+    }
+
+    // claim the scheduling of another variation; fails when the variation budget is exhausted
+    Bool claim_variation() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (scheduled >= max_variations) {
+            exhausted = true;
+            return false;
+        }
+        scheduled++;
+        return true;
+    }
+
+    UInt get_best_depth() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return best_depth;
+    }
+
+    // report the depth of a scheduled variation
+    void add_result(UInt depth, const VarChoices &choices) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!found || depth < best_depth || (depth == best_depth && lower_variation(choices, best_choices))) {
+            found = true;
+            best_depth = depth;
+            best_choices = choices;
+        }
+    }
+
+    // the best variation, when found
+    Bool get_best(UInt &depth, VarChoices &choices) {
+        std::lock_guard<std::mutex> lock(mutex);
+        depth = best_depth;
+        choices = best_choices;
+        return found;
+    }
+};
+
 // Scheduler class extension with entries to find the variations based on the dependence graph.
 class Depgraph : public Scheduler {
 private:
-    // variation encoding multiply function aiming to catch overflow
+    // multiply numbers of variations, giving TOO_MANY_VARIATIONS when the product doesn't fit
     VarCode mult(VarCode a, VarCode b) {
-        VarCode    r = a * b;
-        if (r < a || r < b) {
-            QL_FATAL("Error: number of variations more than fits in unsigned long");
+        if (a == TOO_MANY_VARIATIONS || b == TOO_MANY_VARIATIONS || (a != 0 && b >= TOO_MANY_VARIATIONS / a)) {
+            return TOO_MANY_VARIATIONS;
         }
-        return r;
+        return a * b;
     }
 
 public:
+    // the variations are generated by modifying the lemon graph
+    Depgraph() {
+        graph_required = true;
+    }
+
     // after scheduling, delete the added arcs (ZAZ/XAX) from the depgraph to restore it to the original state
     void clean_variation( List<lemon::ListDigraph::Arc>& newarcslist) {
         for (auto a : newarcslist) {
@@ -78,17 +201,42 @@ public:
             graph.erase(a);
         }
         newarcslist.clear();
+        graph_to_arrays();
+    }
+
+    // the choices encoded by variation number var
+    VarChoices varchoices(
+        const List<List<lemon::ListDigraph::Arc>>& varslist,
+        VarCode var
+    ) {
+        VarChoices choices;
+        for (const auto &subvarslist : varslist) {
+            for (auto svs = subvarslist.size(); svs != 0; svs--) {
+                choices.push_back(var % svs);
+                var = var / svs;
+            }
+        }
+        return choices;
     }
 
     // return encoding of variation var as a string for debugging output
     Str varstring(
-        List<List<lemon::ListDigraph::Arc>>& varslist,
+        const List<List<lemon::ListDigraph::Arc>>& varslist,
         VarCode var
+    ) {
+        return varstring(varslist, varchoices(varslist, var));
+    }
+
+    // return the choices of a variation as a string for debugging output and statistics
+    Str varstring(
+        const List<List<lemon::ListDigraph::Arc>>& varslist,
+        const VarChoices &choices
     ) {
         StrStrm ss;
 
+        UInt choice = 0;
         Int varslist_index = 1;
-        for (auto subvarslist : varslist) {
+        for (const auto &subvarslist : varslist) {
             if (varslist_index != 1) {
                 ss << "|";
             }
@@ -96,9 +244,7 @@ public:
                 if (svs != subvarslist.size()) {
                     ss << "-";
                 }
-                auto thisone = var % svs;
-                ss << thisone;
-                var = var / svs;
+                ss << choices[choice++];
             }
             varslist_index++;
         }
@@ -113,18 +259,29 @@ public:
         List<List<lemon::ListDigraph::Arc>>& varslist,
         List<lemon::ListDigraph::Arc>& newarcslist,
         VarCode var
+    ) {
+        QL_DOUT("... variation " << var << ":");
+        gen_variation(varslist, newarcslist, varchoices(varslist, var));
+    }
+
+    // same, for the variation given by its choices
+    void gen_variation(
+        List<List<lemon::ListDigraph::Arc>>& varslist,
+        List<lemon::ListDigraph::Arc>& newarcslist,
+        const VarChoices &choices
     ) {
         List<List<lemon::ListDigraph::Arc>> recipe_varslist = varslist;  // deepcopy, i.e. must copy each sublist of list as well
-        QL_DOUT("... variation " << var << " (" << varstring(varslist,var) << "):");
+        QL_DOUT("... variation " << varstring(varslist, choices) << ":");
         QL_DOUT("... recipe_varslist.size()=" << recipe_varslist.size());
+        UInt choice = 0;
         Int varslist_index = 1;
         for (auto subvarslist : recipe_varslist) {
             QL_DOUT("... subvarslist index=" << varslist_index << " subvarslist.size()=" << subvarslist.size());
             Bool prevvalid = false;             // add arc between each pair of nodes so skip 1st arc in subvarslist
             lemon::ListDigraph::Node    prevn = s;     // previous node when prevvalid==true; fake initialization by s
             for (auto svs = subvarslist.size(); svs != 0; svs--) {
-                auto thisone = var % svs;     // gives 0 <= thisone < subvarslist.size()
-                QL_DOUT("...... var=" << var << " svs=" << svs << " thisone=var%svs=" << thisone << " nextvar=var/svs=" << var/svs);
+                auto thisone = choices[choice++];     // gives 0 <= thisone < subvarslist.size()
+                QL_DOUT("...... svs=" << svs << " thisone=" << thisone);
                 auto li = subvarslist.begin();
                 std::advance(li, thisone);
                 lemon::ListDigraph::Arc a = *li;   // i.e. select the thisone's element in this subvarslist
@@ -142,10 +299,10 @@ public:
                 prevvalid = true;
                 prevn = n;
                 subvarslist.erase(li);      // take thisone's element out of the subvarslist, reducing it to list one element shorter
-                var = var / svs;              // take out the current subvarslist.size() out of the encoding
             }
             varslist_index++;
         }
+        graph_to_arrays();
     }
 
     // split the incoming dependences (in arclist) into a separate set for each qubit cause
@@ -193,10 +350,10 @@ public:
                 lemon::ListDigraph::Node srcNode  = graph.source(a);
                 QL_DOUT("... " << instruction[srcNode]->qasm() << " as " << DepTypeName[depType[a]] << " by q" << cause[a]);
                 perm_index++;
-                perm_count *= perm_index;
+                perm_count = mult(perm_count, perm_index);
             }
             QL_DOUT("Giving rise to " << perm_count << " variations");
-            var_count *= perm_count;
+            var_count = mult(var_count, perm_count);
             list_index++;
         }
         QL_DOUT("Total " << var_count << " variations");
@@ -224,6 +381,8 @@ public:
                     ||  depType[arc] == DAD
                     ||  depType[arc] == ZAD
                     ||  depType[arc] == XAD
+                    ||  depType[arc] == XAX     // sequentializing non-commuting rotations
+                    ||  depType[arc] == ZAZ
                 ) {
                     continue;
                 }
@@ -248,6 +407,145 @@ public:
         }
     }
 
+    // whether there is a path from node from to node to in the depgraph
+    Bool reaches(lemon::ListDigraph::Node from, lemon::ListDigraph::Node to) {
+        Vec<Bool> visited(graph.maxNodeId() + 1, false);
+        Vec<lemon::ListDigraph::Node> stack;
+        stack.push_back(from);
+        visited[graph.id(from)] = true;
+        while (!stack.empty()) {
+            lemon::ListDigraph::Node n = stack.back();
+            stack.pop_back();
+            if (n == to) {
+                return true;
+            }
+            for (lemon::ListDigraph::OutArcIt arc(graph, n); arc != lemon::INVALID; ++arc) {
+                lemon::ListDigraph::Node m = graph.target(arc);
+                if (!visited[graph.id(m)]) {
+                    visited[graph.id(m)] = true;
+                    stack.push_back(m);
+                }
+            }
+        }
+        return false;
+    }
+
+    // lower bound of the depth that schedule_rc computes for the depgraph and for the depgraph with any dependences added;
+    // the resource-constrained scheduler respects the dependences, so each gate starts at least its critical path length
+    // (the longest path to it from the gates without predecessors) after the first gate,
+    // and the last gate to start executes for at least the shortest duration
+    UInt critical_path_length() {
+        UInt node_count = graph.maxNodeId() + 1;
+        Vec<UInt> pred_count(node_count, 0);
+        Vec<UInt> start(node_count, 0);
+        for (lemon::ListDigraph::ArcIt arc(graph); arc != lemon::INVALID; ++arc) {
+            pred_count[graph.id(graph.target(arc))]++;
+        }
+        Bool any_gate = false;
+        UInt max_start = 0;
+        UInt min_duration = 0;
+        Vec<lemon::ListDigraph::Node> ready;
+        ready.push_back(s);
+        while (!ready.empty()) {
+            lemon::ListDigraph::Node n = ready.back();
+            ready.pop_back();
+            UInt n_start = start[graph.id(n)];
+            if (n != s && n != t) {
+                UInt duration = (instruction[n]->duration + cycle_time - 1) / cycle_time;
+                max_start = max<UInt>(max_start, n_start);
+                min_duration = any_gate ? min<UInt>(min_duration, duration) : duration;
+                any_gate = true;
+            }
+            for (lemon::ListDigraph::OutArcIt arc(graph, n); arc != lemon::INVALID; ++arc) {
+                UInt m = graph.id(graph.target(arc));
+                if (n != s) {
+                    start[m] = max<UInt>(start[m], n_start + weight[arc]);
+                }
+                if (--pred_count[m] == 0) {
+                    ready.push_back(graph.target(arc));
+                }
+            }
+        }
+        return any_gate ? max_start + min_duration : 0;
+    }
+
+    // bounded search of the subtree of variations below the given partial variation, see the top of this file;
+    // open[set] are the gates of each commutable set that are still to be ordered, in the order in which
+    // the variation encoding refers to them, and last[set] the gate ordered last when some of them were;
+    // choices are the choices made so far; the first forced.size() choices are the ones in forced
+    void search(
+        const Vec<Vec<lemon::ListDigraph::Arc>> &sets,
+        const Vec<UInt> &forced,
+        SearchState &state,
+        const quantum_platform &platform,
+        Vec<Vec<lemon::ListDigraph::Arc>> &open,
+        Vec<lemon::ListDigraph::Node> &last,
+        UInt set,
+        VarChoices &choices
+    ) {
+        if (state.out_of_time()) {
+            return;
+        }
+        if (set == sets.size()) {
+            if (!state.claim_variation()) {
+                return;
+            }
+            graph_to_arrays();
+            auto depth = schedule_rc(platform);
+            QL_DOUT("... scheduled variation " << choices << ", depth=" << depth);
+            state.add_result(depth, choices);
+            return;
+        }
+        if (open[set].empty()) {
+            // this set has been ordered completely; bound before ordering the next one
+            if (critical_path_length() > state.get_best_depth()) {
+                state.pruned++;
+                return;
+            }
+            search(sets, forced, state, platform, open, last, set + 1, choices);
+            return;
+        }
+
+        UInt svs = open[set].size();
+        Bool first = svs == sets[set].size();
+        UInt choice = choices.size();
+        for (UInt i = 0; i < svs; i++) {
+            if (choice < forced.size() && i != forced[choice]) {
+                continue;
+            }
+            lemon::ListDigraph::Arc a = open[set][i];
+            lemon::ListDigraph::Node n = graph.source(a);
+            lemon::ListDigraph::Node prevn = last[set];
+            lemon::ListDigraph::Arc newarc;
+            if (!first) {
+                if (reaches(n, prevn)) {
+                    // ordering n after prevn contradicts the dependences; so do all variations below
+                    state.cyclic++;
+                    continue;
+                }
+                newarc = graph.addArc(prevn, n);
+                weight[newarc] = weight[a];
+                cause[newarc] = cause[a];
+                depType[newarc] = (depType[a] == DAZ ? ZAZ : XAX);
+            }
+            last[set] = n;
+            open[set].erase(open[set].begin() + i);
+
+            choices.push_back(i);
+            search(sets, forced, state, platform, open, last, set, choices);
+            choices.pop_back();
+
+            open[set].insert(open[set].begin() + i, a);
+            last[set] = prevn;
+            if (!first) {
+                graph.erase(newarc);
+            }
+            if (state.exhausted) {
+                return;
+            }
+        }
+    }
+
     // schedule the constructed depgraph for the platform with resource constraints and return the resulting depth
     UInt schedule_rc(const quantum_platform& platform) {
         Str schedopt = options::get("scheduler");
@@ -275,6 +573,49 @@ public:
     }
 };
 
+// copy of a gate for scheduling variations concurrently; the scheduler sets the cycle of the gates it schedules
+// (and the platform caches the instruction of the gate in it), so concurrent schedules need their own gates;
+// everything else is taken from the gate that is copied
+class gate_copy : public gate {
+private:
+    const gate *original;
+public:
+    explicit gate_copy(const gate &g) : gate(g), original(&g) {}
+    void write_qasm(std::ostream &os) const override { original->write_qasm(os); }
+    gate_type_t type() const override { return original->type(); }
+    cmat_t mat() const override { return original->mat(); }
+};
+
+// dependence graph of a copy of a kernel's circuit, with its commutable sets, for the bounded search
+class SearchGraph {
+public:
+    Arena gates;                                            // owns the gate copies in ckt
+    circuit ckt;
+    Depgraph sched;
+    Vec<Vec<lemon::ListDigraph::Arc>> sets;                 // the commutable sets, as found in sched
+
+    SearchGraph(const quantum_kernel &kernel, const quantum_platform &platform) {
+        for (auto gp : kernel.c) {
+            ckt.push_back(gates.make<gate_copy>(*gp));
+        }
+        sched.init(ckt, platform, platform.qubit_number, kernel.creg_count, kernel.breg_count);
+        List<List<lemon::ListDigraph::Arc>> varslist;
+        VarCode total = 1;
+        sched.find_variations(varslist, total);
+        for (auto &subvarslist : varslist) {
+            sets.emplace_back(subvarslist.begin(), subvarslist.end());
+        }
+    }
+
+    // search the subtree of variations that starts with the given choices
+    void search(const Vec<UInt> &forced, SearchState &state, const quantum_platform &platform) {
+        Vec<Vec<lemon::ListDigraph::Arc>> open = sets;
+        Vec<lemon::ListDigraph::Node> last(sets.size(), sched.s);
+        VarChoices choices;
+        sched.search(sets, forced, state, platform, open, last, 0, choices);
+    }
+};
+
 // generate variations and keep the one with the least depth in the current kernel's circuit
 class commute_variation_c {
 private:
@@ -312,23 +653,104 @@ private:
         OutFile(ss_output_file.str()).write(ss_qasm.str());
     }
 
+    // bounded search for the variation with the least depth (see the top of this file);
+    // return whether one was found, and then its choices and depth
+    Bool search(
+        const quantum_kernel &kernel,
+        const quantum_platform &platform,
+        const List<List<lemon::ListDigraph::Arc>> &varslist,
+        VarChoices &result_choices,
+        UInt &min_depth,
+        StrStrm &stats
+    ) {
+        auto maxvarsopt = options::get("vary_commutations_max_variations");
+        auto maxtimeopt = options::get("vary_commutations_max_time");
+        auto threadsopt = options::get("vary_commutations_threads");
+        UInt max_variations = (maxvarsopt == "inf") ? MAX : parse_uint(maxvarsopt);
+        Real max_seconds = (maxtimeopt == "inf") ? INF : parse_real(maxtimeopt);
+        UInt nthreads = (threadsopt == "max") ? ThreadPool::hardware_threads() : parse_uint(threadsopt);
+        SearchState state(max_variations, max_seconds);
+
+        // split the search into subtrees by forcing its first choices, enough of them to keep the threads busy;
+        // the radix of a choice is the number of gates of its set that are still to be ordered
+        Vec<UInt> radices;
+        for (const auto &subvarslist : varslist) {
+            for (auto svs = subvarslist.size(); svs != 0; svs--) {
+                radices.push_back(svs);
+            }
+        }
+        UInt nforced = 0;
+        UInt nsubtrees = 1;
+        if (nthreads > 1) {
+            while (nforced < radices.size() && nsubtrees < 16 * nthreads) {
+                nsubtrees *= radices[nforced];
+                nforced++;
+            }
+        }
+        QL_DOUT("Bounded search of variations in " << nsubtrees << " subtrees using " << nthreads << " threads ...");
+
+        // each thread takes a copy of the dependence graph from the idle ones, or makes one when there is none
+        std::mutex graphs_mutex;
+        List<std::unique_ptr<SearchGraph>> idle_graphs;
+        auto context = options::active_context();
+        auto search_subtree = [&](UInt subtree) {
+            options::Scope scope(context);
+            Vec<UInt> forced;
+            for (UInt i = 0; i < nforced; i++) {
+                forced.push_back(subtree % radices[i]);
+                subtree /= radices[i];
+            }
+            std::unique_ptr<SearchGraph> graph;
+            {
+                std::lock_guard<std::mutex> lock(graphs_mutex);
+                if (!idle_graphs.empty()) {
+                    graph = std::move(idle_graphs.front());
+                    idle_graphs.pop_front();
+                }
+            }
+            if (!graph) {
+                graph.reset(new SearchGraph(kernel, platform));
+            }
+            graph->search(forced, state, platform);
+            std::lock_guard<std::mutex> lock(graphs_mutex);
+            idle_graphs.push_back(std::move(graph));
+        };
+        if (nthreads > 1) {
+            ThreadPool(nthreads).for_each(nsubtrees, search_subtree);
+        } else {
+            search_subtree(0);
+        }
+
+        Bool found = state.get_best(min_depth, result_choices);
+        stats << "# ----- variations scheduled: " << state.scheduled << std::endl;
+        stats << "# ----- partial variations pruned by critical path: " << state.pruned << std::endl;
+        stats << "# ----- partial variations rejected by dependence cycle: " << state.cyclic << std::endl;
+        if (state.exhausted) {
+            stats << "# ----- search budget exhausted" << std::endl;
+        }
+        return found;
+    }
+
 public:
 
-    void generate(
+    // replace the kernel's circuit by its variation with the least depth and write statistics on this to stats;
+    // returns whether the circuit was replaced
+    Bool generate(
         const quantum_program *programp,
         quantum_kernel& kernel,
-        const quantum_platform & platform
+        const quantum_platform & platform,
+        StrStrm &stats
     ) {
         QL_DOUT("Generate commutable variations of kernel circuit ...");
         circuit &ckt = kernel.c;
         if (ckt.empty()) {
             QL_DOUT("Empty kernel " << kernel.name);
-            return;
+            return false;
         }
         if (options::get("scheduler_commute") == "no") {
             QL_COUT("Scheduler_commute option is \"no\": don't generate commutation variations");
             QL_DOUT("Scheduler_commute option is \"no\": don't generate commutation variations");
-            return;
+            return false;
         }
     
         QL_DOUT("Create a dependence graph and recognize commutation");
@@ -340,7 +762,54 @@ public:
         VarCode total = 1;
         sched.find_variations(varslist, total);
         sched.show_sets(varslist);
-    
+        stats << "# ----- kernel " << kernel.name << ": commutable sets: " << varslist.size() << ", variations: ";
+        if (total == TOO_MANY_VARIATIONS) {
+            stats << "more than " << TOO_MANY_VARIATIONS << std::endl;
+        } else {
+            stats << total << std::endl;
+        }
+
+        VarChoices result_choices;
+        UInt min_depth;
+        if (options::get("vary_commutations") == "bounded") {
+            if (!search(kernel, platform, varslist, result_choices, min_depth, stats)) {
+                QL_DOUT("No variation was scheduled within the search budget; kernel circuit is left unchanged");
+                return false;
+            }
+            QL_DOUT("Min depth=" << min_depth << ", selected variation " << sched.varstring(varslist, result_choices));
+            stats << "# ----- best depth: " << min_depth << " (variation " << sched.varstring(varslist, result_choices) << ")" << std::endl;
+        } else {
+            if (total == TOO_MANY_VARIATIONS) {
+                QL_FATAL("Error: number of variations more than fits in unsigned long; use vary_commutations=bounded");
+            }
+            VarCode result_varno;
+            enumerate(platform, sched, varslist, total, result_varno, min_depth);
+            result_choices = sched.varchoices(varslist, result_varno);
+            stats << "# ----- best depth: " << min_depth << " (variation " << result_varno << ")" << std::endl;
+        }
+
+        // Find out which depth heuristics would find
+        auto hdepth = sched.schedule_rc(platform);
+        QL_DOUT("Note that heuristics would find a schedule of the circuit with depth " << hdepth);
+
+        // Set kernel.c representing result variation by regenerating it and scheduling it ...
+        List<lemon::ListDigraph::Arc> newarcslist;
+        sched.gen_variation(varslist, newarcslist, result_choices);
+        (void) sched.schedule_rc(platform); // sets kernel.c reflecting the additional deps of the variation
+        sched.clean_variation(newarcslist);
+        QL_DOUT("Find circuit with minimum depth while exploiting commutation [Done]");
+        return true;
+    }
+
+    // enumerate all variations, schedule each and find the one with the least depth
+    void enumerate(
+        const quantum_platform &platform,
+        Depgraph &sched,
+        List<List<lemon::ListDigraph::Arc>> &varslist,
+        VarCode total,
+        VarCode &result_varno,
+        UInt &min_depth
+    ) {
         QL_DOUT("Start enumerating " << total << " variations ...");
         QL_DOUT("=========================\n\n");
     
@@ -374,56 +843,58 @@ public:
             QL_DOUT("... depth " << vit->first << ": " << vit->second.size() << " variations");
         }
         auto mit = vars_per_depth.begin();
-        auto min_depth = mit->first;
+        min_depth = mit->first;
         auto vars = mit->second;
-        auto result_varno = vars.front();       // just the first one, could be more sophisticated
+        result_varno = vars.front();       // just the first one, could be more sophisticated
         QL_DOUT("Min depth=" << min_depth << ", number of variations=" << vars.size() << ", selected varno=" << result_varno);
-    
-        // Find out which depth heuristics would find
-        auto hdepth = sched.schedule_rc(platform);
-        QL_DOUT("Note that heuristics would find a schedule of the circuit with depth " << hdepth);
-    
-        // Set kernel.c representing result variation by regenerating it and scheduling it ...
-        sched.gen_variation(varslist, newarcslist, result_varno);
-        (void) sched.schedule_rc(platform); // sets kernel.c reflecting the additional deps of the variation
-        sched.clean_variation(newarcslist);
-        QL_DOUT("Find circuit with minimum depth while exploiting commutation [Done]");
-    
-        options::set("scheduler_commute", "no");    // next schedulers will respect the commutation order found
     }
 };
 
-static void commute_variation_kernel(
+static Bool commute_variation_kernel(
     quantum_program *programp,
     quantum_kernel &kernel,
-    const quantum_platform &platform
+    const quantum_platform &platform,
+    StrStrm &stats
 ) {
     QL_DOUT("Commute variation ...");
+    Bool varied = false;
     if (!kernel.c.empty()) {
-        if( options::get("vary_commutations") == "yes" ) {
+        if( options::get("vary_commutations") != "no" ) {
             // find the shortest circuit by varying on gate commutation; replace kernel.c by it
             commute_variation_c   cv;
-            cv.generate(programp, kernel, platform);
+            varied = cv.generate(programp, kernel, platform, stats);
         }
     }
 
     QL_DOUT("Commute variation [DONE]");
+    return varied;
 }
 
 void commute_variation(
     quantum_program *programp,              // updates the circuits of the program
     const quantum_platform &platform,
-    const Str &passname
+    const Str &passname,
+    Str *statistics
 ) {
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    for (UInt k = 0; k < programp->kernels.size(); ++k) {
-        commute_variation_kernel(programp, programp->kernels[k], platform);
+    std::atomic<Bool> varied{false};
+    Str stats = programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &ss) {
+        if (commute_variation_kernel(programp, kernel, platform, ss)) {
+            varied = true;
+        }
+    });
+    if (varied) {
+        options::set("scheduler_commute", "no");    // next schedulers will respect the commutation orders found
     }
 
-    report_statistics(programp, platform, "out", passname, "# ");
+    report_statistics(programp, platform, "out", passname, "# ", stats);
     report_qasm(programp, platform, "out", passname);
+
+    if (statistics) {
+        *statistics += stats;
+    }
 }
 
 } // namespace ql
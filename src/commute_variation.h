@@ -37,6 +37,15 @@
  * that those incoming dependencies come from; those nodes form the commutable
  * sets. Recognition of commutation during dependency graph construction is
  * enabled by pre-setting the option scheduler_commute to yes.
+ *
+ * The option vary_commutations selects between enumerating all variations
+ * (yes), of which there are the product of the factorials of the sizes of the
+ * commutable sets, and a branch-and-bound search (bounded) that rejects
+ * partial orders of the sets as soon as they are cyclic and prunes those of
+ * which the critical path already exceeds the least depth found. The bounded
+ * search can be limited in the number of variations it schedules and in time,
+ * and can be done using multiple threads; see commute_variation.cc. The best
+ * depth found is reported in the pass statistics.
  */
 
 #pragma once
@@ -51,7 +60,8 @@ namespace ql {
 void commute_variation(
     quantum_program *programp,              // updates the circuits of the program
     const quantum_platform &platform,
-    const utils::Str &passname
+    const utils::Str &passname,
+    utils::Str *statistics = nullptr        // when non-null, the statistics of the pass are appended to it
 );
 
 } // namespace ql
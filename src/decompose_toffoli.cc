@@ -28,12 +28,14 @@ static void decompose_toffoli_kernel(
 
             QL_DOUT("... decompose_toffoli (option=" << opt << "), decomposing gate '" << g->qasm() << "' in new kernel: " << toff_kernel.name);
             toff_kernel.instruction_map = kernel.instruction_map;
+            toff_kernel.instruction_index = kernel.instruction_index;
+            toff_kernel.gate_arena = kernel.gate_arena;     // the decomposition's gates end up in kernel.c
             toff_kernel.qubit_count = kernel.qubit_count;
             toff_kernel.cycle_time = kernel.cycle_time;
             toff_kernel.condition = g->condition;
             toff_kernel.cond_operands = g->cond_operands;
 
-            Vec<UInt> goperands = g->operands;
+            const auto &goperands = g->operands;
             UInt cq1 = goperands[0];
             UInt cq2 = goperands[1];
             UInt tq = goperands[2];
@@ -10,6 +10,16 @@ namespace ql {
 
 using namespace utils;
 
+/**
+ * make a gate of this backend when reading a binary IR file; by default, the
+ * backend has no gates of its own
+ */
+gate *eqasm_compiler::make_binary_ir_gate(UInt tag, Arena &arena) const {
+    (void)tag;
+    (void)arena;
+    return nullptr;
+}
+
 /**
  * write eqasm code to file/stdout
  */
@@ -6,6 +6,8 @@
 
 #include "utils/str.h"
 #include "utils/vec.h"
+#include "utils/arena.h"
+#include "gate.h"
 #include "program.h"
 #include "platform.h"
 
@@ -39,6 +41,14 @@ public:
      */
     virtual void write_traces(const utils::Str &file_name="");
 
+    /**
+     * make a gate in the given arena of the class that this backend's own gates
+     * with the given gate::binary_ir_tag() have, when reading a binary IR file;
+     * the reader sets its attributes. Returns nullptr for tags that the backend
+     * doesn't know.
+     */
+    virtual gate *make_binary_ir_gate(utils::UInt tag, utils::Arena &arena) const;
+
 };
 
 } // namespace ql
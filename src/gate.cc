@@ -5,42 +5,120 @@
 #include "gate.h"
 
 #include <cctype>
+#include <mutex>
 #include "utils/num.h"
 #include "utils/str.h"
+#include "utils/map.h"
 
 namespace ql {
 
 using namespace utils;
 
+namespace {
+
+// the process-wide table of interned gate names
+class gate_name_table_t {
+public:
+    gate_name_table_t() {
+        // in the order of gate_opcode_t
+        for (const char *name : {
+            "measure", "prepz", "prep_z", "display",
+            "cnot", "cz", "cphase",
+            "rz", "z", "pauli_z", "rz180", "z90", "rz90", "zm90", "mrz90", "s", "sdag", "t", "tdag",
+            "rx", "x", "pauli_x", "rx180", "x90", "rx90", "xm90", "mrx90", "x45"
+        }) {
+            intern(name);
+        }
+        QL_ASSERT(opcodes.size() == opc_builtin_count);
+    }
+
+    UInt intern(const Str &name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = opcodes.find(name);
+        if (it != opcodes.end()) {
+            return it->second;
+        }
+        UInt opcode = opcodes.size();
+        opcodes.set(name) = opcode;
+        return opcode;
+    }
+
+private:
+    std::mutex mutex;
+    Map<Str, UInt> opcodes;
+};
+
+gate_name_table_t &gate_names() {
+    static gate_name_table_t table;
+    return table;
+}
+
+} // anonymous namespace
+
+UInt intern_gate_name(const Str &name) {
+    return gate_names().intern(name);
+}
+
+UInt gate::get_opcode() {
+    if (opcode == NO_OPCODE) {
+        opcode = intern_gate_name(name.substr(0, name.find(' ')));
+    }
+    return opcode;
+}
+
+UInt gate::binary_ir_tag() const {
+    return type();
+}
+
 Bool gate::is_conditional() const {
     return condition != cond_always;
 }
 
-instruction_t gate::cond_qasm() const {
+instruction_t gate::qasm() const {
+    StrStrm ss;
+    write_qasm(ss);
+    return instruction_t(ss.str());
+}
+
+void gate::write_cond_qasm(std::ostream &os) const {
     QL_ASSERT(gate::is_valid_cond(condition, cond_operands));
     switch (condition) {
         case cond_always:
-            return "";
+            break;
         case cond_never:
-            return instruction_t("cond(0) ");
+            os << "cond(0) ";
+            break;
         case cond_unary:
-            return instruction_t("cond(b[" + to_string(cond_operands[0]) + "]) ");
+            os << "cond(b[" << cond_operands[0] << "]) ";
+            break;
         case cond_not:
-            return instruction_t("cond(!b[" + to_string(cond_operands[0]) + "]) ");
+            os << "cond(!b[" << cond_operands[0] << "]) ";
+            break;
         case cond_and:
-            return instruction_t("cond(b[" + to_string(cond_operands[0]) + "]&&b[" + to_string(cond_operands[1]) + ") ");
+            os << "cond(b[" << cond_operands[0] << "]&&b[" << cond_operands[1] << ") ";
+            break;
         case cond_nand:
-            return instruction_t("cond(!(b[" + to_string(cond_operands[0]) + "]&&b[" + to_string(cond_operands[1]) + ")) ");
+            os << "cond(!(b[" << cond_operands[0] << "]&&b[" << cond_operands[1] << ")) ";
+            break;
         case cond_or:
-            return instruction_t("cond(b[" + to_string(cond_operands[0]) + "]||b[" + to_string(cond_operands[1]) + ") ");
+            os << "cond(b[" << cond_operands[0] << "]||b[" << cond_operands[1] << ") ";
+            break;
         case cond_nor:
-            return instruction_t("cond(!(b[" + to_string(cond_operands[0]) + "]||b[" + to_string(cond_operands[1]) + ")) ");
+            os << "cond(!(b[" << cond_operands[0] << "]||b[" << cond_operands[1] << ")) ";
+            break;
         case cond_xor:
-            return instruction_t("cond(b[" + to_string(cond_operands[0]) + "]^^b[" + to_string(cond_operands[1]) + ") ");
+            os << "cond(b[" << cond_operands[0] << "]^^b[" << cond_operands[1] << ") ";
+            break;
         case cond_nxor:
-            return instruction_t("cond(!(b[" + to_string(cond_operands[0]) + "]^^b[" + to_string(cond_operands[1]) + ")) ");
+            os << "cond(!(b[" << cond_operands[0] << "]^^b[" << cond_operands[1] << ")) ";
+            break;
     }
-    return "";
+}
+
+instruction_t gate::cond_qasm() const {
+    StrStrm ss;
+    write_cond_qasm(ss);
+    return instruction_t(ss.str());
 }
 
 Bool gate::is_valid_cond(cond_type_t condition, const Vec<UInt> &cond_operands) {
@@ -68,8 +146,9 @@ identity::identity(UInt q) : m(identity_c) {
     operands.push_back(q);
 }
 
-instruction_t identity::qasm() const {
-    return instruction_t(cond_qasm() + "i q[" + to_string(operands[0]) + "]");
+void identity::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "i q[" << operands[0] << "]";
 }
 
 gate_type_t identity::type() const {
@@ -86,8 +165,9 @@ hadamard::hadamard(UInt q) : m(hadamard_c) {
     operands.push_back(q);
 }
 
-instruction_t hadamard::qasm() const {
-    return instruction_t(cond_qasm() + "h q[" + to_string(operands[0]) + "]");
+void hadamard::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "h q[" << operands[0] << "]";
 }
 
 gate_type_t hadamard::type() const {
@@ -104,8 +184,9 @@ phase::phase(UInt q) : m(phase_c) {
     operands.push_back(q);
 }
 
-instruction_t phase::qasm() const {
-    return instruction_t(cond_qasm() + "s q[" + to_string(operands[0]) + "]");
+void phase::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "s q[" << operands[0] << "]";
 }
 
 gate_type_t phase::type() const {
@@ -125,8 +206,9 @@ phasedag::phasedag(UInt q) : m(phasedag_c) {
     operands.push_back(q);
 }
 
-instruction_t phasedag::qasm() const {
-    return instruction_t(cond_qasm() + "sdag q[" + to_string(operands[0]) + "]");
+void phasedag::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "sdag q[" << operands[0] << "]";
 }
 
 gate_type_t phasedag::type() const {
@@ -148,8 +230,9 @@ rx::rx(UInt q, double theta) {
     m(1,1) = cos(angle/2);
 }
 
-instruction_t rx::qasm() const {
-    return instruction_t(cond_qasm() + "rx q[" + to_string(operands[0]) + "], " + to_string(angle));
+void rx::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "rx q[" << operands[0] << "], " << angle;
 }
 
 gate_type_t rx::type() const {
@@ -171,8 +254,9 @@ ry::ry(UInt q, double theta) {
     m(1,1) = cos(angle/2);
 }
 
-instruction_t ry::qasm() const {
-    return instruction_t(cond_qasm() + "ry q[" + to_string(operands[0]) + "], " + to_string(angle));
+void ry::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "ry q[" << operands[0] << "], " << angle;
 }
 
 gate_type_t ry::type() const {
@@ -194,8 +278,9 @@ rz::rz(UInt q, double theta) {
     m(1,1) = Complex(cos(angle/2), sin(angle/2));
 }
 
-instruction_t rz::qasm() const {
-    return instruction_t(cond_qasm() + "rz q[" + to_string(operands[0]) + "], " + to_string(angle));
+void rz::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "rz q[" << operands[0] << "], " << angle;
 }
 
 gate_type_t rz::type() const {
@@ -212,8 +297,9 @@ t::t(UInt q) : m(t_c) {
     operands.push_back(q);
 }
 
-instruction_t t::qasm() const {
-    return instruction_t(cond_qasm() + "t q[" + to_string(operands[0]) + "]");
+void t::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "t q[" << operands[0] << "]";
 }
 
 gate_type_t t::type() const {
@@ -230,8 +316,9 @@ tdag::tdag(UInt q) : m(tdag_c) {
     operands.push_back(q);
 }
 
-instruction_t tdag::qasm() const {
-    return instruction_t(cond_qasm() + "tdag q[" + to_string(operands[0]) + "]");
+void tdag::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "tdag q[" << operands[0] << "]";
 }
 
 gate_type_t tdag::type() const {
@@ -248,8 +335,9 @@ pauli_x::pauli_x(UInt q) : m(pauli_x_c) {
     operands.push_back(q);
 }
 
-instruction_t pauli_x::qasm() const {
-    return instruction_t(cond_qasm() + "x q[" + to_string(operands[0]) + "]");
+void pauli_x::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "x q[" << operands[0] << "]";
 }
 
 gate_type_t pauli_x::type() const {
@@ -266,8 +354,9 @@ pauli_y::pauli_y(UInt q) : m(pauli_y_c) {
     operands.push_back(q);
 }
 
-instruction_t pauli_y::qasm() const {
-    return instruction_t(cond_qasm() + "y q[" + to_string(operands[0]) + "]");
+void pauli_y::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "y q[" << operands[0] << "]";
 }
 
 gate_type_t pauli_y::type() const {
@@ -284,8 +373,9 @@ pauli_z::pauli_z(UInt q) : m(pauli_z_c) {
     operands.push_back(q);
 }
 
-instruction_t pauli_z::qasm() const {
-    return instruction_t(cond_qasm() + "z q[" + to_string(operands[0]) + "]");
+void pauli_z::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "z q[" << operands[0] << "]";
 }
 
 gate_type_t pauli_z::type() const {
@@ -302,8 +392,9 @@ rx90::rx90(UInt q) : m(rx90_c) {
     operands.push_back(q);
 }
 
-instruction_t rx90::qasm() const {
-    return instruction_t(cond_qasm() + "x90 q[" + to_string(operands[0]) + "]");
+void rx90::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "x90 q[" << operands[0] << "]";
 }
 
 gate_type_t rx90::type() const {
@@ -320,8 +411,9 @@ mrx90::mrx90(UInt q) : m(mrx90_c) {
     operands.push_back(q);
 }
 
-instruction_t mrx90::qasm() const {
-    return instruction_t(cond_qasm() + "mx90 q[" + to_string(operands[0]) + "]");
+void mrx90::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "mx90 q[" << operands[0] << "]";
 }
 
 gate_type_t mrx90::type() const {
@@ -338,8 +430,9 @@ rx180::rx180(UInt q) : m(rx180_c) {
     operands.push_back(q);
 }
 
-instruction_t rx180::qasm() const {
-    return instruction_t(cond_qasm() + "x180 q[" + to_string(operands[0]) + "]");
+void rx180::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "x180 q[" << operands[0] << "]";
 }
 
 gate_type_t rx180::type() const {
@@ -356,8 +449,9 @@ ry90::ry90(UInt q) : m(ry90_c) {
     operands.push_back(q);
 }
 
-instruction_t ry90::qasm() const {
-    return instruction_t(cond_qasm() + "y90 q[" + to_string(operands[0]) + "]");
+void ry90::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "y90 q[" << operands[0] << "]";
 }
 
 gate_type_t ry90::type() const {
@@ -374,8 +468,9 @@ mry90::mry90(UInt q) : m(mry90_c) {
     operands.push_back(q);
 }
 
-instruction_t mry90::qasm() const {
-    return instruction_t(cond_qasm() + "my90 q[" + to_string(operands[0]) + "]");
+void mry90::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "my90 q[" << operands[0] << "]";
 }
 
 gate_type_t mry90::type() const {
@@ -392,8 +487,9 @@ ry180::ry180(UInt q) : m(ry180_c) {
     operands.push_back(q);
 }
 
-instruction_t ry180::qasm() const {
-    return instruction_t(cond_qasm() + "y180 q[" + to_string(operands[0]) + "]");
+void ry180::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "y180 q[" << operands[0] << "]";
 }
 
 gate_type_t ry180::type() const {
@@ -417,15 +513,12 @@ measure::measure(UInt q, UInt c) : m(identity_c) {
     creg_operands.push_back(c);
 }
 
-instruction_t measure::qasm() const {
-    StrStrm ss;
-    ss << "measure ";
-    ss << "q[" << operands[0] << "]";
+void measure::write_qasm(std::ostream &os) const {
+    os << "measure ";
+    os << "q[" << operands[0] << "]";
     if (!creg_operands.empty()) {
-        ss << ", r[" << creg_operands[0] << "]";
+        os << ", r[" << creg_operands[0] << "]";
     }
-
-    return instruction_t(ss.str());
 }
 
 gate_type_t measure::type() const {
@@ -442,8 +535,9 @@ prepz::prepz(UInt q) : m(identity_c) {
     operands.push_back(q);
 }
 
-instruction_t prepz::qasm() const {
-    return instruction_t(cond_qasm() + "prep_z q[" + to_string(operands[0]) +"]");
+void prepz::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "prep_z q[" << operands[0] << "]";
 }
 
 gate_type_t prepz::type() const {
@@ -461,9 +555,9 @@ cnot::cnot(UInt q1, UInt q2) : m(cnot_c) {
     operands.push_back(q2);
 }
 
-instruction_t cnot::qasm() const {
-    return instruction_t(cond_qasm() + "cnot q[" + to_string(operands[0]) + "]"
-                         + ",q[" + to_string(operands[1]) + "]");
+void cnot::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "cnot q[" << operands[0] << "],q[" << operands[1] << "]";
 }
 
 gate_type_t cnot::type() const {
@@ -481,9 +575,9 @@ cphase::cphase(UInt q1, UInt q2) : m(cphase_c) {
     operands.push_back(q2);
 }
 
-instruction_t cphase::qasm() const {
-    return instruction_t(cond_qasm() + "cz q[" + to_string(operands[0]) + "]"
-                         + ",q[" + to_string(operands[1]) + "]");
+void cphase::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "cz q[" << operands[0] << "],q[" << operands[1] << "]";
 }
 
 gate_type_t cphase::type() const {
@@ -502,10 +596,9 @@ toffoli::toffoli(UInt q1, UInt q2, UInt q3) : m(toffoli_c) {
     operands.push_back(q3);
 }
 
-instruction_t toffoli::qasm() const {
-    return instruction_t(cond_qasm() + "toffoli q[" + to_string(operands[0]) + "]"
-                         + ",q[" + to_string(operands[1]) + "]"
-                         + ",q[" + to_string(operands[2]) + "]");
+void toffoli::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "toffoli q[" << operands[0] << "],q[" << operands[1] << "],q[" << operands[2] << "]";
 }
 
 gate_type_t toffoli::type() const {
@@ -521,8 +614,8 @@ nop::nop() : m(nop_c) {
     duration = 20;
 }
 
-instruction_t nop::qasm() const {
-    return instruction_t("nop");
+void nop::write_qasm(std::ostream &os) const {
+    os << "nop";
 }
 
 gate_type_t nop::type() const {
@@ -540,9 +633,9 @@ swap::swap(UInt q1, UInt q2) : m(swap_c) {
     operands.push_back(q2);
 }
 
-instruction_t swap::qasm() const {
-    return instruction_t(cond_qasm() + "swap q[" + to_string(operands[0]) + "]"
-                         + ",q[" + to_string(operands[1]) + "]");
+void swap::write_qasm(std::ostream &os) const {
+    write_cond_qasm(os);
+    os << "swap q[" << operands[0] << "],q[" << operands[1] << "]";
 }
 
 gate_type_t swap::type() const {
@@ -566,8 +659,8 @@ wait::wait(Vec<UInt> qubits, UInt d, UInt dc) : m(nop_c) {
     }
 }
 
-instruction_t wait::qasm() const {
-    return instruction_t("wait " + to_string(duration_in_cycles));
+void wait::write_qasm(std::ostream &os) const {
+    os << "wait " << duration_in_cycles;
 }
 
 gate_type_t wait::type() const {
@@ -583,8 +676,8 @@ SOURCE::SOURCE() : m(nop_c) {
     duration = 1;
 }
 
-instruction_t SOURCE::qasm() const {
-    return instruction_t("SOURCE");
+void SOURCE::write_qasm(std::ostream &os) const {
+    os << "SOURCE";
 }
 
 gate_type_t SOURCE::type() const {
@@ -600,8 +693,8 @@ SINK::SINK() : m(nop_c) {
     duration = 1;
 }
 
-instruction_t SINK::qasm() const {
-    return instruction_t("SINK");
+void SINK::write_qasm(std::ostream &os) const {
+    os << "SINK";
 }
 
 gate_type_t SINK::type() const {
@@ -617,8 +710,8 @@ display::display() : m(nop_c) {
     duration = 0;
 }
 
-instruction_t display::qasm() const {
-    return instruction_t("display");
+void display::write_qasm(std::ostream &os) const {
+    os << "display";
 }
 
 gate_type_t display::type() const {
@@ -629,7 +722,13 @@ cmat_t display::mat() const {
     return m;
 }
 
-custom_gate::custom_gate(const Str &name) {
+// the definition of custom gates that are not loaded from the configuration file
+static const std::shared_ptr<const custom_gate_definition_t> &empty_custom_gate_definition() {
+    static const std::shared_ptr<const custom_gate_definition_t> empty = std::make_shared<const custom_gate_definition_t>();
+    return empty;
+}
+
+custom_gate::custom_gate(const Str &name) : definition(empty_custom_gate_definition()) {
     this->name = name;  // just remember name, e.g. "x", "x %0" or "x q0", expansion is done by add_custom_gate_if_available().
     // FIXME: no syntax check is performed
 }
@@ -643,12 +742,12 @@ custom_gate::custom_gate(const custom_gate &g) {
     creg_operands = g.creg_operands;
     // int_operand = g.int_operand; FIXME
     duration = g.duration;
+    instruction_id = g.instruction_id;
+    instruction_table_id = g.instruction_table_id;
+    opcode = g.opcode;
     // angle = g.angle; FIXME
     // cycle = g.cycle; FIXME
-    m.m[0] = g.m.m[0];
-    m.m[1] = g.m.m[1];
-    m.m[2] = g.m.m[2];
-    m.m[3] = g.m.m[3];
+    definition = g.definition;
 }
 
 /**
@@ -680,6 +779,7 @@ UInt custom_gate::qubit_id(const Str &qubit) {
  */
 void custom_gate::load(nlohmann::json &instr) {
     QL_DOUT("loading instruction '" << name << "'...");
+    custom_gate_definition_t def = *definition;
     Str l_attr = "(none)";
     try {
         l_attr = "qubits";
@@ -703,10 +803,10 @@ void custom_gate::load(nlohmann::json &instr) {
         // FIXME: make matrix optional, default to NaN
         auto mat = instr["matrix"];
         QL_DOUT("matrix: " << instr["matrix"]);
-        m.m[0] = Complex(mat[0][0], mat[0][1]);
-        m.m[1] = Complex(mat[1][0], mat[1][1]);
-        m.m[2] = Complex(mat[2][0], mat[2][1]);
-        m.m[3] = Complex(mat[3][0], mat[3][1]);
+        def.m.m[0] = Complex(mat[0][0], mat[0][1]);
+        def.m.m[1] = Complex(mat[1][0], mat[1][1]);
+        def.m.m[2] = Complex(mat[2][0], mat[2][1]);
+        def.m.m[3] = Complex(mat[3][0], mat[3][1]);
         
     } catch (Json::exception &e) {
         QL_EOUT("while loading instruction '" << name << "' (attr: " << l_attr
@@ -717,9 +817,10 @@ void custom_gate::load(nlohmann::json &instr) {
     }
 
     if (instr.count("cc_light_instr") > 0) {	// FIXME: platform dependency
-        arch_operation_name = instr["cc_light_instr"].get<Str>();
+        def.arch_operation_name = instr["cc_light_instr"].get<Str>();
         QL_DOUT("cc_light_instr: " << instr["cc_light_instr"]);
     }
+    definition = std::make_shared<const custom_gate_definition_t>(std::move(def));
 }
 
 void custom_gate::print_info() const {
@@ -727,49 +828,45 @@ void custom_gate::print_info() const {
     QL_PRINTLN("    |- name     : " << name);
     QL_PRINTLN("    |- qubits   : " << to_string(operands));
     QL_PRINTLN("    |- duration : " << duration);
+    const cmat_t &m = definition->m;
     QL_PRINTLN("    |- matrix   : [" << m.m[0] << ", " << m.m[1] << ", " << m.m[2] << ", " << m.m[3] << "]");
 }
 
-instruction_t custom_gate::qasm() const {
-    StrStrm ss;
+void custom_gate::write_qasm(std::ostream &os) const {
+    // the gate name is the name up to the first space, written without copying it
     UInt p = name.find(' ');
-    Str gate_name = name.substr(0, p);
-    ss << cond_qasm();
-    if (operands.empty()) {
-        ss << gate_name;
-    } else if (operands.size() == 1) {
-        ss << gate_name << " q[" << operands[0] << "]";
-    } else {
-        ss << gate_name << " q[" << operands[0] << "]";
+    UInt len = (p == Str::npos) ? name.size() : p;
+    write_cond_qasm(os);
+    os.write(name.data(), len);
+    if (!operands.empty()) {
+        os << " q[" << operands[0] << "]";
         for (UInt i = 1; i < operands.size(); i++) {
-            ss << ",q[" << operands[i] << "]";
+            os << ",q[" << operands[i] << "]";
         }
     }
 
     // deal with custom gates with argument, such as angle
-    if (gate_name == "rx" || gate_name == "ry" || gate_name == "rz") {	// FIXME: implicitly defining semantics here
-        ss << ", " << angle;
+    if (len == 2 && name[0] == 'r' && (name[1] == 'x' || name[1] == 'y' || name[1] == 'z')) {	// FIXME: implicitly defining semantics here
+        os << ", " << angle;
     }
 
     if (creg_operands.size() == 1) {
-        ss << ", r[" << creg_operands[0] << "]";
+        os << ", r[" << creg_operands[0] << "]";
     } else if (creg_operands.size() > 1) {
-        ss << ", r[" << creg_operands[0] << "]";
+        os << ", r[" << creg_operands[0] << "]";
         for (size_t i = 1; i < creg_operands.size(); i++) {
-            ss << ", r[" << creg_operands[i] << "]";
+            os << ", r[" << creg_operands[i] << "]";
         }
     }
 
     if (breg_operands.size() == 1) {
-        ss << ", b[" << breg_operands[0] << "]";
+        os << ", b[" << breg_operands[0] << "]";
     } else if (breg_operands.size() > 1) {
-        ss << ", b[" << breg_operands[0] << "]";
+        os << ", b[" << breg_operands[0] << "]";
         for (size_t i = 1; i < breg_operands.size(); i++) {
-            ss << ", b[" << breg_operands[i] << "]";
+            os << ", b[" << breg_operands[i] << "]";
         }
     }
-
-    return instruction_t(ss.str());
 }
 
 gate_type_t custom_gate::type() const {
@@ -777,7 +874,7 @@ gate_type_t custom_gate::type() const {
 }
 
 cmat_t custom_gate::mat() const {
-    return m;
+    return definition->m;
 }
 
 composite_gate::composite_gate(const Str &name) : custom_gate(name) {
@@ -789,16 +886,17 @@ composite_gate::composite_gate(const Str &name, const Vec<gate*> &seq) : custom_
     for (gate *g : seq) {
         gs.push_back(g);
         duration += g->duration;    // FIXME: not true if gates operate in parallel
-        operands.insert(operands.end(), g->operands.begin(), g->operands.end());
+        for (UInt q : g->operands) {
+            operands.push_back(q);
+        }
     }
 }
 
-instruction_t composite_gate::qasm() const {
-    StrStrm instr;
+void composite_gate::write_qasm(std::ostream &os) const {
     for (gate * g : gs) {
-        instr << g->qasm() << std::endl;
+        g->write_qasm(os);
+        os << "\n";
     }
-    return instruction_t(instr.str());
 }
 
 gate_type_t composite_gate::type() const {
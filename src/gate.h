@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include <memory>
 #include "utils/str.h"
 #include "utils/vec.h"
+#include "utils/small_vec.h"
 #include "utils/json.h"
 #include "utils/misc.h"
 #include "matrix.h"
@@ -181,6 +183,26 @@ typedef enum e_cond_type {
 
 const utils::UInt MAX_CYCLE = utils::MAX;
 
+/*
+ * Gate names are interned in a process-wide symbol table to an integer opcode,
+ * so that passes can dispatch on a gate's kind without string compares.
+ * The opcodes below are those of the gate names that passes dispatch on;
+ * they are interned first, in this order, so they are constants.
+ */
+typedef enum e_gate_opcode : utils::UInt {
+    opc_measure, opc_prepz, opc_prep_z, opc_display,
+    opc_cnot, opc_cz, opc_cphase,
+    opc_rz, opc_z, opc_pauli_z, opc_rz180, opc_z90, opc_rz90, opc_zm90, opc_mrz90, opc_s, opc_sdag, opc_t, opc_tdag,
+    opc_rx, opc_x, opc_pauli_x, opc_rx180, opc_x90, opc_rx90, opc_xm90, opc_mrx90, opc_x45,
+    opc_builtin_count
+} gate_opcode_t;
+
+const utils::UInt NO_OPCODE = utils::MAX;
+
+// opcode of name, interning it when it is new; thread-safe, but takes a process-wide lock,
+// so lookups on hot paths use the opcodes cached in gates and instruction_index_t instead
+utils::UInt intern_gate_name(const utils::Str &name);
+
 struct swap_parameters {
     utils::Bool part_of_swap = false;
     // at the end of the swap r0 stores v0 and r1 stores v1
@@ -204,7 +226,7 @@ struct swap_parameters {
 class gate {
 public:
     utils::Str name;
-    utils::Vec<utils::UInt> operands;             // qubit operands
+    utils::SmallVec<utils::UInt, 3> operands;     // qubit operands
     utils::Vec<utils::UInt> creg_operands;
     utils::Vec<utils::UInt> breg_operands;        // bit operands e.g. assigned to by measure; cond_operands are separate
     utils::Vec<utils::UInt> cond_operands;        // 0, 1 or 2 bit operands of condition
@@ -214,12 +236,19 @@ public:
     utils::UInt duration = 0;
     utils::Real angle = 0.0;                      // for arbitrary rotations
     utils::UInt cycle = MAX_CYCLE;                // cycle after scheduling; MAX_CYCLE indicates undefined
+    utils::UInt instruction_id = utils::MAX;      // index in quantum_platform::instruction_attributes, set in the platform's prototypes; MAX when unknown
+    utils::UInt instruction_table_id = 0;         // quantum_platform::instruction_table_id of the table instruction_id indexes; 0 when none
+    utils::UInt opcode = NO_OPCODE;               // cached opcode of name without parameters; see get_opcode()
     virtual ~gate() = default;
-    virtual instruction_t qasm() const = 0;
+    virtual void write_qasm(std::ostream &os) const = 0;  // appends the gate in qasm layout to os
+    instruction_t qasm() const;                   // returns the gate in qasm layout, see write_qasm()
     virtual gate_type_t   type() const = 0;
     virtual cmat_t        mat()  const = 0;  // to do : change cmat_t type to avoid stack smashing on 2 qubits gate operations
+    virtual utils::UInt   binary_ir_tag() const;  // class of the gate in binary IR files (see binary_ir.h), by default its type()
     utils::Str visual_type = ""; // holds the visualization type of this gate that will be linked to a specific configuration in the visualizer
     utils::Bool is_conditional() const;           // whether gate has condition that is NOT cond_always
+    utils::UInt get_opcode();                     // opcode of the name up to the first space, e.g. of "cz" for "cz q0,q3"
+    void write_cond_qasm(std::ostream &os) const; // appends the condition expression in qasm layout to os
     instruction_t cond_qasm() const;              // returns the condition expression in qasm layout
     static utils::Bool is_valid_cond(cond_type_t condition, const utils::Vec<utils::UInt> &cond_operands);
 };
@@ -234,7 +263,7 @@ class identity : public gate {
 public:
     cmat_t m;
     explicit identity(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -243,7 +272,7 @@ class hadamard : public gate {
 public:
     cmat_t m;
     explicit hadamard(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -252,7 +281,7 @@ class phase : public gate {
 public:
     cmat_t m;
     explicit phase(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -261,7 +290,7 @@ class phasedag : public gate {
 public:
     cmat_t m;
     explicit phasedag(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -270,7 +299,7 @@ class rx : public gate {
 public:
     cmat_t m;
     rx(utils::UInt q, utils::Real theta);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -279,7 +308,7 @@ class ry : public gate {
 public:
     cmat_t m;
     ry(utils::UInt q, utils::Real theta);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -288,7 +317,7 @@ class rz : public gate {
 public:
     cmat_t m;
     rz(utils::UInt q, utils::Real theta);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -297,7 +326,7 @@ class t : public gate {
 public:
     cmat_t m;
     explicit t(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -306,7 +335,7 @@ class tdag : public gate {
 public:
     cmat_t m;
     explicit tdag(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -315,7 +344,7 @@ class pauli_x : public gate {
 public:
     cmat_t m;
     explicit pauli_x(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -324,7 +353,7 @@ class pauli_y : public gate {
 public:
     cmat_t m;
     explicit pauli_y(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -333,7 +362,7 @@ class pauli_z : public gate {
 public:
     cmat_t m;
     explicit pauli_z(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -342,7 +371,7 @@ class rx90 : public gate {
 public:
     cmat_t m;
     explicit rx90(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -351,7 +380,7 @@ class mrx90 : public gate {
 public:
     cmat_t m;
     explicit mrx90(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -360,7 +389,7 @@ class rx180 : public gate {
 public:
     cmat_t m;
     explicit rx180(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -369,7 +398,7 @@ class ry90 : public gate {
 public:
     cmat_t m;
     explicit ry90(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -378,7 +407,7 @@ class mry90 : public gate {
 public:
     cmat_t m;
     explicit mry90(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -387,7 +416,7 @@ class ry180 : public gate {
 public:
     cmat_t m;
     explicit ry180(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -397,7 +426,7 @@ public:
     cmat_t m;
     explicit measure(utils::UInt q);
     measure(utils::UInt q, utils::UInt c);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -406,7 +435,7 @@ class prepz : public gate {
 public:
     cmat_t m;
     explicit prepz(utils::UInt q);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -415,7 +444,7 @@ class cnot : public gate {
 public:
     cmat_t m;
     cnot(utils::UInt q1, utils::UInt q2);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -424,7 +453,7 @@ class cphase : public gate {
 public:
     cmat_t m;
     cphase(utils::UInt q1, utils::UInt q2);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -433,7 +462,7 @@ class toffoli : public gate {
 public:
     cmat_t m;
     toffoli(utils::UInt q1, utils::UInt q2, utils::UInt q3);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -442,7 +471,7 @@ class nop : public gate {
 public:
     cmat_t m;
     nop();
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -451,7 +480,7 @@ class swap : public gate {
 public:
     cmat_t m;
     swap(utils::UInt q1, utils::UInt q2);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -466,7 +495,7 @@ public:
     utils::UInt duration_in_cycles;
 
     wait(utils::Vec<utils::UInt> qubits, utils::UInt d, utils::UInt dc);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -475,7 +504,7 @@ class SOURCE : public gate {
 public:
     cmat_t m;
     SOURCE();
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -484,7 +513,7 @@ class SINK : public gate {
 public:
     cmat_t m;
     SINK();
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -493,22 +522,28 @@ class display : public gate {
 public:
     cmat_t m;
     display();
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
 
-class custom_gate : public gate {
-public:
+// what a custom gate takes from its instruction in the configuration file;
+// immutable once loaded, and shared by the platform's prototype gate and all gates copied from it
+struct custom_gate_definition_t {
     cmat_t m; // matrix representation
     utils::Str arch_operation_name;  // name of instruction in the architecture (e.g. cc_light_instr)
+};
+
+class custom_gate : public gate {
+public:
+    std::shared_ptr<const custom_gate_definition_t> definition;
     explicit custom_gate(const utils::Str &name);
     custom_gate(const custom_gate &g);
     static bool is_qubit_id(const utils::Str &str);
     static utils::UInt qubit_id(const utils::Str &qubit);
     void load(nlohmann::json &instr);
     void print_info() const;
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -519,7 +554,7 @@ public:
     utils::Vec<gate *> gs;
     explicit composite_gate(const utils::Str &name);
     composite_gate(const utils::Str &name, const utils::Vec<gate*> &seq);
-    instruction_t qasm() const override;
+    void write_qasm(std::ostream &os) const override;
     gate_type_t type() const override;
     cmat_t mat() const override;
 };
@@ -4,6 +4,7 @@
 
 #include "hardware_configuration.h"
 
+#include <cctype>
 #include <regex>
 
 namespace ql {
@@ -211,4 +212,97 @@ void hardware_configuration::load(
     }
 }
 
+// parses the operand list of an instruction key, e.g. "q0,q3" or "%0,%1", in the form that the
+// kernel constructs it; returns false when the list is not in that form, e.g. when it has spaces
+static Bool parse_operand_list(const Str &list, char prefix, Vec<UInt> &operands) {
+    UInt start = 0;
+    while (start <= list.size()) {
+        UInt end = list.find(',', start);
+        if (end == Str::npos) {
+            end = list.size();
+        }
+        if (end - start < 2 || list[start] != prefix) {
+            return false;
+        }
+        Str digits = list.substr(start + 1, end - start - 1);
+        UInt operand = 0;
+        for (auto c : digits) {
+            if (!std::isdigit(c)) {
+                return false;
+            }
+            if (operand > (UInt)MAX / 10) {
+                QL_FATAL("JSON file: operand '" << prefix << digits << "' in instruction operand list '" << list << "' is out of range");
+            }
+            operand = operand * 10 + (c - '0');
+        }
+        if (to_string(operand) != digits) {
+            return false;
+        }
+        operands.push_back(operand);
+        start = end + 1;
+    }
+    return true;
+}
+
+instruction_index_t::instruction_index_t(const instruction_map_t &instruction_map) {
+    for (const auto &entry : instruction_map) {
+        const Str &key = entry.first;
+        generic.set(intern(key)) = entry.second;
+
+        UInt p = key.rfind(' ');
+        if (p == Str::npos) {
+            continue;
+        }
+        UInt opcode = intern(key.substr(0, p));
+        Str list = key.substr(p + 1);
+        Vec<UInt> operands;
+        if (parse_operand_list(list, 'q', operands)) {
+            specialized.set({opcode, operands}) = entry.second;
+            continue;
+        }
+        operands.clear();
+        if (parse_operand_list(list, '%', operands)) {
+            Bool in_order = true;
+            for (UInt i = 0; i < operands.size(); i++) {
+                in_order = in_order && operands[i] == i;
+            }
+            if (in_order) {
+                parameterized.set({opcode, operands.size()}) = entry.second;
+            }
+        }
+    }
+}
+
+UInt instruction_index_t::intern(const Str &name) {
+    UInt opcode = intern_gate_name(name);
+    opcodes.set(name) = opcode;
+    return opcode;
+}
+
+UInt instruction_index_t::find_opcode(const Str &name) const {
+    auto it = opcodes.find(name);
+    return it == opcodes.end() ? NO_OPCODE : it->second;
+}
+
+custom_gate *instruction_index_t::find(UInt opcode) const {
+    auto it = generic.find(opcode);
+    return it == generic.end() ? nullptr : it->second;
+}
+
+custom_gate *instruction_index_t::find_specialized(UInt opcode, const Vec<UInt> &qubits) const {
+    if (specialized.empty()) {
+        return nullptr;
+    }
+    auto it = specialized.find({opcode, qubits});
+    return it == specialized.end() ? nullptr : it->second;
+}
+
+custom_gate *instruction_index_t::find_parameterized(UInt opcode, UInt arity) const {
+    if (parameterized.empty()) {
+        return nullptr;
+    }
+    auto it = parameterized.find({opcode, arity});
+    return it == parameterized.end() ? nullptr : it->second;
+}
+
 } // namespace ql
@@ -6,12 +6,51 @@
 
 #include "utils/str.h"
 #include "utils/map.h"
+#include "utils/pair.h"
 #include "gate.h"
 
 namespace ql {
 
 typedef utils::Map<utils::Str, custom_gate*> instruction_map_t;
 
+/**
+ * Index on the keys of an instruction map by opcode, so that the kernel finds the
+ * entry for a gate without constructing the names of its specialized ("cz q0,q3")
+ * and parameterized ("cz %0,%1") variants. The names are interned once by the
+ * constructor; after that the index is read-only, so lookups need no locking.
+ */
+class instruction_index_t {
+public:
+    explicit instruction_index_t(const instruction_map_t &instruction_map);
+
+    // opcode of name when it is a key, or the name of a specialized or parameterized key; NO_OPCODE otherwise
+    utils::UInt find_opcode(const utils::Str &name) const;
+
+    // entry with key name, or nullptr
+    custom_gate *find(utils::UInt opcode) const;
+    custom_gate *find(const utils::Str &name) const { return find(find_opcode(name)); }
+
+    // entry with key "<name> q<qubits[0]>,q<qubits[1]>,...", or nullptr
+    custom_gate *find_specialized(utils::UInt opcode, const utils::Vec<utils::UInt> &qubits) const;
+    custom_gate *find_specialized(const utils::Str &name, const utils::Vec<utils::UInt> &qubits) const {
+        return find_specialized(find_opcode(name), qubits);
+    }
+
+    // entry with key "<name> %0,%1,...,%<arity-1>", or nullptr
+    custom_gate *find_parameterized(utils::UInt opcode, utils::UInt arity) const;
+    custom_gate *find_parameterized(const utils::Str &name, utils::UInt arity) const {
+        return find_parameterized(find_opcode(name), arity);
+    }
+
+private:
+    utils::Map<utils::Str, utils::UInt> opcodes;                                            // the names interned by the constructor
+    utils::Map<utils::UInt, custom_gate*> generic;                                          // by opcode of the whole key
+    utils::Map<utils::Pair<utils::UInt, utils::Vec<utils::UInt>>, custom_gate*> specialized; // by opcode and qubits
+    utils::Map<utils::Pair<utils::UInt, utils::UInt>, custom_gate*> parameterized;           // by opcode and arity
+
+    utils::UInt intern(const utils::Str &name);
+};
+
 /**
  * loading hardware configuration
  */
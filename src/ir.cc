@@ -11,6 +11,37 @@ namespace ir {
 
 using namespace utils;
 
+/**
+ * Reserves space for the given number of gates, sections and bundles.
+ */
+void bundles_t::reserve(UInt num_gates, UInt num_sections, UInt num_bundles) {
+    gates.reserve(num_gates);
+    section_offsets.reserve(num_sections);
+    bundles.reserve(num_bundles);
+}
+
+/**
+ * Appends a new, empty bundle.
+ */
+void bundles_t::add_bundle(UInt start_cycle, UInt duration_in_cycles) {
+    bundles.push_back({start_cycle, duration_in_cycles, section_offsets.size(), section_offsets.size()});
+}
+
+/**
+ * Appends a new, empty section to the last bundle.
+ */
+void bundles_t::add_section() {
+    section_offsets.push_back(gates.size());
+    bundles.back().end_section = section_offsets.size();
+}
+
+/**
+ * Appends a gate to the last section of the last bundle.
+ */
+void bundles_t::add_gate(gate *gp) {
+    gates.push_back(gp);
+}
+
 /**
  * Create a circuit with valid cycle values from the bundled internal
  * representation.
@@ -18,9 +49,10 @@ using namespace utils;
 circuit circuiter(const bundles_t &bundles) {
     circuit circ;
 
+    circ.reserve(bundles.num_gates());
     for (const bundle_t &abundle : bundles) {
-        for (auto sec_it = abundle.parallel_sections.begin(); sec_it != abundle.parallel_sections.end(); ++sec_it) {
-            for (auto gp : *sec_it) {
+        for (auto section : bundles.sections(abundle)) {
+            for (auto gp : section) {
                 gp->cycle = abundle.start_cycle;
                 circ.push_back(gp);
             }
@@ -34,11 +66,11 @@ circuit circuiter(const bundles_t &bundles) {
 }
 
 /**
- * Create a bundled-qasm external representation from the bundled internal
- * representation.
+ * Write a bundled-qasm external representation of the bundled internal
+ * representation to the given stream, gate by gate, without building it as a
+ * string first.
  */
-Str qasm(const bundles_t &bundles) {
-    StrStrm ssqasm;
+void write_qasm(std::ostream &os, const bundles_t &bundles) {
     UInt curr_cycle=1;        // FIXME HvS prefer to start at 0; also see depgraph creation
     Str skipgate = "wait";
     if (options::get("issue_skip_319") == "yes") {
@@ -49,39 +81,47 @@ Str qasm(const bundles_t &bundles) {
         auto st_cycle = abundle.start_cycle;
         auto delta = st_cycle - curr_cycle;
         if (delta > 1) {
-            ssqasm << "    " << skipgate << " " << delta - 1 << std::endl;
+            os << "    " << skipgate << " " << delta - 1 << "\n";
         }
 
         auto ngates = 0;
-        for (auto sec_it = abundle.parallel_sections.begin(); sec_it != abundle.parallel_sections.end(); ++sec_it) {
-            ngates += sec_it->size();
+        for (auto section : bundles.sections(abundle)) {
+            ngates += section.size();
         }
-        ssqasm << "    ";
-        if (ngates > 1) ssqasm << "{ ";
+        os << "    ";
+        if (ngates > 1) os << "{ ";
         auto isfirst = 1;
-        for (auto sec_it = abundle.parallel_sections.begin(); sec_it != abundle.parallel_sections.end(); ++sec_it) {
-            for (auto gp : *sec_it) {
+        for (auto section : bundles.sections(abundle)) {
+            for (auto gp : section) {
                 if (isfirst == 0) {
-                    ssqasm << " | ";
+                    os << " | ";
                 }
-                ssqasm << gp->qasm();
+                gp->write_qasm(os);
                 isfirst = 0;
             }
         }
-        if (ngates > 1) ssqasm << " }";
+        if (ngates > 1) os << " }";
         curr_cycle+=delta;
-        ssqasm << "\n";
+        os << "\n";
     }
 
     if (!bundles.empty()) {
         auto &last_bundle = bundles.back();
         UInt lsduration = last_bundle.duration_in_cycles;
         if (lsduration > 1) {
-            ssqasm << "    " << skipgate << " " << lsduration - 1 << std::endl;
+            os << "    " << skipgate << " " << lsduration - 1 << "\n";
         }
     }
+}
 
-    return ssqasm.str();
+/**
+ * Create a bundled-qasm external representation from the bundled internal
+ * representation.
+ */
+Str qasm(const bundles_t &bundles) {
+    StrStrm ss;
+    write_qasm(ss, bundles);
+    return ss.str();
 }
 
 /**
@@ -98,12 +138,7 @@ Str qasm(const bundles_t &bundles) {
  */
 bundles_t bundler(const circuit &circ, UInt cycle_time) {
     bundles_t bundles;          // result bundles
-
-    bundle_t    currBundle;     // current bundle at currCycle that is being filled
-    UInt      currCycle = 0;  // cycle at which bundle is to be scheduled
-
-    currBundle.start_cycle = currCycle; // starts off as empty bundle starting at currCycle
-    currBundle.duration_in_cycles = 0;
+    bundles.reserve(circ.size(), circ.size(), circ.size());
 
     QL_DOUT("bundler ...");
 
@@ -116,60 +151,31 @@ bundles_t bundler(const circuit &circ, UInt cycle_time) {
             continue;
         }
         UInt newCycle = gp->cycle;        // taking cycle values from circuit, so excludes SOURCE and SINK!
-        if (newCycle < currCycle) {
-            QL_FATAL("Error: circuit not ordered by cycle value");
-        }
-        if (newCycle > currCycle) {
-            if (!currBundle.parallel_sections.empty()) {
-                // finish currBundle at currCycle
-                // DOUT(".. bundle at cycle " << currCycle << " duration in cycles: " << currBundle.duration_in_cycles);
-                // for (auto &s : currBundle.parallel_sections)
-                // {
-                //     for (auto &sgp: s)
-                //     {
-                //         DOUT("... with gate(@" << sgp->cycle << ")  " << sgp->qasm());
-                //     }
-                // }
-                bundles.push_back(currBundle);
-                QL_DOUT(".. ready with bundle at cycle " << currCycle);
-                currBundle.parallel_sections.clear();
+        if (bundles.empty() || newCycle > bundles.back().start_cycle) {
+            if (!bundles.empty()) {
+                QL_DOUT(".. ready with bundle at cycle " << bundles.back().start_cycle);
             }
-
-            // new empty currBundle at newCycle
-            currCycle = newCycle;
-            // DOUT(".. bundling at cycle: " << currCycle);
-            currBundle.start_cycle = currCycle;
-            currBundle.duration_in_cycles = 0;
+            // new empty bundle at newCycle
+            bundles.add_bundle(newCycle, 0);
+        } else if (newCycle < bundles.back().start_cycle) {
+            QL_FATAL("Error: circuit not ordered by cycle value");
         }
 
-        // add gp to currBundle
-        section_t asec;
-        asec.push_back(gp);
-        currBundle.parallel_sections.push_back(asec);
-        // DOUT("... gate: " << gp->qasm() << " in private parallel section");
+        // add gp to the last bundle, in a private parallel section
+        bundle_t &currBundle = bundles.back();
+        bundles.add_section();
+        bundles.add_gate(gp);
         currBundle.duration_in_cycles = max(currBundle.duration_in_cycles, (gp->duration+cycle_time-1)/cycle_time);
     }
-    if (!currBundle.parallel_sections.empty()) {
-        // finish currBundle (which is last bundle) at currCycle
-        // DOUT("... bundle at cycle " << currCycle << " duration in cycles: " << currBundle.duration_in_cycles);
-        // for (auto &s : currBundle.parallel_sections)
-        // {
-        //     for (auto &sgp: s)
-        //     {
-        //         DOUT("... with gate(@" << sgp->cycle << ")  " << sgp->qasm());
-        //     }
-        // }
-        bundles.push_back(currBundle);
-        QL_DOUT(".. ready with bundle at cycle " << currCycle);
-    }
 
-    // currCycle == cycle of last gate of circuit scheduled
+    // the cycle of the last bundle is the cycle of last gate of circuit scheduled
     // duration_in_cycles later the system starts idling
     // depth is the difference between the cycle in which it starts idling and the cycle it started execution
     if (bundles.empty()) {
         QL_DOUT("Depth: " << 0);
     } else {
-        QL_DOUT("Depth: " << currCycle + currBundle.duration_in_cycles - bundles.front().start_cycle);
+        QL_DOUT(".. ready with bundle at cycle " << bundles.back().start_cycle);
+        QL_DOUT("Depth: " << bundles.back().start_cycle + bundles.back().duration_in_cycles - bundles.front().start_cycle);
     }
     QL_DOUT("bundler [DONE]");
     return bundles;
@@ -182,10 +188,10 @@ bundles_t bundler(const circuit &circ, UInt cycle_time) {
 void DebugBundles(const Str &at, const bundles_t &bundles) {
     QL_DOUT("DebugBundles at: " << at << " showing " << bundles.size() << " bundles");
     for (const auto& abundle : bundles) {
-        QL_DOUT("... bundle with nsections: " << abundle.parallel_sections.size());
-        for (auto secIt = abundle.parallel_sections.begin(); secIt != abundle.parallel_sections.end(); ++secIt) {
-            QL_DOUT("... section with ngates: " << secIt->size());
-            for (auto gp : *secIt) {
+        QL_DOUT("... bundle with nsections: " << bundles.sections(abundle).size());
+        for (auto section : bundles.sections(abundle)) {
+            QL_DOUT("... section with ngates: " << section.size());
+            for (auto gp : section) {
                 // auto n = get_cc_light_instruction_name(gp->name, platform);
                 QL_DOUT("... ... gate: " << gp->qasm() << " name: " << gp->name << " cc_light_iname: " << "?");
             }
@@ -6,23 +6,146 @@
 
 #include "utils/num.h"
 #include "utils/str.h"
-#include "utils/list.h"
+#include "utils/vec.h"
 #include "gate.h"
 #include "circuit.h"
 
 namespace ql {
 namespace ir {
 
-typedef utils::List<gate *>section_t;
+/**
+ * A parallel section of a bundle: a range of gates in the gate array of the
+ * bundles_t it belongs to.
+ */
+class section_t {
+private:
+    gate *const *first;
+    gate *const *last;
+
+public:
+    section_t(gate *const *first, gate *const *last) : first(first), last(last) {}
+    gate *const *begin() const { return first; }
+    gate *const *end() const { return last; }
+    utils::UInt size() const { return last - first; }
+    utils::Bool empty() const { return first == last; }
+    gate *front() const { return *first; }
+};
 
 class bundle_t {
 public:
-    utils::UInt start_cycle;                         // start cycle for all gates in parallel_sections
-    utils::UInt duration_in_cycles;                  // the maximum gate duration in parallel_sections
-    utils::List<section_t> parallel_sections;
+    utils::UInt start_cycle;                         // start cycle for all gates in its sections
+    utils::UInt duration_in_cycles;                  // the maximum gate duration in its sections
+    utils::UInt first_section;                       // index of its first section in bundles_t
+    utils::UInt end_section;                         // index just beyond its last section in bundles_t
 };
 
-typedef utils::List<bundle_t> bundles_t;          // note that subsequent bundles can overlap in time
+/**
+ * Bundled representation of a scheduled circuit. It is stored flat: the gates
+ * of all bundles are in one array, in order of bundle and section, and the
+ * sections and bundles are tables of offsets into it; note that subsequent
+ * bundles can overlap in time.
+ *
+ * Iterate over it as follows:
+ *
+ *     for (const auto &bundle : bundles) {
+ *         for (auto section : bundles.sections(bundle)) {
+ *             for (auto gp : section) {
+ *                 ...
+ */
+class bundles_t {
+private:
+    utils::Vec<gate *> gates;                        // all gates, bundle by bundle and section by section
+    utils::Vec<utils::UInt> section_offsets;         // index in gates of the first gate of each section
+    utils::Vec<bundle_t> bundles;
+
+public:
+
+    /**
+     * The sections of a bundle, as returned by sections().
+     */
+    class section_range_t {
+    private:
+        const bundles_t *owner;
+        utils::UInt first;
+        utils::UInt last;
+
+    public:
+        class const_iterator {
+        private:
+            const bundles_t *owner;
+            utils::UInt index;
+
+        public:
+            const_iterator(const bundles_t *owner, utils::UInt index) : owner(owner), index(index) {}
+            section_t operator*() const { return owner->section(index); }
+            const_iterator &operator++() { index++; return *this; }
+            utils::Bool operator!=(const const_iterator &other) const { return index != other.index; }
+            utils::Bool operator==(const const_iterator &other) const { return index == other.index; }
+        };
+
+        section_range_t(const bundles_t *owner, utils::UInt first, utils::UInt last) : owner(owner), first(first), last(last) {}
+        const_iterator begin() const { return const_iterator(owner, first); }
+        const_iterator end() const { return const_iterator(owner, last); }
+        utils::UInt size() const { return last - first; }
+        utils::Bool empty() const { return first == last; }
+    };
+
+    typedef utils::Vec<bundle_t>::iterator iterator;
+    typedef utils::Vec<bundle_t>::const_iterator const_iterator;
+
+    iterator begin() { return bundles.begin(); }
+    iterator end() { return bundles.end(); }
+    const_iterator begin() const { return bundles.begin(); }
+    const_iterator end() const { return bundles.end(); }
+    utils::UInt size() const { return bundles.size(); }
+    utils::Bool empty() const { return bundles.empty(); }
+    bundle_t &front() { return bundles.front(); }
+    const bundle_t &front() const { return bundles.front(); }
+    bundle_t &back() { return bundles.back(); }
+    const bundle_t &back() const { return bundles.back(); }
+
+    /**
+     * Returns the section with the given index.
+     */
+    section_t section(utils::UInt index) const {
+        auto first = gates.data() + section_offsets[index];
+        auto last = gates.data() + (index + 1 < section_offsets.size() ? section_offsets[index + 1] : gates.size());
+        return section_t(first, last);
+    }
+
+    /**
+     * Returns the sections of the given bundle.
+     */
+    section_range_t sections(const bundle_t &bundle) const {
+        return section_range_t(this, bundle.first_section, bundle.end_section);
+    }
+
+    /**
+     * Returns the total number of gates in all bundles.
+     */
+    utils::UInt num_gates() const { return gates.size(); }
+
+    /**
+     * Reserves space for the given number of gates, sections and bundles.
+     */
+    void reserve(utils::UInt num_gates, utils::UInt num_sections, utils::UInt num_bundles);
+
+    /**
+     * Appends a new, empty bundle.
+     */
+    void add_bundle(utils::UInt start_cycle, utils::UInt duration_in_cycles);
+
+    /**
+     * Appends a new, empty section to the last bundle.
+     */
+    void add_section();
+
+    /**
+     * Appends a gate to the last section of the last bundle.
+     */
+    void add_gate(gate *gp);
+
+};
 
 /**
  * Create a circuit with valid cycle values from the bundled internal
@@ -30,6 +153,13 @@ typedef utils::List<bundle_t> bundles_t;          // note that subsequent bundle
  */
 circuit circuiter(const bundles_t &bundles);
 
+/**
+ * Write a bundled-qasm external representation of the bundled internal
+ * representation to the given stream, gate by gate, without building it as a
+ * string first.
+ */
+void write_qasm(std::ostream &os, const bundles_t &bundles);
+
 /**
  * Create a bundled-qasm external representation from the bundled internal
  * representation.
@@ -42,9 +172,9 @@ utils::Str qasm(const bundles_t &bundles);
  *
  * assumes gatep->cycle attribute reflects the cycle assignment;
  * assumes circuit being a vector of gate pointers is ordered by this cycle value;
- * create bundles in a single scan over the circuit, using currBundle and currCycle as state:
- *  - currBundle: bundle that is being put together; currBundle copied into output bundles when the bundle has been done
- *  - currCycle: cycle at which currBundle will be put; equals cycle value of all contained gates
+ * creates the bundles in a single scan over the circuit, appending each gate
+ * in its own section to the last bundle, or to a new bundle when its cycle is
+ * later than that of the last bundle
  *
  * FIXME HvS cycles_valid must be true before each call to this bundler
  */
@@ -25,7 +25,10 @@ namespace ql {
 using namespace utils;
 
 quantum_kernel::quantum_kernel(const Str &name) :
-    name(name), iterations(1), type(kernel_type_t::STATIC)
+    name(name), iterations(1), type(kernel_type_t::STATIC),
+    instruction_map(std::make_shared<const instruction_map_t>()),
+    instruction_index(std::make_shared<const instruction_index_t>(*instruction_map)),
+    gate_arena(std::make_shared<utils::Arena>())
 {
     condition = cond_always;
 }
@@ -45,6 +48,8 @@ quantum_kernel::quantum_kernel(
     type(kernel_type_t::STATIC)
 {
     instruction_map = platform.instruction_map;
+    instruction_index = platform.instruction_index;
+    gate_arena = std::make_shared<Arena>();
     cycle_time = platform.cycle_time;
     cycles_valid = true;
     condition = cond_always;
@@ -73,7 +78,7 @@ void quantum_kernel::set_kernel_type(kernel_type_t typ) {
 Str quantum_kernel::get_gates_definition() const {
     StrStrm ss;
 
-    for (auto i = instruction_map.begin(); i != instruction_map.end(); i++) {
+    for (auto i = instruction_map->begin(); i != instruction_map->end(); i++) {
         ss << i->first << std::endl;
     }
     return ss.str();
@@ -91,6 +96,79 @@ const circuit &quantum_kernel::get_circuit() const {
     return c;
 }
 
+/**
+ * The bundled representation of the circuit of a kernel, with the gates,
+ * cycles and durations of the circuit it was made from, to check whether it is
+ * still up to date.
+ */
+class kernel_bundles_t {
+private:
+    struct source_gate_t {
+        gate *gp;
+        UInt cycle;
+        UInt duration;
+    };
+    Vec<source_gate_t> source;
+    UInt cycle_time;
+
+public:
+    ir::bundles_t bundles;
+
+    kernel_bundles_t(const circuit &c, UInt cycle_time) : cycle_time(cycle_time), bundles(ir::bundler(c, cycle_time)) {
+        source.reserve(c.size());
+        for (auto gp : c) {
+            source.push_back({gp, gp->cycle, gp->duration});
+        }
+    }
+
+    Bool is_bundling_of(const circuit &c, UInt cycle_time) const {
+        if (c.size() != source.size() || cycle_time != this->cycle_time) {
+            return false;
+        }
+        for (UInt i = 0; i < c.size(); i++) {
+            const auto &s = source[i];
+            if (c[i] != s.gp || c[i]->cycle != s.cycle || c[i]->duration != s.duration) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+const ir::bundles_t &quantum_kernel::get_bundles() const {
+    if (!bundles || !bundles->is_bundling_of(c, cycle_time)) {
+        bundles = std::make_shared<kernel_bundles_t>(c, cycle_time);
+    }
+    return bundles->bundles;
+}
+
+kernel_statistics_t quantum_kernel::get_statistics(const quantum_platform &platform) const {
+    kernel_statistics_t stats;
+    UInt cycle_time = platform.cycle_time;
+    stats.qubit_usecount.resize(platform.qubit_number, 0);
+    stats.qubit_usedcyclecount.resize(platform.qubit_number, 0);
+    for (auto &gp : c) {
+        switch (gp->type()) {
+            case __classical_gate__:
+                stats.classical_operations++;
+                break;
+            case __wait_gate__:
+                break;
+            default:    // quantum gate
+                stats.quantum_gates++;
+                if (gp->operands.size() > 1) {
+                    stats.non_single_qubit_gates++;
+                }
+                for (auto v : gp->operands) {
+                    stats.qubit_usecount[v]++;
+                    stats.qubit_usedcyclecount[v] += (gp->duration+cycle_time-1)/cycle_time;
+                }
+                break;
+        }
+    }
+    return stats;
+}
+
 void quantum_kernel::identity(UInt qubit) {
     gate("identity", qubit);
 }
@@ -108,21 +186,21 @@ void quantum_kernel::h(UInt qubit) {
 }
 
 void quantum_kernel::rx(UInt qubit, Real angle) {
-    c.push_back(new ql::rx(qubit,angle));
+    c.push_back(gate_arena->make<ql::rx>(qubit,angle));
     c.back()->condition = condition;
     c.back()->cond_operands = cond_operands;;
     cycles_valid = false;
 }
 
 void quantum_kernel::ry(UInt qubit, Real angle) {
-    c.push_back(new ql::ry(qubit,angle));
+    c.push_back(gate_arena->make<ql::ry>(qubit,angle));
     c.back()->condition = condition;
     c.back()->cond_operands = cond_operands;;
     cycles_valid = false;
 }
 
 void quantum_kernel::rz(UInt qubit, Real angle) {
-    c.push_back(new ql::rz(qubit,angle));
+    c.push_back(gate_arena->make<ql::rz>(qubit,angle));
     c.back()->condition = condition;
     c.back()->cond_operands = cond_operands;;
     cycles_valid = false;
@@ -206,7 +284,7 @@ void quantum_kernel::cphase(UInt qubit1, UInt qubit2) {
 
 void quantum_kernel::toffoli(UInt qubit1, UInt qubit2, UInt qubit3) {
     // TODO add custom gate check if needed
-    c.push_back(new ql::toffoli(qubit1, qubit2, qubit3));
+    c.push_back(gate_arena->make<ql::toffoli>(qubit1, qubit2, qubit3));
     c.back()->condition = condition;
     c.back()->cond_operands = cond_operands;;
     cycles_valid = false;
@@ -221,7 +299,7 @@ void quantum_kernel::wait(const Vec<UInt> &qubits, UInt duration) {
 }
 
 void quantum_kernel::display() {
-    c.push_back(new ql::display());
+    c.push_back(gate_arena->make<ql::display>());
     cycles_valid = false;
 }
 
@@ -371,80 +449,80 @@ Bool quantum_kernel::add_default_gate_if_available(
     }
 
     if (gname == "identity" || gname == "i") {
-        c.push_back(new ql::identity(qubits[0]));
+        c.push_back(gate_arena->make<ql::identity>(qubits[0]));
         result = true;
     } else if (gname == "hadamard" || gname == "h") {
-        c.push_back(new ql::hadamard(qubits[0]));
+        c.push_back(gate_arena->make<ql::hadamard>(qubits[0]));
         result = true;
     } else if (gname == "pauli_x" || gname == "x") {
-        c.push_back(new pauli_x(qubits[0]));
+        c.push_back(gate_arena->make<pauli_x>(qubits[0]));
         result = true;
     } else if( gname == "pauli_y" || gname == "y") {
-        c.push_back(new pauli_y(qubits[0]));
+        c.push_back(gate_arena->make<pauli_y>(qubits[0]));
         result = true;
     } else if (gname == "pauli_z" || gname == "z") {
-        c.push_back(new pauli_z(qubits[0]));
+        c.push_back(gate_arena->make<pauli_z>(qubits[0]));
         result = true;
     } else if (gname == "s" || gname == "phase") {
-        c.push_back(new phase(qubits[0]));
+        c.push_back(gate_arena->make<phase>(qubits[0]));
         result = true;
     } else if (gname == "sdag" || gname == "phasedag") {
-        c.push_back(new phasedag(qubits[0]));
+        c.push_back(gate_arena->make<phasedag>(qubits[0]));
         result = true;
     } else if (gname == "t") {
-        c.push_back(new ql::t(qubits[0]));
+        c.push_back(gate_arena->make<ql::t>(qubits[0]));
         result = true;
     } else if (gname == "tdag") {
-        c.push_back(new ql::tdag(qubits[0]));
+        c.push_back(gate_arena->make<ql::tdag>(qubits[0]));
         result = true;
     } else if (gname == "rx") {
-        c.push_back(new ql::rx(qubits[0], angle));
+        c.push_back(gate_arena->make<ql::rx>(qubits[0], angle));
         result = true;
     } else if (gname == "ry") {
-        c.push_back(new ql::ry(qubits[0], angle));
+        c.push_back(gate_arena->make<ql::ry>(qubits[0], angle));
         result = true;
     } else if( gname == "rz") {
-        c.push_back(new ql::rz(qubits[0], angle));
+        c.push_back(gate_arena->make<ql::rz>(qubits[0], angle));
         result = true;
     } else if (gname == "rx90") {
-        c.push_back(new ql::rx90(qubits[0]));
+        c.push_back(gate_arena->make<ql::rx90>(qubits[0]));
         result = true;
     } else if (gname == "mrx90") {
-        c.push_back(new ql::mrx90(qubits[0]));
+        c.push_back(gate_arena->make<ql::mrx90>(qubits[0]));
         result = true;
     } else if (gname == "rx180") {
-        c.push_back(new ql::rx180(qubits[0]));
+        c.push_back(gate_arena->make<ql::rx180>(qubits[0]));
         result = true;
     } else if (gname == "ry90") {
-        c.push_back(new ql::ry90(qubits[0]));
+        c.push_back(gate_arena->make<ql::ry90>(qubits[0]));
         result = true;
     } else if (gname == "mry90") {
-        c.push_back(new ql::mry90(qubits[0]));
+        c.push_back(gate_arena->make<ql::mry90>(qubits[0]));
         result = true;
     } else if (gname == "ry180") {
-        c.push_back(new ql::ry180(qubits[0]));
+        c.push_back(gate_arena->make<ql::ry180>(qubits[0]));
         result = true;
     } else if (gname == "measure") {
         if (cregs.empty()) {
-            c.push_back(new ql::measure(qubits[0]));
+            c.push_back(gate_arena->make<ql::measure>(qubits[0]));
         } else {
-            c.push_back(new ql::measure(qubits[0], cregs[0]));
+            c.push_back(gate_arena->make<ql::measure>(qubits[0], cregs[0]));
         }
         result = true;
     } else if (gname == "prepz") {
-        c.push_back(new ql::prepz(qubits[0]));
+        c.push_back(gate_arena->make<ql::prepz>(qubits[0]));
         result = true;
     } else if (gname == "cnot") {
-        c.push_back(new ql::cnot(qubits[0], qubits[1]));
+        c.push_back(gate_arena->make<ql::cnot>(qubits[0], qubits[1]));
         result = true;
     } else if (gname == "cz" || gname == "cphase") {
-        c.push_back(new ql::cphase(qubits[0], qubits[1]) );
+        c.push_back(gate_arena->make<ql::cphase>(qubits[0], qubits[1]) );
         result = true;
     } else if (gname == "toffoli") {
-        c.push_back(new ql::toffoli(qubits[0], qubits[1], qubits[2]));
+        c.push_back(gate_arena->make<ql::toffoli>(qubits[0], qubits[1], qubits[2]));
         result = true;
     } else if (gname == "swap") {
-        c.push_back(new ql::swap(qubits[0], qubits[1]));
+        c.push_back(gate_arena->make<ql::swap>(qubits[0], qubits[1]));
         result = true;
     } else if (gname == "barrier") {
         /*
@@ -456,9 +534,9 @@ Bool quantum_kernel::add_default_gate_if_available(
             for (UInt q = 0; q < qubit_count; q++) {
                 all_qubits.push_back(q);
             }
-            c.push_back(new ql::wait(all_qubits, 0, 0));
+            c.push_back(gate_arena->make<ql::wait>(all_qubits, 0, 0));
         } else {
-            c.push_back(new ql::wait(qubits, 0, 0));
+            c.push_back(gate_arena->make<ql::wait>(qubits, 0, 0));
         }
         result = true;
     } else if (gname == "wait") {
@@ -472,9 +550,9 @@ Bool quantum_kernel::add_default_gate_if_available(
             for (UInt q = 0; q < qubit_count; q++) {
                 all_qubits.push_back(q);
             }
-            c.push_back(new ql::wait(all_qubits, duration, duration_in_cycles));
+            c.push_back(gate_arena->make<ql::wait>(all_qubits, duration, duration_in_cycles));
         } else {
-            c.push_back(new ql::wait(qubits, duration, duration_in_cycles));
+            c.push_back(gate_arena->make<ql::wait>(qubits, duration, duration_in_cycles));
         }
         result = true;
     } else {
@@ -516,28 +594,19 @@ Bool quantum_kernel::add_custom_gate_if_available(
         return false;   // return, so a default gate will be attempted
     }
 #endif
-    // construct canonical name
-    Str instr = "";
-    for (auto qubit : qubits) {
-        if (!instr.empty()) {
-            instr += ",";
-        }
-        instr += "q" + to_string(qubit);
-    }
-    instr = gname + " " + instr;
-
     // first check if a specialized custom gate is available
-    // a specialized custom gate is of the form: "cz q0 q3"
-    instruction_map_t::iterator it = instruction_map.find(instr);
-    if (it == instruction_map.end()) {
-        it = instruction_map.find(gname);
+    // a specialized custom gate is of the form: "cz q0,q3"
+    UInt opcode = instruction_index->find_opcode(gname);
+    custom_gate *prototype = instruction_index->find_specialized(opcode, qubits);
+    if (!prototype) {
+        prototype = instruction_index->find(opcode);
     }
-    if (it == instruction_map.end()) {
+    if (!prototype) {
         QL_DOUT("custom gate not added for " << gname);
         return false;
     }
 
-    custom_gate *g = new custom_gate(*(it->second));
+    custom_gate *g = gate_arena->make<custom_gate>(*prototype);
     for (auto qubit : qubits) {
         g->operands.push_back(qubit);
     }
@@ -572,8 +641,8 @@ void quantum_kernel::get_decomposed_ins(
     for (auto &agate : sub_gates) {
         Str &sub_ins = agate->name;
         QL_DOUT("  sub ins: " << sub_ins);
-        auto it = instruction_map.find(sub_ins);
-        if (it != instruction_map.end()) {
+        auto it = instruction_map->find(sub_ins);
+        if (it != instruction_map->end()) {
             sub_instructions.push_back(sub_ins);
         } else {
             throw Exception("[x] error : kernel::gate() : gate decomposition not available for '" + sub_ins + "'' in the target platform !", false);
@@ -598,23 +667,12 @@ Bool quantum_kernel::add_spec_decomposed_gate_if_available(
     Bool added = false;
     QL_DOUT("Checking if specialized decomposition is available for " << gate_name);
 
-    // construct canonical name
-    Str instr_parameterized = "";
-    for (auto qubit : all_qubits) {
-        if (!instr_parameterized.empty()) {
-            instr_parameterized += ",";
-        }
-        instr_parameterized += "q" + to_string(qubit);
-    }
-    instr_parameterized = gate_name + " " + instr_parameterized;
-    QL_DOUT("specialized instruction name: " << instr_parameterized);
-
-    // find the name
-    auto it = instruction_map.find(instr_parameterized);
-    if (it != instruction_map.end()) {
+    // find the specialized gate, e.g. "cz q0,q3"
+    custom_gate *spec_gate = instruction_index->find_specialized(gate_name, all_qubits);
+    if (spec_gate) {
         // check gate type
-        QL_DOUT("specialized composite gate found for " << instr_parameterized);
-        composite_gate * gptr = (composite_gate *)(it->second);
+        QL_DOUT("specialized composite gate found for " << spec_gate->name);
+        composite_gate * gptr = (composite_gate *)spec_gate;
         if (gptr->type() == __composite_gate__) {
             QL_DOUT("composite gate type");
         } else {
@@ -671,7 +729,7 @@ Bool quantum_kernel::add_spec_decomposed_gate_if_available(
         }
         added = true;
     } else {
-        QL_DOUT("composite gate not found for " << instr_parameterized);
+        QL_DOUT("composite gate not found for " << gate_name);
     }
 
     return added;
@@ -694,22 +752,11 @@ Bool quantum_kernel::add_param_decomposed_gate_if_available(
     Bool added = false;
     QL_DOUT("Checking if parameterized composite gate is available for " << gate_name);
 
-    // construct instruction name from gate_name and actual qubit parameters
-    Str instr_parameterized = "";
-    for (UInt i = 0; i < all_qubits.size(); i++) {
-        if (!instr_parameterized.empty()) {
-            instr_parameterized += ",";
-        }
-        instr_parameterized += "%" + to_string(i);
-    }
-    instr_parameterized = gate_name + " " + instr_parameterized;
-    QL_DOUT("parameterized instruction name: " << instr_parameterized);
-
-    // check for composite ins
-    auto it = instruction_map.find(instr_parameterized);
-    if (it != instruction_map.end()) {
-        QL_DOUT("parameterized gate found for " << instr_parameterized);
-        composite_gate * gptr = (composite_gate *)(it->second);
+    // check for composite ins, e.g. "cz %0,%1" for the number of actual qubit parameters
+    custom_gate *param_gate = instruction_index->find_parameterized(gate_name, all_qubits.size());
+    if (param_gate) {
+        QL_DOUT("parameterized gate found for " << param_gate->name);
+        composite_gate * gptr = (composite_gate *)param_gate;
         if (gptr->type() == __composite_gate__) {
             QL_DOUT("composite gate type");
         } else {
@@ -740,7 +787,7 @@ Bool quantum_kernel::add_param_decomposed_gate_if_available(
                     QL_FATAL("Illegal qubit parameter index " << sub_str_token
                                                               << " exceeds actual number of parameters given (" << all_qubits.size()
                                                               << ") while adding sub ins '" << sub_ins
-                                                              << "' in parameterized instruction '" << instr_parameterized << "'");
+                                                              << "' in parameterized instruction '" << param_gate->name << "'");
                 }
                 this_gate_qubits.push_back(all_qubits[qubit_idx]);
             }
@@ -769,7 +816,7 @@ Bool quantum_kernel::add_param_decomposed_gate_if_available(
         }
         added = true;
     } else {
-        QL_DOUT("composite gate not found for " << instr_parameterized);
+        QL_DOUT("composite gate not found for " << gate_name);
     }
     return added;
 }
@@ -1090,9 +1137,9 @@ Int quantum_kernel::recursiveRelationsForUnitaryDecomposition(
     } else { //n=1
         // DOUT("Adding the zyz decomposition gates at index: "<< i);
         // zyz gates happen on the only qubit in the list.
-        c.push_back(new ql::rz(qubits.back(), u.instructionlist[i]));
-        c.push_back(new ql::ry(qubits.back(), u.instructionlist[i + 1]));
-        c.push_back(new ql::rz(qubits.back(), u.instructionlist[i + 2]));
+        c.push_back(gate_arena->make<ql::rz>(qubits.back(), u.instructionlist[i]));
+        c.push_back(gate_arena->make<ql::ry>(qubits.back(), u.instructionlist[i + 1]));
+        c.push_back(gate_arena->make<ql::rz>(qubits.back(), u.instructionlist[i + 2]));
         // How many gates this took
         return 3;
     }
@@ -1108,16 +1155,16 @@ void quantum_kernel::multicontrolled_rz(
     // DOUT("Adding a multicontrolled rz-gate at start index " << start_index << ", to " << to_string(qubits, "qubits: "));
     UInt idx;
     //The first one is always controlled from the last to the first qubit.
-    c.push_back(new ql::rz(qubits.back(),-instruction_list[start_index]));
-    c.push_back(new ql::cnot(qubits[0], qubits.back()));
+    c.push_back(gate_arena->make<ql::rz>(qubits.back(),-instruction_list[start_index]));
+    c.push_back(gate_arena->make<ql::cnot>(qubits[0], qubits.back()));
     for (UInt i = 1; i < end_index - start_index; i++) {
         idx = log2(((i)^((i)>>1))^((i+1)^((i+1)>>1)));
-        c.push_back(new ql::rz(qubits.back(),-instruction_list[i+start_index]));
-        c.push_back(new ql::cnot(qubits[idx], qubits.back()));
+        c.push_back(gate_arena->make<ql::rz>(qubits.back(),-instruction_list[i+start_index]));
+        c.push_back(gate_arena->make<ql::cnot>(qubits[idx], qubits.back()));
     }
     // The last one is always controlled from the next qubit to the first qubit
-    c.push_back(new ql::rz(qubits.back(),-instruction_list[end_index]));
-    c.push_back(new ql::cnot(qubits.end()[-2], qubits.back()));
+    c.push_back(gate_arena->make<ql::rz>(qubits.back(),-instruction_list[end_index]));
+    c.push_back(gate_arena->make<ql::cnot>(qubits.end()[-2], qubits.back()));
     cycles_valid = false;
 }
 
@@ -1132,17 +1179,17 @@ void quantum_kernel::multicontrolled_ry(
     UInt idx;
 
     //The first one is always controlled from the last to the first qubit.
-    c.push_back(new ql::ry(qubits.back(),-instruction_list[start_index]));
-    c.push_back(new ql::cnot(qubits[0], qubits.back()));
+    c.push_back(gate_arena->make<ql::ry>(qubits.back(),-instruction_list[start_index]));
+    c.push_back(gate_arena->make<ql::cnot>(qubits[0], qubits.back()));
 
     for (UInt i = 1; i < end_index - start_index; i++) {
         idx = log2(((i)^((i)>>1))^((i+1)^((i+1)>>1)));
-        c.push_back(new ql::ry(qubits.back(),-instruction_list[i+start_index]));
-        c.push_back(new ql::cnot(qubits[idx], qubits.back()));
+        c.push_back(gate_arena->make<ql::ry>(qubits.back(),-instruction_list[i+start_index]));
+        c.push_back(gate_arena->make<ql::cnot>(qubits[idx], qubits.back()));
     }
     // Last one is controlled from the next qubit to the first one.
-    c.push_back(new ql::ry(qubits.back(),-instruction_list[end_index]));
-    c.push_back(new ql::cnot(qubits.end()[-2], qubits.back()));
+    c.push_back(gate_arena->make<ql::ry>(qubits.back(),-instruction_list[end_index]));
+    c.push_back(gate_arena->make<ql::cnot>(qubits.end()[-2], qubits.back()));
     cycles_valid = false;
 }
 
@@ -1199,18 +1246,22 @@ Str quantum_kernel::get_epilogue() const {
     return ss.str();
 }
 
-Str quantum_kernel::qasm() const {
-    StrStrm ss;
-
-    ss << get_prologue();
+void quantum_kernel::write_qasm(std::ostream &os) const {
+    os << get_prologue();
 
     for (UInt i = 0; i < c.size(); ++i) {
-        ss << "    " << c[i]->qasm() << "\n";
+        os << "    ";
+        c[i]->write_qasm(os);
+        os << "\n";
     }
 
-    ss << get_epilogue();
+    os << get_epilogue();
+}
 
-    return  ss.str();
+Str quantum_kernel::qasm() const {
+    StrStrm ss;
+    write_qasm(ss);
+    return ss.str();
 }
 
 /**
@@ -1233,12 +1284,12 @@ void quantum_kernel::classical(const creg &destination, const operation &oper) {
         }
     }
 
-    c.push_back(new ql::classical(destination, oper));
+    c.push_back(gate_arena->make<ql::classical>(destination, oper));
     cycles_valid = false;
 }
 
 void quantum_kernel::classical(const Str &operation) {
-    c.push_back(new ql::classical(operation));
+    c.push_back(gate_arena->make<ql::classical>(operation));
     cycles_valid = false;
 }
 
@@ -1484,7 +1535,7 @@ void quantum_kernel::controlled_single(
     for (auto &g : ckt) {
         Str gname = g->name;
         gate_type_t gtype = g->type();
-        Vec<UInt> goperands = g->operands;
+        auto goperands = g->operands;
         QL_DOUT("Generating controlled gate for " << gname);
         QL_DOUT("Type : " << gtype);
         if (gtype == __pauli_x_gate__ || gtype == __rx180_gate__) {
@@ -1641,49 +1692,49 @@ void quantum_kernel::conjugate(const quantum_kernel *k) {
         QL_DOUT("Generating conjugate gate for " << gname);
         QL_DOUT("Type : " << gtype);
         if (gtype == __pauli_x_gate__ || gtype == __rx180_gate__) {
-            gate("x", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("x", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __pauli_y_gate__ || gtype == __ry180_gate__) {
-            gate("y", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("y", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __pauli_z_gate__) {
-            gate("z", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("z", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __hadamard_gate__) {
-            gate("hadamard", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("hadamard", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __identity_gate__) {
-            gate("identity", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("identity", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __t_gate__) {
-            gate("tdag", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("tdag", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __tdag_gate__) {
-            gate("t", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("t", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __phase_gate__) {
-            gate("sdag", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("sdag", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __phasedag_gate__) {
-            gate("s", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("s", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __cnot_gate__) {
-            gate("cnot", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("cnot", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __swap_gate__) {
-            gate("swap", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("swap", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __rx_gate__) {
-            gate("rx", g->operands, {}, g->duration, -(g->angle) , g->breg_operands);
+            gate("rx", g->operands.to_vec(), {}, g->duration, -(g->angle) , g->breg_operands);
         } else if (gtype == __ry_gate__) {
-            gate("ry", g->operands, {}, g->duration, -(g->angle) , g->breg_operands);
+            gate("ry", g->operands.to_vec(), {}, g->duration, -(g->angle) , g->breg_operands);
         } else if (gtype == __rz_gate__) {
-            gate("rz", g->operands, {}, g->duration, -(g->angle) , g->breg_operands);
+            gate("rz", g->operands.to_vec(), {}, g->duration, -(g->angle) , g->breg_operands);
         } else if (gtype == __rx90_gate__) {
-            gate("mrx90", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("mrx90", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __mrx90_gate__) {
-            gate("rx90", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("rx90", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __rx180_gate__) {
-            gate("x", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("x", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __ry90_gate__) {
-            gate("mry90", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("mry90", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __mry90_gate__) {
-            gate("ry90", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("ry90", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __ry180_gate__) {
-            gate("y", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("y", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __cphase_gate__) {
-            gate("cphase", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("cphase", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else if (gtype == __toffoli_gate__) {
-            gate("toffoli", g->operands, {}, g->duration, g->angle, g->breg_operands);
+            gate("toffoli", g->operands.to_vec(), {}, g->duration, g->angle, g->breg_operands);
         } else {
             QL_EOUT("Conjugate version of gate '" << gname << "' not defined !");
             throw Exception("[x] error : kernel::conjugate : Conjugate version of gate '" + gname + "' not defined ! ", false);
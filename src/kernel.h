@@ -8,8 +8,10 @@
 #include "utils/str.h"
 #include "utils/vec.h"
 #include "utils/opt.h"
+#include "utils/arena.h"
 #include "gate.h"
 #include "circuit.h"
+#include "ir.h"
 #include "classical.h"
 #include "hardware_configuration.h"
 #include "unitary.h"
@@ -25,6 +27,18 @@ enum class kernel_type_t {
     ELSE_START, ELSE_END
 };
 
+class kernel_bundles_t;
+
+// statistics of the circuit of a kernel, as reported by report_statistics;
+// computed in one pass over the circuit by quantum_kernel::get_statistics()
+struct kernel_statistics_t {
+    utils::UInt quantum_gates = 0;
+    utils::UInt non_single_qubit_gates = 0;
+    utils::UInt classical_operations = 0;
+    utils::Vec<utils::UInt> qubit_usecount;         // per qubit, number of quantum gates operating on it
+    utils::Vec<utils::UInt> qubit_usedcyclecount;   // per qubit, number of cycles of the quantum gates operating on it
+};
+
 class quantum_kernel {
 public: // FIXME: should be private
     utils::Str              name;
@@ -37,9 +51,12 @@ public: // FIXME: should be private
     utils::Bool             cycles_valid; // used in bundler to check if kernel has been scheduled
     utils::Opt<operation>   br_condition;
     utils::UInt             cycle_time;   // FIXME HvS just a copy of platform.cycle_time
-    instruction_map_t       instruction_map;
+    std::shared_ptr<const instruction_map_t> instruction_map;      // supported operations, shared with the platform
+    std::shared_ptr<const instruction_index_t> instruction_index;  // index on the keys of instruction_map
+    std::shared_ptr<utils::Arena> gate_arena;  // owns the gates created by this kernel; shared with its copies, freed with the last one
     utils::Vec<utils::UInt> cond_operands;    // see gate interface: condition mode to make new gates conditional
     cond_type_t             condition;        // kernel condition mode is set by gate_preset_condition()
+    mutable std::shared_ptr<const kernel_bundles_t> bundles;  // cache of get_bundles()
 
 public:
     quantum_kernel(const utils::Str &name);
@@ -61,6 +78,14 @@ public:
     circuit &get_circuit();
     const circuit &get_circuit() const;
 
+    // returns the bundled representation of the circuit, which must have valid cycles;
+    // it is cached until the gates of the circuit, their cycles or their durations change,
+    // and the reference is valid until the next call
+    const ir::bundles_t &get_bundles() const;
+
+    // returns the statistics of the circuit for the qubits and cycle time of the given platform
+    kernel_statistics_t get_statistics(const quantum_platform &platform) const;
+
     void identity(utils::UInt qubit);
     void i(utils::UInt qubit);
     void hadamard(utils::UInt qubit);
@@ -280,6 +305,7 @@ public:
     // FIXME: create a separate QASM backend?
     utils::Str get_prologue() const;
     utils::Str get_epilogue() const;
+    void write_qasm(std::ostream &os) const;    // streams the circuit's gates, one per line, into os
     utils::Str qasm() const;
 
     void classical(const creg &destination, const operation &oper);
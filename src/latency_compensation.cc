@@ -24,38 +24,118 @@ static void lc_sort_by_cycle(circuit *cp) {
     std::stable_sort(cp->begin(), cp->end(), lc_cycle_lessthan);
 }
 
+latency_window_t::latency_window_t(const quantum_platform &platform) : platform(platform) {
+    for (auto &attr : platform.instruction_attributes) {
+        if (attr.has_latency) {
+            min_latency_cycles = min(min_latency_cycles, attr.latency_cycles);
+        }
+    }
+}
+
+Bool latency_window_t::push(gate *gp) {
+    if (pushed_one && gp->cycle < last_cycle) {
+        return false;
+    }
+    pushed_one = true;
+    last_cycle = gp->cycle;
+
+    const instruction_attributes_t *attr = platform.find_instruction_attributes(gp);
+    if (attr && attr->has_latency) {
+        Int latency_cycles = attr->latency_cycles;
+        compensated_one = true;
+
+        gp->cycle = gp->cycle + latency_cycles;
+        QL_DOUT("... compensated to @" << gp->cycle << " <- " << gp->name << " with " << latency_cycles );
+    }
+
+    // insert after all gates with a cycle not larger than that of gp; these
+    // are found near the back, within the latency spread
+    auto it = window.end();
+    while (it != window.begin() && (*std::prev(it))->cycle > gp->cycle) {
+        --it;
+    }
+    window.insert(it, gp);
+    return true;
+}
+
+Bool latency_window_t::ready() const {
+    if (window.empty()) {
+        return false;
+    }
+    // gates pushed later have a scheduled cycle of at least last_cycle, so a
+    // compensated cycle of at least last_cycle + min_latency_cycles
+    return finished || Int(window.front()->cycle) < Int(last_cycle) + min_latency_cycles;
+}
+
+void latency_window_t::finish() {
+    finished = true;
+}
+
+Bool latency_window_t::empty() const {
+    return window.empty();
+}
+
+gate *latency_window_t::front() const {
+    return window.front();
+}
+
+gate *latency_window_t::pop() {
+    gate *gp = window.front();
+    window.pop_front();
+    return gp;
+}
+
+Bool latency_window_t::compensated() const {
+    return compensated_one;
+}
+
 void latency_compensation_kernel(
     quantum_kernel &kernel,
     const quantum_platform &platform
 ) {
     QL_DOUT("Latency compensation ...");
 
-    circuit* circp = &kernel.c;
-
-    Bool compensated_one = false;
-    for (auto &gp : *circp) {
-        auto &id = gp->name;
-        // DOUT("Latency compensating instruction: " << id);
-        Int latency_cycles = 0;
-
-        if (platform.instruction_settings.count(id) > 0) {
-            if (platform.instruction_settings[id].count("latency") > 0) {
-                Real latency_ns = platform.instruction_settings[id]["latency"];
-                latency_cycles = Int(round_away_from_zero(latency_ns / platform.cycle_time));
+    circuit &circ = kernel.c;
+
+    // stream the circuit through the window, writing the gates back in place;
+    // fewer gates have been popped than pushed so this never overwrites a gate
+    // still to be pushed
+    latency_window_t window(platform);
+    UInt nout = 0;
+    UInt nin = 0;
+    for (; nin < circ.size(); nin++) {
+        if (!window.push(circ[nin])) {
+            break;
+        }
+        while (window.ready()) {
+            circ[nout++] = window.pop();
+        }
+    }
+    window.finish();
+    while (window.ready()) {
+        circ[nout++] = window.pop();
+    }
+    Bool compensated_one = window.compensated();
+
+    if (nin < circ.size()) {
+        // the circuit was not ordered by cycle; compensate the rest one by one
+        // and sort it all
+        QL_DOUT("... circuit not ordered by cycle, sorting it after latency compensation");
+        for (; nin < circ.size(); nin++) {
+            gate *gp = circ[nin];
+            const instruction_attributes_t *attr = platform.find_instruction_attributes(gp);
+            if (attr && attr->has_latency) {
                 compensated_one = true;
-
-                gp->cycle = gp->cycle + latency_cycles;
-                QL_DOUT("... compensated to @" << gp->cycle << " <- " << id << " with " << latency_cycles );
+                gp->cycle = gp->cycle + attr->latency_cycles;
+                QL_DOUT("... compensated to @" << gp->cycle << " <- " << gp->name << " with " << attr->latency_cycles );
             }
         }
+        lc_sort_by_cycle(&circ);
     }
 
     if (compensated_one) {
-        QL_DOUT("... sorting on cycle value after latency compensation");
-        lc_sort_by_cycle(circp);
-
         QL_DOUT("... printing schedule after latency compensation");
-        for (auto &gp : *circp) {
+        for (auto &gp : circ) {
             QL_DOUT("...... @(" << gp->cycle << "): " << gp->qasm());
         }
     } else {
@@ -72,9 +152,9 @@ void latency_compensation(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    for (UInt k = 0; k < programp->kernels.size(); ++k) {
-        latency_compensation_kernel(programp->kernels[k], platform);
-    }
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
+        latency_compensation_kernel(kernel, platform);
+    });
 
     report_statistics(programp, platform, "out", passname, "# ");
     report_qasm(programp, platform, "out", passname);
@@ -4,13 +4,60 @@
 
 #pragma once
 
+#include "utils/num.h"
 #include "utils/str.h"
+#include "utils/list.h"
+#include "gate.h"
 #include "program.h"
 #include "platform.h"
 
 namespace ql {
 
-// buffer_delay_insertion pass
+/**
+ * Reorder window for latency compensation. Gates are pushed in non-decreasing
+ * order of their scheduled cycle, get their cycle shifted by the latency of
+ * their instruction, and are popped in non-decreasing order of the compensated
+ * cycle, keeping the original order of gates with equal cycles. A gate can only
+ * be overtaken by gates scheduled at most the latency spread of the platform
+ * later, so only that many cycles worth of gates are held in the window instead
+ * of sorting the whole circuit.
+ */
+class latency_window_t {
+public:
+    explicit latency_window_t(const quantum_platform &platform);
+
+    // compensates the cycle of gp and adds it to the window; returns false,
+    // leaving gp untouched, when gp is scheduled before a previously pushed gate
+    utils::Bool push(gate *gp);
+
+    // true when the front gate and all gates in its cycle can no longer be
+    // overtaken by gates pushed later; all gates are ready after finish()
+    utils::Bool ready() const;
+    void finish();
+
+    utils::Bool empty() const;
+    gate *front() const;
+    gate *pop();
+
+    // whether any gate was compensated so far
+    utils::Bool compensated() const;
+
+private:
+    const quantum_platform &platform;
+    utils::Int min_latency_cycles = 0;      // smallest shift of any instruction, <= 0
+    utils::Bool pushed_one = false;
+    utils::UInt last_cycle = 0;             // scheduled cycle of the last pushed gate
+    utils::Bool finished = false;
+    utils::Bool compensated_one = false;
+    utils::List<gate*> window;              // pushed gates not yet popped, by compensated cycle
+};
+
+void latency_compensation_kernel(
+    quantum_kernel &kernel,
+    const quantum_platform &platform
+);
+
+// latency_compensation pass
 void latency_compensation(
     quantum_program *programp,
     const quantum_platform &platform,
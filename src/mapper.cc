@@ -17,6 +17,7 @@ namespace ql {
 namespace mapper {
 
 using namespace utils;
+using Context = options::Context;
 
 // Grid initializer
 // initialize mapper internal grid maps from configuration
@@ -32,7 +33,7 @@ void Grid::Init(const quantum_platform *p) {
     InitXY();       // x[qi],y[qi] when form==gf_xy, as read from topology.qubits
     InitNbs();      // nbs[qi], read from topology.edges when connectivity is specified, otherwise, when full, computed
     SortNbs();      // when form embedded in grid, sort clock-wise starting from 12:00, to know boundary of search space
-    ComputeDist();  // dist[qi][qj] by Floyd-Warshall, is maximum when not connected
+    ComputeDist();  // dist[qi*nq+qj] by breadth-first search, is maximum when not connected
     DPRINTGrid();
 }
 
@@ -62,9 +63,9 @@ Bool Grid::IsInterCoreHop(UInt qs, UInt qt) const {
 // formulae for convex (hole free) topologies with underlying grid and with bidirectional edges:
 //      gf_cross:   max( abs( x[to_realqi] - x[from_realqi] ), abs( y[to_realqi] - y[from_realqi] ))
 //      gf_plus:    abs( x[to_realqi] - x[from_realqi] ) + abs( y[to_realqi] - y[from_realqi] )
-// when the neighbor relation is defined (topology.edges in config file), Floyd-Warshall is used, which currently is always
+// when the neighbor relation is defined (topology.edges in config file), breadth-first search is used, which currently is always
 UInt Grid::Distance(UInt from_realqi, UInt to_realqi) const {
-    return dist[from_realqi][to_realqi];
+    return dist[from_realqi*nq + to_realqi];
 }
 
 // coredistance between two qubits
@@ -117,8 +118,7 @@ Real Grid::Angle(Int cx, Int cy, Int x, Int y) const {
 void Grid::Normalize(UInt src, neighbors_t &nbl) const {
     if (form != gf_xy) {
         // there are no implicit/explicit x/y coordinates defined per qubit, so no sense of nearness
-        Str mappathselectopt = options::get("mappathselect");
-        QL_ASSERT(mappathselectopt != "borders");
+        QL_ASSERT(options::context().mappathselect != Context::MapPathSelect::BORDERS);
         return;
     }
 
@@ -163,24 +163,26 @@ void Grid::Normalize(UInt src, neighbors_t &nbl) const {
     // for (auto dn : nbl) { std::cout << dn << " "; } std::cout << std::endl;
 }
 
-// Floyd-Warshall dist[i][j] = shortest distances between all nq qubits i and j
+// dist[i*nq+j] = shortest distances between all nq qubits i and j
 // when not connected, distance remains maximum value
+//
+// all edges have length 1, so a breadth-first search from each qubit i computes row i of dist;
+// this is O(nq*(nq+edges)) instead of the O(nq^3) of Floyd-Warshall, which matters for large platforms
 void Grid::ComputeDist() {
-    // initialize all distances to maximum value, to neighbors to 1, to itself to 0
-    dist.resize(nq); for (UInt i=0; i<nq; i++) dist[i].resize(nq, MAX_CYCLE);
+    dist.assign(nq*nq, MAX_CYCLE);
+    Vec<UInt> queue(nq);
     for (UInt i = 0; i < nq; i++) {
-        dist[i][i] = 0;
-        for (UInt j : nbs.get(i)) {
-            dist[i][j] = 1;
-        }
-    }
-
-    // find shorter distances by gradually including more qubits (k) in path
-    for (UInt k = 0; k < nq; k++) {
-        for (UInt i = 0; i < nq; i++) {
-            for (UInt j = 0; j < nq; j++) {
-                if (dist[i][j] > dist[i][k] + dist[k][j]) {
-                    dist[i][j] = dist[i][k] + dist[k][j];
+        UInt *row = &dist[i*nq];
+        UInt head = 0;
+        UInt tail = 0;
+        row[i] = 0;
+        queue[tail++] = i;
+        while (head < tail) {
+            UInt k = queue[head++];
+            for (UInt j : nbs.get(k)) {
+                if (row[j] == MAX_CYCLE) {
+                    row[j] = row[k] + 1;
+                    queue[tail++] = j;
                 }
             }
         }
@@ -189,16 +191,124 @@ void Grid::ComputeDist() {
     for (UInt i = 0; i < nq; i++) {
         for (UInt j = 0; j < nq; j++) {
             if (form == gf_cross) {
-                QL_ASSERT (dist[i][j] == (max(abs(x[i] - x[j]),
+                QL_ASSERT (dist[i*nq+j] == (max(abs(x[i] - x[j]),
                                                       abs(y[i] - y[j]))));
             } else if (form == gf_plus) {
-                QL_ASSERT (dist[i][j] ==
+                QL_ASSERT (dist[i*nq+j] ==
                               (abs(x[i] - x[j]) + abs(y[i] - y[j])));
             }
 
         }
     }
 #endif
+
+    // distances changed, so forget paths that were enumerated before
+    pathcache.reset();
+    pathcache.emplace();
+}
+
+// key of the memo tables in pathcache;
+// budget is at most MinHops, so less than nq+3
+UInt Grid::PathKey(UInt src, UInt tgt, UInt budget, whichpaths_t which) const {
+    QL_ASSERT(budget < nq+3);
+    return ((UInt(which)*(nq+3) + budget)*nq + src)*nq + tgt;
+}
+
+// next hops from src on the paths to tgt within budget hops, bounded by a particular strategy (which)
+const Vec<UInt> &Grid::NextHops(UInt src, UInt tgt, UInt budget, whichpaths_t which) const {
+    std::lock_guard<std::mutex> lock(pathcache->mutex);
+    return NextHopsLocked(src, tgt, budget, which);
+}
+
+const Vec<UInt> &Grid::NextHopsLocked(UInt src, UInt tgt, UInt budget, whichpaths_t which) const {
+    UInt key = PathKey(src, tgt, budget, which);
+    auto it = pathcache->nexthops.find(key);
+    if (it != pathcache->nexthops.end()) {
+        return it->second;
+    }
+
+    // reduce neighbors nbs to those n continuing a path within budget
+    // src=>tgt is distance d, budget>=d is allowed, attempt src->n=>tgt
+    // src->n is one hop, budget from n is one less so distance(n,tgt) <= budget-1 (i.e. distance < budget)
+    // when budget==d, this defaults to distance(n,tgt) <= d-1
+    auto nbl = nbs.get(src);
+    nbl.remove_if([this,budget,tgt](const UInt& n) { return Distance(n,tgt) >= budget; });
+
+    // rotate neighbor list nbl such that largest difference between angles of adjacent elements is beyond back()
+    // this makes only sense when there is an underlying xy grid; when not, which can only be wp_all_shortest
+    Normalize(src, nbl);
+    // subset to those neighbors that continue in direction(s) we want
+    if (which == wp_left_shortest) {
+        nbl.remove_if( [nbl](const UInt& n) { return n != nbl.front(); } );
+    } else if (which == wp_right_shortest) {
+        nbl.remove_if( [nbl](const UInt& n) { return n != nbl.back(); } );
+    } else if (which == wp_leftright_shortest) {
+        nbl.remove_if( [nbl](const UInt& n) { return n != nbl.front() && n != nbl.back(); } );
+    }
+
+    return pathcache->nexthops.set(key) = Vec<UInt>(nbl.begin(), nbl.end());
+}
+
+// all paths from src to tgt within budget hops, bounded by a particular strategy (which)
+//
+// The paths are enumerated by a depth-first walk over the next hops table,
+// in the order of the next hops at each qubit, so the order is the one of the recursive definition:
+// - when src==tgt, the only path is the one with just src
+// - otherwise, for each next hop n from src, all paths from n to tgt within budget-1 hops, with src in front;
+//   when looking both left and right still and there is a choice at src, the first next hop continues left
+//   and the others continue right
+const Vec<Grid::path_t> &Grid::ShortestPaths(UInt src, UInt tgt, UInt budget, whichpaths_t which) const {
+    std::lock_guard<std::mutex> lock(pathcache->mutex);
+    UInt key = PathKey(src, tgt, budget, which);
+    auto it = pathcache->paths.find(key);
+    if (it != pathcache->paths.end()) {
+        return it->second;
+    }
+
+    Vec<path_t> &resps = pathcache->paths.set(key);
+    path_t path;
+    path.push_back(src);
+    if (src == tgt) {
+        resps.push_back(path);
+        return resps;
+    }
+    QL_ASSERT(Distance(src, tgt) >= 1);
+
+    // stack of the qubits on the current path that still have next hops to visit
+    typedef struct {
+        const Vec<UInt> *nexthops;  // next hops of this qubit
+        UInt            next;       // index in nexthops of the next one to visit
+        UInt            budget;     // budget from this qubit
+        whichpaths_t    which;      // strategy from this qubit
+    } frame_t;
+    Vec<frame_t> stack;
+    stack.push_back({&NextHopsLocked(src, tgt, budget, which), 0, budget, which});
+    while (!stack.empty()) {
+        frame_t &f = stack.back();
+        if (f.next == f.nexthops->size()) {
+            stack.pop_back();
+            path.pop_back();
+            continue;
+        }
+        UInt n = (*f.nexthops)[f.next];
+        whichpaths_t newwhich = f.which;
+        // but for each neighbor only look in desired direction, if any
+        if (f.which == wp_leftright_shortest && f.nexthops->size() != 1) {
+            // when looking both left and right still, and there is a choice now, split into left and right
+            newwhich = (f.next == 0) ? wp_left_shortest : wp_right_shortest;
+        }
+        UInt newbudget = f.budget - 1;
+        f.next++;
+
+        path.push_back(n);
+        if (n == tgt) {
+            resps.push_back(path);
+            path.pop_back();
+        } else {
+            stack.push_back({&NextHopsLocked(n, tgt, newbudget, newwhich), 0, newbudget, newwhich});
+        }
+    }
+    return resps;
 }
 
 void Grid::DPRINTGrid() const {
@@ -246,10 +356,10 @@ void Grid::PrintGrid() const {
 // init grid form attributes
 void Grid::InitForm() {
     Str formstr;
-    if (platformp->topology.count("form") <= 0) {
+    if (platformp->topology->count("form") <= 0) {
         formstr = "xy";
     } else {
-        formstr = platformp->topology["form"].get<Str>();
+        formstr = (*platformp->topology)["form"].get<Str>();
     }
     if (formstr == "xy") { form = gf_xy; }
     if (formstr == "irregular") { form = gf_irregular; }
@@ -260,19 +370,19 @@ void Grid::InitForm() {
         ny = 0;
     } else {
         // gf_xy have an x/y space; coordinates are explicitly specified
-        nx = platformp->topology["x_size"];
-        ny = platformp->topology["y_size"];
+        nx = (*platformp->topology)["x_size"];
+        ny = (*platformp->topology)["y_size"];
     }
     QL_DOUT("... formstr=" << formstr << "; form=" << form << "; nx=" << nx << "; ny=" << ny);
 }
 
 // init multi-core attributes
 void Grid::InitCores() {
-    if (platformp->topology.count("number_of_cores") <= 0) {
+    if (platformp->topology->count("number_of_cores") <= 0) {
         ncores = 1;
         QL_DOUT("Number of cores (topology[\"number_of_cores\"]) not defined");
     } else {
-        ncores = platformp->topology["number_of_cores"];
+        ncores = (*platformp->topology)["number_of_cores"];
         if (ncores <= 0) {
             QL_FATAL("Number of cores (topology[\"number_of_cores\"]) is not a positive value: " << ncores);
         }
@@ -281,11 +391,11 @@ void Grid::InitCores() {
 
     // when not specified in single-core: == nq (i.e. all qubits)
     // when not specified in multi-core: == nq/ncores (i.e. all qubits of a core)
-    if (platformp->topology.count("comm_qubits_per_core") <= 0) {
+    if (platformp->topology->count("comm_qubits_per_core") <= 0) {
         ncommqpc = nq/ncores;   // i.e. all are comm qubits
         QL_DOUT("Number of comm_qubits per core (topology[\"comm_qubits_per_core\"]) not defined; assuming all are comm qubits.");
     } else {
-        ncommqpc = platformp->topology["comm_qubits_per_core"];
+        ncommqpc = (*platformp->topology)["comm_qubits_per_core"];
         if (ncommqpc <= 0) {
             QL_FATAL("Number of communication qubits per core (topology[\"comm_qubits_per_core\"]) is not a positive value: " << ncommqpc);
         }
@@ -299,13 +409,13 @@ void Grid::InitCores() {
 // init x, and y maps
 void Grid::InitXY() {
     if (form != gf_irregular) {
-        if (platformp->topology.count("qubits") == 0) {
+        if (platformp->topology->count("qubits") == 0) {
             QL_FATAL("Regular configuration doesn't specify qubits and their coordinates");
         } else {
-            if (nq != platformp->topology["qubits"].size()) {
+            if (nq != (*platformp->topology)["qubits"].size()) {
                 QL_FATAL("Mismatch between platform qubit number and qubit coordinate list");
             }
-            for (auto &aqbit : platformp->topology["qubits"]) {
+            for (auto &aqbit : (*platformp->topology)["qubits"]) {
                 UInt qi = aqbit["id"];
                 Int qx = aqbit["x"];
                 Int qy = aqbit["y"];
@@ -336,12 +446,12 @@ void Grid::InitXY() {
 
 // init nbs map
 void Grid::InitNbs() {
-    if (platformp->topology.count("connectivity") <= 0) {
+    if (platformp->topology->count("connectivity") <= 0) {
         QL_DOUT("Configuration doesn't specify topology.connectivity: assuming connectivity is specified by edges section");
         conn = gc_specified;
     } else {
         Str connstr;
-        connstr = platformp->topology["connectivity"].get<Str>();
+        connstr = (*platformp->topology)["connectivity"].get<Str>();
         if (connstr == "specified") {
             conn = gc_specified;
         } else if (connstr == "full") {
@@ -352,10 +462,10 @@ void Grid::InitNbs() {
         QL_DOUT("topology.connectivity=" << connstr );
     }
     if (conn == gc_specified) {
-        if (platformp->topology.count("edges") == 0) {
+        if (platformp->topology->count("edges") == 0) {
             QL_FATAL(" There aren't edges configured in the platform's topology");
         }
-        for (auto &anedge : platformp->topology["edges"]) {
+        for (auto &anedge : (*platformp->topology)["edges"]) {
             QL_DOUT("connectivity is specified by edges section, reading ...");
             UInt qs = anedge["src"];
             UInt qd = anedge["dst"];
@@ -664,8 +774,6 @@ FreeCycle::FreeCycle() {
 
 void FreeCycle::Init(const quantum_platform *p, const UInt breg_count) {
     QL_DOUT("FreeCycle::Init()");
-    arch::resource_manager_t lrm(*p, forward_scheduling);   // allocated here and copied below to rm because of platform parameter
-    QL_DOUT("... created FreeCycle Init local resource_manager");
     platformp = p;
     nq = platformp->qubit_number;
     nb = breg_count;
@@ -673,9 +781,9 @@ void FreeCycle::Init(const quantum_platform *p, const UInt breg_count) {
     QL_DOUT("... FreeCycle: nq=" << nq << ", nb=" << nb << ", ct=" << ct << "), initializing to all 0 cycles");
     fcv.clear();
     fcv.resize(nq+nb, 1);   // this 1 implies that cycle of first gate will be 1 and not 0; OpenQL convention!?!?
-    QL_DOUT("... about to copy FreeCycle Init local resource_manager to FreeCycle member rm");
-    rm = lrm;
-    QL_DOUT("... done copy FreeCycle Init local resource_manager to FreeCycle member rm");
+    rm.reset();
+    rm.emplace(*p, forward_scheduling);   // not shared with any other FreeCycle yet
+    QL_DOUT("... created FreeCycle Init resource_manager");
 }
 
 // depth of the FreeCycle map
@@ -741,8 +849,7 @@ Bool FreeCycle::IsFirstOperandEarlier(UInt r0, UInt r1) const {
 // will a swap(fr0,fr1) start earlier than a swap(sr0,sr1)?
 // is really a short-cut ignoring config file and perhaps several other details
 Bool FreeCycle::IsFirstSwapEarliest(UInt fr0, UInt fr1, UInt sr0, UInt sr1) const {
-    Str mapreverseswapopt = options::get("mapreverseswap");
-    if (mapreverseswapopt == "yes") {
+    if (options::context().mapreverseswap) {
         if (fcv[fr0] < fcv[fr1]) {
             UInt  tmp = fr1; fr1 = fr0; fr0 = tmp;
         }
@@ -784,20 +891,12 @@ UInt FreeCycle::StartCycleNoRc(gate *g) const {
 UInt FreeCycle::StartCycle(gate *g) {
     UInt startCycle = StartCycleNoRc(g);
 
-    auto mapopt = options::get("mapper");
-    if (mapopt == "baserc" || mapopt == "minextendrc") {
+    auto mapopt = options::context().mapper;
+    if (mapopt == Context::Mapper::BASERC || mapopt == Context::Mapper::MINEXTENDRC) {
         UInt baseStartCycle = startCycle;
 
-        while (startCycle < MAX_CYCLE) {
-            // QL_DOUT("Startcycle for " << g->qasm() << ": available? at startCycle=" << startCycle);
-            if (rm.available(startCycle, g, *platformp)) {
-                // QL_DOUT(" ... [" << startCycle << "] resources available for " << g->qasm());
-                break;
-            } else {
-                // QL_DOUT(" ... [" << startCycle << "] Busy resource for " << g->qasm());
-                startCycle++;
-            }
-        }
+        // QL_DOUT("Startcycle for " << g->qasm() << ": first cycle with resources available from startCycle=" << startCycle);
+        startCycle = rm->next_available(startCycle, g, *platformp);
         if (baseStartCycle != startCycle) {
             // QL_DOUT(" ... from [" << baseStartCycle << "] to [" << startCycle-1 << "] busy resource(s) for " << g->qasm());
         }
@@ -829,12 +928,68 @@ void FreeCycle::AddNoRc(gate *g, UInt startCycle) {
 void FreeCycle::Add(gate *g, UInt startCycle) {
     AddNoRc(g, startCycle);
 
-    auto mapopt = options::get("mapper");
-    if (mapopt == "baserc" || mapopt == "minextendrc") {
-        rm.reserve(startCycle, g, *platformp);
+    auto mapopt = options::context().mapper;
+    if (mapopt == Context::Mapper::BASERC || mapopt == Context::Mapper::MINEXTENDRC) {
+        if (rm.unwrap().use_count() != 1) {
+            // rm is still shared with the FreeCycle map(s) this one was copied from or to;
+            // give this FreeCycle map a private copy before changing it
+            Ptr<arch::resource_manager_t> private_rm;
+            private_rm.emplace(*rm);
+            rm = private_rm;
+        }
+        rm->reserve(startCycle, g, *platformp);
+    }
+}
+
+// constructs an empty list
+SharedGateList::SharedGateList() : head(), n(0) {
+}
+
+// destructor unlinking the older nodes iteratively,
+// to avoid a recursion as deep as the list is long;
+// stops at the first older node that is still referenced by another list
+SharedGateList::Node::~Node() {
+    auto p = std::move(prev);
+    while (p && p.use_count() == 1) {
+        auto older = std::move(p->prev);
+        p = std::move(older);   // destroys the node p pointed at, which has no prev anymore
     }
 }
 
+Bool SharedGateList::empty() const {
+    return n == 0;
+}
+
+UInt SharedGateList::size() const {
+    return n;
+}
+
+// make the list empty; only drops this list's reference to the nodes
+void SharedGateList::clear() {
+    head.reset();
+    n = 0;
+}
+
+// add gate gp at the end of the list (i.e. as newest) with start cycle c
+void SharedGateList::push_back(gate_p gp, UInt c) {
+    auto node = std::make_shared<Node>();
+    node->entry.gp = gp;
+    node->entry.cycle = c;
+    node->prev = std::move(head);
+    head = std::move(node);
+    n++;
+}
+
+// return the entries of the list, oldest first, i.e. in the order they were added
+Vec<SharedGateList::entry_t> SharedGateList::entries() const {
+    Vec<entry_t> result(n);
+    UInt i = n;
+    for (Node *p = head.get(); p != nullptr; p = p->prev.get()) {
+        result[--i] = p->entry;
+    }
+    return result;
+}
+
 // explicit Past constructor
 // needed for virgin construction
 Past::Past() {
@@ -842,17 +997,21 @@ Past::Past() {
 }
 
 // past initializer
-void Past::Init(const quantum_platform *p, quantum_kernel *k, Grid *g) {
+void Past::Init(const quantum_platform *p, quantum_kernel *k, std::mutex *km, const Grid *g) {
     QL_DOUT("Past::Init");
     platformp = p;
     kernelp = k;
+    kernel_mutexp = km;
     gridp = g;
 
     nq = platformp->qubit_number;
     nb = kernelp->breg_count;
     ct = platformp->cycle_time;
 
-    QL_ASSERT(kernelp->c.empty());   // kernelp->c will be used by new_gate to return newly created gates into
+    {
+        std::lock_guard<std::mutex> lock(*kernel_mutexp);
+        QL_ASSERT(kernelp->c.empty());   // kernelp->c will be used by new_gate to return newly created gates into
+    }
     v2r.Init(nq);               // v2r initializtion until v2r is imported from context
     fc.Init(platformp, nb);     // fc starts off with all qubits free, is updated after schedule of each gate
     waitinglg.clear();          // no gates pending to be scheduled in; Add of gate to past entered here
@@ -860,7 +1019,6 @@ void Past::Init(const quantum_platform *p, quantum_kernel *k, Grid *g) {
     outlg.clear();              // no gates output yet by flushing from or bypassing this past
     nswapsadded = 0;            // no swaps or moves added yet to this past; AddSwap adds one here
     nmovesadded = 0;            // no moves added yet to this past; AddSwap may add one here
-    cycle.clear();              // no gates have cycles assigned in this past; scheduling gate updates this
 }
 
 // import Past's v2r from v2r_value
@@ -888,8 +1046,8 @@ void Past::Print(const Str &s) const {
     v2r.Print("");
     fc.Print("");
     // QL_DOUT("... list of gates in past");
-    for (auto &gp : lg) {
-        QL_DOUT("[" << cycle.at(gp) << "] " << gp->qasm());
+    for (auto &e : lg.entries()) {
+        QL_DOUT("[" << e.cycle << "] " << e.gp->qasm());
     }
 }
 
@@ -916,48 +1074,36 @@ void Past::Schedule() {
         // so using tryfc.StartCycle/tryfc.Add we get a realistic ASAP rc schedule.
         // We use a copy of fc and not fc itself, since the latter reflects the really scheduled gates
         // and that shouldn't be changed.
+        // When only one gate is waiting, it is the one found and the trial would compute its startCycle
+        // in an unchanged copy of fc, so then it is computed in fc directly.
         //
         // This search is really a hack to avoid
         // the construction of a dependence graph and a set of schedulable gates
-        FreeCycle   tryfc = fc;
-        for (auto &trygp : waitinglg) {
-            UInt tryStartCycle = tryfc.StartCycle(trygp);
-            tryfc.Add(trygp, tryStartCycle);
-
-            if (tryStartCycle < startCycle) {
-                startCycle = tryStartCycle;
-                gp = trygp;
+        if (waitinglg.size() == 1) {
+            gp = waitinglg.front();
+            startCycle = fc.StartCycle(gp);
+        } else {
+            FreeCycle   tryfc = fc;
+            for (auto &trygp : waitinglg) {
+                UInt tryStartCycle = tryfc.StartCycle(trygp);
+                tryfc.Add(trygp, tryStartCycle);
+
+                if (tryStartCycle < startCycle) {
+                    startCycle = tryStartCycle;
+                    gp = trygp;
+                }
             }
         }
 
         // add this gate to the maps, scheduling the gate (doing the cycle assignment)
         // QL_DOUT("... add " << gp->qasm() << " startcycle=" << startCycle << " cycles=" << ((gp->duration+ct-1)/ct) );
         fc.Add(gp, startCycle);
-        cycle.set(gp) = startCycle; // cycle[gp] is private to this past but gp->cycle is private to gp
         gp->cycle = startCycle; // so gp->cycle gets assigned for each alter' Past and finally definitively for mainPast
         // QL_DOUT("... set " << gp->qasm() << " at cycle " << startCycle);
 
-        // insert gate gp in lg, the list of gates, in cycle[gp] order, and inside this order, as late as possible
-        //
-        // reverse iterate because the insertion is near the end of the list
-        // insert so that cycle values are in order afterwards and the new one is nearest to the end
-        auto rigp = lg.rbegin();
-        Bool inserted = false;
-        for (; rigp != lg.rend(); rigp++) {
-            if (cycle.at(*rigp) <= startCycle) {
-                // rigp.base() because insert doesn't work with reverse iteration
-                // rigp.base points after the element that rigp is pointing at
-                // which is lucky because insert only inserts before the given element
-                // the end effect is inserting after rigp
-                lg.insert(rigp.base(), gp);
-                inserted = true;
-                break;
-            }
-        }
-        // when list was empty or no element was found, just put it in front
-        if (!inserted) {
-            lg.push_front(gp);
-        }
+        // add gate gp to lg, the list of gates, with its startCycle that is private to this past;
+        // lg is kept in order of scheduling, and FlushAll puts it in cycle order
+        lg.push_back(gp, startCycle);
 
         // having added it to the main list, remove it from the waiting list
         waitinglg.remove(gp);
@@ -1024,6 +1170,7 @@ Bool Past::new_gate(
     const Vec<UInt> &gcondregs
 ) const {
     Bool added;
+    std::lock_guard<std::mutex> lock(*kernel_mutexp);
     QL_ASSERT(circ.empty());
     QL_ASSERT(kernelp->c.empty());
     // create gate(s) in kernelp->c
@@ -1071,9 +1218,9 @@ void Past::GenMove(circuit &circ, UInt &r0, UInt &r1) {
 
     // first (optimistically) create the move circuit and add it to circ
     Bool created;
-    auto mapperopt = options::get("mapper");
+    auto mapperopt = options::context().mapper;
     if (gridp->IsInterCoreHop(r0, r1)) {
-        if (mapperopt == "maxfidelity") {
+        if (mapperopt == Context::Mapper::MAXFIDELITY) {
             created = new_gate(circ, "tmove_prim", {r0,r1});    // gates implementing tmove returned in circ
         } else {
             created = new_gate(circ, "tmove_real", {r0,r1});    // gates implementing tmove returned in circ
@@ -1085,7 +1232,7 @@ void Past::GenMove(circuit &circ, UInt &r0, UInt &r1) {
             }
         }
     } else {
-        if (mapperopt == "maxfidelity") {
+        if (mapperopt == Context::Mapper::MAXFIDELITY) {
             created = new_gate(circ, "move_prim", {r0,r1});    // gates implementing move returned in circ
         } else {
             created = new_gate(circ, "move_real", {r0,r1});    // gates implementing move returned in circ
@@ -1119,14 +1266,7 @@ void Past::GenMove(circuit &circ, UInt &r0, UInt &r1) {
         // when difference in extending circuit after scheduling initcirc+circ or just circ
         // is less equal than threshold cycles (0 would mean scheduling initcirc was for free),
         // commit to it, otherwise abort
-        Int threshold;
-        Str mapusemovesopt = options::get("mapusemoves");
-        if (mapusemovesopt == "yes") {
-            threshold = 0;
-        } else {
-            threshold = atoi(mapusemovesopt.c_str());
-        }
-        if (InsertionCost(initcirc, circ) <= threshold) {
+        if (InsertionCost(initcirc, circ) <= options::context().mapusemoves_threshold) {
             // so we go for it!
             // circ contains move; it must get the initcirc before it ...
             // do this by appending circ's gates to initcirc, and then swapping circ and initcirc content
@@ -1174,8 +1314,7 @@ void Past::AddSwap(UInt r0, UInt r1) {
     UInt v1 = v2r.GetVirt(r1);
 
     circuit circ;   // current kernel copy, clear circuit
-    Str mapusemovesopt = options::get("mapusemoves");
-    if (mapusemovesopt != "no" && (v2r.GetRs(r0) != rs_hasstate || v2r.GetRs(r1) != rs_hasstate)) {
+    if (options::context().mapusemoves && (v2r.GetRs(r0) != rs_hasstate || v2r.GetRs(r1) != rs_hasstate)) {
         GenMove(circ, r0, r1);
         created = circ.size()!=0;
         if (created) {
@@ -1191,8 +1330,7 @@ void Past::AddSwap(UInt r0, UInt r1) {
     }
     if (!created) {
         // no move generated so do swap
-        Str mapreverseswapopt = options::get("mapreverseswap");
-        if (mapreverseswapopt == "yes") {
+        if (options::context().mapreverseswap) {
             // swap(r0,r1) is about to be generated
             // it is functionally symmetrical,
             // but in the implementation r1 starts 1 cycle earlier than r0 (we should derive this from json file ...)
@@ -1203,9 +1341,9 @@ void Past::AddSwap(UInt r0, UInt r1) {
                 QL_DOUT("... reversed swap to become swap(q" << r0 << ",q" << r1 << ") ...");
             }
         }
-        auto mapperopt = options::get("mapper");
+        auto mapperopt = options::context().mapper;
         if (gridp->IsInterCoreHop(r0, r1)) {
-            if (mapperopt == "maxfidelity") {
+            if (mapperopt == Context::Mapper::MAXFIDELITY) {
                 created = new_gate(circ, "tswap_prim", {r0,r1});    // gates implementing tswap returned in circ
             } else {
                 created = new_gate(circ, "tswap_real", {r0,r1});    // gates implementing tswap returned in circ
@@ -1218,7 +1356,7 @@ void Past::AddSwap(UInt r0, UInt r1) {
             }
             QL_DOUT("... tswap(q" << r0 << ",q" << r1 << ") ...");
         } else {
-            if (mapperopt == "maxfidelity") {
+            if (mapperopt == Context::Mapper::MAXFIDELITY) {
                 created = new_gate(circ, "swap_prim", {r0,r1});    // gates implementing swap returned in circ
             } else {
                 created = new_gate(circ, "swap_real", {r0,r1});    // gates implementing swap returned in circ
@@ -1305,20 +1443,19 @@ void Past::MakeReal(gate *gp, circuit &circ) {
     Str gname = gp->name;
     stripname(gname);
 
-    Vec<UInt> real_qubits = gp->operands;// starts off as copy of virtual qubits!
+    Vec<UInt> real_qubits = gp->operands.to_vec();// starts off as copy of virtual qubits!
     for (auto &qi : real_qubits) {
         qi = MapQubit(qi);          // and now they are real
-        auto mapprepinitsstateopt = options::get("mapprepinitsstate");
-        if (mapprepinitsstateopt == "yes" && (gname == "prepz" || gname == "Prepz")) {
+        if (options::context().mapprepinitsstate && (gname == "prepz" || gname == "Prepz")) {
             v2r.SetRs(qi, rs_wasinited);
         } else {
             v2r.SetRs(qi, rs_hasstate);
         }
     }
 
-    auto mapperopt = options::get("mapper");
+    auto mapperopt = options::context().mapper;
     Str real_gname = gname;
-    if (mapperopt == "maxfidelity") {
+    if (mapperopt == Context::Mapper::MAXFIDELITY) {
         QL_DOUT("MakeReal: with mapper==maxfidelity generate _prim");
         real_gname.append("_prim");
     } else {
@@ -1373,7 +1510,7 @@ void Past::MakePrimitive(gate *gp, circuit &circ) const {
     Bool created = new_gate(
         circ,
         prim_gname,
-        gp->operands,
+        gp->operands.to_vec(),
         gp->creg_operands,
         gp->duration,
         gp->angle,
@@ -1385,7 +1522,7 @@ void Past::MakePrimitive(gate *gp, circuit &circ) const {
         created = new_gate(
             circ,
             gname,
-            gp->operands,
+            gp->operands.to_vec(),
             gp->creg_operands,
             gp->duration,
             gp->angle,
@@ -1417,8 +1554,14 @@ UInt Past::MaxFreeCycle() const {
 // - nonq gates first cause lg to be flushed/cleared to output before the nonq gate is output
 // all gates in outlg are out of view for scheduling/mapping optimization and can be taken out to elsewhere
 void Past::FlushAll() {
-    for (auto &gp : lg) {
-        outlg.push_back(gp);
+    // lg is in order of scheduling; flush it in cycle order and inside this order in order of scheduling,
+    // i.e. each gate as late as possible among the gates with the same cycle
+    auto lge = lg.entries();
+    std::stable_sort(lge.begin(), lge.end(), [](const SharedGateList::entry_t &e1, const SharedGateList::entry_t &e2) {
+        return e1.cycle < e2.cycle;
+    });
+    for (auto &e : lge) {
+        outlg.push_back(e.gp);
     }
     lg.clear();         // so effectively, lg's content was moved to outlg
 
@@ -1438,8 +1581,8 @@ void Past::ByPass(gate *gp) {
 
 // mainPast flushes outlg to parameter oc
 void Past::Out(circuit &oc) {
-    for (auto &gp : outlg) {
-        oc.push_back(gp);
+    for (auto &e : outlg.entries()) {
+        oc.push_back(e.gp);
     }
     outlg.clear();
 }
@@ -1452,16 +1595,17 @@ Alter::Alter() {
 
 // Alter initializer
 // This should only be called after a virgin construction and not after cloning a path.
-void Alter::Init(const quantum_platform *p, quantum_kernel *k, Grid *g) {
+void Alter::Init(const quantum_platform *p, quantum_kernel *k, std::mutex *km, const Grid *g) {
     QL_DOUT("Alter::Init(number of qubits=" << p->qubit_number);
     platformp = p;
     kernelp = k;
+    kernel_mutexp = km;
     gridp = g;
 
     nq = platformp->qubit_number;
     ct = platformp->cycle_time;
     // total, fromSource and fromTarget start as empty vectors
-    past.Init(platformp, kernelp, gridp);      // initializes past to empty
+    past.Init(platformp, kernelp, kernel_mutexp, gridp);      // initializes past to empty
     didscore = false;                   // will not print score for now
 }
 
@@ -1554,19 +1698,13 @@ void Alter::Print(const Str &s, const List<Alter> &la) {
     }
 }
 
-// add a node to the path in front, extending its length with one
-void Alter::Add2Front(UInt q) {
-    total.insert(total.begin(), q); // hopelessly inefficient
-}
-
 // add to a max of maxnumbertoadd swap gates for the current path to the given past
 // this past can be a path-local one or the main past
 // after having added them, schedule the result into that past
-void Alter::AddSwaps(Past &past, const Str &mapselectswapsopt) const {
-    // QL_DOUT("Addswaps " << mapselectswapsopt);
-    if (mapselectswapsopt == "one" || mapselectswapsopt == "all") {
+void Alter::AddSwaps(Past &past, Context::MapSelectSwaps mapselectswapsopt) const {
+    if (mapselectswapsopt == Context::MapSelectSwaps::ONE || mapselectswapsopt == Context::MapSelectSwaps::ALL) {
         UInt  numberadded = 0;
-        UInt  maxnumbertoadd = ("one"==mapselectswapsopt ? 1 : MAX_CYCLE);
+        UInt  maxnumbertoadd = (Context::MapSelectSwaps::ONE == mapselectswapsopt ? 1 : MAX_CYCLE);
 
         UInt  fromSourceQ;
         UInt  toSourceQ;
@@ -1588,7 +1726,7 @@ void Alter::AddSwaps(Past &past, const Str &mapselectswapsopt) const {
             numberadded++;
         }
     } else {
-        QL_ASSERT("earliest" == mapselectswapsopt);
+        QL_ASSERT(Context::MapSelectSwaps::EARLIEST == mapselectswapsopt);
         if (fromSource.size() >= 2 && fromTarget.size() >= 2) {
             if (past.IsFirstSwapEarliest(fromSource[0], fromSource[1], fromTarget[0], fromTarget[1])) {
                 past.AddSwap(fromSource[0], fromSource[1]);
@@ -1621,11 +1759,11 @@ void Alter::Extend(const Past &currPast, const Past &basePast) {
     // QL_DOUT("... clone past, add swaps, compute overall score and keep it all in current alternative");
     past = currPast;   // explicitly clone currPast to an alternative-local copy of it, Alter.past
     // QL_DOUT("... adding swaps to alternative-local past ...");
-    AddSwaps(past, "all");
+    AddSwaps(past, Context::MapSelectSwaps::ALL);
     // QL_DOUT("... done adding/scheduling swaps to alternative-local past");
 
-    auto mapperopt = options::get("mapper");
-    if (mapperopt == "maxfidelity") {
+    auto mapperopt = options::context().mapper;
+    if (mapperopt == Context::Mapper::MAXFIDELITY) {
         QL_FATAL("Mapper option maxfidelity has been disabled");
         // score = quick_fidelity(past.lg);
     } else {
@@ -1695,9 +1833,10 @@ void Alter::Split(const Grid &grid, List<Alter> &resla) const {
 }
 
 // just program wide initialization
-void Future::Init(const quantum_platform *p) {
+void Future::Init(const quantum_platform *p, std::mutex *sm) {
     // QL_DOUT("Future::Init ...");
     platformp = p;
+    schedmutexp = sm;
     // QL_DOUT("Future::Init [DONE]");
 }
 
@@ -1707,23 +1846,19 @@ void Future::Init(const quantum_platform *p) {
 void Future::SetCircuit(quantum_kernel &kernel, Scheduler &sched, UInt nq, UInt nc, UInt nb) {
     QL_DOUT("Future::SetCircuit ...");
     schedp = &sched;
-    Str maplookaheadopt = options::get("maplookahead");
-    if (maplookaheadopt == "no") {
+    auto maplookaheadopt = options::context().maplookahead;
+    if (maplookaheadopt == Context::MapLookahead::NO) {
         input_gatepv = kernel.c;                                // copy to free original circuit to allow outputing to
         input_gatepp = input_gatepv.begin();                    // iterator set to start of input circuit copy
     } else {
         schedp->init(kernel.c, *platformp, nq, nc, nb);         // fills schedp->graph (dependence graph) from all of circuit
         // and so also the original circuit can be output to after this
-        for (auto &gp : kernel.c) {
-            scheduled.set(gp) = false;   // none were scheduled
-        }
-        scheduled.set(schedp->instruction[schedp->s]) = false;      // also the dummy nodes not
-        scheduled.set(schedp->instruction[schedp->t]) = false;
-        avlist.clear();
-        avlist.push_back(schedp->s);
+        scheduled.assign(schedp->node_gate.size(), false);   // none were scheduled, also the dummy nodes not
         schedp->set_remaining(forward_scheduling);          // to know criticality
+        avlist.clear();
+        avlist.insert(schedp->source_id, schedp->criticality[schedp->source_id]);
 
-        if (options::get("print_dot_graphs") == "yes") {
+        if (options::context().print_dot_graphs) {
             Str map_dot;
             StrStrm fname;
 
@@ -1742,8 +1877,8 @@ void Future::SetCircuit(quantum_kernel &kernel, Scheduler &sched, UInt nq, UInt
 // Return whether some non-quantum gate was found
 Bool Future::GetNonQuantumGates(List<gate*> &nonqlg) const {
     nonqlg.clear();
-    Str maplookaheadopt = options::get("maplookahead");
-    if (maplookaheadopt == "no") {
+    auto maplookaheadopt = options::context().maplookahead;
+    if (maplookaheadopt == Context::MapLookahead::NO) {
         gate* gp = *input_gatepp;
         if (circuit::const_iterator(input_gatepp) != input_gatepv.end()) {
             if (
@@ -1755,7 +1890,7 @@ Bool Future::GetNonQuantumGates(List<gate*> &nonqlg) const {
         }
     } else {
         for (auto n : avlist) {
-            gate*  gp = schedp->instruction[n];
+            gate*  gp = schedp->node_gate[n];
             if (
                 gp->type() == __classical_gate__
                 || gp->type() == __dummy_gate__
@@ -1771,8 +1906,8 @@ Bool Future::GetNonQuantumGates(List<gate*> &nonqlg) const {
 // Return whether some gate was found
 Bool Future::GetGates(List<gate*> &qlg) const {
     qlg.clear();
-    Str maplookaheadopt = options::get("maplookahead");
-    if (maplookaheadopt == "no") {
+    auto maplookaheadopt = options::context().maplookahead;
+    if (maplookaheadopt == Context::MapLookahead::NO) {
         if (input_gatepp != input_gatepv.end()) {
             gate *gp = *input_gatepp;
             if (gp->operands.size() > 2) {
@@ -1782,7 +1917,7 @@ Bool Future::GetGates(List<gate*> &qlg) const {
         }
     } else {
         for (auto n : avlist) {
-            gate *gp = schedp->instruction[n];
+            gate *gp = schedp->node_gate[n];
             if (gp->operands.size() > 2) {
                 QL_FATAL(" gate: " << gp->qasm() << " has more than 2 operand qubits; please decompose such gates first before mapping.");
             }
@@ -1795,22 +1930,38 @@ Bool Future::GetGates(List<gate*> &qlg) const {
 // Indicate that a gate currently in avlist has been mapped, can be taken out of the avlist
 // and its successors can be made available
 void Future::DoneGate(gate *gp) {
-    Str maplookaheadopt = options::get("maplookahead");
-    if (maplookaheadopt == "no") {
+    auto maplookaheadopt = options::context().maplookahead;
+    if (maplookaheadopt == Context::MapLookahead::NO) {
         input_gatepp = std::next(input_gatepp);
     } else {
-        schedp->TakeAvailable(schedp->node.at(gp), avlist, scheduled, forward_scheduling);
+        std::lock_guard<std::mutex> lock(*schedmutexp);
+        schedp->TakeAvailable(AvailableNode(gp), avlist, scheduled, forward_scheduling);
+    }
+}
+
+// Return the node in avlist of gate gp;
+// the gates handled by the mapper are those that GetGates and GetNonQuantumGates got from avlist
+UInt Future::AvailableNode(gate *gp) const {
+    for (auto n : avlist) {
+        if (schedp->node_gate[n] == gp) {
+            return n;
+        }
     }
+    QL_FATAL("gate " << gp->qasm() << " is not available for mapping");
 }
 
 // Return gp in lag that is most critical (provided lookahead is enabled)
 // This is used in tiebreak, when every other option has failed to make a distinction.
 gate *Future::MostCriticalIn(List<gate*> &lag) const {
-    Str maplookaheadopt = options::get("maplookahead");
-    if (maplookaheadopt == "no") {
+    auto maplookaheadopt = options::context().maplookahead;
+    if (maplookaheadopt == Context::MapLookahead::NO) {
         return lag.front();
     } else {
-        return schedp->find_mostcritical(lag);
+        List<UInt> lan;
+        for (auto gp : lag) {
+            lan.push_back(AvailableNode(gp));
+        }
+        return schedp->find_mostcritical(lan);
     }
 }
 
@@ -1891,7 +2042,7 @@ private:
     const quantum_platform   *platformp;  // platform
     UInt                      nlocs;      // number of locations, real qubits; index variables k and l
     UInt                      nvq;        // same range as nlocs; when not, take set from config and create v2i earlier
-    Grid                     *gridp;      // current grid with Distance function
+    const Grid               *gridp;      // current grid with Distance function
 
                                           // remaining attributes are computed per circuit
     UInt                      nfac;       // number of facilities, actually used virtual qubits; index variables i and j
@@ -1911,7 +2062,7 @@ public:
     }
 
     // kernel-once initialization
-    void Init(Grid *g, const quantum_platform *p) {
+    void Init(const Grid *g, const quantum_platform *p) {
         // QL_DOUT("InitialPlace Init ...");
         platformp = p;
         nlocs = p->qubit_number;
@@ -2402,87 +2553,18 @@ public:
 // budget is the maximum number of hops allowed in the path from src and is at least distance to tgt;
 // it can be higher when not all hops qualify for doing a two-qubit gate or to find more than just the shortest paths.
 void Mapper::GenShortestPaths(gate *gp, UInt src, UInt tgt, UInt budget, List<Alter> &resla, whichpaths_t which) {
-    List<Alter> genla;    // list that will get the result of a recursive Gen call
-
     QL_DOUT("GenShortestPaths: src=" << src << " tgt=" << tgt << " budget=" << budget << " which=" << which);
     QL_ASSERT(resla.empty());
 
-    if (src == tgt) {
-        // found target
-        // create a virgin Alter and initialize it to become an empty path
-        // add src to this path (so that it becomes a distance 0 path with one qubit, src)
-        // and add the Alter to the result list
+    // create a virgin Alter for each path and initialize it to become that path
+    for (auto &path : gridp->ShortestPaths(src, tgt, budget, which)) {
         Alter a;
-        a.Init(platformp, kernelp, &grid);
+        a.Init(platformp, kernelp, &kernel_mutex, gridp);
         a.targetgp = gp;
-        a.Add2Front(src);
+        a.total = path;
         resla.push_back(a);
-        a.DPRINT("... empty path after adding to result list");
-        Alter::DPRINT("... result list after adding empty path", resla);
-        QL_DOUT("... will return now");
-        return;
     }
-
-    // start looking around at neighbors for serious paths
-    UInt d = grid.Distance(src, tgt);
-    QL_DOUT("GenShortestPaths: distance(src=" << src << ", tgt=" << tgt << ") = " << d);
-    QL_ASSERT(d >= 1);
-
-    // reduce neighbors nbs to those n continuing a path within budget
-    // src=>tgt is distance d, budget>=d is allowed, attempt src->n=>tgt
-    // src->n is one hop, budget from n is one less so distance(n,tgt) <= budget-1 (i.e. distance < budget)
-    // when budget==d, this defaults to distance(n,tgt) <= d-1
-    auto nbl = grid.nbs.get(src);
-    nbl.remove_if([this,budget,tgt](const UInt& n) { return grid.Distance(n,tgt) >= budget; });
-    if (logger::log_level >= logger::LogLevel::LOG_DEBUG) {
-        QL_DOUT("GenShortestPaths: ... after reducing to steps within budget, nbl: ");
-        for (auto dn : nbl) {
-            QL_DOUT("..." << dn << " ");
-        }
-    }
-
-    // rotate neighbor list nbl such that largest difference between angles of adjacent elements is beyond back()
-    // this makes only sense when there is an underlying xy grid; when not, which can only be wp_all_shortest
-    grid.Normalize(src, nbl);
-    // subset to those neighbors that continue in direction(s) we want
-    if (which == wp_left_shortest) {
-        nbl.remove_if( [nbl](const UInt& n) { return n != nbl.front(); } );
-    } else if (which == wp_right_shortest) {
-        nbl.remove_if( [nbl](const UInt& n) { return n != nbl.back(); } );
-    } else if (which == wp_leftright_shortest) {
-        nbl.remove_if( [nbl](const UInt& n) { return n != nbl.front() && n != nbl.back(); } );
-    }
-
-    if (logger::log_level >= logger::LogLevel::LOG_DEBUG) {
-        QL_DOUT("GenShortestPaths: ... after normalizing, before iterating, nbl: ");
-        for (auto dn : nbl) {
-            QL_DOUT("..." << dn << " ");
-        }
-    }
-
-    // for all resulting neighbors, find all continuations of a shortest path
-    for (auto &n : nbl) {
-        whichpaths_t newwhich = which;
-        // but for each neighbor only look in desired direction, if any
-        if (which == wp_leftright_shortest && nbl.size() != 1) {
-            // when looking both left and right still, and there is a choice now, split into left and right
-            if (n == nbl.front()) {
-                newwhich = wp_left_shortest;
-            } else {
-                newwhich = wp_right_shortest;
-            }
-        }
-        GenShortestPaths(gp, n, tgt, budget-1, genla, newwhich);  // get list of possible paths in budget-1 from n to tgt in genla
-        resla.splice(resla.end(), genla);           // moves all of genla to resla; makes genla empty
-    }
-    // resla contains all paths starting from a neighbor of src, to tgt
-
-    // add src to front of all to-be-returned paths from src's neighbors to tgt
-    for (auto &a : resla) {
-        QL_DOUT("... GenShortestPaths, about to add src=" << src << " in front of path");
-        a.Add2Front(src);
-    }
-    QL_DOUT("... GenShortestPaths: returning from call of: " << "src=" << src << " tgt=" << tgt << " budget=" << budget << " which=" << which);
+    Alter::DPRINT("... GenShortestPaths: result list", resla);
 }
 
 // Generate shortest paths in the grid for making gate gp NN, from qubit src to qubit tgt, with an alternative for each one
@@ -2498,19 +2580,16 @@ void Mapper::GenShortestPaths(gate *gp, UInt src, UInt tgt, UInt budget, List<Al
 void Mapper::GenShortestPaths(gate *gp, UInt src, UInt tgt, List<Alter> &resla) {
     List<Alter> directla;  // list that will hold all not-yet-split Alters directly from src to tgt
 
-    UInt budget = grid.MinHops(src, tgt);
-    Str mappathselectopt = options::get("mappathselect");
-    if (mappathselectopt == "all") {
+    UInt budget = gridp->MinHops(src, tgt);
+    if (options::context().mappathselect == Context::MapPathSelect::ALL) {
         GenShortestPaths(gp, src, tgt, budget, directla, wp_all_shortest);
-    } else if (mappathselectopt == "borders") {
-        GenShortestPaths(gp, src, tgt, budget, directla, wp_leftright_shortest);
     } else {
-        QL_FATAL("Unknown value of mapppathselect option " << mappathselectopt);
+        GenShortestPaths(gp, src, tgt, budget, directla, wp_leftright_shortest);
     }
 
     // QL_DOUT("about to split the paths");
     for (auto &a : directla) {
-        a.Split(grid, resla);
+        a.Split(*gridp, resla);
     }
     // Alter::DPRINT("... after generating and splitting the paths", resla);
 }
@@ -2522,7 +2601,7 @@ void Mapper::GenAltersGate(gate *gp, List<Alter> &la, Past &past) {
     QL_ASSERT (q.size() == 2);
     UInt  src = past.MapQubit(q[0]);  // interpret virtual operands in past's current map
     UInt  tgt = past.MapQubit(q[1]);
-    QL_DOUT("GenAltersGate: " << gp->qasm() << " in real (q" << src << ",q" << tgt << ") at MinHops=" << grid.MinHops(src, tgt));
+    QL_DOUT("GenAltersGate: " << gp->qasm() << " in real (q" << src << ",q" << tgt << ") at MinHops=" << gridp->MinHops(src, tgt));
     past.DFcPrint();
 
     GenShortestPaths(gp, src, tgt, la);// find shortest paths from src to tgt, and split these
@@ -2534,8 +2613,8 @@ void Mapper::GenAltersGate(gate *gp, List<Alter> &la, Past &past) {
 // and return the found variations by appending them to the given list of Alters, la
 // Depending on maplookahead only take first (most critical) gate or take all gates.
 void Mapper::GenAlters(List<gate*> lg, List<Alter> &la, Past &past) {
-    Str maplookaheadopt = options::get("maplookahead");
-    if (maplookaheadopt == "all") {
+    auto maplookaheadopt = options::context().maplookahead;
+    if (maplookaheadopt == Context::MapLookahead::ALL) {
         // create alternatives for each gate in lg
         QL_DOUT("GenAlters, " << lg.size() << " 2q gates; create an alternative for each");
         for (auto gp : lg) {
@@ -2551,25 +2630,25 @@ void Mapper::GenAlters(List<gate*> lg, List<Alter> &la, Past &past) {
     }
 }
 
-// start the random generator with a seed
+// a seed for the random generator
 // that is unique to the microsecond
-void Mapper::RandomInit() {
+UInt Mapper::RandomSeed() {
     auto ts = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-    // QL_DOUT("Seeding random generator with " << ts );
-    gen.seed(ts);
+    return ts;
 }
 
 // if the maptiebreak option indicates so,
 // generate a random Int number in range 0..count-1 and use
 // that to index in list of alternatives and to return that one,
-// otherwise return a fixed one (front, back or first most critical one
-Alter Mapper::ChooseAlter(List<Alter> &la, Future &future) {
+// otherwise return a fixed one (front, back or first most critical one;
+// random draws are made from altgen
+Alter Mapper::ChooseAlter(List<Alter> &la, Future &future, std::mt19937 &altgen) {
     if (la.size() == 1) {
         return la.front();
     }
 
-    Str maptiebreakopt = options::get("maptiebreak");
-    if (maptiebreakopt == "critical") {
+    auto maptiebreakopt = options::context().maptiebreak;
+    if (maptiebreakopt == Context::MapTieBreak::CRITICAL) {
         List<gate*> lag;
         for (auto &a : la) {
             lag.push_back(a.targetgp);
@@ -2585,10 +2664,10 @@ Alter Mapper::ChooseAlter(List<Alter> &la, Future &future) {
         return la.front();
     }
 
-    if (maptiebreakopt == "random") {
+    if (maptiebreakopt == Context::MapTieBreak::RANDOM) {
         Alter res;
         std::uniform_int_distribution<> dis(0, (la.size()-1));
-        UInt choice = dis(gen);
+        UInt choice = dis(altgen);
         UInt i = 0;
         for (auto &a : la) {
             if (i == choice) {
@@ -2601,12 +2680,12 @@ Alter Mapper::ChooseAlter(List<Alter> &la, Future &future) {
         return res;
     }
 
-    if (maptiebreakopt == "last") {
+    if (maptiebreakopt == Context::MapTieBreak::LAST) {
         // QL_DOUT(" ... took last " << " from 0.." << (la.size()-1));
         return la.back();
     }
 
-    if (maptiebreakopt == "first") {
+    if (maptiebreakopt == Context::MapTieBreak::FIRST) {
         // QL_DOUT(" ... took first " << " from 0.." << (la.size()-1));
         return la.front();
     }
@@ -2638,12 +2717,11 @@ void Mapper::CommitAlter(Alter &resa, Future &future, Past &past) {
     gate *resgp = resa.targetgp;   // and the 2q target gate then in resgp
     resa.DPRINT("... CommitAlter, alternative to commit, will add swaps and then map target 2q gate");
 
-    Str mapselectswapsopt = options::get("mapselectswaps");
-    resa.AddSwaps(past, mapselectswapsopt);
+    resa.AddSwaps(past, options::context().mapselectswaps);
 
     // when only some swaps were added, the resgp might not yet be NN, so recheck
     auto &q = resgp->operands;
-    if (grid.MinHops(past.MapQubit(q[0]), past.MapQubit(q[1])) == 1) {
+    if (gridp->MinHops(past.MapQubit(q[0]), past.MapQubit(q[1])) == 1) {
         // resgp is NN: so done with this 2q gate
         // QL_DOUT("... CommitAlter, target 2q is NN, map it and done: " << resgp->qasm());
         MapRoutedGate(resgp, past);     // the 2q target gate is NN now and thus can be mapped
@@ -2726,7 +2804,7 @@ Bool Mapper::MapMappableGates(Future &future, Past &past, List<gate*> &lg, Bool
                 auto &q = gp->operands;
                 UInt  src = past.MapQubit(q[0]);      // interpret virtual operands in current map
                 UInt  tgt = past.MapQubit(q[1]);
-                UInt  d = grid.MinHops(src, tgt);    // and find minimum number of hops between real counterparts
+                UInt  d = gridp->MinHops(src, tgt);    // and find minimum number of hops between real counterparts
                 if (d == 1) {
                     QL_DOUT("MapMappableGates, NN no routing: " << gp->qasm() << " in real (q" << src << ",q" << tgt << ")");
                     MapRoutedGate(gp, past);
@@ -2760,15 +2838,38 @@ Bool Mapper::MapMappableGates(Future &future, Past &past, List<gate*> &lg, Bool
     }
 }
 
+// call f on each alternative in la with its index in la, in parallel on the threads of pool when it is available
+void Mapper::ForEachAlter(List<Alter> &la, const std::function<void(Alter &, UInt)> &f) {
+    if (poolp == NULL || la.size() <= 1) {
+        UInt i = 0;
+        for (auto &a : la) {
+            f(a, i++);
+        }
+        return;
+    }
+    Vec<Alter*> lap;
+    for (auto &a : la) {
+        lap.push_back(&a);
+    }
+    auto context = options::active_context();
+    poolp->for_each(lap.size(), [&](UInt i) {
+        options::Scope scope(context);
+        f(*lap[i], i);
+    });
+}
+
 // select Alter determined by strategy defined by mapper options
 // - if base[rc], select from whole list of Alters, of which all 'remain'
 // - if minextend[rc], select Alter from list of Alters with minimal cycle extension of given past
 //   when several remain with equal minimum extension, recurse to reduce this set of remaining ones
 //   - level: level of recursion at which SelectAlter is called: 0 is base, 1 is 1st, etc.
 //   - option mapselectmaxlevel: max level of recursion to use, where inf indicates no maximum
-// - maptiebreak option indicates which one to take when several (still) remain
+// - maptiebreak option indicates which one to take when several (still) remain;
+//   random draws are made from altgen, and the recursion for each alternative draws from
+//   its own generator, seeded from altgen in the order of the alternatives,
+//   so that the result doesn't depend on the number of threads evaluating them
 // result is returned in resa
-void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &past, Past &basePast, Int level) {
+void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &past, Past &basePast, Int level, std::mt19937 &altgen) {
     // la are all alternatives we enter with
     QL_ASSERT(!la.empty());  // so there is always a result Alter
 
@@ -2776,22 +2877,22 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
     List<Alter> bla;       // best alternative subset of gla, suitable to choose result from
 
     QL_DOUT("SelectAlter ENTRY level=" << level << " from " << la.size() << " alternatives");
-    auto mapperopt = options::get("mapper");
-    if (mapperopt == "base" || mapperopt == "baserc") {
+    auto mapperopt = options::context().mapper;
+    if (mapperopt == Context::Mapper::BASE || mapperopt == Context::Mapper::BASERC) {
         Alter::DPRINT("... SelectAlter base (equally good/best) alternatives:", la);
-        resa = ChooseAlter(la, future);
+        resa = ChooseAlter(la, future, altgen);
         resa.DPRINT("... the selected Alter is");
         // QL_DOUT("SelectAlter DONE level=" << level << " from " << la.size() << " alternatives");
         return;
     }
-    QL_ASSERT(mapperopt == "minextend" || mapperopt == "minextendrc" || mapperopt == "maxfidelity");
+    QL_ASSERT(mapperopt == Context::Mapper::MINEXTEND || mapperopt == Context::Mapper::MINEXTENDRC || mapperopt == Context::Mapper::MAXFIDELITY);
 
     // Compute a.score of each alternative relative to basePast, and sort la on it, minimum first
-    for (auto &a : la) {
+    ForEachAlter(la, [&](Alter &a, UInt) {
         a.DPRINT("Considering extension by alternative: ...");
         a.Extend(past, basePast);           // locally here, past will be cloned and kept in alter
         // and the extension stored into the a.score
-    }
+    });
     la.sort([this](const Alter &a1, const Alter &a2) { return a1.score < a2.score; });
     Alter::DPRINT("... SelectAlter sorted all entry alternatives after extension:", la);
 
@@ -2804,16 +2905,16 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
     gla.remove_if([this,la](const Alter& a) { return a.score != la.front().score; });
     UInt las = la.size();
     UInt glas = gla.size();
-    auto mapselectmaxwidthopt = options::get("mapselectmaxwidth");
-    if ("min" != mapselectmaxwidthopt) {
+    auto mapselectmaxwidthopt = options::context().mapselectmaxwidth;
+    if (mapselectmaxwidthopt != Context::MapSelectMaxWidth::MIN) {
         UInt keep = 1;
-        if (mapselectmaxwidthopt == "minplusone") {
+        if (mapselectmaxwidthopt == Context::MapSelectMaxWidth::MINPLUSONE) {
             keep = glas+1;
-        } else if (mapselectmaxwidthopt == "minplushalfmin") {
+        } else if (mapselectmaxwidthopt == Context::MapSelectMaxWidth::MINPLUSHALFMIN) {
             keep = glas+glas/2;
-        } else if (mapselectmaxwidthopt == "minplusmin") {
+        } else if (mapselectmaxwidthopt == Context::MapSelectMaxWidth::MINPLUSMIN) {
             keep = glas*2;
-        } else if (mapselectmaxwidthopt == "all") {
+        } else if (mapselectmaxwidthopt == Context::MapSelectMaxWidth::ALL) {
             keep = las;
         } if (keep < las) {
             gla = la;
@@ -2830,8 +2931,7 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
 
     // Prepare for recursion;
     // option mapselectmaxlevel indicates the maximum level of recursion (0 is no recursion)
-    auto mapselectmaxlevelstring = options::get("mapselectmaxlevel");
-    Int mapselectmaxlevel = (mapselectmaxlevelstring == "inf") ? MAX_CYCLE : parse_int(mapselectmaxlevelstring);
+    Int mapselectmaxlevel = options::context().mapselectmaxlevel;
 
     // When maxlevel has been reached, stop the recursion, and choose from the best minextend/maxfidelity alternatives
     if (level >= mapselectmaxlevel) {
@@ -2840,7 +2940,7 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
         bla = gla;
         bla.remove_if([this,gla](const Alter& a) { return a.score != gla.front().score; });
         Alter::DPRINT("... SelectAlter reduced to best alternatives to choose result from:", bla);
-        resa = ChooseAlter(bla, future);
+        resa = ChooseAlter(bla, future, altgen);
         resa.DPRINT("... the selected Alter (STOPPING RECURSION) is");
         // QL_DOUT("SelectAlter DONE level=" << level << " from " << bla.size() << " best alternatives");
         return;
@@ -2866,7 +2966,11 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
     // This means that recursion always goes to maxlevel or end-of-circuit.
     // This anomaly may need correction.
     // QL_DOUT("... SelectAlter level=" << level << " entering recursion with " << gla.size() << " good alternatives");
-    for (auto &a : gla) {
+    Vec<UInt> seeds;                    // seed of the random generator of the recursion for each alternative
+    for (UInt i = 0; i < gla.size(); i++) {
+        seeds.push_back(altgen());
+    }
+    ForEachAlter(gla, [&](Alter &a, UInt i) {
         a.DPRINT("... ... considering alternative:");
         Future future_copy = future;            // copy!
         Past   past_copy = past;                // copy!
@@ -2875,8 +2979,8 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
 
         Bool    havegates;                  // are there still non-NN 2q gates to map?
         List<gate*> lg;            // list of non-NN 2q gates taken from avlist, as returned from MapMappableGates
-        Str maplookaheadopt = options::get("maplookahead");
-        Str maprecNN2qopt = options::get("maprecNN2q");
+        auto maplookaheadopt = options::context().maplookahead;
+        Bool maprecNN2qopt = options::context().maprecNN2q;
         // In recursion, look at option maprecNN2q:
         // - MapMappableGates with alsoNN2q==true is greedy and immediately maps each 1q and NN 2q gate
         // - MapMappableGates with alsoNN2q==false is not greedy, maps all 1q gates but not the (NN) 2q gates
@@ -2886,7 +2990,7 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
         // This creates more clear recursion: one 2q at a time instead of a possible empty set of NN2qs followed by a nonNN2q;
         // also when a NN2q is found, this is perfect; this is not seen when immediately mapping all NN2qs.
         // So goal is to prove that maprecNN2q should be no at this place, in the recursion step, but not at level 0!
-        Bool alsoNN2q = (maprecNN2qopt == "yes") && (maplookaheadopt == "noroutingfirst" || maplookaheadopt == "all");
+        Bool alsoNN2q = maprecNN2qopt && (maplookaheadopt == Context::MapLookahead::NOROUTINGFIRST || maplookaheadopt == Context::MapLookahead::ALL);
         havegates = MapMappableGates(future_copy, past_copy, lg, alsoNN2q); // map all easy gates; remainder returned in lg
 
         if (havegates) {
@@ -2895,14 +2999,15 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
             GenAlters(lg, la, past_copy);       // gen all possible variations to make gates in lg NN, in current past.v2r mapping
             QL_DOUT("... ... SelectAlter level=" << level << ", generated for these 2q gates " << la.size() << " alternatives; RECURSE ... ");
             Alter resa;                         // result alternative selected and returned by next SelectAlter call
-            SelectAlter(la, resa, future_copy, past_copy, basePast, level+1); // recurse, best in resa ...
+            std::mt19937 recgen(seeds[i]);      // random generator of the recursion for this alternative
+            SelectAlter(la, resa, future_copy, past_copy, basePast, level+1, recgen); // recurse, best in resa ...
             resa.DPRINT("... ... SelectAlter, generated for these 2q gates ... ; RECURSE DONE; resulting alternative ");
             a.score = resa.score;               // extension of deep recursion is treated as extension at current level,
             // by this an alternative started bad may be compensated by deeper alts
         } else {
             QL_DOUT("... ... SelectAlter level=" << level << ", no gates to evaluate next; RECURSION BOTTOM");
-            auto mapperopt = options::get("mapper");
-            if (mapperopt == "maxfidelity") {
+            auto mapperopt = options::context().mapper;
+            if (mapperopt == Context::Mapper::MAXFIDELITY) {
                 QL_FATAL("Mapper option maxfidelity has been disabled");
                 // a.score = quick_fidelity(past_copy.lg);
             } else {
@@ -2911,7 +3016,7 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
             a.DPRINT("... ... SelectAlter, after committing this alternative, mapped easy gates, no gates to evaluate next; RECURSION BOTTOM");
         }
         a.DPRINT("... ... DONE considering alternative:");
-    }
+    });
     // Sort list of good alternatives (gla) on score resulting after recursion
     gla.sort([this](const Alter &a1, const Alter &a2) { return a1.score < a2.score; });
     Alter::DPRINT("... SelectAlter sorted alternatives after recursion:", gla);
@@ -2921,7 +3026,7 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
     bla = gla;
     bla.remove_if([this,gla](const Alter& a) { return a.score != gla.front().score; });
     Alter::DPRINT("... SelectAlter equally best alternatives on return of RECURSION:", bla);
-    resa = ChooseAlter(bla, future);
+    resa = ChooseAlter(bla, future, altgen);
     resa.DPRINT("... the selected Alter is");
     // QL_DOUT("... SelectAlter level=" << level << " selecting from " << bla.size() << " equally good alternatives above DONE");
     QL_DOUT("SelectAlter DONE level=" << level << " from " << la.size() << " alternatives");
@@ -2934,8 +3039,8 @@ void Mapper::SelectAlter(List<Alter> &la, Alter &resa, Future &future, Past &pas
 // and past is the last past (top of recursion stack) relative to which the mapping is done.
 void Mapper::MapGates(Future &future, Past &past, Past &basePast) {
     List<gate*> lg;              // list of non-mappable gates taken from avlist, as returned from MapMappableGates
-    Str maplookaheadopt = options::get("maplookahead");
-    Bool alsoNN2q = (maplookaheadopt == "noroutingfirst" || maplookaheadopt == "all");
+    auto maplookaheadopt = options::context().maplookahead;
+    Bool alsoNN2q = (maplookaheadopt == Context::MapLookahead::NOROUTINGFIRST || maplookaheadopt == Context::MapLookahead::ALL);
     while (MapMappableGates(future, past, lg, alsoNN2q)) { // returns false when no gates remain
         // all gates in lg are two-qubit quantum gates that cannot be mapped
         // select which one(s) to (partially) route, according to one of the known strategies
@@ -2947,7 +3052,7 @@ void Mapper::MapGates(Future &future, Past &past, Past &basePast) {
 
         // select best one
         Alter resa;
-        SelectAlter(la, resa, future, past, basePast, 0);
+        SelectAlter(la, resa, future, past, basePast, 0, gen);
         // select one according to strategy specified by options; result in resa
 
         // commit to best one
@@ -2962,12 +3067,12 @@ void Mapper::MapCircuit(quantum_kernel &kernel, Virt2Real &v2r) {
     Past    mainPast;       // past window, contains output schedule, storing all gates until taken out
     Scheduler sched;        // new scheduler instance (from src/scheduler.h) used for its dependence graph
 
-    future.Init(platformp);
+    future.Init(platformp, &sched_mutex);
     future.SetCircuit(kernel, sched, nq, nc, nb); // constructs depgraph, initializes avlist, ready for producing gates
     kernel.c.clear();       // future has copied kernel.c to private data; kernel.c ready for use by new_gate
     kernelp = &kernel;      // keep kernel to call kernelp->gate() inside Past.new_gate(), to create new gates
 
-    mainPast.Init(platformp, kernelp, &grid);  // mainPast and Past clones inside Alters ready for generating output schedules into
+    mainPast.Init(platformp, kernelp, &kernel_mutex, gridp);  // mainPast and Past clones inside Alters ready for generating output schedules into
     mainPast.ImportV2r(v2r);    // give it the current mapping/state
     // mainPast.DPRINT("start mapping");
 
@@ -2994,7 +3099,7 @@ void Mapper::MakePrimitives(quantum_kernel &kernel) {
     kernel.c.clear();                           // kernel.c ready for use by new_gate
 
     Past            mainPast;                   // output window in which gates are scheduled
-    mainPast.Init(platformp, kernelp, &grid);
+    mainPast.Init(platformp, kernelp, &kernel_mutex, gridp);
 
     for (auto & gp : input_gatepv) {
         circuit tmpCirc;
@@ -3043,7 +3148,7 @@ void Mapper::Map(quantum_kernel& kernel) {
         ipr_t           ipok;           // one of several ip result possibilities
         Real          iptimetaken;      // time solving the initial placement took, in seconds
 
-        ip.Init(&grid, platformp);
+        ip.Init(gridp, platformp);
         ip.Place(kernel.c, v2r, ipok, iptimetaken, initialplaceopt); // compute mapping (in v2r) using ip model, may fail
         QL_DOUT("InitialPlace: kernel=" << kernel.name << " initialplace=" << initialplaceopt << " initialplace2qhorizon=" << initialplace2qhorizonopt << " result=" << ip.ipr2string(ipok) << " iptimetaken=" << iptimetaken << " seconds [DONE]");
 #else // ifdef INITIALPLACE
@@ -3070,22 +3175,30 @@ void Mapper::Map(quantum_kernel& kernel) {
     QL_DOUT("Mapping kernel " << kernel.name << " [DONE]");
 }
 
-// initialize mapper for whole program
-// lots could be split off for the whole program, once that is needed
+// number of threads to evaluate alternatives with, following option mapselectthreads;
+// also with random tiebreak, since each alternative's recursion draws from its own generator (see SelectAlter)
+UInt Mapper::SelectThreads() {
+    auto mapselectthreadsopt = options::get("mapselectthreads");
+    return (mapselectthreadsopt == "max") ? ThreadPool::hardware_threads() : parse_uint(mapselectthreadsopt);
+}
+
+// initialize mapper for a kernel of the program
+// with what is shared by the mappers of all kernels of the program
 //
 // initialization for a particular kernel is separate (in Map entry)
-void Mapper::Init(const quantum_platform *p) {
+void Mapper::Init(const quantum_platform *p, const Grid *g, ThreadPool *selectpool, UInt seed) {
     // QL_DOUT("Mapping initialization ...");
-    // QL_DOUT("... Grid initialization: platform qubits->coordinates, ->neighbors, distance ...");
     platformp = p;
     nq = p->qubit_number;
     // nc = p->creg_number;  // nc should come from platform, but doesn't; is taken from kernel in Map
     // nb = p->breg_number;  // nb should come from platform, but doesn't; is taken from kernel in Map
-    RandomInit();
+    // QL_DOUT("Seeding random generator with " << seed );
+    gen.seed(seed);
     // QL_DOUT("... platform/real number of qubits=" << nq << ");
     cycle_time = p->cycle_time;
 
-    grid.Init(platformp);
+    gridp = g;
+    poolp = selectpool;
 
     // QL_DOUT("Mapping initialization [DONE]");
 }
@@ -8,16 +8,21 @@
 #include <chrono>
 #include <ctime>
 #include <ratio>
+#include <functional>
+#include <mutex>
 #include "utils/map.h"
 #include "utils/vec.h"
 #include "utils/list.h"
 #include "utils/str.h"
 #include "utils/num.h"
+#include "utils/ptr.h"
+#include "utils/thread_pool.h"
 #include "platform.h"
 #include "kernel.h"
 #include "resource_manager.h"
 #include "gate.h"
 #include "scheduler.h"
+#include "options.h"
 //#include "metrics.h"
 
 namespace ql {
@@ -58,11 +63,13 @@ namespace mapper {
 // Grid public members (apart from nq):
 //  form:               how relation between neighbors is specified
 //  Distance(qi,qj):    distance in physical connection hops from real qubit qi to real qubit qj;
-//                      - computing it relies on nbs (and Floyd-Warshall) (gf_xy and gf_irregular)
+//                      - computing it relies on nbs (and breadth-first search) (gf_xy and gf_irregular)
 //  nbs[qi]:            list of neighbor real qubits of real qubit qi
 //                      - nbs can be derived from topology.edges (gf_xy and gf_irregular)
 //  Normalize(qi, neighborlist):    rotate neighborlist such that largest angle diff around qi is behind last element
 //                      relies on nbs, and x[i]/y[i] (gf_xy only)
+//  ShortestPaths(qi, qj, budget, which):   all paths from real qubit qi to real qubit qj within budget hops;
+//                      relies on Distance, nbs and Normalize; memoized
 //
 // For an irregular grid form, only nq and edges (so nbs) need to be specified; distance is computed from nbs:
 // - there is no underlying rectangular grid, so there are no defined x and y coordinates of qubits;
@@ -95,6 +102,14 @@ typedef enum GridForms {
     gf_irregular    // nodes have explicit neighbor definitions, qubits don't have x/y coordinates
 } gridform_t;
 
+// Which paths to generate between two qubits; see Grid::ShortestPaths
+typedef enum WhichPaths {
+    wp_all_shortest,            // all shortest paths
+    wp_left_shortest,           // only the shortest along the left side of the rectangle of src and tgt
+    wp_right_shortest,          // only the shortest along the right side of the rectangle of src and tgt
+    wp_leftright_shortest       // both the left and right shortest
+} whichpaths_t;
+
 class Grid {
 public:
     const quantum_platform *platformp;    // current platform: topology
@@ -111,7 +126,9 @@ public:
     utils::Map<utils::UInt,neighbors_t> nbs;       // nbs[i] is list of neighbor qubits of qubit i
     utils::Map<utils::UInt,utils::Int> x;          // x[i] is x coordinate of qubit i
     utils::Map<utils::UInt,utils::Int> y;          // y[i] is y coordinate of qubit i
-    utils::Vec<utils::Vec<utils::UInt>> dist;      // dist[i][j] is computed distance between qubits i and j;
+    utils::Vec<utils::UInt> dist;                  // dist[i*nq+j] is computed distance between qubits i and j;
+
+    typedef utils::Vec<utils::UInt> path_t;        // path as sequence of qubits, from source to target
 
     // Grid initializer
     // initialize mapper internal grid maps from configuration
@@ -132,7 +149,7 @@ public:
     // formulae for convex (hole free) topologies with underlying grid and with bidirectional edges:
     //      gf_cross:   max( abs( x[to_realqi] - x[from_realqi] ), abs( y[to_realqi] - y[from_realqi] ))
     //      gf_plus:    abs( x[to_realqi] - x[from_realqi] ) + abs( y[to_realqi] - y[from_realqi] )
-    // when the neighbor relation is defined (topology.edges in config file), Floyd-Warshall is used, which currently is always
+    // when the neighbor relation is defined (topology.edges in config file), breadth-first search is used, which currently is always
     utils::UInt Distance(utils::UInt from_realqi, utils::UInt to_realqi) const;
 
     // coredistance between two qubits
@@ -160,9 +177,21 @@ public:
     // and this can only be computed when there is an underlying x/y grid (so not for form==gf_irregular)
     void Normalize(utils::UInt src, neighbors_t &nbl) const;
 
-    // Floyd-Warshall dist[i][j] = shortest distances between all nq qubits i and j
+    // dist[i*nq+j] = shortest distances between all nq qubits i and j, by breadth-first search from each i
     void ComputeDist();
 
+    // next hops from src on the paths to tgt within budget hops, bounded by a particular strategy (which):
+    // the neighbors n of src with Distance(n,tgt) < budget, normalized and reduced to those in the desired direction(s);
+    // memoized, so together these form a table of the DAG of shortest paths that is filled on demand
+    const utils::Vec<utils::UInt> &NextHops(utils::UInt src, utils::UInt tgt, utils::UInt budget, whichpaths_t which) const;
+
+    // all paths from src to tgt within budget hops, bounded by a particular strategy (which),
+    // enumerated by walking the next hops table;
+    // memoized, so each combination of arguments is enumerated only once for all gates of all kernels
+    // whose mappers share this Grid, i.e. those of a program (see the mapper pass);
+    // may be called concurrently
+    const utils::Vec<path_t> &ShortestPaths(utils::UInt src, utils::UInt tgt, utils::UInt budget, whichpaths_t which) const;
+
     void DPRINTGrid() const;
     void PrintGrid() const;
 
@@ -181,6 +210,23 @@ public:
     // sort nbs map; see Normalize and Angle above
     void SortNbs();
 
+private:
+    // memo tables of NextHops and ShortestPaths;
+    // these are filled on demand, also by alternatives and kernels that are mapped in parallel, so this has a mutex;
+    // they only hold what the Grid determines, so a mapping doesn't depend on what was cached before
+    struct PathCache {
+        std::mutex                                  mutex;
+        utils::Map<utils::UInt,utils::Vec<utils::UInt>> nexthops;   // indexed by PathKey
+        utils::Map<utils::UInt,utils::Vec<path_t>>  paths;          // indexed by PathKey
+    };
+    mutable utils::Ptr<PathCache> pathcache;
+
+    // key of the memo tables in pathcache
+    utils::UInt PathKey(utils::UInt src, utils::UInt tgt, utils::UInt budget, whichpaths_t which) const;
+
+    // NextHops with pathcache->mutex locked
+    const utils::Vec<utils::UInt> &NextHopsLocked(utils::UInt src, utils::UInt tgt, utils::UInt budget, whichpaths_t which) const;
+
 };
 
 // =========================================================================================
@@ -310,6 +356,10 @@ public:
 //
 // since gate durations are in nano-seconds, and one cycle is some fixed number of nano-seconds,
 // the duration is converted to a rounded-up number of cycles when computing the added latency
+//
+// a FreeCycle map is copied for each alternative and for each trial schedule;
+// the resource manager in it is shared between copies until one of them reserves a resource (copy-on-write),
+// so that copies that only query availability don't clone the resource manager
 class FreeCycle {
 private:
 
@@ -318,7 +368,7 @@ private:
     utils::UInt              nb;          // bregs are in map (behind qubits) to track dependences around conditions
     utils::UInt              ct;          // multiplication factor from cycles to nano-seconds (unit of duration)
     utils::Vec<utils::UInt>  fcv;         // fcv[real qubit index i]: qubit i is free from this cycle on
-    arch::resource_manager_t rm;          // actual resources occupied by scheduled gates
+    utils::Ptr<arch::resource_manager_t> rm;  // actual resources occupied by scheduled gates, shared until reserve
 
 
     // access free cycle value of qubit q[i] or breg b[i-nq]
@@ -382,6 +432,60 @@ public:
 
 };
 
+// =========================================================================================
+// SharedGateList: list of gates with their start cycles, shared between copies of a Past
+//
+// The gate lists of a Past grow with the circuit, while each alternative that is evaluated
+// is a copy of the main Past that is extended by just a few swaps.
+// So the gate lists are represented as a persistent singly linked list of immutable nodes, newest first:
+// copying the list is a pointer copy and adding a gate creates one node on top of the shared older nodes.
+// A copy of a Past thereby only records its delta relative to the Past it was copied from,
+// and evaluating N alternatives costs O(N*delta) instead of O(N*circuit).
+class SharedGateList {
+public:
+    typedef gate *gate_p;
+
+    // a gate in the list with the start cycle that it was scheduled at in the owning past
+    typedef struct {
+        gate_p      gp;
+        utils::UInt cycle;
+    } entry_t;
+
+private:
+
+    // node of the list; nodes are never modified after creation except when being destroyed
+    class Node {
+    public:
+        entry_t                 entry;  // gate in this node
+        std::shared_ptr<Node>   prev;   // older nodes, shared with the other lists that were copied from this one
+
+        // destructor unlinking the older nodes iteratively,
+        // to avoid a recursion as deep as the list is long
+        ~Node();
+    };
+
+    std::shared_ptr<Node>   head;       // newest node, nullptr when empty
+    utils::UInt             n;          // number of gates in the list
+
+public:
+
+    // constructs an empty list
+    SharedGateList();
+
+    utils::Bool empty() const;
+    utils::UInt size() const;
+
+    // make the list empty; only drops this list's reference to the nodes
+    void clear();
+
+    // add gate gp at the end of the list (i.e. as newest) with start cycle c
+    void push_back(gate_p gp, utils::UInt c = 0);
+
+    // return the entries of the list, oldest first, i.e. in the order they were added
+    utils::Vec<entry_t> entries() const;
+
+};
+
 // =========================================================================================
 // Past: state of the mapper while somewhere in the mapping process
 //
@@ -398,6 +502,9 @@ public:
 // and beyond are mapped and have real qubits as operands.
 // While experimenting with path alternatives, a clone is made of the main past,
 // to insert swaps and evaluate the latency effects; note that inserting swaps changes the mapping.
+// Such a clone is cheap: the gate lists (see SharedGateList) and the resource manager (see FreeCycle)
+// are shared with the main past and only the changes made in the clone are private to it;
+// what is copied (Virt2Real and the FreeCycle vector) is proportional to the number of qubits.
 //
 // On arrival of a quantum gate(s):
 // - [isempty(waitinglg)]
@@ -420,7 +527,8 @@ private:
     utils::UInt                 ct;         // cycle time, multiplier from cycles to nano-seconds
     const quantum_platform      *platformp; // platform describing resources for scheduling
     quantum_kernel              *kernelp;   // current kernel for creating gates
-    Grid                        *gridp;     // pointer to grid to know which hops are inter-core
+    std::mutex                  *kernel_mutexp; // serializes creating gates in kernelp by Pasts of alternatives evaluated in parallel
+    const Grid                  *gridp;     // pointer to grid to know which hops are inter-core
 
     Virt2Real                   v2r;        // state: current Virt2Real map, imported/exported to kernel
     FreeCycle                   fc;         // state: FreeCycle map (including resource_manager) of this Past
@@ -428,16 +536,14 @@ private:
     utils::List<gate_p>         waitinglg;  // . . .  list of q gates in this Past, topological order, waiting to be scheduled in
     //        waitinglg only contains gates from Add and final Schedule call
     //        when evaluating alternatives, it is empty when Past is cloned; so no state
-public:
-    utils::List<gate_p>         lg;         // state: list of q gates in this Past, scheduled by their (start) cycle values
-    //        so this is the result list of this Past, to compare with other Alters
-private:
-    utils::List<gate_p>         outlg;      // . . .  list of gates flushed out of this Past, not yet put in outCirc
-    //        when evaluating alternatives, outlg stays constant; so no state
-    utils::Map<gate_p,utils::UInt> cycle;      // state: gate to cycle map, startCycle value of each past gatecycle[gp]
-    //        cycle[gp] can be different for each gp for each past
+    SharedGateList              lg;         // state: list of q gates in this Past in order of scheduling, with their (start) cycle values
+    //        the startCycle value of each gate is private to this past,
+    //        i.e. it can be different for each gp for each past;
     //        gp->cycle is not used by MapGates
-    //        although updated by set_cycle called from MakeAvailable/TakeAvailable
+    //        although updated by set_cycle called from MakeAvailable/TakeAvailable;
+    //        FlushAll puts the gates out in cycle order
+    SharedGateList              outlg;      // . . .  list of gates flushed out of this Past, not yet put in outCirc
+    //        when evaluating alternatives, outlg stays constant; so no state
     utils::UInt                  nswapsadded;// number of swaps (including moves) added to this past
     utils::UInt                  nmovesadded;// number of moves added to this past
 
@@ -448,7 +554,7 @@ public:
     Past();
 
     // past initializer
-    void Init(const quantum_platform *p, quantum_kernel *k, Grid *g);
+    void Init(const quantum_platform *p, quantum_kernel *k, std::mutex *km, const Grid *g);
 
     // import Past's v2r from v2r_value
     void ImportV2r(const Virt2Real &v2r_value);
@@ -621,7 +727,8 @@ class Alter {
 public:
     const quantum_platform  *platformp;  // descriptions of resources for scheduling
     quantum_kernel          *kernelp;    // kernel pointer to allow calling kernel private methods
-    Grid                    *gridp;      // grid pointer to know which hops are inter-core
+    std::mutex              *kernel_mutexp; // serializes creating gates in kernelp, see Past
+    const Grid              *gridp;      // grid pointer to know which hops are inter-core
     utils::UInt             nq;          // width of Past and Virt2Real map is number of real qubits
     utils::UInt             ct;          // cycle time, multiplier from cycles to nano-seconds
 
@@ -640,7 +747,7 @@ public:
 
     // Alter initializer
     // This should only be called after a virgin construction and not after cloning a path.
-    void Init(const quantum_platform *p, quantum_kernel *k, Grid *g);
+    void Init(const quantum_platform *p, quantum_kernel *k, std::mutex *km, const Grid *g);
 
     // printing facilities of Paths
     // print path as hd followed by [0->1->2]
@@ -656,13 +763,10 @@ public:
     static void DPRINT(const utils::Str &s, const utils::List<Alter> &la);
     static void Print(const utils::Str &s, const utils::List<Alter> &la);
 
-    // add a node to the path in front, extending its length with one
-    void Add2Front(utils::UInt q);
-
     // add to a max of maxnumbertoadd swap gates for the current path to the given past
     // this past can be a path-local one or the main past
     // after having added them, schedule the result into that past
-    void AddSwaps(Past &past, const utils::Str &mapselectswapsopt) const;
+    void AddSwaps(Past &past, options::Context::MapSelectSwaps mapselectswapsopt) const;
 
     // compute cycle extension of the current alternative in prevPast relative to the given base past
     //
@@ -731,14 +835,15 @@ class Future {
 public:
     const quantum_platform            *platformp;
     Scheduler                       *schedp;        // a pointer, since dependence graph doesn't change
+    std::mutex                      *schedmutexp;   // serializes DoneGate's updates of the gates in *schedp, which Future copies share
     circuit                     input_gatepv;   // input circuit when not using scheduler based avlist
 
-    utils::Map<gate*,utils::Bool>        scheduled;      // state: has gate been scheduled, here: done from future?
-    utils::List<lemon::ListDigraph::Node> avlist;         // state: which nodes/gates are available for mapping now?
+    utils::Vec<utils::Bool>     scheduled;      // state: has node been scheduled, here: done from future?
+    AvailableList               avlist;         // state: which nodes/gates are available for mapping now?
     circuit::iterator           input_gatepp;   // state: alternative iterator in input_gatepv
 
     // just program wide initialization
-    void Init(const quantum_platform *p);
+    void Init(const quantum_platform *p, std::mutex *sm);
 
     // Set/switch input to the provided circuit
     // nq, nc and nb are parameters because nc/nb may not be provided by platform but by kernel
@@ -762,6 +867,10 @@ public:
     // This is used in tiebreak, when every other option has failed to make a distinction.
     gate *MostCriticalIn(utils::List<gate*> &lag) const;
 
+private:
+    // Return the node in avlist of gate gp
+    utils::UInt AvailableNode(gate *gp) const;
+
 };
 
 // =========================================================================================
@@ -783,7 +892,8 @@ public:
 // Classical registers are ignored by the mapper currently. TO BE DONE.
 
 // The mapping is done in the context of a grid of qubits defined by the given platform.
-// This grid is initialized once for the whole program and constant after that.
+// This grid is initialized once for the whole program and constant after that;
+// the mappers of the kernels of a program share it, together with its path cache.
 
 // Each kernel in the program is independently mapped (see the Map method),
 // ignoring inter-kernel control flow and thereby the requirement to pass on the current mapping.
@@ -838,16 +948,18 @@ private:
     const quantum_platform  *platformp;     // current platform: topology and gate definitions
     quantum_kernel          *kernelp;       // (copy of) current kernel (class) with free private circuit and methods
                                             // primarily to create gates in Past; Past is part of Mapper and of each Alter
+    std::mutex              kernel_mutex;   // serializes creating gates in kernelp, by the Pasts of alternatives evaluated in parallel
+    std::mutex              sched_mutex;    // serializes updates of the dependence graph, by the Futures of alternatives evaluated in parallel
 
     utils::UInt             nq;             // number of qubits in the platform, number of real qubits
     utils::UInt             nc;             // number of cregs in the platform, number of classical registers
     utils::UInt             nb;             // number of bregs in the platform, number of bit registers
     utils::UInt             cycle_time;     // length in ns of a single cycle of the platform
                                             // is divisor of duration in ns to convert it to cycles
-    Grid                    grid;           // current grid
-
-                                            // Initialized by Mapper.Map
-    std::mt19937            gen;            // Standard mersenne_twister_engine, not yet seeded
+    const Grid              *gridp;         // current grid, shared by the mappers of the kernels of the program
+    utils::ThreadPool       *poolp;         // threads to evaluate alternatives with, see option mapselectthreads;
+                                            // shared like the grid, NULL when alternatives are evaluated sequentially
+    std::mt19937            gen;            // Standard mersenne_twister_engine, seeded by Init
 
 public:
                                             // Passed back by Mapper::Map to caller for reporting
@@ -868,18 +980,13 @@ private:
     // initial path finder
     // generate paths with source src and target tgt as a list of path into resla;
     // this result list resla is allocated by caller and is empty on the call;
-    // which indicates which paths are generated; see below the enum whichpaths;
+    // which indicates which paths are generated; see the enum whichpaths_t above Grid;
     // on top of this, the other mapper options apply
-    typedef enum {
-        wp_all_shortest,            // all shortest paths
-        wp_left_shortest,           // only the shortest along the left side of the rectangle of src and tgt
-        wp_right_shortest,          // only the shortest along the right side of the rectangle of src and tgt
-        wp_leftright_shortest       // both the left and right shortest
-    } whichpaths_t;
-
+    //
     // Find shortest paths between src and tgt in the grid, bounded by a particular strategy (which);
     // budget is the maximum number of hops allowed in the path from src and is at least distance to tgt;
     // it can be higher when not all hops qualify for doing a two-qubit gate or to find more than just the shortest paths.
+    // The paths themselves are enumerated (and memoized) by Grid::ShortestPaths.
     void GenShortestPaths(gate *gp, utils::UInt src, utils::UInt tgt, utils::UInt budget, utils::List<Alter> &resla, whichpaths_t which);
 
     // Generate shortest paths in the grid for making gate gp NN, from qubit src to qubit tgt, with an alternative for each one
@@ -903,15 +1010,12 @@ private:
     // Depending on maplookahead only take first (most critical) gate or take all gates.
     void GenAlters(utils::List<gate*> lg, utils::List<Alter> &la, Past &past);
 
-    // start the random generator with a seed
-    // that is unique to the microsecond
-    void RandomInit();
-
     // if the maptiebreak option indicates so,
     // generate a random utils::Int number in range 0..count-1 and use
     // that to index in list of alternatives and to return that one,
-    // otherwise return a fixed one (front, back or first most critical one
-    Alter ChooseAlter(utils::List<Alter> &la, Future &future);
+    // otherwise return a fixed one (front, back or first most critical one;
+    // random draws are made from altgen
+    Alter ChooseAlter(utils::List<Alter> &la, Future &future, std::mt19937 &altgen);
 
     // Map the gate/operands of a gate that has been routed or doesn't require routing
     void MapRoutedGate(gate *gp, Past &past);
@@ -942,15 +1046,22 @@ private:
     //
     utils::Bool MapMappableGates(Future &future, Past &past, utils::List<gate*> &lg, utils::Bool alsoNN2q);
 
+    // call f on each alternative in la with its index in la, in parallel on the threads of pool when it is available;
+    // f must only modify the alternative it is called on, so that the result doesn't depend on the order of the calls
+    void ForEachAlter(utils::List<Alter> &la, const std::function<void(Alter &, utils::UInt)> &f);
+
     // select Alter determined by strategy defined by mapper options
     // - if base[rc], select from whole list of Alters, of which all 'remain'
     // - if minextend[rc], select Alter from list of Alters with minimal cycle extension of given past
     //   when several remain with equal minimum extension, recurse to reduce this set of remaining ones
     //   - level: level of recursion at which SelectAlter is called: 0 is base, 1 is 1st, etc.
     //   - option mapselectmaxlevel: max level of recursion to use, where inf indicates no maximum
-    // - maptiebreak option indicates which one to take when several (still) remain
+    // - maptiebreak option indicates which one to take when several (still) remain;
+    //   random draws are made from altgen, and the recursion for each alternative draws from
+    //   its own generator, seeded from altgen in the order of the alternatives,
+    //   so that the result doesn't depend on the number of threads evaluating them
     // result is returned in resa
-    void SelectAlter(utils::List<Alter> &la, Alter &resa, Future &future, Past &past, Past &basePast, utils::Int level);
+    void SelectAlter(utils::List<Alter> &la, Alter &resa, Future &future, Past &past, Past &basePast, utils::Int level, std::mt19937 &altgen);
 
     // Given the states of past and future
     // map all mappable gates and find the non-mappable ones
@@ -971,11 +1082,19 @@ public:
     // JvS: moved to mapper.cc ahead of restructuring everything else for persistent INITIALPLACE switch
     void Map(quantum_kernel &kernel);
 
-    // initialize mapper for whole program
-    // lots could be split off for the whole program, once that is needed
+    // a seed for the random generator that is unique to the microsecond;
+    // the mappers of the kernels of a program are seeded with this plus the index of their kernel
+    static utils::UInt RandomSeed();
+
+    // number of threads to evaluate alternatives with, following option mapselectthreads
+    static utils::UInt SelectThreads();
+
+    // initialize mapper for a kernel of the program, given what is shared by all of them:
+    // the grid of the platform, the threads to evaluate alternatives with (NULL for none),
+    // and the seed of the random generator, which is different for each kernel
     //
     // initialization for a particular kernel is separate (in Map entry)
-    void Init(const quantum_platform *p);
+    void Init(const quantum_platform *p, const Grid *g, utils::ThreadPool *selectpool, utils::UInt seed);
 
 };
 
@@ -159,16 +159,17 @@ Real Metrics::bounded_fidelity(const circuit &circ, Vec<Real> &fids) {
 
         QL_IOUT("Next gate\n");
 
-        if (gate->name == "measure") {
+        UInt opcode = gate->get_opcode();
+        if (opcode == opc_measure) {
             continue;
-        } else if (gate->name == "prepz") {
+        } else if (opcode == opc_prepz) {
             UInt qubit = gate->operands[0];
             fids[qubit] = 1.0;
             last_op_endtime[qubit] = gate->cycle + gate->duration / CYCLE_TIME;
             continue;
         }
 
-        if (gate->duration > CYCLE_TIME*2 && gate->name != "prep_z" && gate->name != "measure") {
+        if (gate->duration > CYCLE_TIME*2 && opcode != opc_prep_z && opcode != opc_measure) {
             QL_EOUT("Gate with duration larger than CYCLE_TIME*20 detected! Non primitive?: " << gate->name );
             throw Exception("Check for non primitive gates at cycle " + to_string(gate->cycle) + "!", false);
         }
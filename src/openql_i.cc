@@ -5,6 +5,7 @@
 #include "openql_i.h"
 
 #include "version.h"
+#include "binary_ir.h"
 
 static bool initialized = false;
 
@@ -463,6 +464,14 @@ void Program::compile() {
     program->compile();
 }
 
+void Program::write_binary_ir(const std::string &fname) const {
+    ql::write_binary_ir(program, fname);
+}
+
+void Program::read_binary_ir(const std::string &fname) {
+    ql::read_binary_ir(program, fname);
+}
+
 std::string Program::microcode() const {
 #if OPT_MICRO_CODE
     return program->microcode();
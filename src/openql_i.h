@@ -187,6 +187,8 @@ public:
     void add_for(const Kernel &k, size_t iterations);
     void add_for(const Program &p, size_t iterations);
     void compile();
+    void write_binary_ir(const std::string &fname) const;
+    void read_binary_ir(const std::string &fname);
     std::string microcode() const;
     void print_interaction_matrix() const;
     void write_interaction_matrix() const;
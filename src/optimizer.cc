@@ -23,7 +23,12 @@ public:
 };
 
 /**
- * rotation fuser
+ * sliding window rotation fuser
+ *
+ * Removes each window of consecutive gates of which the product of the matrices
+ * is the identity, trying all window sizes. This is cubic in the circuit length
+ * and does not look at the qubit operands; it has been superseded by
+ * rotations_fusion below and is only kept as a reference for benchmarking.
  */
 class rotations_merging : public optimizer {
 public:
@@ -154,36 +159,206 @@ protected:
 
 };
 
-inline void rotation_optimize_kernel(quantum_kernel &kernel, const quantum_platform &platform) {
-    QL_DOUT("kernel " << kernel.name << " optimize_kernel(): circuit before optimizing: ");
-    print(kernel.c);
-    QL_DOUT("... end circuit");
-    rotations_merging rm;
-    if (contains_measurements(kernel.c)) {
-        QL_DOUT("kernel contains measurements ...");
-        // decompose the circuit
-        Vec<circuit*> cs = split_circuit(kernel.c);
-        Vec<circuit> cs_opt;
-        for (auto c : cs)
-        {
-            if (!contains_measurements(*c)) {
-                circuit opt = rm.optimize(*c);
-                cs_opt.push_back(opt);
+/**
+ * per-qubit rotation fuser
+ *
+ * Streams the circuit once, keeping for each qubit the run of single-qubit
+ * unitary gates on it since the last other gate on it (a multi-qubit,
+ * conditional or non-unitary gate), together with the running 2x2 products
+ * of that run. When the running product returns to an earlier value (up to
+ * global phase), the gates in between multiply to the identity and are
+ * removed, and the run continues from that earlier value; this also catches
+ * nested cancellations like x h h x. Any other gate on a qubit flushes its
+ * run; a gate without qubit operands (e.g. a wait on all qubits) flushes all
+ * runs. To stay linear, the running product is only compared to the ones
+ * of the last few gates of the run, and to the start of the run.
+ */
+class rotations_fusion : public optimizer {
+public:
+
+    circuit optimize(circuit &ic) override {
+        Vec<Bool> removed(ic.size(), false);
+        Vec<run_t> runs;                    // indexed by qubit
+        for (UInt i = 0; i < ic.size(); i++) {
+            gate *g = ic[i];
+            if (!is_fusable(g)) {
+                if (g->operands.empty()) {
+                    runs.clear();
+                } else {
+                    for (auto q : g->operands) {
+                        if (q < runs.size()) {
+                            runs[q] = run_t();
+                        }
+                    }
+                }
+                continue;
+            }
+
+            UInt q = g->operands[0];
+            if (q >= runs.size()) {
+                runs.resize(q + 1);
+            }
+            run_t &run = runs[q];
+            if (run.prefix.empty()) {
+                run.prefix.push_back(identity_mat());
+            }
+            cmat_t p = fuse(run.prefix.back(), g->mat());
+            run.gates.push_back(i);
+
+            // find an earlier prefix equal to p, but not the directly preceding one,
+            // since a single gate with an identity matrix may be a placeholder
+            UInt n = run.gates.size();
+            UInt found = n;
+            UInt first = (n > lookback) ? n - lookback : 0;
+            for (UInt k = n - 1; k-- > first; ) {
+                if (is_same(run.prefix[k], p)) {
+                    found = k;
+                    break;
+                }
+            }
+            if (found == n && first > 0 && is_same(run.prefix[0], p)) {
+                found = 0;
+            }
+
+            if (found == n) {
+                run.prefix.push_back(p);
             } else {
-                cs_opt.push_back(*c);
+                for (UInt k = found; k < n; k++) {
+                    removed[run.gates[k]] = true;
+                }
+                run.gates.resize(found);
+                run.prefix.resize(found + 1);
             }
         }
-        // for (int i=0; i<cs_opt.size(); ++i)
-        // print(cs_opt[i]);
-        kernel.c.clear( );
-        for (size_t i = 0; i < cs_opt.size(); ++i) {
-            for (size_t j = 0; j < cs_opt[i].size(); j++) {
-                kernel.c.push_back(cs_opt[i][j]);
+
+        circuit oc;
+        for (UInt i = 0; i < ic.size(); i++) {
+            if (!removed[i]) {
+                oc.push_back(ic[i]);
             }
         }
-    } else {
-        kernel.c = rm.optimize(kernel.c);
+        return oc;
+    }
+
+protected:
+
+    /**
+     * run of single-qubit gates on a qubit: prefix[k] is the product of the
+     * matrices of the first k remaining gates of the run (so prefix[0] is the
+     * identity), gates[k] is the index of gate k in the input circuit
+     */
+    typedef struct {
+        Vec<cmat_t> prefix;
+        Vec<UInt> gates;
+    } run_t;
+
+    /**
+     * maximum number of gates back that the running product is compared to
+     */
+    static const UInt lookback = 16;
+
+    static cmat_t identity_mat() {
+        return cmat_t(nop_c);
+    }
+
+    /**
+     * product of the matrices of gate g1 followed by gate g2, i.e. m2*m1
+     */
+    static cmat_t fuse(const cmat_t &m1, const cmat_t &m2) {
+        cmat_t res;
+        const Complex *x = m2.m;
+        const Complex *y = m1.m;
+        Complex *r = res.m;
+        r[0] = x[0]*y[0] + x[1]*y[2];
+        r[1] = x[0]*y[1] + x[1]*y[3];
+        r[2] = x[2]*y[0] + x[3]*y[2];
+        r[3] = x[2]*y[1] + x[3]*y[3];
+        return res;
+    }
+
+    /**
+     * whether a and b are unitaries that are equal up to global phase, i.e.
+     * whether a^dagger*b is a multiple of the identity
+     */
+    static Bool is_same(const cmat_t &a, const cmat_t &b) {
+        const Complex *x = a.m;
+        const Complex *y = b.m;
+        Complex r0 = std::conj(x[0])*y[0] + std::conj(x[2])*y[2];
+        Complex r1 = std::conj(x[0])*y[1] + std::conj(x[2])*y[3];
+        Complex r2 = std::conj(x[1])*y[0] + std::conj(x[3])*y[2];
+        Complex r3 = std::conj(x[1])*y[1] + std::conj(x[3])*y[3];
+        return std::abs(r1) < __epsilon__ && std::abs(r2) < __epsilon__ && std::abs(r0 - r3) < __epsilon__;
+    }
+
+    /**
+     * whether m is unitary; custom gates without a meaningful matrix fail this
+     */
+    static Bool is_unitary(const cmat_t &mat) {
+        const Complex *m = mat.m;
+        Complex r0 = m[0]*std::conj(m[0]) + m[1]*std::conj(m[1]);
+        Complex r1 = m[0]*std::conj(m[2]) + m[1]*std::conj(m[3]);
+        Complex r3 = m[2]*std::conj(m[2]) + m[3]*std::conj(m[3]);
+        return std::abs(r0 - 1.0) < __epsilon__ && std::abs(r1) < __epsilon__ && std::abs(r3 - 1.0) < __epsilon__;
+    }
+
+    /**
+     * whether g is an unconditional single-qubit unitary gate
+     */
+    static Bool is_fusable(const gate *g) {
+        if (g->operands.size() != 1 || g->is_conditional()) {
+            return false;
+        }
+        switch (g->type()) {
+            case __prepz_gate__:
+            case __measure_gate__:
+            case __display__:
+            case __display_binary__:
+            case __nop_gate__:
+            case __dummy_gate__:
+            case __wait_gate__:
+            case __classical_gate__:
+            case __composite_gate__:
+                return false;
+            case __custom_gate__:
+                // prepz and measure may be defined with an identity matrix
+                if (g->name.find("prepz") == 0 || g->name.find("measure") == 0) {
+                    return false;
+                }
+                break;
+            default:
+                break;
+        }
+        return is_unitary(g->mat());
     }
+
+};
+
+/**
+ * Removes sequences of single-qubit gates on a qubit that together are the
+ * identity, in time linear in the number of gates.
+ */
+circuit rotation_fuse(const circuit &c) {
+    circuit ic = c;
+    rotations_fusion rf;
+    return rf.optimize(ic);
+}
+
+/**
+ * The sliding window rotation merger that was used before rotation_fuse.
+ */
+circuit rotation_merge_sliding_window(const circuit &c) {
+    circuit ic = c;
+    rotations_merging rm;
+    return rm.optimize(ic);
+}
+
+inline void rotation_optimize_kernel(quantum_kernel &kernel, const quantum_platform &platform) {
+    QL_DOUT("kernel " << kernel.name << " optimize_kernel(): circuit before optimizing: ");
+    print(kernel.c);
+    QL_DOUT("... end circuit");
+    // measurements and prepz are not fusable, so these flush the runs of their qubits;
+    // there is no need to split the circuit at them anymore
+    kernel.c = rotation_fuse(kernel.c);
     kernel.cycles_valid = false;
     QL_DOUT("kernel " << kernel.name << " rotation_optimize(): circuit after optimizing: ");
     print(kernel.c);
@@ -198,9 +373,9 @@ void rotation_optimize(
 ) {
     if (options::get("optimize") == "yes") {
         QL_IOUT("optimizing quantum kernels...");
-        for (size_t k=0; k<programp->kernels.size(); ++k) {
-            rotation_optimize_kernel(programp->kernels[k], platform);
-        }
+        programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
+            rotation_optimize_kernel(kernel, platform);
+        });
     }
 }
 
@@ -7,9 +7,24 @@
 #include "utils/str.h"
 #include "program.h"
 #include "platform.h"
+#include "circuit.h"
 
 namespace ql {
 
+/**
+ * Removes sequences of single-qubit gates on a qubit that together are the
+ * identity (up to global phase), in time linear in the number of gates. This
+ * is what the rotation_optimize pass does for each kernel.
+ */
+circuit rotation_fuse(const circuit &c);
+
+/**
+ * The sliding window rotation merger that was used before rotation_fuse. It
+ * is cubic in the number of gates and ignores qubit operands; it is only kept
+ * as a reference for benchmarking.
+ */
+circuit rotation_merge_sliding_window(const circuit &c);
+
 void rotation_optimize(
     quantum_program *programp,
     const quantum_platform &platform,
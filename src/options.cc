@@ -148,6 +148,15 @@ void Option::reset() {
     value_changed();
 }
 
+/**
+ * Takes over the value of the given option, which must be of the same kind,
+ * without calling the callbacks.
+ */
+void Option::copy_value_from(const Option &src) {
+    current_value = src.current_value;
+    configured = src.configured;
+}
+
 /**
  * Returns whether this option was manually configured.
  */
@@ -451,6 +460,14 @@ RealOption::RealOption(
     }
 }
 
+/**
+ * Returns the number of times an option was set or reset, to find out
+ * whether anything changed since an earlier call.
+ */
+UInt Options::get_changes() const {
+    return *changes;
+}
+
 /**
  * Adds a string option.
  */
@@ -574,6 +591,19 @@ void Options::update_from(const Options &src) {
     }
 }
 
+/**
+ * Like update_from(), but without calling the callbacks of the options; their
+ * side effects (such as setting the log level or making the output directory)
+ * already happened when the values were set in src.
+ */
+void Options::copy_values_from(const Options &src) {
+    for (const auto &it : src.options) {
+        if (it.second->is_set()) {
+            operator[](it.first).copy_value_from(*it.second);
+        }
+    }
+}
+
 /**
  * Resets all options to their default values.
  */
@@ -637,6 +667,11 @@ Options make_ql_options() {
     options.add_bool("scheduler_uniform", "Do uniform scheduling or not");
     options.add_bool("scheduler_commute", "Commute two-qubit gates when possible, or not");
     options.add_bool("scheduler_commute_rotations", "Commute rotation gates and with two-qubit gates when possible, or not");
+    options.add_enum("vary_commutations", "Replace the circuit by its variation wrt commuting gates with the least depth, found by enumerating all variations or by a bounded search", "no", {"no", "yes", "bounded"});
+    options.add_int ("vary_commutations_max_variations", "Maximum number of variations that the bounded search of vary_commutations schedules", "inf", 1, MAX, {"inf"});
+    options.add_real("vary_commutations_max_time", "Maximum time in seconds that the bounded search of vary_commutations takes per kernel", "inf", 0, INF, {"inf"});
+    options.add_int ("vary_commutations_threads", "Number of threads to do the bounded search of vary_commutations with", "1", 1, 64, {"max"});
+    options.add_enum("scheduler_depgraph", "Dependence graph of the schedulers as lemon graph, or only as arrays (faster, less memory)", "lemon", {"lemon", "arrays"});
     options.add_bool("use_default_gates", "Use default gates or not", "yes");
     options.add_bool("optimize", "optimize or not");
     options.add_bool("clifford_prescheduler", "clifford optimize before prescheduler yes or not");
@@ -644,6 +679,10 @@ Options make_ql_options() {
     options.add_bool("clifford_premapper", "clifford optimize before mapping yes or not");
     options.add_bool("clifford_postmapper", "clifford optimize after mapping yes or not");
     options.add_enum("decompose_toffoli", "Type of decomposition used for toffoli", "no", {"no", "NC", "AM"});
+    options.add_bool("platform_cache", "Reuse the platform loaded earlier from the same, unchanged configuration file", true);
+    options.add_bool("unitary_decomposition_cache", "Reuse the decomposition of an earlier unitary with the same matrix", true);
+    options.add_int ("unitary_decomposition_threads", "Number of threads to decompose the independent halves of a unitary with", "1", 1, 64, {"max"});
+    options.add_int ("kernel_threads", "Number of threads to run the passes that handle each kernel independently with, on different kernels in parallel", "1", 1, 64, {"max"});
     options.add_enum("quantumsim", "Produce quantumsim output, and of which kind", "no", {"no", "yes", "qsoverlay"});
     options.add_bool("issue_skip_319", "Issue skip instead of wait in bundles");
 
@@ -664,6 +703,7 @@ Options make_ql_options() {
     options.add_bool("maprecNN2q", "Recursing also on NN 2q gate?");
     options.add_int ("mapselectmaxlevel", "Maximum recursion in selecting alternatives on minimum extension", "0", 0, 10, {"inf"});
     options.add_enum("mapselectmaxwidth", "Maximum width number of alternatives to enter recursion with", "min", {"min", "minplusone", "minplushalfmin", "minplusmin", "all"});
+    options.add_int ("mapselectthreads", "Number of threads to evaluate alternatives with in selecting alternatives on minimum extension; the result does not depend on it", "1", 1, 64, {"max"});
     options.add_enum("maptiebreak", "Tie break method", "random", {"first", "last", "random", "critical"});
     options.add_int ("mapusemoves", "Use unused qubit to move thru", "yes", 0, 20, {"no", "yes"});
     options.add_bool("mapreverseswap", "Reverse swap operands when better", true);
@@ -680,19 +720,123 @@ Options make_ql_options() {
 Options global = make_ql_options();
 
 /**
- * Convenience function for getting an option value as a string from the global
- * options record.
+ * Returns the index of the value of the given option in the given list of
+ * values, as the enumeration type E with the values in the same order.
+ */
+template <class E>
+static E parse_enum(const Option &option, std::initializer_list<const char *> values) {
+    UInt index = 0;
+    for (auto value : values) {
+        if (option.as_str() == value) {
+            return static_cast<E>(index);
+        }
+        index++;
+    }
+    throw Exception("unexpected value " + option.as_str() + " for option " + option.get_name(), false);
+}
+
+/**
+ * Makes a context with the current values of the given options. The values are
+ * copied without calling the callbacks of the options, which act on global
+ * state (the log level, the output directory), since contexts are made by
+ * compilations running in parallel.
+ */
+Context::Context(const Options &src) : options(make_ql_options()) {
+    options.copy_values_from(src);
+    parse();
+}
+
+/**
+ * Parses the typed fields from the options again.
+ */
+void Context::parse() {
+    mapper = parse_enum<Mapper>(options["mapper"], {"no", "base", "baserc", "minextend", "minextendrc", "maxfidelity"});
+    maplookahead = parse_enum<MapLookahead>(options["maplookahead"], {"no", "1qfirst", "noroutingfirst", "all"});
+    mappathselect = parse_enum<MapPathSelect>(options["mappathselect"], {"all", "borders"});
+    mapselectswaps = parse_enum<MapSelectSwaps>(options["mapselectswaps"], {"one", "all", "earliest"});
+    mapselectmaxwidth = parse_enum<MapSelectMaxWidth>(options["mapselectmaxwidth"], {"min", "minplusone", "minplushalfmin", "minplusmin", "all"});
+    maptiebreak = parse_enum<MapTieBreak>(options["maptiebreak"], {"first", "last", "random", "critical"});
+    const Str &maxlevel = options["mapselectmaxlevel"].as_str();
+    mapselectmaxlevel = maxlevel == "inf" ? MAX : parse_int(maxlevel);
+    const Str &usemoves = options["mapusemoves"].as_str();
+    mapusemoves = usemoves != "no";
+    mapusemoves_threshold = (usemoves == "yes" || usemoves == "no") ? 0 : parse_int(usemoves);
+    mapreverseswap = options["mapreverseswap"].as_bool();
+    maprecNN2q = options["maprecNN2q"].as_bool();
+    mapprepinitsstate = options["mapprepinitsstate"].as_bool();
+    scheduler_commute = options["scheduler_commute"].as_bool();
+    scheduler_commute_rotations = options["scheduler_commute_rotations"].as_bool();
+    print_dot_graphs = options["print_dot_graphs"].as_bool();
+}
+
+/**
+ * The context that is active on this thread, if any.
+ */
+static thread_local std::shared_ptr<Context> active;
+
+/**
+ * Activates the given context on the calling thread.
+ */
+Scope::Scope(const std::shared_ptr<Context> &context) : previous(active) {
+    active = context;
+}
+
+/**
+ * Restores the previously active context.
+ */
+Scope::~Scope() {
+    active = previous;
+}
+
+/**
+ * Returns the context that is active on the calling thread, or an empty
+ * pointer when the global options are used.
+ */
+std::shared_ptr<Context> active_context() {
+    return active;
+}
+
+/**
+ * Returns the active context of the calling thread. When no context is
+ * active, returns a context that reflects the global options; it is made
+ * again when any option changed since.
+ */
+const Context &context() {
+    if (active) {
+        return *active;
+    }
+    static thread_local std::unique_ptr<Context> global_context;
+    static thread_local UInt global_changes = 0;
+    UInt changes = global.get_changes();
+    if (!global_context || global_changes != changes) {
+        global_context.reset(new Context(global));
+        global_changes = changes;
+    }
+    return *global_context;
+}
+
+/**
+ * Convenience function for getting an option value as a string from the
+ * active context, or from the global options record if there is none.
  */
 const Str &get(const Str &key) {
+    if (active) {
+        return active->options[key].as_str();
+    }
     return global[key].as_str();
 }
 
 /**
- * Convenience function for setting an option value for the global options
- * record.
+ * Convenience function for setting an option value in the active context, or
+ * in the global options record if there is none.
  */
 void set(const Str &key, const Str &value) {
-    global[key] = value;
+    if (active) {
+        active->options[key] = value;
+        active->parse();
+    } else {
+        global[key] = value;
+    }
 }
 
 } // namespace options
@@ -5,7 +5,9 @@
 #pragma once
 
 #include <iostream>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include "utils/ptr.h"
 #include "utils/str.h"
 #include "utils/list.h"
@@ -152,6 +154,12 @@ public:
      */
     void reset();
 
+    /**
+     * Takes over the value of the given option, which must be of the same
+     * kind, without calling the callbacks.
+     */
+    void copy_value_from(const Option &src);
+
     /**
      * Returns whether this option was manually configured.
      */
@@ -374,6 +382,11 @@ private:
      */
     utils::Map<utils::Str, utils::Ptr<Option>> options;
 
+    /**
+     * Number of times an option was set or reset.
+     */
+    std::shared_ptr<std::atomic<utils::UInt>> changes = std::make_shared<std::atomic<utils::UInt>>(0);
+
 public:
 
     /**
@@ -384,9 +397,16 @@ public:
         auto option = utils::Ptr<Option>();
         option.emplace<T>(std::forward<Args>(args)...);
         options.set(option->get_name()) = option;
-        return *option;
+        auto counter = changes;
+        return option->with_callback([counter](Option&){ (*counter)++; });
     }
 
+    /**
+     * Returns the number of times an option was set or reset, to find out
+     * whether anything changed since an earlier call.
+     */
+    utils::UInt get_changes() const;
+
     /**
      * Adds a string option.
      */
@@ -455,6 +475,13 @@ public:
      */
     void update_from(const Options &src);
 
+    /**
+     * Like update_from(), but without calling the callbacks of the options;
+     * their side effects (such as setting the log level or making the output
+     * directory) already happened when the values were set in src.
+     */
+    void copy_values_from(const Options &src);
+
     /**
      * Resets all options to their default values.
      */
@@ -489,14 +516,97 @@ Options make_ql_options();
 QL_GLOBAL extern Options global;
 
 /**
- * Convenience function for getting an option value as a string from the global
- * options record.
+ * The options of a single compilation. A context is made from the global
+ * options when a compilation starts, and activated on the compiling thread
+ * (and on the threads it distributes work over) with a Scope. While it is
+ * active, get() and set() operate on the context rather than on the global
+ * options, so that several programs can be compiled in parallel threads,
+ * and options changed by passes don't leak into the global options.
+ *
+ * The options that the mapper and the schedulers read in their inner loops
+ * are also available as typed fields, parsed when the context is made and
+ * updated by set().
+ */
+class Context {
+public:
+    enum class Mapper { NO, BASE, BASERC, MINEXTEND, MINEXTENDRC, MAXFIDELITY };
+    enum class MapLookahead { NO, ONEQFIRST, NOROUTINGFIRST, ALL };
+    enum class MapPathSelect { ALL, BORDERS };
+    enum class MapSelectSwaps { ONE, ALL, EARLIEST };
+    enum class MapSelectMaxWidth { MIN, MINPLUSONE, MINPLUSHALFMIN, MINPLUSMIN, ALL };
+    enum class MapTieBreak { FIRST, LAST, RANDOM, CRITICAL };
+
+    /**
+     * All options, as strings.
+     */
+    Options options;
+
+    Mapper mapper;
+    MapLookahead maplookahead;
+    MapPathSelect mappathselect;
+    MapSelectSwaps mapselectswaps;
+    MapSelectMaxWidth mapselectmaxwidth;
+    MapTieBreak maptiebreak;
+    utils::Int mapselectmaxlevel;       // utils::MAX for "inf"
+    utils::Bool mapusemoves;
+    utils::Int mapusemoves_threshold;   // 0 for "yes"
+    utils::Bool mapreverseswap;
+    utils::Bool maprecNN2q;
+    utils::Bool mapprepinitsstate;
+    utils::Bool scheduler_commute;
+    utils::Bool scheduler_commute_rotations;
+    utils::Bool print_dot_graphs;
+
+    /**
+     * Makes a context with the current values of the given options.
+     */
+    explicit Context(const Options &src);
+
+    /**
+     * Parses the typed fields from the options again.
+     */
+    void parse();
+
+};
+
+/**
+ * Activates the given context on the calling thread for the lifetime of the
+ * Scope object, restoring the previously active context afterwards. An empty
+ * context pointer selects the global options.
+ */
+class Scope {
+private:
+    std::shared_ptr<Context> previous;
+
+public:
+    explicit Scope(const std::shared_ptr<Context> &context);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+/**
+ * Returns the context that is active on the calling thread, or an empty
+ * pointer when the global options are used. Pass this to a Scope to give
+ * worker threads the options of the compilation they work for.
+ */
+std::shared_ptr<Context> active_context();
+
+/**
+ * Returns the active context of the calling thread. When no context is
+ * active, returns a context that reflects the global options.
+ */
+const Context &context();
+
+/**
+ * Convenience function for getting an option value as a string from the
+ * active context, or from the global options record if there is none.
  */
 const utils::Str &get(const utils::Str &key);
 
 /**
- * Convenience function for setting an option value for the global options
- * record.
+ * Convenience function for setting an option value in the active context, or
+ * in the global options record if there is none.
  */
 void set(const utils::Str &key, const utils::Str &value);
 
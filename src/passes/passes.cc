@@ -13,6 +13,7 @@
 #include "clifford.h"
 #include "decompose_toffoli.h"
 #include "cqasm/cqasm_reader.h"
+#include "binary_ir.h"
 #include "latency_compensation.h"
 #include "buffer_insertion.h"
 #include "commute_variation.h"
@@ -223,6 +224,58 @@ void WriterPass::runOnProgram(quantum_program *program) {
 //     { ///@note-rn: temoporary hack to make the writer pass for those 2 configurations soft (i.e., do not delete the subcircuits) so that it does not require a reader pass after it!. This is needed until we fix the synchronization between hardware configuration files and openql tests. Until then a Reader pass would be needed after a hard Write pass. However, a Reader pass will make some unit tests to fail due to a mismatch between the instructions in the tests (i.e., prepz) and included/defined in the hardware config files CONFLICTING with the prepz instr not being available in libQASM.
 }
 
+/**
+ * @brief   Gets the name of the file a binary IR pass writes or reads
+ * @param   Binary IR pass
+ * @param   Program object to be written or read
+ * @return  Value of the pass option binary_ir_file, or by default the program
+ *          name with extension .bir in the output directory
+ */
+static Str binaryIRFileName(const AbstractPass &pass, const quantum_program *program) {
+    Str fname = pass.getPassOptions()["binary_ir_file"].as_str();
+    if (fname == "none") {
+        fname = options::get("output_dir") + "/" + program->name + ".bir";
+    }
+    return fname;
+}
+
+/**
+ * @brief  Binary IR writer pass constructor
+ * @param  Name of the binary IR writer pass
+ */
+BinaryWriterPass::BinaryWriterPass(const Str &name) : AbstractPass(name) {
+    getPassOptions().add_str("binary_ir_file", "path of the binary IR file to write", "none");
+}
+
+/**
+ * @brief  Checkpoint the program to a binary IR file
+ * @param  Program object to be written
+ */
+void BinaryWriterPass::runOnProgram(quantum_program *program) {
+    QL_DOUT("run BinaryWriterPass with name = " << getPassName() << " on program " << program->name);
+
+    write_binary_ir(program, binaryIRFileName(*this, program));
+}
+
+/**
+ * @brief  Binary IR reader pass constructor
+ * @param  Name of the binary IR reader pass
+ */
+BinaryReaderPass::BinaryReaderPass(const Str &name) : AbstractPass(name) {
+    getPassOptions().add_str("binary_ir_file", "path of the binary IR file to read", "none");
+}
+
+/**
+ * @brief  Replace the kernels of the program by those of a binary IR file, to
+ *         resume a compilation where the BinaryWriter pass checkpointed it
+ * @param  Program object to be read
+ */
+void BinaryReaderPass::runOnProgram(quantum_program *program) {
+    QL_DOUT("run BinaryReaderPass with name = " << getPassName() << " on program " << program->name);
+
+    read_binary_ir(program, binaryIRFileName(*this, program));
+}
+
 /**
  * @brief  Rotation optimizer pass constructor
  * @param  Name of the optimized pass
@@ -366,7 +419,7 @@ CCLPrepCodeGeneration::CCLPrepCodeGeneration(const Str &name) : AbstractPass(nam
  * @param  Program object to be prepared
  */
 void CCLPrepCodeGeneration::runOnProgram(quantum_program *program) {
-    const Json &instruction_settings = program->platform.instruction_settings;
+    const Json &instruction_settings = *program->platform.instruction_settings;
     for (const Json &i : instruction_settings) {
        if (i.count("cc_light_instr") <= 0) {
             QL_FATAL("cc_light_instr not found for " << i);
@@ -433,7 +486,9 @@ CommuteVariationPass::CommuteVariationPass(const Str &name) : AbstractPass(name)
  * @param  Program object to be latency compensated
  */
 void CommuteVariationPass::runOnProgram(quantum_program *program) {
-    commute_variation(program, program->platform, getPassName());
+    Str stats;
+    commute_variation(program, program->platform, getPassName(), &stats);
+    appendStatistics(stats);
 }
 
 /**
@@ -481,6 +536,21 @@ void InsertBufferDelaysPass::runOnProgram(quantum_program *program) {
     insert_buffer_delays(program, program->platform, getPassName());
 }
 
+/**
+ * @brief  Latency compensation and buffer delay insertion pass constructor
+ * @param  Name of the pass
+ */
+LatencyAndBufferDelaysPass::LatencyAndBufferDelaysPass(const Str &name) : AbstractPass(name) {
+}
+
+/**
+ * @brief  Apply latency compensation and insert buffer delays in one pass over each kernel
+ * @param  Program object to be latency compensated and extended with buffer delays
+ */
+void LatencyAndBufferDelaysPass::runOnProgram(quantum_program *program) {
+    compensate_latency_and_insert_buffer_delays(program, program->platform, getPassName());
+}
+
 /**
  * @brief  Decomposer Post Schedule  Pass
  * @param  Name of the decomposer pass
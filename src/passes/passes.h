@@ -63,6 +63,32 @@ public:
     void runOnProgram(quantum_program *program) override;
 };
 
+/**
+ * Binary IR Writer Pass
+ */
+class BinaryWriterPass : public AbstractPass {
+public:
+    /**
+     * @brief  Binary IR writer pass constructor
+     * @param  Name of the binary IR writer pass
+     */
+    explicit BinaryWriterPass(const utils::Str &name);
+    void runOnProgram(quantum_program *program) override;
+};
+
+/**
+ * Binary IR Reader Pass
+ */
+class BinaryReaderPass : public AbstractPass {
+public:
+    /**
+     * @brief  Binary IR reader pass constructor
+     * @param  Name of the binary IR reader pass
+     */
+    explicit BinaryReaderPass(const utils::Str &name);
+    void runOnProgram(quantum_program *program) override;
+};
+
 /**
  * Optimizer Pass
  */
@@ -245,6 +271,19 @@ public:
     void runOnProgram(quantum_program *program) override;
 };
 
+/**
+ * Latency Compensation and Insert Buffer Delays Pass
+ */
+class LatencyAndBufferDelaysPass : public AbstractPass {
+public:
+    /**
+     * @brief  Latency compensation and buffer delay insertion pass constructor
+     * @param  Name of the pass
+     */
+    explicit LatencyAndBufferDelaysPass(const utils::Str &name);
+    void runOnProgram(quantum_program *program) override;
+};
+
 /**
  * CC-Light Decompose PostSchedule Pass
  */
@@ -5,6 +5,7 @@
 #include "utils/num.h"
 #include "passmanager.h"
 #include "write_sweep_points.h"
+#include "options.h"
 
 namespace ql {
 
@@ -71,6 +72,12 @@ void PassManager::loadPassesFromConfigFile(const Str &newName, const Str &cfg) {
 void PassManager::compile(quantum_program *program) const {
 
     QL_DOUT("In PassManager::compile ... ");
+
+    // the passes get their own copy of the options, such that options they
+    // change don't leak into other compilations running in parallel
+    auto context = options::active_context();
+    options::Scope scope(std::make_shared<options::Context>(context ? context->options : options::global));
+
     for (auto pass : passes) {
         ///@todo-rn: implement option to check if following options are actually needed for a pass
         ///@note-rn: currently(0.8.1.dev), all passes require platform as API parameter, and some passes depend on the nqubits internally. Therefore, these are passed through by setting the program with these fields here. However, this should change in the future since compiling for a simulator might not require a platform, and the number of qubits could be optional.
@@ -83,7 +90,7 @@ void PassManager::compile(quantum_program *program) const {
         //If the old interface is used, platform is already set, so it is not needed to look for platform option and configure the platform from there
         if (!program->platformInitialized) {
             Str hwconfig = pass->getPassOptions()["hwconfig"].as_str();
-            program->platform = *(new quantum_platform("testPlatform",hwconfig));
+            program->platform = *quantum_platform::get("testPlatform", hwconfig);
         }
 
         if (!pass->getSkip()) {
@@ -133,6 +140,10 @@ AbstractPass *PassManager::createPass(const Str &passName, const Str &aliasName)
         pass = new ReaderPass(aliasName);
     } else if (passName == "Writer") {
         pass = new WriterPass(aliasName);
+    } else if (passName == "BinaryWriter") {
+        pass = new BinaryWriterPass(aliasName);
+    } else if (passName == "BinaryReader") {
+        pass = new BinaryReaderPass(aliasName);
     } else if (passName == "RotationOptimizer") {
         pass = new RotationOptimizerPass(aliasName);
     } else if (passName == "DecomposeToffoli") {
@@ -161,6 +172,8 @@ AbstractPass *PassManager::createPass(const Str &passName, const Str &aliasName)
         pass = new LatencyCompensationPass(aliasName);
     } else if (passName == "InsertBufferDelays") {
         pass = new InsertBufferDelaysPass(aliasName);
+    } else if (passName == "LatencyAndBufferDelays") {
+        pass = new LatencyAndBufferDelaysPass(aliasName);
     } else if (passName == "CCLDecomposePostSchedule") {
         pass = new CCLDecomposePostSchedulePass(aliasName);
     } else if (passName == "QisaCodeGeneration") {
@@ -4,38 +4,203 @@
 
 #include "platform.h"
 
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include "utils/pair.h"
+#include "options.h"
+
 namespace ql {
 
 using namespace utils;
 
 // FIXME: constructed object is not usable
-quantum_platform::quantum_platform() : name("default") {
+quantum_platform::quantum_platform() :
+    name("default"),
+    instruction_map(std::make_shared<const instruction_map_t>()),
+    instruction_index(std::make_shared<const instruction_index_t>(*instruction_map)),
+    instruction_settings(std::make_shared<const Json>()),
+    hardware_settings(std::make_shared<const Json>()),
+    resources(std::make_shared<const Json>()),
+    topology(std::make_shared<const Json>()),
+    aliases(std::make_shared<const Json>())
+{
 }
 
 quantum_platform::quantum_platform(
     const Str &name,
     const Str &configuration_file_name
-) :
-    name(name),
-    configuration_file_name(configuration_file_name)
-{
+) {
+    *this = *get(name, configuration_file_name);
+}
+
+// Platforms loaded earlier in the process (option platform_cache), keyed by
+// name and configuration file name. The hash of the file contents tells
+// whether the file changed since; if so, the platform is loaded again and
+// replaces the cached one.
+struct CachedPlatform {
+    UInt hash;
+    std::shared_ptr<const quantum_platform> platform;
+};
+static std::mutex platform_cache_mutex;
+static Map<Pair<Str, Str>, CachedPlatform> platform_cache;
+
+// FNV-1a hash over the contents of the file; false when it can't be read
+static Bool hash_file(const Str &file_name, UInt &hash) {
+    std::ifstream ifs(file_name, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    hash = 14695981039346656037ull;
+    for (std::istreambuf_iterator<char> it(ifs), end; it != end; ++it) {
+        hash = (hash ^ (unsigned char)*it) * 1099511628211ull;
+    }
+    return !ifs.bad();
+}
+
+std::shared_ptr<const quantum_platform> quantum_platform::get(
+    const Str &name,
+    const Str &configuration_file_name
+) {
+    UInt hash = 0;
+    Bool use_cache = options::get("platform_cache") == "yes" && hash_file(configuration_file_name, hash);
+    Pair<Str, Str> key(name, configuration_file_name);
+    if (use_cache) {
+        std::lock_guard<std::mutex> lock(platform_cache_mutex);
+        auto it = platform_cache.find(key);
+        if (it != platform_cache.end() && it->second.hash == hash) {
+            QL_DOUT("platform '" << name << "' (" << configuration_file_name << ") found in cache");
+            return it->second.platform;
+        }
+    }
+
+    auto platform = std::make_shared<quantum_platform>();
+    platform->name = name;
+    platform->configuration_file_name = configuration_file_name;
+    platform->load();
+
+    if (use_cache) {
+        std::lock_guard<std::mutex> lock(platform_cache_mutex);
+        platform_cache.set(key) = {hash, platform};
+    }
+    return platform;
+}
+
+void quantum_platform::load() {
     hardware_configuration hwc(configuration_file_name);
-    hwc.load(instruction_map, instruction_settings, hardware_settings, resources, topology, aliases);
+    instruction_map_t loaded_instruction_map;
+    Json loaded_instruction_settings, loaded_hardware_settings, loaded_resources, loaded_topology, loaded_aliases;
+    hwc.load(
+        loaded_instruction_map, loaded_instruction_settings, loaded_hardware_settings,
+        loaded_resources, loaded_topology, loaded_aliases
+    );
     eqasm_compiler_name = hwc.eqasm_compiler_name;
+    instruction_map = std::make_shared<const instruction_map_t>(std::move(loaded_instruction_map));
+    instruction_index = std::make_shared<const instruction_index_t>(*instruction_map);
+    instruction_settings = std::make_shared<const Json>(std::move(loaded_instruction_settings));
+    hardware_settings = std::make_shared<const Json>(std::move(loaded_hardware_settings));
+    resources = std::make_shared<const Json>(std::move(loaded_resources));
+    topology = std::make_shared<const Json>(std::move(loaded_topology));
+    aliases = std::make_shared<const Json>(std::move(loaded_aliases));
     QL_DOUT("eqasm_compiler_name= " << eqasm_compiler_name);
 
-    if (hardware_settings.count("qubit_number") <= 0) {
+    if (hardware_settings->count("qubit_number") <= 0) {
         QL_FATAL("qubit number of the platform is not specified in the configuration file !");
     } else {
-        qubit_number = hardware_settings["qubit_number"];
+        qubit_number = (*hardware_settings)["qubit_number"];
     }
 
     // FIXME: add creg_count to JSNN file and platform
 
-    if (hardware_settings.count("cycle_time") <= 0) {
+    if (hardware_settings->count("cycle_time") <= 0) {
         QL_FATAL("cycle time of the platform is not specified in the configuration file !");
     } else {
-        cycle_time = hardware_settings["cycle_time"];
+        cycle_time = (*hardware_settings)["cycle_time"];
+    }
+
+    compile_instruction_attributes();
+}
+
+const UInt quantum_platform::NO_INSTRUCTION;
+const UInt quantum_platform::NO_TYPE;
+
+// source of quantum_platform::instruction_table_id; 0 is never handed out
+static std::atomic<UInt> next_instruction_table_id(1);
+
+// compile instruction_settings into instruction_attributes, checking the types of the fields on the way,
+// and give the gate prototypes in instruction_map their instruction id and opcode
+void quantum_platform::compile_instruction_attributes() {
+    instruction_attributes.clear();
+    instruction_ids.clear();
+    instruction_types.clear();
+    instruction_types.push_back("");
+    Map<Str, UInt> type_ids;
+
+    for (auto it = instruction_settings->cbegin(); it != instruction_settings->cend(); ++it) {
+        const Str &iname = it.key();
+        const Json &settings = it.value();
+        if (!settings.is_object()) {
+            QL_FATAL("JSON file: settings of instruction '" << iname << "' is not an object");
+        }
+
+        instruction_attributes_t attr;
+        attr.name = iname;
+
+        auto type_it = settings.find("type");
+        if (type_it != settings.end() && !type_it->is_null()) {
+            if (!type_it->is_string()) {
+                QL_FATAL("JSON file: field 'type' of instruction '" << iname << "' is not a string");
+            }
+            attr.has_type = true;
+            attr.type = type_it->get<Str>();
+            auto id_it = type_ids.find(attr.type);
+            if (id_it != type_ids.end()) {
+                attr.type_id = id_it->second;
+            } else {
+                attr.type_id = instruction_types.size();
+                type_ids.set(attr.type) = attr.type_id;
+                instruction_types.push_back(attr.type);
+            }
+        }
+
+        auto name_it = settings.find("cc_light_instr");
+        if (name_it != settings.end() && !name_it->is_null()) {
+            if (!name_it->is_string()) {
+                QL_FATAL("JSON file: field 'cc_light_instr' of instruction '" << iname << "' is not a string");
+            }
+            attr.has_cc_light_instr = true;
+            attr.cc_light_instr = name_it->get<Str>();
+        }
+
+        auto latency_it = settings.find("latency");
+        if (latency_it != settings.end()) {
+            if (!latency_it->is_number()) {
+                QL_FATAL("JSON file: field 'latency' of instruction '" << iname << "' is not a number");
+            }
+            attr.has_latency = true;
+            attr.latency = latency_it->get<Real>();
+            attr.latency_cycles = Int(round_away_from_zero(attr.latency / cycle_time));
+        }
+
+        auto duration_it = settings.find("duration");
+        if (duration_it != settings.end()) {
+            if (!duration_it->is_number()) {
+                QL_FATAL("JSON file: field 'duration' of instruction '" << iname << "' is not a number");
+            }
+            attr.has_duration = true;
+            attr.duration = duration_it->get<UInt>();
+            attr.duration_cycles = time_to_cycles(attr.duration);
+        }
+
+        instruction_ids.set(iname) = instruction_attributes.size();
+        instruction_attributes.push_back(attr);
+    }
+
+    instruction_table_id = next_instruction_table_id++;
+    for (auto &ins : *instruction_map) {
+        ins.second->instruction_id = find_instruction_id(ins.second->name);
+        ins.second->instruction_table_id = instruction_table_id;
+        ins.second->get_opcode();   // interned here, so gates copied from the prototype don't need to
     }
 }
 
@@ -48,7 +213,7 @@ void quantum_platform::print_info() const {
     QL_PRINTLN("[+] eqasm compiler     : " << eqasm_compiler_name);
     QL_PRINTLN("[+] configuration file : " << configuration_file_name);
     QL_PRINTLN("[+] supported instructions:");
-    for (const auto &i : instruction_map) {
+    for (const auto &i : *instruction_map) {
         QL_PRINTLN("  |-- " << i.first);
     }
 }
@@ -60,10 +225,10 @@ UInt quantum_platform::get_qubit_number() const {
 // find settings for custom gate, preventing JSON exceptions
 const Json &quantum_platform::find_instruction(const Str &iname) const {
     // search the JSON defined instructions, to prevent JSON exception if key does not exist
-    if (!QL_JSON_EXISTS(instruction_settings, iname)) {
+    if (!QL_JSON_EXISTS(*instruction_settings, iname)) {
         QL_FATAL("JSON file: instruction not found: '" << iname << "'");
     }
-    return instruction_settings[iname];
+    return (*instruction_settings)[iname];
 }
 
 
@@ -80,4 +245,21 @@ UInt quantum_platform::time_to_cycles(Real time_ns) const {
     return ceil(time_ns / cycle_time);
 }
 
+UInt quantum_platform::find_instruction_id(const Str &iname) const {
+    auto it = instruction_ids.find(iname);
+    return it == instruction_ids.end() ? NO_INSTRUCTION : it->second;
+}
+
+UInt quantum_platform::find_instruction_id(const gate *g) const {
+    if (g->instruction_table_id == instruction_table_id && g->instruction_id < instruction_attributes.size()) {
+        return g->instruction_id;
+    }
+    return find_instruction_id(g->name);
+}
+
+const instruction_attributes_t *quantum_platform::find_instruction_attributes(const gate *g) const {
+    UInt id = find_instruction_id(g);
+    return id == NO_INSTRUCTION ? nullptr : &instruction_attributes[id];
+}
+
 } // namespace ql
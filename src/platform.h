@@ -4,13 +4,34 @@
 
 #pragma once
 
+#include <memory>
 #include "utils/num.h"
 #include "utils/str.h"
 #include "utils/json.h"
+#include "utils/vec.h"
+#include "utils/map.h"
 #include "hardware_configuration.h"
 
 namespace ql {
 
+// Attributes of an instruction in the instructions section of the configuration file,
+// compiled once when the platform is constructed so that passes don't need json lookups.
+// Absent or null fields leave the corresponding has_ flag false.
+struct instruction_attributes_t {
+    utils::Str  name;                       // key in instruction_settings
+    utils::Bool has_type = false;
+    utils::Str  type;                       // "mw", "flux", "readout", ...
+    utils::UInt type_id = 0;                // index of type in quantum_platform::instruction_types
+    utils::Bool has_cc_light_instr = false;
+    utils::Str  cc_light_instr;
+    utils::Bool has_latency = false;
+    utils::Real latency = 0.0;              // in [ns]
+    utils::Int  latency_cycles = 0;         // latency rounded away from zero to cycles
+    utils::Bool has_duration = false;
+    utils::UInt duration = 0;               // in [ns]
+    utils::UInt duration_cycles = 0;        // duration rounded up to cycles
+};
+
 class quantum_platform {
 public:
     utils::Str              name;                     // platform name
@@ -18,17 +39,36 @@ public:
     utils::UInt             qubit_number;             // number of qubits
     utils::UInt             cycle_time;               // in [ns]
     utils::Str              configuration_file_name;  // configuration file name
-    instruction_map_t       instruction_map;          // supported operations
-    utils::Json             instruction_settings;     // instruction settings (to use by the eqasm backend)
-    utils::Json             hardware_settings;        // additional hardware settings (to use by the eqasm backend)
+    std::shared_ptr<const instruction_map_t> instruction_map;      // supported operations, shared with the kernels
+    std::shared_ptr<const instruction_index_t> instruction_index;  // index on the keys of instruction_map, shared with the kernels
+
+    // sections of the configuration file; immutable once loaded, and shared by copies of the platform
+    std::shared_ptr<const utils::Json> instruction_settings;  // instruction settings (to use by the eqasm backend)
+    std::shared_ptr<const utils::Json> hardware_settings;     // additional hardware settings (to use by the eqasm backend)
+    std::shared_ptr<const utils::Json> resources;
+    std::shared_ptr<const utils::Json> topology;
+    std::shared_ptr<const utils::Json> aliases;               // workaround the generic instruction composition
 
-    utils::Json             resources;
-    utils::Json             topology;
-    utils::Json             aliases;                  // workaround the generic instruction composition
+    static const utils::UInt NO_INSTRUCTION = utils::MAX;  // instruction id of gates not in instruction_settings
+    static const utils::UInt NO_TYPE = 0;                  // type id of instructions without type
+
+    utils::Vec<instruction_attributes_t> instruction_attributes;  // attributes of each instruction, by instruction id
+    utils::Map<utils::Str, utils::UInt> instruction_ids;          // instruction_settings key to instruction id
+    utils::Vec<utils::Str> instruction_types;                     // type id to type, NO_TYPE is ""
+    utils::UInt instruction_table_id = 0;                         // identifies the table above; see gate::instruction_table_id
 
     // FIXME: constructed object is not usable
     quantum_platform();
     quantum_platform(const utils::Str &name, const utils::Str &configuration_file_name);
+
+    /**
+     * Returns the platform loaded from the given configuration file. With
+     * option platform_cache, platforms are kept for the rest of the process
+     * and handed out again as long as the contents of the file don't change,
+     * instead of parsing the file again. The constructor above uses this too,
+     * so its copies share the instruction map and gates with the cached one.
+     */
+    static std::shared_ptr<const quantum_platform> get(const utils::Str &name, const utils::Str &configuration_file_name);
     void print_info() const;
     utils::UInt get_qubit_number() const;  // FIXME: qubit_number is public anyway
 
@@ -50,6 +90,20 @@ public:
     utils::Str find_instruction_type(const utils::Str &iname) const;
 
     utils::UInt time_to_cycles(utils::Real time_ns) const;
+
+    // instruction id of the instruction with the given instruction_settings key, or NO_INSTRUCTION
+    utils::UInt find_instruction_id(const utils::Str &iname) const;
+
+    // instruction id of the gate, or NO_INSTRUCTION; the id that the gate inherited from its
+    // prototype is used when that prototype belongs to this platform, otherwise it is looked up by name
+    utils::UInt find_instruction_id(const gate *g) const;
+
+    // attributes of the instruction of the gate, or nullptr when it is not in instruction_settings
+    const instruction_attributes_t *find_instruction_attributes(const gate *g) const;
+
+private:
+    void load();
+    void compile_instruction_attributes();
 };
 
 } // namespace ql
@@ -5,6 +5,7 @@
 #include "program.h"
 
 #include "utils/filesystem.h"
+#include "utils/thread_pool.h"
 #include "compiler.h"
 #include "options.h"
 #include "interactionMatrix.h"
@@ -385,6 +386,35 @@ void quantum_program::set_sweep_points(const Real *swpts, UInt size) {
     }
 }
 
+Str quantum_program::for_each_kernel(const std::function<void(quantum_kernel &kernel, StrStrm &stats)> &f) {
+    auto threadsopt = options::get("kernel_threads");
+    UInt nthreads = (threadsopt == "max") ? ThreadPool::hardware_threads() : parse_uint(threadsopt);
+    nthreads = min<UInt>(nthreads, kernels.size());
+
+    Vec<Str> stats(kernels.size());
+    auto context = options::active_context();
+    auto do_kernel = [&](UInt k) {
+        options::Scope scope(context);
+        StrStrm ss;
+        f(kernels[k], ss);
+        stats[k] = ss.str();
+    };
+    if (nthreads > 1) {
+        QL_DOUT("processing " << kernels.size() << " kernels on " << nthreads << " threads");
+        ThreadPool(nthreads).for_each(kernels.size(), do_kernel);
+    } else {
+        for (UInt k = 0; k < kernels.size(); k++) {
+            do_kernel(k);
+        }
+    }
+
+    Str result;
+    for (const auto &s : stats) {
+        result += s;
+    }
+    return result;
+}
+
 Vec<quantum_kernel> &quantum_program::get_kernels() {
     return kernels;
 }
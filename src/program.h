@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include "utils/num.h"
 #include "utils/str.h"
 #include "utils/vec.h"
@@ -61,6 +62,11 @@ public:
     utils::Vec<quantum_kernel> &get_kernels();
     const utils::Vec<quantum_kernel> &get_kernels() const;
 
+    // calls f for each kernel, in parallel on the number of threads given by
+    // option kernel_threads; f can write statistics on the kernel to the given
+    // stream, which are returned concatenated in the order of the kernels
+    utils::Str for_each_kernel(const std::function<void(quantum_kernel &kernel, utils::StrStrm &stats)> &f);
+
 };
 
 } // namespace ql
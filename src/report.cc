@@ -45,118 +45,10 @@ namespace ql {
 using namespace utils;
 
 /*
- * support functions for reporting statistics
+ * support functions for reporting statistics; the counts per kernel are
+ * computed in one pass by quantum_kernel::get_statistics, the latency only needs
+ * the first and last gate and is computed here
  */
-static UInt get_classical_operations_count(
-    const circuit &c,
-    const quantum_platform &platform
-) {
-    UInt classical_operations = 0;
-    // DOUT("... reporting get_classical_operations_count");
-    for (auto &gp : c) {
-        switch (gp->type()) {
-            case __classical_gate__:
-                classical_operations++;
-                break;
-            case __wait_gate__:
-                break;
-            default:    // quantum gate
-                break;
-        }
-    }
-    // DOUT("... reporting get_classical_operations_count [done]");
-    return classical_operations;
-}
-
-static UInt get_non_single_qubit_quantum_gates_count(
-    const circuit &c,
-    const quantum_platform &platform
-) {
-    UInt quantum_gates = 0;
-    // DOUT("... reporting get_non_single_qubit_quantum_gates_count");
-    for (auto &gp : c) {
-        switch (gp->type()) {
-            case __classical_gate__:
-                break;
-            case __wait_gate__:
-                break;
-            default:    // quantum gate
-                if (gp->operands.size() > 1) {
-                    quantum_gates++;
-                }
-                break;
-        }
-    }
-    // DOUT("... reporting get_non_single_qubit_quantum_gates_count [done]");
-    return quantum_gates;
-}
-
-static void get_qubit_usecount(
-    const circuit &c,
-    const quantum_platform &platform,
-    Vec<UInt> &usecount
-) {
-    // DOUT("... reporting get_qubit_usecount");
-    for (auto &gp : c) {
-        switch (gp->type()) {
-            case __classical_gate__:
-            case __wait_gate__:
-                break;
-            default:    // quantum gate
-                for (auto v : gp->operands) {
-                    usecount[v]++;
-                }
-                break;
-        }
-    }
-    // DOUT("... reporting get_qubit_usecount [done]");
-}
-
-static void get_qubit_usedcyclecount(
-    const circuit &c,
-    const quantum_platform &platform,
-    Vec<UInt> &usedcyclecount
-) {
-    UInt  cycle_time = platform.cycle_time;
-
-    // DOUT("... reporting get_qubit_usedcyclecount");
-    for (auto &gp : c) {
-        switch (gp->type()) {
-            case __classical_gate__:
-                break;
-            case __wait_gate__:
-                break;
-            default:    // quantum gate
-                for (auto v : gp->operands) {
-                    usedcyclecount[v] += (gp->duration+cycle_time-1)/cycle_time;
-                }
-                break;
-        }
-    }
-    // DOUT("... reporting get_qubit_usedcyclecount [done]");
-}
-
-static UInt get_quantum_gates_count(
-    const circuit &c,
-    const quantum_platform &platform
-) {
-    UInt quantum_gates = 0;
-    // DOUT("... reporting get_quantum_gates_count");
-    for (auto &gp : c) {
-        switch (gp->type()) {
-            case __classical_gate__:
-                break;
-            case __wait_gate__:
-                break;
-            default:    // quantum gate
-                quantum_gates++;
-                break;
-        }
-    }
-    // DOUT("... reporting get_quantum_gates_count [done]");
-    return quantum_gates;
-}
-
 static UInt get_circuit_latency(
     const circuit &c,
     const quantum_platform &platform
@@ -188,7 +80,7 @@ static void report_write_qasm(
     const quantum_platform &platform
 ) {
     // DOUT("... reporting report_write_qasm");
-    StrStrm out_qasm;
+    OutFile out_qasm(fname);
     out_qasm << "version 1.0\n";
     out_qasm << "# this file has been automatically generated by the OpenQL compiler please do not modify it manually.\n";
     out_qasm << "qubits " << programp->qubit_count << "\n";
@@ -199,17 +91,18 @@ static void report_write_qasm(
     }
     // DOUT("... reporting do_bundles=" << do_bundles);
 
+    // the gates are streamed straight into the file, so no copy of the whole
+    // program is built in memory first
     for (auto &kernel : programp->kernels) {
         if (do_bundles) {
             out_qasm << kernel.get_prologue();
-            ir::bundles_t bundles = ir::bundler(kernel.c, platform.cycle_time);
-            out_qasm << ir::qasm(bundles);
+            ir::write_qasm(out_qasm.unwrap(), kernel.get_bundles());
             out_qasm << kernel.get_epilogue();
         } else {
-            out_qasm << kernel.qasm();
+            kernel.write_qasm(out_qasm.unwrap());
         }
     }
-    OutFile(fname).write(out_qasm.str());
+    out_qasm.close();
     // DOUT("... reporting report_write_qasm [done]");
 }
 
@@ -248,7 +141,7 @@ static void report_write_c(
     const quantum_platform &platform
 ) {
     QL_DOUT("... start writing c file");
-    StrStrm out_c;
+    OutFile out_c(fname);
     out_c << "#pragma ckt 100001\n\
 typedef struct {\n\
     char dummy; /* not accessed */\n\
@@ -274,7 +167,7 @@ void " << programp->name << "(){\n";
         out_c << "rs" << programp->creg_count-1 << ";\n\n";
     }
     
-    for (auto kernel : programp->get_kernels()) {
+    for (auto &kernel : programp->get_kernels()) {
          QL_DOUT("          Kernel name: " << kernel.get_name() << " with type = " << (int)kernel.type);
         
         switch (kernel.type) {
@@ -309,7 +202,7 @@ void " << programp->name << "(){\n";
                 break;
 
             case kernel_type_t::STATIC: {        
-                circuit circ = kernel.get_circuit();
+                const circuit &circ = kernel.get_circuit();
                 for (auto g : circ) {
                     //NOTE-rn: match gate name to an instruction in the config file, otherwise this will fail.
                     UInt p = g->name.find(' ');
@@ -334,8 +227,7 @@ void " << programp->name << "(){\n";
     }
 
     out_c << "}\n";
-    
-    OutFile(fname).write(out_c.str());
+    out_c.close();
     QL_DOUT("... writing c file [done]");
 }
 
@@ -532,23 +424,17 @@ void report_kernel_statistics(
     }
 
     // DOUT("... reporting report_kernel_statistics");
-    Vec<UInt> usecount;
-    usecount.resize(platform.qubit_number, 0);
-    get_qubit_usecount(k.c, platform, usecount);
-    UInt qubits_used = 0; for (auto v: usecount) { if (v != 0) { qubits_used++; } }
-
-    Vec<UInt> usedcyclecount;
-    usedcyclecount.resize(platform.qubit_number, 0);
-    get_qubit_usedcyclecount(k.c, platform, usedcyclecount);
+    kernel_statistics_t stats = k.get_statistics(platform);
+    UInt qubits_used = 0; for (auto v: stats.qubit_usecount) { if (v != 0) { qubits_used++; } }
 
     UInt  circuit_latency = get_circuit_latency(k.c, platform);
     os << comment_prefix << "kernel: " << k.name << "\n";
     os << comment_prefix << "----- circuit_latency: " << circuit_latency << "\n";
-    os << comment_prefix << "----- quantum gates: " << get_quantum_gates_count(k.c, platform) << "\n";
-    os << comment_prefix << "----- non single qubit gates: " << get_non_single_qubit_quantum_gates_count(k.c, platform) << "\n";
-    os << comment_prefix << "----- classical operations: " << get_classical_operations_count(k.c, platform) << "\n";
+    os << comment_prefix << "----- quantum gates: " << stats.quantum_gates << "\n";
+    os << comment_prefix << "----- non single qubit gates: " << stats.non_single_qubit_gates << "\n";
+    os << comment_prefix << "----- classical operations: " << stats.classical_operations << "\n";
     os << comment_prefix << "----- qubits used: " << qubits_used << "\n";
-    os << comment_prefix << "----- qubit cycles use:" << usedcyclecount << "\n";
+    os << comment_prefix << "----- qubit cycles use:" << stats.qubit_usedcyclecount << "\n";
     // DOUT("... reporting report_kernel_statistics [done]");
 }
 
@@ -574,12 +460,15 @@ void report_totals_statistics(
     UInt total_quantum_gates = 0;
     UInt total_non_single_qubit_gates= 0;
     for (auto &k : kernels) {
-        get_qubit_usecount(k.c, platform, usecount);
+        kernel_statistics_t stats = k.get_statistics(platform);
+        for (UInt q = 0; q < usecount.size(); q++) {
+            usecount[q] += stats.qubit_usecount[q];
+        }
 
         total_circuit_latency += get_circuit_latency(k.c, platform);
-        total_classical_operations += get_classical_operations_count(k.c, platform);
-        total_quantum_gates += get_quantum_gates_count(k.c, platform);
-        total_non_single_qubit_gates += get_non_single_qubit_quantum_gates_count(k.c, platform);
+        total_classical_operations += stats.classical_operations;
+        total_quantum_gates += stats.quantum_gates;
+        total_non_single_qubit_gates += stats.non_single_qubit_gates;
     }
     UInt qubits_used = 0; for (auto v: usecount) { if (v != 0) { qubits_used++; } }
 
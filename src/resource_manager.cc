@@ -22,6 +22,20 @@ resource_t::resource_t(
     QL_DOUT("constructing resource: " << n << " for direction (0:fwd,1:bwd): " << dir);
 }
 
+UInt resource_t::next_available(
+    UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    if (available(op_start_cycle, ins, platform)) {
+        return op_start_cycle;
+    }
+    if (forward_scheduling == direction) {
+        return op_start_cycle + 1;
+    }
+    return op_start_cycle > 0 ? op_start_cycle - 1 : 0;
+}
+
 void resource_t::Print(const Str &s) {
     QL_DOUT(s);
     QL_DOUT("resource name=" << name << "; count=" << count);
@@ -97,6 +111,28 @@ void platform_resource_manager_t::reserve(
     // DOUT("all resources reserved for: " << ins->qasm());
 }
 
+// each resource skips the cycles in which it is busy,
+// until all agree on a cycle at which they are available
+utils::UInt platform_resource_manager_t::next_available(
+    utils::UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    utils::UInt cycle = op_start_cycle;
+    utils::Bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto rptr : resource_ptrs) {
+            utils::UInt next_cycle = rptr->next_available(cycle, ins, platform);
+            if (next_cycle != cycle) {
+                cycle = next_cycle;
+                changed = true;
+            }
+        }
+    }
+    return cycle;
+}
+
 // destructor destroying deep resource_t's
 // runs before shallow destruction which is done by synthesized platform_resource_manager_t destructor
 platform_resource_manager_t::~platform_resource_manager_t() {
@@ -172,6 +208,14 @@ void resource_manager_t::reserve(
     platform_resource_manager_ptr->reserve(op_start_cycle, ins, platform);
 }
 
+utils::UInt resource_manager_t::next_available(
+    utils::UInt op_start_cycle,
+    gate *ins,
+    const quantum_platform &platform
+) {
+    return platform_resource_manager_ptr->next_available(op_start_cycle, ins, platform);
+}
+
 // destructor destroying deep platform_resource_managert_t
 // runs before shallow destruction which is done by synthesized resource_manager_t destructor
 resource_manager_t::~resource_manager_t() {
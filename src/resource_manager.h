@@ -30,6 +30,12 @@ public:
     virtual utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) = 0;
     virtual void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform) = 0;
 
+    // return op_start_cycle when the resource is available for ins at op_start_cycle;
+    // otherwise return a later (earlier when scheduling backward) cycle such that the resource is busy for ins
+    // in all cycles from op_start_cycle up to it; by default this is the next cycle,
+    // resources that know how long they will stay busy override this to skip those cycles at once
+    virtual utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
+
     virtual resource_t *clone() const & = 0;
     virtual resource_t *clone() && = 0;
 
@@ -65,6 +71,10 @@ public:
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
 
+    // return the first cycle from op_start_cycle on (going back when scheduling backward)
+    // at which all resources are available for ins
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
+
     // destructor destroying deep resource_t's
     // runs before shallow destruction which is done by synthesized platform_resource_manager_t destructor
     virtual ~platform_resource_manager_t();
@@ -92,6 +102,7 @@ public:
 
     utils::Bool available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
     void reserve(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
+    utils::UInt next_available(utils::UInt op_start_cycle, gate *ins, const quantum_platform &platform);
 
     // destructor destroying deep platform_resource_managert_t
     // runs before shallow destruction which is done by synthesized resource_manager_t destructor
@@ -86,6 +86,8 @@
 
 #include "scheduler.h"
 
+#include <algorithm>
+
 #include "utils/vec.h"
 #include "utils/filesystem.h"
 
@@ -93,26 +95,64 @@ namespace ql {
 
 using namespace utils;
 using ListDigraph = lemon::ListDigraph;
-using ListDigraphPath = lemon::Path<ListDigraph>;
+
+AvailableList::AvailableList() : next_seq(0) {
+}
+
+void AvailableList::clear() {
+    entries.clear();
+    entry_of.clear();
+    next_seq = 0;
+}
+
+Bool AvailableList::empty() const {
+    return entries.empty();
+}
+
+UInt AvailableList::size() const {
+    return entries.size();
+}
+
+Bool AvailableList::contains(UInt node) const {
+    return entry_of.find(node) != entry_of.end();
+}
+
+void AvailableList::insert(UInt node, UInt criticality) {
+    Entry e = {criticality, next_seq, node};
+    entries.insert(e);
+    entry_of.set(node) = e;
+    next_seq++;
+}
+
+void AvailableList::remove(UInt node) {
+    auto it = entry_of.find(node);
+    if (it != entry_of.end()) {
+        entries.erase(it->second);
+        entry_of.erase(it);
+    }
+}
+
+AvailableList::const_iterator AvailableList::begin() const {
+    return const_iterator(entries.begin());
+}
+
+AvailableList::const_iterator AvailableList::end() const {
+    return const_iterator(entries.end());
+}
 
 Scheduler::Scheduler() :
     instruction(graph),
-    name(graph),
     weight(graph),
     opType(graph),
     cause(graph),
-    depType(graph)
+    depType(graph),
+    source_id(0),
+    sink_id(0),
+    graph_required(false),
+    with_graph(false)
 {
 }
 
-// ins->name may contain parameters, so must be stripped first before checking it for gate's name
-void Scheduler::stripname(Str &name) {
-    UInt p = name.find(' ');
-    if (p != Str::npos) {
-        name = name.substr(0,p);
-    }
-}
-
 // Add a dependency between two nodes: from node fromID to node toID
 // the dependence is annotated with the deptype, operandtype and operand for possible transformations and for tracing
 void Scheduler::add_dep(
@@ -123,14 +163,23 @@ void Scheduler::add_dep(
     UInt operand
 ) {
     QL_DOUT(".. adddep ... from fromID " << fromID << " to toID " << toID << "   opnd=" << OperandTypeName[operandType] << "[" << operand << "], dep=" << DepTypeName[deptype]);
-    auto fromNode = graph.nodeFromId(fromID);
-    auto toNode = graph.nodeFromId(toID);
-    auto arc = graph.addArc(fromNode, toNode);
-    weight[arc] = Int(ceil(static_cast<Real>(instruction[fromNode]->duration) / cycle_time));
-    opType[arc] = operandType;
-    cause[arc] = operand;
-    depType[arc] = deptype;
-    QL_DOUT("... dep " << name[fromNode] << " -> " << name[toNode] << " opnd=" << OperandTypeName[opType[arc]] << "[" << cause[arc] << "], dep=" << DepTypeName[depType[arc]] << ", wght=" << weight[arc] << ")");
+    UInt wght = UInt(ceil(static_cast<Real>(node_gate[fromID]->duration) / cycle_time));
+    if (with_graph) {
+        auto arc = graph.addArc(graph.nodeFromId(fromID), graph.nodeFromId(toID));
+        weight[arc] = wght;
+        opType[arc] = operandType;
+        cause[arc] = operand;
+        depType[arc] = deptype;
+    } else {
+        // the arcs into toID are added consecutively, since toID is the node being added
+        arc_source.push_back(fromID);
+        arc_target.push_back(toID);
+        arc_weight.push_back(wght);
+        arc_opType.push_back(operandType);
+        arc_cause.push_back(operand);
+        arc_depType.push_back(deptype);
+    }
+    QL_DOUT("... dep " << node_gate[fromID]->qasm() << " -> " << node_gate[toID]->qasm() << " opnd=" << OperandTypeName[operandType] << "[" << operand << "], dep=" << DepTypeName[deptype] << ", wght=" << wght << ")");
 }
 
 // Signal a new event to the depgraph constructor:
@@ -276,6 +325,92 @@ void Scheduler::new_event(
     }
 }
 
+// add a node for gate gp to the dependency graph and return its id
+UInt Scheduler::add_node(gate *gp) {
+    UInt id = node_gate.size();
+    node_gate.push_back(gp);
+    if (with_graph) {
+        auto n = graph.addNode();
+        QL_ASSERT(graph.id(n) == Int(id));
+        instruction[n] = gp;
+        node.set(gp) = n;
+    } else {
+        in_begin.push_back(arc_source.size());
+    }
+    return id;
+}
+
+// complete the arrays constructed by init when graph was not constructed:
+// put the arcs into each node in the order in which graph would iterate them, i.e. the last added one first,
+// and derive from those the arcs out of each node, also the last added one first
+void Scheduler::finish_arrays() {
+    UInt node_count = node_gate.size();
+    UInt arc_count = arc_source.size();
+    in_begin.push_back(arc_count);
+    for (UInt i = 0; i < node_count; i++) {
+        UInt b = in_begin[i];
+        UInt e = in_begin[i+1];
+        std::reverse(arc_source.begin() + b, arc_source.begin() + e);
+        std::reverse(arc_weight.begin() + b, arc_weight.begin() + e);
+        std::reverse(arc_opType.begin() + b, arc_opType.begin() + e);
+        std::reverse(arc_cause.begin() + b, arc_cause.begin() + e);
+        std::reverse(arc_depType.begin() + b, arc_depType.begin() + e);
+    }
+
+    // count the arcs out of each node, and then fill each node's range visiting all arcs from the last added one
+    out_begin.assign(node_count + 1, 0);
+    for (UInt a = 0; a < arc_count; a++) {
+        out_begin[arc_source[a] + 1]++;
+    }
+    for (UInt i = 0; i < node_count; i++) {
+        out_begin[i + 1] += out_begin[i];
+    }
+    out_arc.resize(arc_count);
+    Vec<UInt> next_out(out_begin.begin(), out_begin.end() - 1);
+    for (UInt i = node_count; i-- > 0; ) {
+        for (UInt a = in_begin[i]; a < in_begin[i+1]; a++) {
+            out_arc[next_out[arc_source[a]]++] = a;
+        }
+    }
+}
+
+// (re)construct the arrays from graph, with the arcs of each node in the order in which graph iterates them;
+// the node ids are those of graph, which are dense because nodes are never erased
+void Scheduler::graph_to_arrays() {
+    UInt node_count = node_gate.size();
+    in_begin.clear();
+    out_begin.clear();
+    out_arc.clear();
+    arc_source.clear();
+    arc_target.clear();
+    arc_weight.clear();
+    arc_opType.clear();
+    arc_cause.clear();
+    arc_depType.clear();
+
+    ListDigraph::ArcMap<UInt> arc_index(graph);
+    for (UInt i = 0; i < node_count; i++) {
+        in_begin.push_back(arc_source.size());
+        for (ListDigraph::InArcIt arc(graph, graph.nodeFromId(i)); arc != lemon::INVALID; ++arc) {
+            arc_index[arc] = arc_source.size();
+            arc_source.push_back(graph.id(graph.source(arc)));
+            arc_target.push_back(i);
+            arc_weight.push_back(weight[arc]);
+            arc_opType.push_back(OperandType(opType[arc]));
+            arc_cause.push_back(cause[arc]);
+            arc_depType.push_back(DepType(depType[arc]));
+        }
+    }
+    in_begin.push_back(arc_source.size());
+    for (UInt i = 0; i < node_count; i++) {
+        out_begin.push_back(out_arc.size());
+        for (ListDigraph::OutArcIt arc(graph, graph.nodeFromId(i)); arc != lemon::INVALID; ++arc) {
+            out_arc.push_back(arc_index[arc]);
+        }
+    }
+    out_begin.push_back(out_arc.size());
+}
+
 // construct the dependency graph ('graph') with nodes from the circuit and adding arcs for their dependencies
 void Scheduler::init(
     circuit &ckt,
@@ -293,6 +428,8 @@ void Scheduler::init(
 
     cycle_time = platform.cycle_time;
     circp = &ckt;
+    with_graph = graph_required || options::get("scheduler_depgraph") == "lemon";
+    QL_DOUT("Scheduler.init: dependence graph as " << (with_graph ? "lemon graph" : "arrays"));
 
     // dependencies are created with a current gate as target
     // and with those previous gates as source that have an operand match with the current gate:
@@ -303,13 +440,12 @@ void Scheduler::init(
     // start filling the dependency graph by creating the s node, the top of the graph
     {
         // add dummy source node
-        auto srcNode = graph.addNode();
-        instruction[srcNode] = new SOURCE();    // so SOURCE is defined as instruction[s], not unique in itself
-        node.set(instruction[srcNode]) = srcNode;
-        name[srcNode] = instruction[srcNode]->qasm();
-        s = srcNode;
+        source_id = add_node(new SOURCE());     // so SOURCE is defined as node_gate[source_id], not unique in itself
+        if (with_graph) {
+            s = graph.nodeFromId(source_id);
+        }
     }
-    Int srcID = graph.id(s);
+    Int srcID = source_id;
 
     // start the state machines, one for each possible operand
     LastQEvent.resize(qubit_count, Default);    // start as if SOURCE gate did Default on all qubit operands
@@ -325,6 +461,9 @@ void Scheduler::init(
     LastBWriter.resize(breg_count, srcID);
     LastBReaders.resize(breg_count);            // start off as empty list, no Breader seen yet
 
+    Bool commute = options::context().scheduler_commute;
+    Bool commute_rotations = options::context().scheduler_commute_rotations;
+
     // for each gate pointer ins in the circuit, add a node and add dependencies on previous gates to it
     for (auto ins : ckt) {
         QL_DOUT("Current instruction's name: `" << ins->name << "'");
@@ -342,15 +481,11 @@ void Scheduler::init(
             QL_DOUT(".. Condition: `" << ins->cond_qasm() << "'");
         }
 
-        auto iname = ins->name; // copy!!!!
-        stripname(iname);
+        // ins->name may contain parameters, so the opcode is that of the name without them
+        UInt opcode = ins->get_opcode();
 
         // Add node
-        ListDigraph::Node currNode = graph.addNode();
-        int currID = graph.id(currNode);
-        instruction[currNode] = ins;
-        node.set(ins) = currNode;
-        name[currNode] = ins->qasm();   // and this includes any condition!
+        int currID = add_node(ins);
 
         // Add edges (arcs)
         // In quantum computing there are no real Reads and Writes on qubits because they cannot be cloned.
@@ -401,8 +536,8 @@ void Scheduler::init(
         }
 
         // each type of gate has a different 'signature' of events; switch out to each one
-        if (iname == "measure") {
-            QL_DOUT(". considering " << name[currNode] << " as measure");
+        if (opcode == opc_measure) {
+            QL_DOUT(". considering " << ins->qasm() << " as measure");
             // Default each qubit operand + Cwrite each classical operand + Bwrite each bit operand
             for (auto operand : ins->operands) {
                 new_event(currID, Qubit, operand, Default, false);
@@ -414,8 +549,8 @@ void Scheduler::init(
                 new_event(currID, Breg, boperand, Bwrite, false);
             }
             QL_DOUT(". measure done");
-        } else if (iname == "display") {
-            QL_DOUT(". considering " << name[currNode] << " as display");
+        } else if (opcode == opc_display) {
+            QL_DOUT(". considering " << ins->qasm() << " as display");
             // no operands, display all qubits, cregs and bregs
             // FIXME: operands should have been added when creating this gate; then this special case would not be needed
             // Default on each qubit operand
@@ -437,58 +572,58 @@ void Scheduler::init(
                 new_event(currID, Breg, boperand, Bwrite, false);
             }
         } else if (ins->type() == gate_type_t::__classical_gate__) {
-            QL_DOUT(". considering " << name[currNode] << " as classical gate");
+            QL_DOUT(". considering " << ins->qasm() << " as classical gate");
             // Cwrite each classical operand
             for (auto coperand : ins->creg_operands) {
                 new_event(currID, Creg, coperand, Cwrite, false);
             }
-        } else if (iname == "cnot") {
-            QL_DOUT(". considering " << name[currNode] << " as cnot");
+        } else if (opcode == opc_cnot) {
+            QL_DOUT(". considering " << ins->qasm() << " as cnot");
             // CNOTs first operand is control and a Zrotate, second operand is target and an Xrotate
             QL_ASSERT(ins->operands.size() == 2);
-            new_event(currID, Qubit, ins->operands[0], Zrotate, options::get("scheduler_commute") == "yes");
-            new_event(currID, Qubit, ins->operands[1], Xrotate, options::get("scheduler_commute") == "yes");
-        } else if (iname == "cz" || iname == "cphase") {
-            QL_DOUT(". considering " << name[currNode] << " as cz");
+            new_event(currID, Qubit, ins->operands[0], Zrotate, commute);
+            new_event(currID, Qubit, ins->operands[1], Xrotate, commute);
+        } else if (opcode == opc_cz || opcode == opc_cphase) {
+            QL_DOUT(". considering " << ins->qasm() << " as cz");
             // CZs operands are both Zrotates
             QL_ASSERT(ins->operands.size() == 2);
-            new_event(currID, Qubit, ins->operands[0], Zrotate, options::get("scheduler_commute") == "yes");
-            new_event(currID, Qubit, ins->operands[1], Zrotate, options::get("scheduler_commute") == "yes");
+            new_event(currID, Qubit, ins->operands[0], Zrotate, commute);
+            new_event(currID, Qubit, ins->operands[1], Zrotate, commute);
         } else if (
-                iname == "rz"
-                || iname == "z"
-                || iname == "pauli_z"
-                || iname == "rz180"
-                || iname == "z90"
-                || iname == "rz90"
-                || iname == "zm90"
-                || iname == "mrz90"
-                || iname == "s"
-                || iname == "sdag"
-                || iname == "t"
-                || iname == "tdag"
+                opcode == opc_rz
+                || opcode == opc_z
+                || opcode == opc_pauli_z
+                || opcode == opc_rz180
+                || opcode == opc_z90
+                || opcode == opc_rz90
+                || opcode == opc_zm90
+                || opcode == opc_mrz90
+                || opcode == opc_s
+                || opcode == opc_sdag
+                || opcode == opc_t
+                || opcode == opc_tdag
             ) {
-            QL_DOUT(". considering " << name[currNode] << " as Z rotation");
+            QL_DOUT(". considering " << ins->qasm() << " as Z rotation");
             // Z rotations on single operand
             QL_ASSERT(ins->operands.size() == 1);
-            new_event(currID, Qubit, ins->operands[0], Zrotate, options::get("scheduler_commute_rotations") == "yes");
+            new_event(currID, Qubit, ins->operands[0], Zrotate, commute_rotations);
         } else if (
-                iname == "rx"
-                || iname == "x"
-                || iname == "pauli_x"
-                || iname == "rx180"
-                || iname == "x90"
-                || iname == "rx90"
-                || iname == "xm90"
-                || iname == "mrx90"
-                || iname == "x45"
+                opcode == opc_rx
+                || opcode == opc_x
+                || opcode == opc_pauli_x
+                || opcode == opc_rx180
+                || opcode == opc_x90
+                || opcode == opc_rx90
+                || opcode == opc_xm90
+                || opcode == opc_mrx90
+                || opcode == opc_x45
             ) {
-            QL_DOUT(". considering " << name[currNode] << " as X rotation");
+            QL_DOUT(". considering " << ins->qasm() << " as X rotation");
             // X rotations on single operand
             QL_ASSERT(ins->operands.size() == 1);
-            new_event(currID, Qubit, ins->operands[0], Xrotate, options::get("scheduler_commute_rotations") == "yes");
+            new_event(currID, Qubit, ins->operands[0], Xrotate, commute_rotations);
         } else {
-            QL_DOUT(". considering " << name[currNode] << " as no special gate (catch-all, generic rules)");
+            QL_DOUT(". considering " << ins->qasm() << " as no special gate (catch-all, generic rules)");
             // Default on each qubit operand
             // Cwrite on each classical operand
             // Bwrite on each bit operand
@@ -509,12 +644,11 @@ void Scheduler::init(
     // finish filling the dependency graph by creating the t node, the bottom of the graph
     {
         // add dummy target node
-        ListDigraph::Node currNode = graph.addNode();
-        int currID = graph.id(currNode);
-        instruction[currNode] = new SINK();    // so SINK is defined as instruction[t], not unique in itself
-        node.set(instruction[currNode]) = currNode;
-        name[currNode] = instruction[currNode]->qasm();
-        t = currNode;
+        int currID = add_node(new SINK());     // so SINK is defined as node_gate[sink_id], not unique in itself
+        sink_id = currID;
+        if (with_graph) {
+            t = graph.nodeFromId(sink_id);
+        }
 
         // add deps to the dummy target node to close the dependency chains
         // it behaves as a Default to every qubit, Cwrite/Bwrite to every creg and breg
@@ -544,6 +678,12 @@ void Scheduler::init(
         }
     }
 
+    if (with_graph) {
+        graph_to_arrays();
+    } else {
+        finish_arrays();
+    }
+
     // when in doubt about dependence graph, enable next line to get a dump of it in debugging output
     DPRINTDepgraph("init");
 
@@ -551,8 +691,9 @@ void Scheduler::init(
     // but when afterwards dependencies are added, cycles may be created,
     // and after doing so (a copy of) this test should certainly be done because
     // a cyclic dependency graph cannot be scheduled;
-    // this test here is a kind of debugging aid whether dependency creation was done well
-    if (!dag(graph)) {
+    // this test here is a kind of debugging aid whether dependency creation was done well;
+    // the arrays constructed by init only have arcs from a lower to a higher node id, so are acyclic anyhow
+    if (with_graph && !dag(graph)) {
         QL_FATAL("The dependency graph is not a DAG.");
     }
     QL_DOUT("dependency graph creation Done.");
@@ -562,16 +703,17 @@ void Scheduler::init(
 void Scheduler::DPRINTDepgraph(const Str &s) const {
     if (logger::log_level >= logger::LogLevel::LOG_DEBUG) {
         std::cout << "Depgraph " << s << std::endl;
-        for (ListDigraph::NodeIt n(graph); n != lemon::INVALID; ++n) {
-            std::cout << "Node " << graph.id(n) << " \"" << name[n] << "\" :" << std::endl;
+        for (UInt n = node_gate.size(); n-- > 0; ) {
+            std::cout << "Node " << n << " \"" << node_gate[n]->qasm() << "\" :" << std::endl;
             std::cout << "    out:";
-            for (ListDigraph::OutArcIt arc(graph,n); arc != lemon::INVALID; ++arc) {
-                std::cout << " Arc(" << graph.id(arc) << "," << DepTypeName[ depType[arc] ] << "," << OperandTypeName[opType[arc]] << "[" << cause[arc] << "])->node(" << graph.id(graph.target(arc)) << ")";
+            for (UInt i = out_begin[n]; i < out_begin[n+1]; i++) {
+                UInt arc = out_arc[i];
+                std::cout << " Arc(" << arc << "," << DepTypeName[ arc_depType[arc] ] << "," << OperandTypeName[arc_opType[arc]] << "[" << arc_cause[arc] << "])->node(" << arc_target[arc] << ")";
             }
             std::cout << std::endl;
             std::cout << "    in:";
-            for (ListDigraph::InArcIt arc(graph,n); arc != lemon::INVALID; ++arc) {
-                std::cout << " Arc(" << graph.id(arc) << "," << DepTypeName[ depType[arc] ] << "," << OperandTypeName[opType[arc]] << "[" << cause[arc] << "])<-node(" << graph.id(graph.source(arc)) << ")";
+            for (UInt arc = in_begin[n]; arc < in_begin[n+1]; arc++) {
+                std::cout << " Arc(" << arc << "," << DepTypeName[ arc_depType[arc] ] << "," << OperandTypeName[arc_opType[arc]] << "[" << arc_cause[arc] << "])<-node(" << arc_source[arc] << ")";
             }
             std::cout << std::endl;
         }
@@ -581,15 +723,36 @@ void Scheduler::DPRINTDepgraph(const Str &s) const {
 
 void Scheduler::print() const {
     QL_COUT("Printing dependency Graph ");
-    digraphWriter(graph).
-        nodeMap("name", name).
-        arcMap("optype", opType).
-        arcMap("cause", cause).
-        arcMap("weight", weight).
-        // arcMap("depType", depType).
-        node("source", s).
-        node("target", t).
-        run();
+    if (with_graph) {
+        ListDigraph::NodeMap<Str> name(graph);
+        for (ListDigraph::NodeIt n(graph); n != lemon::INVALID; ++n) {
+            name[n] = instruction[n]->qasm();
+        }
+        digraphWriter(graph).
+            nodeMap("name", name).
+            arcMap("optype", opType).
+            arcMap("cause", cause).
+            arcMap("weight", weight).
+            // arcMap("depType", depType).
+            node("source", s).
+            node("target", t).
+            run();
+    } else {
+        // similar to the lemon graph format written by digraphWriter
+        std::cout << "@nodes\nlabel\tname\t\n";
+        for (UInt n = node_gate.size(); n-- > 0; ) {
+            std::cout << n << "\t\"" << node_gate[n]->qasm() << "\"\t\n";
+        }
+        std::cout << "@arcs\n\t\tlabel\toptype\tcause\tweight\t\n";
+        for (UInt n = node_gate.size(); n-- > 0; ) {
+            for (UInt i = out_begin[n]; i < out_begin[n+1]; i++) {
+                UInt arc = out_arc[i];
+                std::cout << n << "\t" << arc_target[arc] << "\t" << arc << "\t" << arc_opType[arc]
+                          << "\t" << arc_cause[arc] << "\t" << arc_weight[arc] << "\t\n";
+            }
+        }
+        std::cout << "@attributes\nsource " << source_id << "\ntarget " << sink_id << std::endl;
+    }
 }
 
 void Scheduler::write_dependence_matrix() const {
@@ -597,16 +760,12 @@ void Scheduler::write_dependence_matrix() const {
     Str datfname( options::get("output_dir") + "/dependenceMatrix.dat");
     OutFile fout(datfname);
 
-    UInt totalInstructions = countNodes(graph);
+    UInt totalInstructions = node_gate.size();
     Vec<Vec<Bool> > Matrix(totalInstructions, Vec<Bool>(totalInstructions));
 
     // now print the edges
-    for (ListDigraph::ArcIt arc(graph); arc != lemon::INVALID; ++arc) {
-        auto srcNode = graph.source(arc);
-        auto dstNode = graph.target(arc);
-        UInt srcID = graph.id( srcNode );
-        UInt dstID = graph.id( dstNode );
-        Matrix[srcID][dstID] = true;
+    for (UInt arc = 0; arc < arc_source.size(); arc++) {
+        Matrix[arc_source[arc]][arc_target[arc]] = true;
     }
 
     for (UInt i = 1; i < totalInstructions - 1; i++) {
@@ -627,68 +786,66 @@ void Scheduler::write_dependence_matrix() const {
 // the latter never happens when the depgraph was constructed directly from the circuit
 // but when in between the depgraph was updated (as done in commute_variation),
 // dependences may have been inserted in the opposite circuit direction and then the recursion kicks in
-void Scheduler::set_cycle_gate(gate *gp, scheduling_direction_t dir) {
-    ListDigraph::Node currNode = node.at(gp);
+void Scheduler::set_cycle_gate(UInt n, scheduling_direction_t dir) {
     UInt  currCycle;
     if (forward_scheduling == dir) {
         currCycle = 0;
-        for (ListDigraph::InArcIt arc(graph,currNode); arc != lemon::INVALID; ++arc) {
-            auto nextgp = instruction[graph.source(arc)];
+        for (UInt arc = in_begin[n]; arc < in_begin[n+1]; arc++) {
+            auto nextgp = node_gate[arc_source[arc]];
             if (nextgp->cycle == MAX_CYCLE) {
-                set_cycle_gate(nextgp, dir);
+                set_cycle_gate(arc_source[arc], dir);
             }
-            currCycle = max<UInt>(currCycle, nextgp->cycle + weight[arc]);
+            currCycle = max<UInt>(currCycle, nextgp->cycle + arc_weight[arc]);
         }
     } else {
         currCycle = ALAP_SINK_CYCLE;
-        for (ListDigraph::OutArcIt arc(graph,currNode); arc != lemon::INVALID; ++arc) {
-            auto nextgp = instruction[graph.target(arc)];
+        for (UInt i = out_begin[n]; i < out_begin[n+1]; i++) {
+            UInt arc = out_arc[i];
+            auto nextgp = node_gate[arc_target[arc]];
             if (nextgp->cycle == MAX_CYCLE) {
-                set_cycle_gate(nextgp, dir);
+                set_cycle_gate(arc_target[arc], dir);
             }
-            currCycle = min<UInt>(currCycle, nextgp->cycle - weight[arc]);
+            currCycle = min<UInt>(currCycle, nextgp->cycle - arc_weight[arc]);
         }
     }
-    gp->cycle = currCycle;
-    QL_DOUT("... set_cycle of " << gp->qasm() << " cycles " << gp->cycle);
+    node_gate[n]->cycle = currCycle;
+    QL_DOUT("... set_cycle of " << node_gate[n]->qasm() << " cycles " << currCycle);
 }
 
+// the nodes are visited in id order, which is circuit order;
+// the cycle values don't depend on that order, only the number of recursive calls of set_cycle_gate does
 void Scheduler::set_cycle(scheduling_direction_t dir) {
     // note when iterating that graph contains SOURCE and SINK whereas the circuit doesn't
-    for (ListDigraph::NodeIt n(graph); n != lemon::INVALID; ++n) {
-        instruction[n]->cycle = MAX_CYCLE;       // not yet visited successfully by set_cycle_gate
+    for (auto gp : node_gate) {
+        gp->cycle = MAX_CYCLE;       // not yet visited successfully by set_cycle_gate
     }
     if (forward_scheduling == dir) {
-        set_cycle_gate(instruction[s], dir);
-        for (auto gpit = circp->begin(); gpit != circp->end(); gpit++) {
-            if ((*gpit)->cycle == MAX_CYCLE) {
-                set_cycle_gate(*gpit, dir);
+        set_cycle_gate(source_id, dir);
+        for (UInt n = 0; n < node_gate.size(); n++) {
+            if (node_gate[n]->cycle == MAX_CYCLE) {
+                set_cycle_gate(n, dir);
             }
         }
-        set_cycle_gate(instruction[t], dir);
     } else {
-        set_cycle_gate(instruction[t], dir);
-        for (auto gpit = circp->rbegin(); gpit != circp->rend(); gpit++) {
-            if ((*gpit)->cycle == MAX_CYCLE) {
-                set_cycle_gate(*gpit, dir);
+        set_cycle_gate(sink_id, dir);
+        for (UInt n = node_gate.size(); n-- > 0; ) {
+            if (node_gate[n]->cycle == MAX_CYCLE) {
+                set_cycle_gate(n, dir);
             }
         }
-        set_cycle_gate(instruction[s], dir);
 
         // readjust cycle values of gates so that SOURCE is at 0
-        UInt  SOURCECycle = instruction[s]->cycle;
+        UInt  SOURCECycle = node_gate[source_id]->cycle;
         QL_DOUT("... readjusting cycle values by -" << SOURCECycle);
 
-        instruction[t]->cycle -= SOURCECycle;
-        for (auto &gp : *circp) {
-            gp->cycle -= SOURCECycle;
+        for (auto gp : node_gate) {
+            gp->cycle -= SOURCECycle;           // SOURCE's becomes 0
         }
-        instruction[s]->cycle -= SOURCECycle;   // i.e. becomes 0
     }
 }
 
-static Bool cycle_lessthan(gate *gp1, gate *gp2) {
-    return gp1->cycle < gp2->cycle;
+static Bool cycle_lessthan(const std::pair<UInt, gate*> &cg1, const std::pair<UInt, gate*> &cg2) {
+    return cg1.first < cg2.first;
 }
 
 // sort circuit by the gates' cycle attribute in non-decreasing order
@@ -700,8 +857,17 @@ void Scheduler::sort_by_cycle(circuit *cp) {
     //     DOUT("...... (@" << gp->cycle << ") " << gp->qasm());
     // }
 
-    // std::sort doesn't preserve the original order of elements that have equal values but std::stable_sort does
-    std::stable_sort(cp->begin(), cp->end(), cycle_lessthan);
+    // std::sort doesn't preserve the original order of elements that have equal values but std::stable_sort does;
+    // the cycle values are copied next to the gate pointers to not dereference those in each comparison
+    Vec<std::pair<UInt, gate*>> cycle_gates;
+    cycle_gates.reserve(cp->size());
+    for (auto gp : *cp) {
+        cycle_gates.emplace_back(gp->cycle, gp);
+    }
+    std::stable_sort(cycle_gates.begin(), cycle_gates.end(), cycle_lessthan);
+    for (UInt i = 0; i < cycle_gates.size(); i++) {
+        (*cp)[i] = cycle_gates[i].second;
+    }
 
     QL_DOUT("... after sorting on cycle value");
     // for ( circuit::iterator gpit = cp->begin(); gpit != cp->end(); gpit++)
@@ -717,7 +883,7 @@ void Scheduler::schedule_asap(Str &sched_dot) {
     set_cycle(forward_scheduling);
     sort_by_cycle(circp);
 
-    if (options::get("print_dot_graphs") == "yes") {
+    if (options::context().print_dot_graphs) {
         StrStrm ssdot;
         get_dot(false, true, ssdot);
         sched_dot = ssdot.str();
@@ -732,7 +898,7 @@ void Scheduler::schedule_alap(Str &sched_dot) {
     set_cycle(backward_scheduling);
     sort_by_cycle(circp);
 
-    if (options::get("print_dot_graphs") == "yes") {
+    if (options::context().print_dot_graphs) {
         StrStrm ssdot;
         get_dot(false, true, ssdot);
         sched_dot = ssdot.str();
@@ -745,68 +911,168 @@ void Scheduler::schedule_alap(Str &sched_dot) {
 // it is without RC and depends on direction: forward:ASAP so cycles until SINK, backward:ALAP so cycles until SOURCE;
 // remaining[node] is complementary to node's cycle value,
 // so the implementation below is also a systematically modified copy of that of set_cycle_gate and set_cycle
-void Scheduler::set_remaining_gate(gate* gp, scheduling_direction_t dir) {
-    ListDigraph::Node currNode = node.at(gp);
+void Scheduler::set_remaining_gate(UInt n, scheduling_direction_t dir) {
     UInt currRemain = 0;
-    QL_DOUT("... set_remaining of node " << graph.id(currNode) << ": " << gp->qasm() << " ...");
+    QL_DOUT("... set_remaining of node " << n << ": " << node_gate[n]->qasm() << " ...");
     if (forward_scheduling == dir) {
-        for (ListDigraph::OutArcIt arc(graph,currNode); arc != lemon::INVALID; ++arc) {
-            auto nextNode = graph.target(arc);
-            QL_DOUT("...... target of arc " << graph.id(arc) << " to node " << graph.id(nextNode));
-            if (remaining.at(nextNode) == MAX_CYCLE) {
-                set_remaining_gate(instruction[nextNode], dir);
+        for (UInt i = out_begin[n]; i < out_begin[n+1]; i++) {
+            UInt arc = out_arc[i];
+            UInt nextNode = arc_target[arc];
+            QL_DOUT("...... target of arc " << arc << " to node " << nextNode);
+            if (remaining[nextNode] == MAX_CYCLE) {
+                set_remaining_gate(nextNode, dir);
             }
-            currRemain = max<UInt>(currRemain, remaining.at(nextNode) + weight[arc]);
+            currRemain = max<UInt>(currRemain, remaining[nextNode] + arc_weight[arc]);
         }
     } else {
-        for (ListDigraph::InArcIt arc(graph,currNode); arc != lemon::INVALID; ++arc) {
-            auto nextNode = graph.source(arc);
-            QL_DOUT("...... source of arc " << graph.id(arc) << " from node " << graph.id(nextNode));
-            if (remaining.at(nextNode) == MAX_CYCLE) {
-                set_remaining_gate(instruction[nextNode], dir);
+        for (UInt arc = in_begin[n]; arc < in_begin[n+1]; arc++) {
+            UInt nextNode = arc_source[arc];
+            QL_DOUT("...... source of arc " << arc << " from node " << nextNode);
+            if (remaining[nextNode] == MAX_CYCLE) {
+                set_remaining_gate(nextNode, dir);
             }
-            currRemain = max<UInt>(currRemain, remaining.at(nextNode) + weight[arc]);
+            currRemain = max<UInt>(currRemain, remaining[nextNode] + arc_weight[arc]);
         }
     }
-    remaining.set(currNode) = currRemain;
-    QL_DOUT("... set_remaining of node " << graph.id(currNode) << ": " << gp->qasm() << " remaining " << currRemain);
+    remaining[n] = currRemain;
+    QL_DOUT("... set_remaining of node " << n << ": " << node_gate[n]->qasm() << " remaining " << currRemain);
 }
 
 void Scheduler::set_remaining(scheduling_direction_t dir) {
     // note when iterating that graph contains SOURCE and SINK whereas the circuit doesn't;
-    // regretfully, the order of visiting the nodes while iterating over the graph, is undefined
-    // and in set_remaining (and set_cycle) the order matters (i.e. in circuit order or reversed circuit order)
-    for (ListDigraph::NodeIt n(graph); n != lemon::INVALID; ++n) {
-        remaining.set(n) = MAX_CYCLE;               // not yet visited successfully by set_remaining_gate
-    }
+    // the nodes are visited in (reversed) id order, which is (reversed) circuit order
+    remaining.assign(node_gate.size(), MAX_CYCLE);  // not yet visited successfully by set_remaining_gate
     if (forward_scheduling == dir) {
         // remaining until SINK (i.e. the SINK.cycle-ALAP value)
-        set_remaining_gate(instruction[t], dir);
-        for (auto gpit = circp->rbegin(); gpit != circp->rend(); gpit++) {
-            if (remaining.at(node.at(*gpit)) == MAX_CYCLE) {
-                set_remaining_gate(*gpit, dir);
+        set_remaining_gate(sink_id, dir);
+        for (UInt n = node_gate.size(); n-- > 0; ) {
+            if (remaining[n] == MAX_CYCLE) {
+                set_remaining_gate(n, dir);
             }
         }
-        set_remaining_gate(instruction[s], dir);
     } else {
         // remaining until SOURCE (i.e. the ASAP value)
-        set_remaining_gate(instruction[s], dir);
-        for (auto gpit = circp->begin(); gpit != circp->end(); gpit++) {
-            if (remaining.at(node.at(*gpit)) == MAX_CYCLE) {
-                set_remaining_gate(*gpit, dir);
+        set_remaining_gate(source_id, dir);
+        for (UInt n = 0; n < node_gate.size(); n++) {
+            if (remaining[n] == MAX_CYCLE) {
+                set_remaining_gate(n, dir);
+            }
+        }
+    }
+    set_criticality(dir);
+}
+
+// see the description of deep-criticality in scheduler.h
+void Scheduler::set_criticality(scheduling_direction_t dir) {
+    UInt node_count = node_gate.size();
+    Bool forward = (forward_scheduling == dir);
+
+    // order the nodes such that each comes after its depending nodes (Kahn's algorithm),
+    // then stably on remaining, so that within each group of equal remaining this order is kept
+    Vec<UInt> order;
+    Vec<UInt> pending(node_count);
+    for (UInt n = 0; n < node_count; n++) {
+        pending[n] = forward ? out_begin[n+1] - out_begin[n] : in_begin[n+1] - in_begin[n];
+        if (pending[n] == 0) {
+            order.push_back(n);
+        }
+    }
+    for (UInt i = 0; i < order.size(); i++) {
+        UInt n = order[i];
+        if (forward) {
+            for (UInt arc = in_begin[n]; arc < in_begin[n+1]; arc++) {
+                if (--pending[arc_source[arc]] == 0) {
+                    order.push_back(arc_source[arc]);
+                }
+            }
+        } else {
+            for (UInt i2 = out_begin[n]; i2 < out_begin[n+1]; i2++) {
+                if (--pending[arc_target[out_arc[i2]]] == 0) {
+                    order.push_back(arc_target[out_arc[i2]]);
+                }
+            }
+        }
+    }
+    QL_ASSERT(order.size() == node_count);
+    std::stable_sort(order.begin(), order.end(), [this](UInt n1, UInt n2) { return remaining[n1] < remaining[n2]; });
+
+    criticality.assign(node_count, 0);
+    Vec<Vec<UInt>> key(node_count);     // key of each node in the current group
+    Vec<UInt> seen(node_count, MAX_CYCLE);   // seen[d] == n when d was already counted as depending node of n
+    UInt next_rank = 0;
+    for (UInt first = 0; first < order.size(); ) {
+        UInt group_remaining = remaining[order[first]];
+        UInt last = first;
+        while (last < order.size() && remaining[order[last]] == group_remaining) {
+            last++;
+        }
+
+        for (UInt i = first; i < last; i++) {
+            UInt n = order[i];
+            Vec<UInt> deps;
+            if (forward) {
+                for (UInt i2 = out_begin[n]; i2 < out_begin[n+1]; i2++) {
+                    deps.push_back(arc_target[out_arc[i2]]);
+                }
+            } else {
+                for (UInt arc = in_begin[n]; arc < in_begin[n+1]; arc++) {
+                    deps.push_back(arc_source[arc]);
+                }
+            }
+            if (deps.empty()) {
+                key[n] = {0};
+                continue;
+            }
+            UInt max_remaining = 0;
+            for (auto d : deps) {
+                max_remaining = max<UInt>(max_remaining, remaining[d]);
+            }
+            UInt count = 0;
+            UInt best = MAX_CYCLE;
+            for (auto d : deps) {
+                if (remaining[d] != max_remaining || seen[d] == n) {
+                    continue;
+                }
+                seen[d] = n;    // dependences that are duplicates for the scheduler are counted once
+                count++;
+                if (
+                    best == MAX_CYCLE
+                    || (max_remaining < group_remaining && criticality[best] < criticality[d])
+                    || (max_remaining == group_remaining && key[best] < key[d])
+                ) {
+                    best = d;
+                }
+            }
+            key[n] = {1, max_remaining, count};
+            if (max_remaining < group_remaining) {
+                key[n].push_back(criticality[best]);
+            } else {
+                key[n].insert(key[n].end(), key[best].begin(), key[best].end());
             }
         }
-        set_remaining_gate(instruction[t], dir);
+
+        std::sort(order.begin() + first, order.begin() + last, [&key](UInt n1, UInt n2) { return key[n1] < key[n2]; });
+        for (UInt i = first; i < last; i++) {
+            if (i > first && key[order[i-1]] < key[order[i]]) {
+                next_rank++;
+            }
+            criticality[order[i]] = next_rank;
+        }
+        next_rank++;
+        for (UInt i = first; i < last; i++) {
+            Vec<UInt>().swap(key[order[i]]);
+        }
+        first = last;
     }
 }
 
-gate *Scheduler::find_mostcritical(List<gate*> &lg) {
+gate *Scheduler::find_mostcritical(const List<UInt> &ln) {
     UInt maxRemain = 0;
     gate *mostCriticalGate = nullptr;
-    for (auto gp : lg) {
-        UInt gr = remaining.at(node.at(gp));
+    for (auto n : ln) {
+        UInt gr = remaining[n];
         if (gr > maxRemain) {
-            mostCriticalGate = gp;
+            mostCriticalGate = node_gate[n];
             maxRemain = gr;
         }
     }
@@ -817,112 +1083,32 @@ gate *Scheduler::find_mostcritical(List<gate*> &lg) {
 // Set the curr_cycle of the scheduling algorithm to start at the appropriate end as well;
 // note that the cycle attributes will be shifted down to start at 1 after backward scheduling.
 void Scheduler::init_available(
-    List<ListDigraph::Node> &avlist,
+    AvailableList &avlist,
     scheduling_direction_t dir,
     UInt &curr_cycle
 ) {
     avlist.clear();
     if (forward_scheduling == dir) {
         curr_cycle = 0;
-        instruction[s]->cycle = curr_cycle;
-        avlist.push_back(s);
+        node_gate[source_id]->cycle = curr_cycle;
+        avlist.insert(source_id, criticality[source_id]);
     } else {
         curr_cycle = ALAP_SINK_CYCLE;
-        instruction[t]->cycle = curr_cycle;
-        avlist.push_back(t);
-    }
-}
-
-// collect the list of directly depending nodes
-// (i.e. those necessarily scheduled after the given node) without duplicates;
-// dependencies that are duplicates from the perspective of the scheduler
-// may be present in the dependency graph because the scheduler ignores dependency type and cause
-void Scheduler::get_depending_nodes(
-    ListDigraph::Node n,
-    scheduling_direction_t dir,
-    List<ListDigraph::Node> &ln
-) {
-    if (forward_scheduling == dir) {
-        for (ListDigraph::OutArcIt succArc(graph,n); succArc != lemon::INVALID; ++succArc) {
-            auto succNode = graph.target(succArc);
-            // DOUT("...... succ of " << instruction[n]->qasm() << " : " << instruction[succNode]->qasm());
-            Bool found = false;             // filter out duplicates
-            for (auto anySuccNode : ln) {
-                if (succNode == anySuccNode) {
-                    // DOUT("...... duplicate: " << instruction[succNode]->qasm());
-                    found = true;           // duplicate found
-                }
-            }
-            if (!found) {                   // found new one
-                ln.push_back(succNode);     // new node to ln
-            }
-        }
-        // ln contains depending nodes of n without duplicates
-    } else {
-        for (ListDigraph::InArcIt predArc(graph,n); predArc != lemon::INVALID; ++predArc) {
-            ListDigraph::Node predNode = graph.source(predArc);
-            // DOUT("...... pred of " << instruction[n]->qasm() << " : " << instruction[predNode]->qasm());
-            Bool found = false;             // filter out duplicates
-            for (auto anyPredNode : ln) {
-                if (predNode == anyPredNode) {
-                    // DOUT("...... duplicate: " << instruction[predNode]->qasm());
-                    found = true;           // duplicate found
-                }
-            }
-            if (!found) {                   // found new one
-                ln.push_back(predNode);     // new node to ln
-            }
-        }
-        // ln contains depending nodes of n without duplicates
+        node_gate[sink_id]->cycle = curr_cycle;
+        avlist.insert(sink_id, criticality[sink_id]);
     }
 }
 
 // Compute of two nodes whether the first one is less deep-critical than the second, for the given scheduling direction;
-// criticality of a node is given by its remaining[node] value which is precomputed;
-// deep-criticality takes into account the criticality of depending nodes (in the right direction!);
-// this function is used to order the avlist in an order from highest deep-criticality to lowest deep-criticality;
+// deep-criticality is precomputed by set_criticality (called by set_remaining) as a rank per node;
+// this is the order of the avlist, from highest deep-criticality to lowest deep-criticality;
 // it is the core of the heuristics of the critical path list scheduler.
 Bool Scheduler::criticality_lessthan(
-    ListDigraph::Node n1,
-    ListDigraph::Node n2,
+    UInt n1,
+    UInt n2,
     scheduling_direction_t dir
-) {
-    if (n1 == n2) return false;             // because not <
-
-    if (remaining.at(n1) < remaining.at(n2)) return true;
-    if (remaining.at(n1) > remaining.at(n2)) return false;
-    // so: remaining[n1] == remaining[n2]
-
-    List<ListDigraph::Node> ln1;
-    List<ListDigraph::Node> ln2;
-
-    get_depending_nodes(n1, dir, ln1);
-    get_depending_nodes(n2, dir, ln2);
-    if (ln2.empty()) return false;          // strictly < only when ln1.empty and ln2.not_empty
-    if (ln1.empty()) return true;           // so when both empty, it is equal, so not strictly <, so false
-    // so: ln1.non_empty && ln2.non_empty
-
-    ln1.sort([this](const ListDigraph::Node &d1, const ListDigraph::Node &d2) { return remaining.at(d1) < remaining.at(d2); });
-    ln2.sort([this](const ListDigraph::Node &d1, const ListDigraph::Node &d2) { return remaining.at(d1) < remaining.at(d2); });
-
-    UInt crit_dep_n1 = remaining.at(ln1.back());    // the last of the list is the one with the largest remaining value
-    UInt crit_dep_n2 = remaining.at(ln2.back());
-
-    if (crit_dep_n1 < crit_dep_n2) return true;
-    if (crit_dep_n1 > crit_dep_n2) return false;
-    // so: crit_dep_n1 == crit_dep_n2, call this crit_dep
-
-    ln1.remove_if([this,crit_dep_n1](ListDigraph::Node n) { return remaining.at(n) < crit_dep_n1; });
-    ln2.remove_if([this,crit_dep_n2](ListDigraph::Node n) { return remaining.at(n) < crit_dep_n2; });
-    // because both contain element with remaining == crit_dep: ln1.non_empty && ln2.non_empty
-
-    if (ln1.size() < ln2.size()) return true;
-    if (ln1.size() > ln2.size()) return false;
-    // so: ln1.size() == ln2.size() >= 1
-
-    ln1.sort([this,dir](const ListDigraph::Node &d1, const ListDigraph::Node &d2) { return criticality_lessthan(d1, d2, dir); });
-    ln2.sort([this,dir](const ListDigraph::Node &d1, const ListDigraph::Node &d2) { return criticality_lessthan(d1, d2, dir); });
-    return criticality_lessthan(ln1.back(), ln2.back(), dir);
+) const {
+    return criticality[n1] < criticality[n2];
 }
 
 // Make node n available
@@ -933,47 +1119,22 @@ Bool Scheduler::criticality_lessthan(
 // avlist is initialized with s or t as first element by init_available
 // avlist is kept ordered on deep-criticality, non-increasing (i.e. highest deep-criticality first)
 void Scheduler::MakeAvailable(
-    ListDigraph::Node n,
-    List<ListDigraph::Node> &avlist,
+    UInt n,
+    AvailableList &avlist,
     scheduling_direction_t dir
 ) {
-    Bool already_in_avlist = false;  // check whether n is already in avlist
-    // originates from having multiple arcs between pair of nodes
-    List<ListDigraph::Node>::iterator first_lower_criticality_inp; // for keeping avlist ordered
-    Bool first_lower_criticality_found = false;                          // for keeping avlist ordered
-
-    QL_DOUT(".... making available node " << name[n] << " remaining: " << remaining.dbg(n));
-    for (auto inp = avlist.begin(); inp != avlist.end(); inp++) {
-        if (*inp == n) {
-            already_in_avlist = true;
-            QL_DOUT("...... duplicate when making available: " << name[n]);
-        } else {
-            // scanning avlist from front to back (avlist is ordered from high to low criticality)
-            // when encountering first node *inp with less criticality,
-            // that is where new node n should be inserted just before,
-            // to keep avlist in desired order
-            //
-            // consequence is that
-            // when a node has same criticality as n, new node n is put after it, as last one of set of same criticality,
-            // so order of calling MakeAvailable (and probably original circuit, and running other scheduler first) matters,
-            // also when all dependency sets (and so remaining values) are identical!
-            if (criticality_lessthan(*inp, n, dir) && !first_lower_criticality_found) {
-                first_lower_criticality_inp = inp;
-                first_lower_criticality_found = true;
-            }
-        }
-    }
-    if (!already_in_avlist) {
-        set_cycle_gate(instruction[n], dir);        // for the schedulers to inspect whether gate has completed
-        if (first_lower_criticality_found) {
-            // add n to avlist just before the first with lower criticality
-            avlist.insert(first_lower_criticality_inp, n);
-        } else {
-            // add n to end of avlist, if none found with less criticality
-            avlist.push_back(n);
-        }
-        QL_DOUT("...... made available node(@" << instruction[n]->cycle << "): " << name[n] << " remaining: " << remaining.dbg(n));
+    // n may already be in avlist when there are multiple arcs between a pair of nodes
+    QL_DOUT(".... making available node " << node_gate[n]->qasm() << " remaining: " << remaining[n]);
+    if (avlist.contains(n)) {
+        QL_DOUT("...... duplicate when making available: " << node_gate[n]->qasm());
+        return;
     }
+    set_cycle_gate(n, dir);        // for the schedulers to inspect whether gate has completed
+    // n is put after all nodes with the same deep-criticality,
+    // so order of calling MakeAvailable (and probably original circuit, and running other scheduler first) matters,
+    // also when all dependency sets (and so remaining values) are identical!
+    avlist.insert(n, criticality[n]);
+    QL_DOUT("...... made available node(@" << node_gate[n]->cycle << "): " << node_gate[n]->qasm() << " remaining: " << remaining[n]);
 }
 
 // take node n out of avlist because it has been scheduled;
@@ -994,21 +1155,20 @@ void Scheduler::MakeAvailable(
 // because from then on that value is compared to the curr_cycle to check
 // whether a node has completed execution and thus is available for scheduling in curr_cycle
 void Scheduler::TakeAvailable(
-    ListDigraph::Node n,
-    List<ListDigraph::Node> &avlist,
-    Map<gate*,Bool> &scheduled,
+    UInt n,
+    AvailableList &avlist,
+    Vec<Bool> &scheduled,
     scheduling_direction_t dir
 ) {
-    scheduled.set(instruction[n]) = true;
+    scheduled[n] = true;
     avlist.remove(n);
 
     if (forward_scheduling == dir) {
-        for (ListDigraph::OutArcIt succArc(graph,n); succArc != lemon::INVALID; ++succArc) {
-            auto succNode = graph.target(succArc);
+        for (UInt i = out_begin[n]; i < out_begin[n+1]; i++) {
+            UInt succNode = arc_target[out_arc[i]];
             Bool schedulable = true;
-            for (ListDigraph::InArcIt predArc(graph,succNode); predArc != lemon::INVALID; ++predArc) {
-                ListDigraph::Node predNode = graph.source(predArc);
-                if (!scheduled.at(instruction[predNode])) {
+            for (UInt predArc = in_begin[succNode]; predArc < in_begin[succNode+1]; predArc++) {
+                if (!scheduled[arc_source[predArc]]) {
                     schedulable = false;
                     break;
                 }
@@ -1018,12 +1178,11 @@ void Scheduler::TakeAvailable(
             }
         }
     } else {
-        for (ListDigraph::InArcIt predArc(graph,n); predArc != lemon::INVALID; ++predArc) {
-            auto predNode = graph.source(predArc);
+        for (UInt predArc = in_begin[n]; predArc < in_begin[n+1]; predArc++) {
+            UInt predNode = arc_source[predArc];
             Bool schedulable = true;
-            for (ListDigraph::OutArcIt succArc(graph,predNode); succArc != lemon::INVALID; ++succArc) {
-                auto succNode = graph.target(succArc);
-                if (!scheduled.at(instruction[succNode])) {
+            for (UInt i = out_begin[predNode]; i < out_begin[predNode+1]; i++) {
+                if (!scheduled[arc_target[out_arc[i]]]) {
                     schedulable = false;
                     break;
                 }
@@ -1036,15 +1195,45 @@ void Scheduler::TakeAvailable(
 }
 
 // advance curr_cycle
-// when no node was selected from the avlist, advance to the next cycle
-// and try again; this makes nodes/instructions to complete execution for one more cycle,
+// when no node was selected from the avlist, advance to the first cycle at which a node in the avlist
+// has its dependent nodes completed and its resources available, and try again;
+// all cycles in between would not change anything, since nothing is scheduled in them;
+// this makes nodes/instructions to complete execution,
 // and makes resources finally available in case of resource constrained scheduling
 // so it contributes to proceeding and to finally have an empty avlist
-void Scheduler::AdvanceCurrCycle(scheduling_direction_t dir, UInt &curr_cycle) {
-    if (forward_scheduling == dir) {
-        curr_cycle++;
+void Scheduler::AdvanceCurrCycle(
+    const AvailableList &avlist,
+    scheduling_direction_t dir,
+    const quantum_platform &platform,
+    arch::resource_manager_t &rm,
+    UInt &curr_cycle
+) {
+    Bool forward = (forward_scheduling == dir);
+    UInt next_cycle = forward ? MAX_CYCLE : 0;
+    for (auto n : avlist) {
+        gate *gp = node_gate[n];
+        UInt cycle;
+        if (forward ? gp->cycle > curr_cycle : gp->cycle < curr_cycle) {
+            cycle = gp->cycle;          // dependent nodes complete at that cycle; resources are checked then
+        } else if (
+            n == source_id || n == sink_id
+            || gp->type() == gate_type_t::__dummy_gate__
+            || gp->type() == gate_type_t::__classical_gate__
+            || gp->type() == gate_type_t::__wait_gate__
+        ) {
+            cycle = curr_cycle;
+        } else {
+            cycle = rm.next_available(curr_cycle, gp, platform);
+        }
+        next_cycle = forward ? min(next_cycle, cycle) : max(next_cycle, cycle);
+    }
+    QL_DOUT("... advancing curr_cycle from " << curr_cycle << " to " << next_cycle);
+
+    // always make progress, also when a resource cannot tell
+    if (forward) {
+        curr_cycle = max(next_cycle, curr_cycle + 1);
     } else {
-        curr_cycle--;
+        curr_cycle = min(next_cycle, curr_cycle - 1);
     }
 }
 
@@ -1053,14 +1242,14 @@ void Scheduler::AdvanceCurrCycle(scheduling_direction_t dir, UInt &curr_cycle) {
 // return true when immediately schedulable
 // when returning false, isres indicates whether resource occupation was the reason or operand completion (for debugging)
 Bool Scheduler::immediately_schedulable(
-    ListDigraph::Node n,
+    UInt n,
     scheduling_direction_t dir,
     const UInt curr_cycle,
     const quantum_platform& platform,
     arch::resource_manager_t &rm,
     Bool &isres
 ) {
-    gate *gp = instruction[n];
+    gate *gp = node_gate[n];
     isres = true;
     // have dependent gates completed at curr_cycle?
     if (
@@ -1069,7 +1258,7 @@ Bool Scheduler::immediately_schedulable(
         ) {
         // are resources available?
         if (
-            n == s || n == t
+            n == source_id || n == sink_id
             || gp->type() == gate_type_t::__dummy_gate__
             || gp->type() == gate_type_t::__classical_gate__
             || gp->type() == gate_type_t::__wait_gate__
@@ -1089,8 +1278,8 @@ Bool Scheduler::immediately_schedulable(
 
 // select a node from the avlist
 // the avlist is deep-ordered from high to low criticality (see criticality_lessthan above)
-ListDigraph::Node Scheduler::SelectAvailable(
-    List<ListDigraph::Node> &avlist,
+UInt Scheduler::SelectAvailable(
+    AvailableList &avlist,
     scheduling_direction_t dir,
     const UInt curr_cycle,
     const quantum_platform &platform,
@@ -1101,14 +1290,14 @@ ListDigraph::Node Scheduler::SelectAvailable(
 
     QL_DOUT("avlist(@" << curr_cycle << "):");
     for (auto n : avlist) {
-        QL_DOUT("...... node(@" << instruction[n]->cycle << "): " << name[n] << " remaining: " << remaining.dbg(n));
+        QL_DOUT("...... node(@" << node_gate[n]->cycle << "): " << node_gate[n]->qasm() << " remaining: " << remaining[n]);
     }
 
     // select the first (most critical) immediately schedulable gate that has duration 0
     for (auto n : avlist) {
         Bool isres;
-        if (instruction[n]->duration == 0 && immediately_schedulable(n, dir, curr_cycle, platform, rm, isres)) {
-            QL_DOUT("... node (@" << instruction[n]->cycle << "): " << name[n] << " duration 0 and immediately schedulable, remaining=" << remaining.dbg(n) << ", selected");
+        if (node_gate[n]->duration == 0 && immediately_schedulable(n, dir, curr_cycle, platform, rm, isres)) {
+            QL_DOUT("... node (@" << node_gate[n]->cycle << "): " << node_gate[n]->qasm() << " duration 0 and immediately schedulable, remaining=" << remaining[n] << ", selected");
             success = true;
             return n;
         }
@@ -1118,16 +1307,16 @@ ListDigraph::Node Scheduler::SelectAvailable(
     for (auto n : avlist) {
         Bool isres;
         if (immediately_schedulable(n, dir, curr_cycle, platform, rm, isres)) {
-            QL_DOUT("... node (@" << instruction[n]->cycle << "): " << name[n] << " immediately schedulable, remaining=" << remaining.dbg(n) << ", selected");
+            QL_DOUT("... node (@" << node_gate[n]->cycle << "): " << node_gate[n]->qasm() << " immediately schedulable, remaining=" << remaining[n] << ", selected");
             success = true;
             return n;
         } else {
-            QL_DOUT("... node (@" << instruction[n]->cycle << "): " << name[n] << " remaining=" << remaining.dbg(n) << ", waiting for " << (isres ? "resource" : "dependent completion"));
+            QL_DOUT("... node (@" << node_gate[n]->cycle << "): " << node_gate[n]->qasm() << " remaining=" << remaining[n] << ", waiting for " << (isres ? "resource" : "dependent completion"));
         }
     }
 
     success = false;
-    return s;   // fake return value
+    return source_id;   // fake return value
 }
 
 // ASAP/ALAP scheduler with RC
@@ -1147,41 +1336,39 @@ void Scheduler::schedule(
 ) {
     QL_DOUT("Scheduling " << (forward_scheduling == dir ? "ASAP" : "ALAP") << " with RC ...");
 
-    // scheduled[gp] :=: whether gate *gp has been scheduled, init all false
-    Map<gate*, Bool> scheduled;
-    // avlist :=: list of schedulable nodes, initially (see below) just s or t
-    List<ListDigraph::Node> avlist;
+    // scheduled[n] :=: whether node n has been scheduled, init all false
+    Vec<Bool> scheduled;
+    // avlist :=: list of schedulable nodes, initially (see below) just SOURCE or SINK
+    AvailableList avlist;
 
     // initializations for this scheduler
     // note that dependency graph is not modified by a scheduler, so it can be reused
     QL_DOUT("... initialization");
-    for (ListDigraph::NodeIt n(graph); n != lemon::INVALID; ++n) {
-        scheduled.set(instruction[n]) = false;   // none were scheduled, including SOURCE/SINK
-    }
+    scheduled.assign(node_gate.size(), false);   // none were scheduled, including SOURCE/SINK
     UInt  curr_cycle;         // current cycle for which instructions are sought
+    set_remaining(dir);         // for each gate, number of cycles until end of schedule, and deep-criticality
     init_available(avlist, dir, curr_cycle);     // first node (SOURCE/SINK) is made available and curr_cycle set
-    set_remaining(dir);         // for each gate, number of cycles until end of schedule
 
     QL_DOUT("... loop over avlist until it is empty");
     while (!avlist.empty()) {
         Bool success;
-        ListDigraph::Node selected_node;
+        UInt selected_node;
 
         selected_node = SelectAvailable(avlist, dir, curr_cycle, platform, rm, success);
         if (!success) {
             // i.e. none from avlist was found suitable to schedule in this cycle
-            AdvanceCurrCycle(dir, curr_cycle);
+            AdvanceCurrCycle(avlist, dir, platform, rm, curr_cycle);
             // so try again; eventually instrs complete and machine is empty
             continue;
         }
 
         // commit selected_node to the schedule
-        gate* gp = instruction[selected_node];
+        gate* gp = node_gate[selected_node];
         QL_DOUT("... selected " << gp->qasm() << " in cycle " << curr_cycle);
         gp->cycle = curr_cycle;                     // scheduler result, including s and t
         if (
-            selected_node != s
-            && selected_node != t
+            selected_node != source_id
+            && selected_node != sink_id
             && gp->type() != gate_type_t::__dummy_gate__
             && gp->type() != gate_type_t::__classical_gate__
             && gp->type() != gate_type_t::__wait_gate__
@@ -1197,18 +1384,16 @@ void Scheduler::schedule(
 
     if (dir == backward_scheduling) {
         // readjust cycle values of gates so that SOURCE is at 0
-        UInt SOURCECycle = instruction[s]->cycle;
+        UInt SOURCECycle = node_gate[source_id]->cycle;
         QL_DOUT("... readjusting cycle values by -" << SOURCECycle);
 
-        instruction[t]->cycle -= SOURCECycle;
-        for (auto & gp : *circp) {
-            gp->cycle -= SOURCECycle;
+        for (auto gp : node_gate) {
+            gp->cycle -= SOURCECycle;           // SOURCE's becomes 0
         }
-        instruction[s]->cycle -= SOURCECycle;   // i.e. becomes 0
     }
     // FIXME HvS cycles_valid now
 
-    if (options::get("print_dot_graphs") == "yes") {
+    if (options::context().print_dot_graphs) {
         StrStrm ssdot;
         get_dot(false, true, ssdot);
         sched_dot = ssdot.str();
@@ -1270,7 +1455,7 @@ void Scheduler::schedule_alap_uniform() {
     // SOURCE (node s) is at cycle 0 and the first circuit's gates are at cycle 1.
     // SINK (node t) is at the earliest cycle that all gates/operations have completed.
     set_cycle(forward_scheduling);
-    UInt cycle_count = instruction[t]->cycle - 1;
+    UInt cycle_count = node_gate[sink_id]->cycle - 1;
     // so SOURCE at cycle 0, then all circuit's gates at cycles 1 to cycle_count, and finally SINK at cycle cycle_count+1
 
     // compute remaining which is the opposite of the alap cycle value (remaining[node] :=: SINK->cycle - alapcycle[node])
@@ -1279,11 +1464,13 @@ void Scheduler::schedule_alap_uniform() {
     set_remaining(forward_scheduling);
 
     // DOUT("Creating gates_per_cycle");
-    // create gates_per_cycle[cycle] = for each cycle the list of gates at cycle cycle
+    // create gates_per_cycle[cycle] = for each cycle the list of gates (as node ids) at cycle cycle, in circuit order
     // this is the basic map to be operated upon by the uniforming scheduler below;
-    Map<UInt, List<gate*>> gates_per_cycle;
-    for (auto gp : *circp) {
-        gates_per_cycle.set(gp->cycle).push_back(gp);
+    Map<UInt, List<UInt>> gates_per_cycle;
+    for (UInt n = 0; n < node_gate.size(); n++) {
+        if (n != source_id && n != sink_id) {
+            gates_per_cycle.set(node_gate[n]->cycle).push_back(n);
+        }
     }
 
     // DOUT("Displaying circuit and bundle statistics");
@@ -1347,15 +1534,15 @@ void Scheduler::schedule_alap_uniform() {
             QL_DOUT("pred_cycle=" << pred_cycle);
             QL_DOUT("gates_per_cycle[curr_cycle].size()=" << gates_per_cycle.get(curr_cycle).size());
             UInt min_remaining_cycle = MAX_CYCLE;
-            gate *best_predgp;
+            UInt best_pred_node = source_id;   // only valid when best_predgp_found
             Bool best_predgp_found = false;
 
             // scan bundle at pred_cycle to find suitable candidate to move forward to curr_cycle
-            for (auto predgp : gates_per_cycle.get(pred_cycle)) {
+            for (auto pred_node : gates_per_cycle.get(pred_cycle)) {
                 Bool forward_predgp = true;
                 UInt predgp_completion_cycle;
-                ListDigraph::Node pred_node = node.at(predgp);
-                QL_DOUT("... considering: " << predgp->qasm() << " @cycle=" << predgp->cycle << " remaining=" << remaining.dbg(pred_node));
+                gate *predgp = node_gate[pred_node];
+                QL_DOUT("... considering: " << predgp->qasm() << " @cycle=" << predgp->cycle << " remaining=" << remaining[pred_node]);
 
                 // candidate's result, when moved, must be ready before end-of-circuit and before used
                 predgp_completion_cycle = curr_cycle + UInt(ceil(static_cast<Real>(predgp->duration)/cycle_time));
@@ -1364,8 +1551,8 @@ void Scheduler::schedule_alap_uniform() {
                     forward_predgp = false;
                     QL_DOUT("... ... rejected (after circuit): " << predgp->qasm() << " would complete @" << predgp_completion_cycle << " SINK @" << cycle_count + 1);
                 } else {
-                    for (ListDigraph::OutArcIt arc(graph,pred_node); arc != lemon::INVALID; ++arc) {
-                        gate *target_gp = instruction[graph.target(arc)];
+                    for (UInt i = out_begin[pred_node]; i < out_begin[pred_node+1]; i++) {
+                        gate *target_gp = node_gate[arc_target[out_arc[i]]];
                         UInt target_cycle = target_gp->cycle;
                         if (predgp_completion_cycle > target_cycle) {
                             forward_predgp = false;
@@ -1376,10 +1563,10 @@ void Scheduler::schedule_alap_uniform() {
 
                 // when multiple nodes in bundle qualify, take the one with lowest remaining
                 // because that is the most critical one and thus deserves a cycle as high as possible (ALAP)
-                if (forward_predgp && remaining.at(pred_node) < min_remaining_cycle) {
-                    min_remaining_cycle = remaining.at(pred_node);
+                if (forward_predgp && remaining[pred_node] < min_remaining_cycle) {
+                    min_remaining_cycle = remaining[pred_node];
                     best_predgp_found = true;
-                    best_predgp = predgp;
+                    best_pred_node = pred_node;
                 }
             }
 
@@ -1388,7 +1575,8 @@ void Scheduler::schedule_alap_uniform() {
             if (best_predgp_found) {
                 // move predgp from pred_cycle to curr_cycle;
                 // adjust all bookkeeping that is affected by this
-                gates_per_cycle.at(pred_cycle).remove(best_predgp);
+                gate *best_predgp = node_gate[best_pred_node];
+                gates_per_cycle.at(pred_cycle).remove(best_pred_node);
                 if (gates_per_cycle.at(pred_cycle).empty()) {
                     // source bundle was non-empty, now it is empty
                     non_empty_bundle_count--;
@@ -1398,13 +1586,13 @@ void Scheduler::schedule_alap_uniform() {
                     non_empty_bundle_count++;
                 }
                 best_predgp->cycle = curr_cycle;        // what it is all about
-                gates_per_cycle.set(curr_cycle).push_back(best_predgp);
+                gates_per_cycle.set(curr_cycle).push_back(best_pred_node);
 
                 // recompute targets
                 if (non_empty_bundle_count == 0) break;     // nothing to do
                 avg_gates_per_cycle = Real(gate_count)/curr_cycle;
                 avg_gates_per_non_empty_cycle = Real(gate_count)/non_empty_bundle_count;
-                QL_DOUT("... moved " << best_predgp->qasm() << " with remaining=" << remaining.dbg(node.at(best_predgp))
+                QL_DOUT("... moved " << best_predgp->qasm() << " with remaining=" << remaining[best_pred_node]
                                      << " from cycle=" << pred_cycle << " to cycle=" << curr_cycle
                                      << "; new avg_gates_per_cycle=" << avg_gates_per_cycle
                                      << "; avg_gates_per_non_empty_cycle=" << avg_gates_per_non_empty_cycle
@@ -1462,19 +1650,8 @@ void Scheduler::get_dot(
     std::ostream &dotout
 ) {
     QL_DOUT("Get_dot");
-    ListDigraphPath p;
-    ListDigraph::ArcMap<Bool> isInCritical{graph};
-    if (WithCritical) {
-        for (ListDigraph::ArcIt a(graph); a != lemon::INVALID; ++a) {
-            isInCritical[a] = false;
-            for (ListDigraphPath::ArcIt ap(p); ap != lemon::INVALID; ++ap) {
-                if (a == ap) {
-                    isInCritical[a] = true;
-                    break;
-                }
-            }
-        }
-    }
+    // the critical path is not computed, so with WithCritical no arc is shown as critical
+    Vec<Bool> isInCritical(arc_source.size(), false);
 
     Str NodeStyle(" fontcolor=black, style=filled, fontsize=16");
     Str EdgeStyle1(" color=black");
@@ -1485,10 +1662,10 @@ void Scheduler::get_dot(
            << "\nedge [fontsize=16, arrowhead=vee, arrowsize=0.5];"
            << std::endl;
 
-    // first print the nodes
-    for (ListDigraph::NodeIt n(graph); n != lemon::INVALID; ++n) {
-        dotout  << "\"" << graph.id(n) << "\""
-                << " [label=\" " << name[n] <<" \""
+    // first print the nodes, in the order in which graph iterates them, i.e. the last added one first
+    for (UInt n = node_gate.size(); n-- > 0; ) {
+        dotout  << "\"" << n << "\""
+                << " [label=\" " << node_gate[n]->qasm() <<" \""
                 << NodeStyle
                 << "];" << std::endl;
     }
@@ -1512,36 +1689,41 @@ void Scheduler::get_dot(
         dotout << ";\n}\n";
 
         // Now print ranks, as shown below
-        dotout << "{ rank=same; Cycle" << instruction[s]->cycle <<"; " << graph.id(s) << "; }\n";
+        Map<gate*, UInt> gate_node;
+        for (UInt n = 0; n < node_gate.size(); n++) {
+            gate_node.set(node_gate[n]) = n;
+        }
+        dotout << "{ rank=same; Cycle" << node_gate[source_id]->cycle <<"; " << source_id << "; }\n";
         for (auto gp : *circp) {
-            dotout << "{ rank=same; Cycle" << gp->cycle <<"; " << graph.id(node.at(gp)) << "; }\n";
+            dotout << "{ rank=same; Cycle" << gp->cycle <<"; " << gate_node.at(gp) << "; }\n";
         }
-        dotout << "{ rank=same; Cycle" << instruction[t]->cycle <<"; " << graph.id(t) << "; }\n";
+        dotout << "{ rank=same; Cycle" << node_gate[sink_id]->cycle <<"; " << sink_id << "; }\n";
     }
 
-    // now print the edges
-    for (ListDigraph::ArcIt arc(graph); arc != lemon::INVALID; ++arc) {
-        auto srcNode = graph.source(arc);
-        auto dstNode = graph.target(arc);
-        Int srcID = graph.id( srcNode );
-        Int dstID = graph.id( dstNode );
-
-        if (WithCritical) {
-            EdgeStyle = (isInCritical[arc] == true) ? EdgeStyle2 : EdgeStyle1;
-        }
-
-        dotout << std::dec
-               << "\"" << srcID << "\""
-               << "->"
-               << "\"" << dstID << "\""
-               << "[ label=\""
-               << OperandTypeName[opType[arc]] << "[" << cause[arc] << "]"
-               << " , " << weight[arc]
-               << " , " << DepTypeName[ depType[arc] ]
-               <<"\""
-               << " " << EdgeStyle << " "
-               << "]"
-               << std::endl;
+    // now print the edges, in the order in which graph iterates them
+    for (UInt n = node_gate.size(); n-- > 0; ) {
+        for (UInt i = out_begin[n]; i < out_begin[n+1]; i++) {
+            UInt arc = out_arc[i];
+            UInt srcID = arc_source[arc];
+            UInt dstID = arc_target[arc];
+
+            if (WithCritical) {
+                EdgeStyle = (isInCritical[arc] == true) ? EdgeStyle2 : EdgeStyle1;
+            }
+
+            dotout << std::dec
+                   << "\"" << srcID << "\""
+                   << "->"
+                   << "\"" << dstID << "\""
+                   << "[ label=\""
+                   << OperandTypeName[arc_opType[arc]] << "[" << arc_cause[arc] << "]"
+                   << " , " << arc_weight[arc]
+                   << " , " << DepTypeName[ arc_depType[arc] ]
+                   <<"\""
+                   << " " << EdgeStyle << " "
+                   << "]"
+                   << std::endl;
+        }
     }
 
     dotout << "}" << std::endl;
@@ -1572,7 +1754,7 @@ void schedule_kernel(
     Scheduler sched;
     sched.init(kernel.c, platform, kernel.qubit_count, kernel.creg_count, kernel.breg_count);
 
-    if (options::get("print_dot_graphs") == "yes") {
+    if (options::context().print_dot_graphs) {
         sched.get_dot(dot);
     }
 
@@ -1602,12 +1784,12 @@ void schedule(
         report_qasm(programp, platform, "in", passname);
 
         QL_IOUT("scheduling the quantum program");
-        for (auto &k : programp->kernels) {
+        programp->for_each_kernel([&](quantum_kernel &k, StrStrm &) {
             Str dot;
             Str kernel_sched_dot;
             schedule_kernel(k, platform, dot, kernel_sched_dot);
 
-            if (options::get("print_dot_graphs") == "yes") {
+            if (options::context().print_dot_graphs) {
                 Str fname;
                 fname = options::get("output_dir") + "/" + k.get_name() + "_dependence_graph.dot";
                 QL_IOUT("writing scheduled dot to '" << fname << "' ...");
@@ -1618,7 +1800,7 @@ void schedule(
                 QL_IOUT("writing scheduled dot to '" << fname << "' ...");
                 OutFile(fname).write(kernel_sched_dot);
             }
-        }
+        });
 
         report_statistics(programp, platform, "out", passname, "# ");
         report_qasm(programp, platform, "out", passname);
@@ -1666,7 +1848,7 @@ void rcschedule(
     report_statistics(programp, platform, "in", passname, "# ");
     report_qasm(programp, platform, "in", passname);
 
-    for (auto &kernel : programp->kernels) {
+    programp->for_each_kernel([&](quantum_kernel &kernel, StrStrm &) {
         QL_IOUT("Scheduling kernel: " << kernel.name);
         if (!kernel.c.empty()) {
             auto num_creg = kernel.creg_count;
@@ -1676,14 +1858,14 @@ void rcschedule(
             rcschedule_kernel(kernel, platform, sched_dot, platform.qubit_number, num_creg, num_breg);
             kernel.cycles_valid = true; // FIXME HvS move this back into call to right after sort_cycle
 
-            if (options::get("print_dot_graphs") == "yes") {
+            if (options::context().print_dot_graphs) {
                 StrStrm fname;
                 fname << options::get("output_dir") << "/" << kernel.name << "_" << passname << ".dot";
                 QL_IOUT("writing " << passname << " dependency graph dot file to '" << fname.str() << "' ...");
                 OutFile(fname.str()).write(sched_dot);
             }
         }
-    }
+    });
 
     report_statistics(programp, platform, "out", passname, "# ");
     report_qasm(programp, platform, "out", passname);
@@ -9,9 +9,12 @@
 
 #include "utils/num.h"
 #include "utils/str.h"
+#include "utils/vec.h"
 #include "utils/list.h"
 #include "utils/map.h"
 
+#include <set>
+
 #include <lemon/list_graph.h>
 #include <lemon/lgf_reader.h>
 #include <lemon/lgf_writer.h>
@@ -40,18 +43,65 @@ typedef utils::Vec<utils::Int> ReadersListType;
 enum OperandType {Qubit, Creg, Breg};
 const utils::Str OperandTypeName[] = {"q", "c", "b"};
 
+// The list of available nodes (avlist) of the list schedulers and of the mapper:
+// the nodes that wrt their dependences can be scheduled, by node id, ordered on deep-criticality
+// from high to low (see Scheduler::set_criticality); nodes of equal deep-criticality are ordered
+// on the moment that they became available, first come first.
+// Insertion and removal are O(log n), iteration is in order.
+class AvailableList {
+private:
+    struct Entry {
+        utils::UInt criticality;
+        utils::UInt seq;
+        utils::UInt node;
+        utils::Bool operator<(const Entry &rhs) const {
+            return criticality > rhs.criticality || (criticality == rhs.criticality && seq < rhs.seq);
+        }
+    };
+    std::set<Entry> entries;
+    utils::Map<utils::UInt, Entry> entry_of;        // entry_of[node] == node's entry in entries
+    utils::UInt next_seq;
+
+public:
+    class const_iterator {
+    private:
+        std::set<Entry>::const_iterator it;
+    public:
+        explicit const_iterator(std::set<Entry>::const_iterator it) : it(it) {}
+        utils::UInt operator*() const { return it->node; }
+        const_iterator &operator++() { ++it; return *this; }
+        utils::Bool operator!=(const const_iterator &rhs) const { return it != rhs.it; }
+        utils::Bool operator==(const const_iterator &rhs) const { return it == rhs.it; }
+    };
+
+    AvailableList();
+    void clear();
+    utils::Bool empty() const;
+    utils::UInt size() const;
+    utils::Bool contains(utils::UInt node) const;
+    // add node with given deep-criticality after all nodes with the same or higher deep-criticality
+    void insert(utils::UInt node, utils::UInt criticality);
+    void remove(utils::UInt node);
+    const_iterator begin() const;
+    const_iterator end() const;
+};
+
 class Scheduler {
 public:
     // dependence graph is constructed (see Init) once from the sequence of gates in a kernel's circuit
     // it can be reused as often as needed as long as no gates are added/deleted; it doesn't modify those gates
+    //
+    // it is represented in two ways:
+    // - as a lemon graph ('graph' with the node and arc maps below) which can be modified (see commute_variation);
+    //   this one is only constructed when option scheduler_depgraph is "lemon" or when graph_required is set
+    // - as arrays (see further below) on which the schedulers operate
     lemon::ListDigraph graph;
 
     // conversion between gate* (pointer to the gate in the circuit) and node (of the dependence graph)
     lemon::ListDigraph::NodeMap<gate*> instruction;// instruction[n] == gate*
     utils::Map<gate*, lemon::ListDigraph::Node>  node;// node[gate*] == n
 
-    // attributes
-    lemon::ListDigraph::NodeMap<utils::Str> name;     // name[n] == qasm string
+    // attributes; a node's name is its gate's qasm string, computed only when needed
     lemon::ListDigraph::ArcMap<utils::Int> weight;    // number of cycles of dependence
     lemon::ListDigraph::ArcMap<utils::Int> opType;    // qubit, creg or breg
     lemon::ListDigraph::ArcMap<utils::Int> cause;     // operand index
@@ -60,6 +110,26 @@ public:
     // s and t nodes are the top and bottom of the dependence graph
     lemon::ListDigraph::Node s, t;                     // instruction[s]==SOURCE, instruction[t]==SINK
 
+    // array representation of the dependence graph;
+    // node ids are 0 for SOURCE, 1..n for the n gates in circuit order and n+1 for SINK, as in graph;
+    // the arcs into node i are in_begin[i] .. in_begin[i+1]-1,
+    // the arcs out of node i are out_arc[out_begin[i]] .. out_arc[out_begin[i+1]-1],
+    // both in the order in which graph iterates them, i.e. the last added one first
+    utils::Vec<gate*> node_gate;                    // node_gate[i] == gate*
+    utils::UInt source_id;                          // node_gate[source_id] == SOURCE
+    utils::UInt sink_id;                            // node_gate[sink_id] == SINK
+    utils::Vec<utils::UInt> in_begin;
+    utils::Vec<utils::UInt> out_begin;
+    utils::Vec<utils::UInt> out_arc;
+
+    // arc attributes, indexed by arc
+    utils::Vec<utils::UInt> arc_source;
+    utils::Vec<utils::UInt> arc_target;
+    utils::Vec<utils::UInt> arc_weight;             // number of cycles of dependence
+    utils::Vec<OperandType> arc_opType;             // qubit, creg or breg
+    utils::Vec<utils::UInt> arc_cause;              // operand index
+    utils::Vec<DepType> arc_depType;                // RAW, WAW, ...
+
     // parameters of dependence graph construction
     utils::UInt cycle_time;     // to convert durations to cycles as weight of dependence
     utils::UInt qubit_count;    // number of qubits, to check/represent qubit as cause of dependence
@@ -68,7 +138,14 @@ public:
     circuit *circp;             // current and result circuit, passed from Init to each scheduler
 
     // scheduler support
-    utils::Map<lemon::ListDigraph::Node, utils::UInt>  remaining;  // remaining[node] == cycles until end; critical path representation
+    utils::Vec<utils::UInt>  remaining;  // remaining[node id] == cycles until end; critical path representation
+    utils::Vec<utils::UInt>  criticality;// criticality[node id] == rank of node in deep-criticality, see set_criticality
+
+protected:
+    // whether graph must be constructed regardless of option scheduler_depgraph,
+    // set by extensions that inspect or modify it
+    utils::Bool graph_required;
+
 private:
     // state of the state machine that is used to construct the dependence graph
     // for each OperandType there is a separate type of state machine
@@ -90,9 +167,6 @@ private:
 public:
     Scheduler();
 
-    // name may contain parameters, so must be stripped first before checking it for gate's name
-    static void stripname(utils::Str &name);
-
     // signal the state machine of dependence graph construction to do a step as specified by the parameters;
     // currID is the new node in the graph for the new gate/instruction;
     // the event concerns a particular operand of this gate, with the specified type and index,
@@ -128,11 +202,23 @@ public:
         utils::UInt bcount
     );
 
+    // (re)construct the arrays from graph; to be called after modifying graph
+    void graph_to_arrays();
+
     void DPRINTDepgraph(const utils::Str &s) const;
     void print() const;
     void write_dependence_matrix() const;
 
 private:
+    // whether graph is constructed by init
+    utils::Bool with_graph;
+
+    // add a node for gate gp and return its id
+    utils::UInt add_node(gate *gp);
+
+    // complete the arrays constructed by init when graph was not constructed
+    void finish_arrays();
+
 
 
 // =========== plain schedulers, just ASAP and ALAP, without RC
@@ -172,9 +258,9 @@ public:
 
     // cycle assignment without RC depending on direction: forward:ASAP, backward:ALAP;
     // without RC, this is all there is to schedule, apart from forming the bundles in ir::bundler()
-    // set_cycle iterates over the circuit's gates and set_cycle_gate over the dependences of each gate
-    // please note that set_cycle_gate expects a caller like set_cycle which iterates gp forward through the circuit
-    void set_cycle_gate(gate *gp, scheduling_direction_t dir);
+    // set_cycle iterates over the nodes and set_cycle_gate over the dependences of each node
+    // please note that set_cycle_gate expects a caller like set_cycle which iterates forward through the nodes
+    void set_cycle_gate(utils::UInt n, scheduling_direction_t dir);
     void set_cycle(scheduling_direction_t dir);
 
     // sort circuit by the gates' cycle attribute in non-decreasing order
@@ -210,10 +296,26 @@ public:
     // This means that criticality has become independent of the direction of scheduling
     // which is easier in the core of the scheduler.
 
-    // Note that set_remaining_gate expects a caller like set_remaining that iterates gp backward over the circuit
-    void set_remaining_gate(gate* gp, scheduling_direction_t dir);
+    // Note that set_remaining_gate expects a caller like set_remaining that iterates backward over the nodes;
+    // set_remaining also computes the deep-criticality ranks by calling set_criticality
+    void set_remaining_gate(utils::UInt n, scheduling_direction_t dir);
     void set_remaining(scheduling_direction_t dir);
-    gate* find_mostcritical(utils::List<gate*>& lg);
+    gate* find_mostcritical(const utils::List<utils::UInt>& ln);
+
+    // Deep-criticality of a node takes into account the criticality of depending nodes (in the right direction!):
+    // of two nodes, the one with the higher remaining value is more deep-critical;
+    // when equal, the one without depending nodes is less deep-critical;
+    // when both have depending nodes, the one with the most critical depending node (highest remaining) is more deep-critical;
+    // when equal, the one with the most depending nodes with that highest remaining value is more deep-critical;
+    // when equal, the comparison is decided by the deep-criticality of the most deep-critical of those depending nodes.
+    // This defines a total order with ties, which set_criticality computes as rank per node,
+    // in one pass over the nodes in reverse topological order,
+    // so that the avlist can be kept ordered on it without recursively comparing the depending nodes each time.
+    // Nodes are grouped by remaining value, lowest first; within a group, each node is given a key
+    // of its depending nodes' maximum remaining value, their count and the rank of the most deep-critical one;
+    // when that one is in the same group (a dependence of 0 cycles), its key is included instead of its rank;
+    // the sorted keys make the ranks, which all are higher than those of the previous groups.
+    void set_criticality(scheduling_direction_t dir);
 
     // ASAP/ALAP list scheduling support code with RC
     // Uses an "available list" (avlist) as interface between dependence graph and scheduler
@@ -235,31 +337,20 @@ public:
     // Set the curr_cycle of the scheduling algorithm to start at the appropriate end as well;
     // note that the cycle attributes will be shifted down to start at 1 after backward scheduling.
     void init_available(
-        utils::List<lemon::ListDigraph::Node> &avlist,
+        AvailableList &avlist,
         scheduling_direction_t dir,
         utils::UInt &curr_cycle
     );
 
-    // collect the list of directly depending nodes
-    // (i.e. those necessarily scheduled after the given node) without duplicates;
-    // dependences that are duplicates from the perspective of the scheduler
-    // may be present in the dependence graph because the scheduler ignores dependence type and cause
-    void get_depending_nodes(
-        lemon::ListDigraph::Node n,
-        scheduling_direction_t dir,
-        utils::List<lemon::ListDigraph::Node> &ln
-    );
-
     // Compute of two nodes whether the first one is less deep-critical than the second, for the given scheduling direction;
-    // criticality of a node is given by its remaining[node] value which is precomputed;
-    // deep-criticality takes into account the criticality of depending nodes (in the right direction!);
-    // this function is used to order the avlist in an order from highest deep-criticality to lowest deep-criticality;
+    // deep-criticality is precomputed by set_criticality (called by set_remaining) as a rank per node;
+    // this is the order of the avlist, from highest deep-criticality to lowest deep-criticality;
     // it is the core of the heuristics of the critical path list scheduler.
     utils::Bool criticality_lessthan(
-        lemon::ListDigraph::Node n1,
-        lemon::ListDigraph::Node n2,
+        utils::UInt n1,
+        utils::UInt n2,
         scheduling_direction_t dir
-    );
+    ) const;
 
     // Make node n available
     // add it to the avlist because the condition for that is fulfilled:
@@ -267,10 +358,11 @@ public:
     //  all its successors were scheduled (backward scheduling)
     // update its cycle attribute to reflect these dependences;
     // avlist is initialized with s or t as first element by init_available
-    // avlist is kept ordered on deep-criticality, non-increasing (i.e. highest deep-criticality first)
+    // avlist is kept ordered on deep-criticality, non-increasing (i.e. highest deep-criticality first);
+    // set_remaining must have been called before
     void MakeAvailable(
-        lemon::ListDigraph::Node n,
-        utils::List<lemon::ListDigraph::Node> &avlist,
+        utils::UInt n,
+        AvailableList &avlist,
         scheduling_direction_t dir
     );
 
@@ -292,25 +384,33 @@ public:
     // because from then on that value is compared to the curr_cycle to check
     // whether a node has completed execution and thus is available for scheduling in curr_cycle
     void TakeAvailable(
-        lemon::ListDigraph::Node n,
-        utils::List<lemon::ListDigraph::Node> &avlist,
-        utils::Map<gate*,utils::Bool> &scheduled,
+        utils::UInt n,
+        AvailableList &avlist,
+        utils::Vec<utils::Bool> &scheduled,
         scheduling_direction_t dir
     );
 
     // advance curr_cycle
-    // when no node was selected from the avlist, advance to the next cycle
-    // and try again; this makes nodes/instructions to complete execution for one more cycle,
+    // when no node was selected from the avlist, advance to the first cycle at which a node in the avlist
+    // has its dependent nodes completed and its resources available, and try again;
+    // all cycles in between would not change anything, since nothing is scheduled in them;
+    // this makes nodes/instructions to complete execution,
     // and makes resources finally available in case of resource constrained scheduling
     // so it contributes to proceeding and to finally have an empty avlist
-    static void AdvanceCurrCycle(scheduling_direction_t dir, utils::UInt &curr_cycle);
+    void AdvanceCurrCycle(
+        const AvailableList &avlist,
+        scheduling_direction_t dir,
+        const quantum_platform &platform,
+        arch::resource_manager_t &rm,
+        utils::UInt &curr_cycle
+    );
 
     // a gate must wait until all its operand are available, i.e. the gates having computed them have completed,
     // and must wait until all resources required for the gate's execution are available;
     // return true when immediately schedulable
     // when returning false, isres indicates whether resource occupation was the reason or operand completion (for debugging)
     utils::Bool immediately_schedulable(
-        lemon::ListDigraph::Node n,
+        utils::UInt n,
         scheduling_direction_t dir,
         const utils::UInt curr_cycle,
         const quantum_platform& platform,
@@ -320,8 +420,8 @@ public:
 
     // select a node from the avlist
     // the avlist is deep-ordered from high to low criticality (see criticality_lessthan above)
-    lemon::ListDigraph::Node SelectAvailable(
-        utils::List<lemon::ListDigraph::Node> &avlist,
+    utils::UInt SelectAvailable(
+        AvailableList &avlist,
         scheduling_direction_t dir,
         const utils::UInt curr_cycle,
         const quantum_platform &platform,
@@ -5,6 +5,9 @@
 #include "unitary.h"
 
 #include "utils/exception.h"
+#include "utils/map.h"
+#include "utils/thread_pool.h"
+#include "options.h"
 
 #ifndef WITHOUT_UNITARY_DECOMPOSITION
 #include <Eigen/MatrixFunctions>
@@ -15,6 +18,10 @@
 #endif
 
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
 
 namespace ql {
 
@@ -60,13 +67,28 @@ Bool unitary::is_decompose_support_enabled() {
 
 // JvS: this was originally the class "unitary" itself, but compile times of
 // Eigen are so excessive that I moved it into its own compile unit and
-// provided a wrapper instead. It doesn't actually NEED to be wrapped like
-// this, because the Eigen::Matrix<...> member is actually only used within
-// the scope of a single method (calling other methods), but I'm not touching
-// this code.
+// provided a wrapper instead.
 class UnitaryDecomposer {
 private:
-    Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic> _matrix;
+    // M^k lookup table used by the multicontrolled rotations; points to the
+    // genMk_lookuptable of the top-level decomposer, which is shared by the
+    // decomposers of the independent parts of the decomposition, or to the
+    // static table for small unitaries
+    const Vec<Eigen::MatrixXd> *Mk_lookuptable;
+
+    // thread pool to decompose independent parts of the decomposition with,
+    // or nullptr to decompose them one after the other
+    ThreadPool *pool;
+
+    // constructs a decomposer for an independent part of the decomposition
+    // done by parent
+    explicit UnitaryDecomposer(const UnitaryDecomposer *parent) :
+        Mk_lookuptable(parent->Mk_lookuptable),
+        pool(parent->pool),
+        name(parent->name),
+        is_decomposed(false)
+    {
+    }
 
 public:
     Str name;
@@ -79,14 +101,62 @@ public:
     Bool is_decomposed;
     Vec<Real> instructionlist;
 
-    typedef Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic> complex_matrix;
+    // The decomposition is written for matrices of N x N, where N is either
+    // Eigen::Dynamic, or 2, 4 or 8 for the fast path for 1-, 2- and 3-qubit
+    // unitaries. The latter use fixed-size matrices, which live on the stack
+    // and are vectorized by Eigen for their exact size.
+    template <int N>
+    struct Half {
+        static const int value = N == Eigen::Dynamic ? Eigen::Dynamic : N/2;
+    };
+    template <int N>
+    using Matrix = Eigen::Matrix<Complex, N, N>;
+    template <int N>
+    using Vector = Eigen::Matrix<Complex, N, 1>;
+    template <int N>
+    using RealMatrix = Eigen::Matrix<Real, N, N>;
+    template <int N>
+    using RealVector = Eigen::Matrix<Real, N, 1>;
+
+    // matrix of at most N x N, for blocks of which the size is only known
+    // at runtime
+    template <int N>
+    using MaxMatrix = Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic, 0, N, N>;
+
+    // SVD for blocks of at most N x N; BDCSVD for dynamic matrices, JacobiSVD
+    // for the fast path, which is what BDCSVD falls back to for small
+    // matrices anyway
+    template <int N>
+    using SVD = typename std::conditional<
+        N == Eigen::Dynamic,
+        Eigen::BDCSVD<MaxMatrix<N>>,
+        Eigen::JacobiSVD<MaxMatrix<N>>
+    >::type;
+
+    // unitaries of fewer qubits are always decomposed in the calling thread
+    static const UInt PARALLEL_MIN_QUBITS = 5;
+
+    // the thread pool shared by the decompositions of the process; it is
+    // only replaced when option unitary_decomposition_threads changes, and
+    // decompositions hold on to the pool they started with
+    static std::shared_ptr<ThreadPool> shared_pool(UInt nthreads) {
+        static std::mutex mutex;
+        static std::shared_ptr<ThreadPool> threads;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!threads || threads->size() != nthreads) {
+            threads = std::make_shared<ThreadPool>(nthreads);
+        }
+        return threads;
+    }
 
-    UnitaryDecomposer() : name(""), is_decomposed(false) {}
+    UnitaryDecomposer() : Mk_lookuptable(&genMk_lookuptable), pool(nullptr), name(""), is_decomposed(false) {}
 
     UnitaryDecomposer(
         const Str &name,
         const Vec<Complex> &array
     ) :
+        Mk_lookuptable(&genMk_lookuptable),
+        pool(nullptr),
         name(name),
         array(array),
         is_decomposed(false)
@@ -95,53 +165,69 @@ public:
                   << ", containing: " << array.size() << " elements");
     }
 
-    Real size() const {
-        if (!array.empty()) {
-            return (Real) array.size();
-        } else {
-            return (Real) _matrix.size();
-        }
-    }
-
-    complex_matrix getMatrix() {
-        if (!array.empty()) {
-            Int matrix_size = (Int)sqrt(array.size());
+    void decompose() {
+        QL_DOUT("decomposing Unitary: " << name);
 
-            Eigen::Map<complex_matrix> matrix(array.data(), matrix_size, matrix_size);
-            _matrix = matrix.transpose();
+        // 1-, 2- and 3-qubit unitaries take the fixed-size fast path
+        switch ((Int)sqrt(array.size())) {
+            case 2:
+                decompose_matrix<2>();
+                break;
+            case 4:
+                decompose_matrix<4>();
+                break;
+            case 8:
+                decompose_matrix<8>();
+                break;
+            default: {
+                // the halves of the decomposition of unitaries of
+                // PARALLEL_MIN_QUBITS or more qubits may be decomposed in
+                // parallel; for smaller ones, that costs more than it saves
+                std::shared_ptr<ThreadPool> threads;
+                auto threadsopt = options::get("unitary_decomposition_threads");
+                UInt nthreads = (threadsopt == "max") ? ThreadPool::hardware_threads() : parse_uint(threadsopt);
+                if (nthreads > 1 && array.size() >= (1ull << (2 * PARALLEL_MIN_QUBITS))) {
+                    threads = shared_pool(nthreads);
+                    pool = threads.get();
+                }
+                decompose_matrix<Eigen::Dynamic>();
+                pool = nullptr;
+            }
         }
-        return _matrix;
-    }
 
-    void decompose() {
-        QL_DOUT("decomposing Unitary: " << name);
+        QL_DOUT("Done decomposing");
+        is_decomposed = true;
+    }
 
-        getMatrix();
-        Int matrix_size = _matrix.rows();
+    template <int N>
+    void decompose_matrix() {
+        Int matrix_size = (Int)sqrt(array.size());
+        Matrix<N> matrix = Eigen::Map<Matrix<N>>(array.data(), matrix_size, matrix_size).transpose();
 
         // compute the number of qubits: length of array is collumns*rows, so log2(sqrt(array.size))
         Int numberofbits = uint64_log2(matrix_size);
 
-        Eigen::MatrixXcd identity = Eigen::MatrixXcd::Identity(matrix_size, matrix_size);
-        Eigen::MatrixXcd matmatadjoint = (_matrix.adjoint()*_matrix);
+        Matrix<N> matmatadjoint = (matrix.adjoint()*matrix);
         // very little accuracy because of tests using printed-from-matlab code that does not have many digits after the comma
-        if (!matmatadjoint.isApprox(identity, 0.001)) {
+        if (!matmatadjoint.isApprox(Matrix<N>::Identity(matrix_size, matrix_size), 0.001)) {
             //Throw an error
             QL_EOUT("Unitary " << name <<" is not a unitary matrix!");
 
             throw utils::Exception("Error: Unitary '"+ name+"' is not a unitary matrix. Cannot be decomposed!" + to_string(matmatadjoint), false);
         }
-        // initialize the general M^k lookuptable
-        genMk();
-
-        decomp_function(_matrix, numberofbits); //needed because the matrix is read in columnmajor
+        if (N == Eigen::Dynamic) {
+            // initialize the general M^k lookuptable
+            genMk(numberofbits);
+        } else {
+            Mk_lookuptable = &small_Mk_lookuptable();
+        }
 
-        QL_DOUT("Done decomposing");
-        is_decomposed = true;
+        decomp_function<N>(matrix, numberofbits); //needed because the matrix is read in columnmajor
     }
 
+    template <typename Derived>
     Str to_string(
-        const complex_matrix &m,
+        const Eigen::MatrixBase<Derived> &m,
         const Str &vector_prefix = "",
         const Str &elem_sep = ", "
     ) {
@@ -157,16 +243,31 @@ public:
     // std::chrono::duration<Real> multiplexing_time;
     // std::chrono::duration<Real> demultiplexing_time;
 
-    void decomp_function(const Eigen::Ref<const complex_matrix>& matrix, Int numberofbits) {
+    // the recursion stops at compile time for the 2 x 2 matrices of the fast
+    // path, and at runtime for dynamic matrices
+    template <int N>
+    void decomp_function(const Eigen::Ref<const Matrix<N>> &matrix, Int numberofbits) {
+        decomp_function<N>(matrix, numberofbits, std::integral_constant<bool, N == 2>());
+    }
+
+    template <int N>
+    void decomp_function(const Eigen::Ref<const Matrix<N>> &matrix, Int numberofbits, std::true_type) {
+        zyz_decomp<N>(matrix);
+    }
+
+    template <int N>
+    void decomp_function(const Eigen::Ref<const Matrix<N>> &matrix, Int numberofbits, std::false_type) {
+        static const int H = Half<N>::value;
         QL_DOUT("decomp_function: \n" << to_string(matrix));
         if(numberofbits == 1) {
-            zyz_decomp(matrix);
+            zyz_decomp<N>(matrix);
         } else {
             Int n = matrix.rows()/2;
 
-            complex_matrix V(n,n);
-            complex_matrix W(n,n);
-            Eigen::VectorXcd D(n);
+            Matrix<H> V(n,n);
+            Matrix<H> W(n,n);
+            Vector<H> D;
+            D.resize(n);
             // if q2 is zero, the whole thing is a demultiplexing problem instead of full CSD
             if (matrix.bottomLeftCorner(n,n).isZero(10e-14) && matrix.topRightCorner(n,n).isZero(10e-14)) {
                 QL_DOUT("Optimization: q2 is zero, only demultiplexing will be performed.");
@@ -174,13 +275,11 @@ public:
                 if (matrix.topLeftCorner(n, n).isApprox(matrix.bottomRightCorner(n,n),10e-4)) {
                     QL_DOUT("Optimization: Unitaries are equal, skip one step in the recursion for unitaries of size: " << n << " They are both: " << matrix.topLeftCorner(n, n));
                     instructionlist.push_back(300.0);
-                    decomp_function(matrix.topLeftCorner(n, n), numberofbits-1);
+                    decomp_function<H>(matrix.topLeftCorner(n, n), numberofbits-1);
                 } else {
-                    demultiplexing(matrix.topLeftCorner(n, n), matrix.bottomRightCorner(n,n), V, D, W, numberofbits-1);
+                    demultiplexing<H>(matrix.topLeftCorner(n, n), matrix.bottomRightCorner(n,n), V, D, W, numberofbits-1);
 
-                    decomp_function(W, numberofbits-1);
-                    multicontrolledZ(D, D.rows());
-                    decomp_function(V, numberofbits-1);
+                    decomp_demultiplexed<H>(V, D, W, numberofbits-1);
                 }
             } else if (
                 // Check to see if it the kronecker product of a bigger matrix and the identity matrix.
@@ -194,39 +293,105 @@ public:
                 QL_DOUT("Optimization: last qubit is not affected, skip one step in the recursion.");
                 // Code for last qubit not affected
                 instructionlist.push_back(100.0);
-                decomp_function(matrix(Eigen::seqN(0, n, 2), Eigen::seqN(0, n, 2)), numberofbits-1);
+                decomp_function<H>(matrix(Eigen::seqN(0, n, 2), Eigen::seqN(0, n, 2)), numberofbits-1);
             } else {
-                complex_matrix ss(n,n);
-                complex_matrix L0(n,n);
-                complex_matrix L1(n,n);
-                complex_matrix R0(n,n);
-                complex_matrix R1(n,n);
+                Matrix<H> ss(n,n);
+                Matrix<H> L0(n,n);
+                Matrix<H> L1(n,n);
+                Matrix<H> R0(n,n);
+                Matrix<H> R1(n,n);
                 // auto start = std::chrono::steady_clock::now();
-                CSD(matrix, L0, L1, R0, R1, ss);
+                CSD<N>(matrix, L0, L1, R0, R1, ss);
                 // CSD_time += (std::chrono::steady_clock::now() - start);
-                demultiplexing(R0, R1, V, D, W, numberofbits-1);
-                decomp_function(W, numberofbits-1);
-                multicontrolledZ(D, D.rows());
-                decomp_function(V, numberofbits-1);
+                if (pool && numberofbits >= 3) {
+                    // the demultiplexing of R0,R1 and of L0,L1 and the
+                    // decompositions that follow are independent
+                    decomp_parts({
+                        [&](UnitaryDecomposer &part) {
+                            Matrix<H> V(n,n);
+                            Matrix<H> W(n,n);
+                            Vector<H> D;
+                            D.resize(n);
+                            part.demultiplexing<H>(R0, R1, V, D, W, numberofbits-1);
+                            part.decomp_demultiplexed<H>(V, D, W, numberofbits-1);
+                        },
+                        [&](UnitaryDecomposer &part) {
+                            part.multicontrolledY<H>(ss.diagonal(), n);
+                        },
+                        [&](UnitaryDecomposer &part) {
+                            Matrix<H> V(n,n);
+                            Matrix<H> W(n,n);
+                            Vector<H> D;
+                            D.resize(n);
+                            part.demultiplexing<H>(L0, L1, V, D, W, numberofbits-1);
+                            part.decomp_demultiplexed<H>(V, D, W, numberofbits-1);
+                        }
+                    });
+                } else {
+                    demultiplexing<H>(R0, R1, V, D, W, numberofbits-1);
+                    decomp_demultiplexed<H>(V, D, W, numberofbits-1);
 
-                multicontrolledY(ss.diagonal(), n);
+                    multicontrolledY<H>(ss.diagonal(), n);
 
-                demultiplexing(L0, L1, V, D, W, numberofbits-1);
-                decomp_function(W, numberofbits-1);
-                multicontrolledZ(D, D.rows());
-                decomp_function(V, numberofbits-1);
+                    demultiplexing<H>(L0, L1, V, D, W, numberofbits-1);
+                    decomp_demultiplexed<H>(V, D, W, numberofbits-1);
+                }
             }
         }
     }
 
+    // decomposes the result of a demultiplexing: W, then the multicontrolled
+    // Z rotation for D, then V; W and V are independent of each other
+    template <int N>
+    void decomp_demultiplexed(
+        const Eigen::Ref<const Matrix<N>> &V,
+        const Eigen::Ref<const Vector<N>> &D,
+        const Eigen::Ref<const Matrix<N>> &W,
+        Int numberofbits
+    ) {
+        if (pool && numberofbits >= 2) {
+            decomp_parts({
+                [&](UnitaryDecomposer &part) { part.decomp_function<N>(W, numberofbits); },
+                [&](UnitaryDecomposer &part) { part.multicontrolledZ<N>(D, D.rows()); },
+                [&](UnitaryDecomposer &part) { part.decomp_function<N>(V, numberofbits); }
+            });
+        } else {
+            decomp_function<N>(W, numberofbits);
+            multicontrolledZ<N>(D, D.rows());
+            decomp_function<N>(V, numberofbits);
+        }
+    }
+
+    // runs the given independent parts of the decomposition on the thread
+    // pool, each with its own decomposer, and appends their instructions to
+    // instructionlist in the order of the parts, such that the result is the
+    // same as when the parts would have been run one after the other; the
+    // angles of the last zyz decomposition are taken from the last part,
+    // which always ends with one
+    void decomp_parts(const Vec<std::function<void(UnitaryDecomposer &)>> &parts) {
+        Vec<std::unique_ptr<UnitaryDecomposer>> decomposers(parts.size());
+        pool->for_each(parts.size(), [&](UInt i) {
+            decomposers[i].reset(new UnitaryDecomposer(this));
+            parts[i](*decomposers[i]);
+        });
+        for (const auto &part : decomposers) {
+            instructionlist.insert(instructionlist.end(), part->instructionlist.begin(), part->instructionlist.end());
+        }
+        alpha = decomposers.back()->alpha;
+        beta = decomposers.back()->beta;
+        gamma = decomposers.back()->gamma;
+    }
+
+    template <int N>
     void CSD(
-        const Eigen::Ref<const complex_matrix> &U,
-        Eigen::Ref<complex_matrix> u1,
-        Eigen::Ref<complex_matrix> u2,
-        Eigen::Ref<complex_matrix> v1,
-        Eigen::Ref<complex_matrix> v2,
-        Eigen::Ref<complex_matrix> s
+        const Eigen::Ref<const Matrix<N>> &U,
+        Eigen::Ref<Matrix<Half<N>::value>> u1,
+        Eigen::Ref<Matrix<Half<N>::value>> u2,
+        Eigen::Ref<Matrix<Half<N>::value>> v1,
+        Eigen::Ref<Matrix<Half<N>::value>> v2,
+        Eigen::Ref<Matrix<Half<N>::value>> s
     ) {
+        static const int H = Half<N>::value;
         // auto start = std::chrono::steady_clock::now();
         //Cosine sine decomposition
         // U = [q1, U01] = [u1    ][c  s][v1  ]
@@ -235,7 +400,7 @@ public:
         // complex_matrix c(n,n); // c matrix is not needed for the higher level
         // complex_matrix q1 = U.topLeftCorner(n/2,m/2);
 
-        Eigen::BDCSVD<complex_matrix> svd(n/2,n/2);
+        SVD<H> svd(n/2,n/2);
         svd.compute(U.topLeftCorner(n/2,n/2), Eigen::ComputeThinU | Eigen::ComputeThinV); // possible because it's square anyway
 
 
@@ -243,11 +408,11 @@ public:
         //          q2 = u2*s*v1.adjoint()
         Int p = n/2;
         // complex_matrix z = Eigen::MatrixXd::Identity(p, p).colwise().reverse();
-        complex_matrix c(svd.singularValues().reverse().asDiagonal());
+        Matrix<H> c(svd.singularValues().reverse().asDiagonal());
         u1.noalias() = svd.matrixU().rowwise().reverse();
         v1.noalias() = svd.matrixV().rowwise().reverse(); // Same v as in matlab: u*s*v.adjoint() = q1
 
-        complex_matrix q2 = U.bottomLeftCorner(p,p)*v1;
+        Matrix<H> q2 = U.bottomLeftCorner(p,p)*v1;
 
         Int k = 0;
         for (Int j = 1; j < p; j++) {
@@ -257,24 +422,24 @@ public:
         }
         //complex_matrix b = q2.block( 0,0, p, k+1);
 
-        Eigen::HouseholderQR<complex_matrix> qr(p,k+1);
+        Eigen::HouseholderQR<MaxMatrix<H>> qr(p,k+1);
         qr.compute(q2.block( 0,0, p, k+1));
         u2 = qr.householderQ();
         s.noalias() = u2.adjoint()*q2;
         if (k < p-1) {
             QL_DOUT("k is smaller than size of q1 = "<< p << ", adjustments will be made, k = " << k);
             k = k+1;
-            Eigen::BDCSVD<complex_matrix> svd2(p-k, p-k);
+            SVD<H> svd2(p-k, p-k);
             svd2.compute(s.block(k, k, p-k, p-k), Eigen::ComputeThinU | Eigen::ComputeThinV);
             s.block(k, k, p-k, p-k) = svd2.singularValues().asDiagonal();
             c.block(0,k, p,p-k) = c.block(0,k, p,p-k)*svd2.matrixV();
             u2.block(0,k, p,p-k) = u2.block(0,k, p,p-k)*svd2.matrixU();
             v1.block(0,k, p,p-k) = v1.block(0,k, p,p-k)*svd2.matrixV();
 
-            Eigen::HouseholderQR<complex_matrix> qr2(p-k, p-k);
+            Eigen::HouseholderQR<MaxMatrix<H>> qr2(p-k, p-k);
 
             qr2.compute(c.block(k,k, p-k,p-k));
-            c.block(k,k,p-k,p-k) = qr2.matrixQR().triangularView<Eigen::Upper>();
+            c.block(k,k,p-k,p-k) = qr2.matrixQR().template triangularView<Eigen::Upper>();
             u1.block(0,k, p,p-k) = u1.block(0,k, p,p-k)*qr2.householderQ();
         }
         // CSD_time2 += (std::chrono::steady_clock::now() - start);
@@ -320,8 +485,8 @@ public:
         v1.adjointInPlace(); // Use this instead of = v1.adjoint (to avoid aliasing issues)
         s = -s;
 
-        complex_matrix tmp_s = u1.adjoint()*U.topRightCorner(p,p);
-        complex_matrix tmp_c = u2.adjoint()*U.bottomRightCorner(p,p);
+        Matrix<H> tmp_s = u1.adjoint()*U.topRightCorner(p,p);
+        Matrix<H> tmp_c = u2.adjoint()*U.bottomRightCorner(p,p);
 
         // Vec<Int> c_ind_row;
         // Vec<Int> s_ind_row;
@@ -341,7 +506,7 @@ public:
         // U = [q1, U01] = [u1    ][c  s][v1  ]
         //     [q2, U11] = [    u2][-s c][   v2]
 
-        complex_matrix tmp(n,n);
+        Matrix<N> tmp(n,n);
         tmp.topLeftCorner(p,p) = u1*c*v1;
         tmp.bottomLeftCorner(p,p) = -u2*s*v1;
         tmp.topRightCorner(p,p) = u1*s*v2;
@@ -354,7 +519,8 @@ public:
 
     }
 
-    void zyz_decomp(const Eigen::Ref<const complex_matrix> &matrix) {
+    template <int N>
+    void zyz_decomp(const Eigen::Ref<const Matrix<N>> &matrix) {
         // auto start = std::chrono::steady_clock::now();
 
         Complex det = matrix.determinant();// matrix(0,0)*matrix(1,1)-matrix(1,0)*matrix(0,1);
@@ -385,35 +551,36 @@ public:
         // zyz_time += (std::chrono::steady_clock::now() - start);
     }
 
+    template <int N>
     void demultiplexing(
-        const Eigen::Ref<const complex_matrix> &U1,
-        const Eigen::Ref<const complex_matrix> &U2,
-        Eigen::Ref<complex_matrix> V,
-        Eigen::Ref<Eigen::VectorXcd> D,
-        Eigen::Ref<complex_matrix> W,
+        const Eigen::Ref<const Matrix<N>> &U1,
+        const Eigen::Ref<const Matrix<N>> &U2,
+        Eigen::Ref<Matrix<N>> V,
+        Eigen::Ref<Vector<N>> D,
+        Eigen::Ref<Matrix<N>> W,
         Int numberofcontrolbits
     ) {
         // [U1 0 ]  = [V 0][D 0 ][W 0]
         // [0  U2]    [0 V][0 D*][0 W]
         // auto start = std::chrono::steady_clock::now();
-        complex_matrix check = U1*U2.adjoint();
+        Matrix<N> check = U1*U2.adjoint();
         // complex_matrix D;
         // complex_matrix V;
         // complex_matrix W;
         if (check == check.adjoint()) {
             QL_IOUT("Demultiplexing matrix is self-adjoint()");
-            Eigen::SelfAdjointEigenSolver<Eigen::MatrixXcd> eigslv(check);
-            D.noalias() = ((complex_matrix) eigslv.eigenvalues()).cwiseSqrt();
+            Eigen::SelfAdjointEigenSolver<Matrix<N>> eigslv(check);
+            D.noalias() = eigslv.eigenvalues().template cast<Complex>().cwiseSqrt();
             V.noalias() = eigslv.eigenvectors();
             W.noalias() = D.asDiagonal()*V.adjoint()*U2;
         } else {
             if (numberofcontrolbits < 5) {//schur is faster for small matrices
-                Eigen::ComplexSchur<complex_matrix> decomposition(check);
+                Eigen::ComplexSchur<Matrix<N>> decomposition(check);
                 D.noalias() = decomposition.matrixT().diagonal().cwiseSqrt();
                 V.noalias() = decomposition.matrixU();
                 W.noalias() = D.asDiagonal() * V.adjoint() * U2;
             } else {
-                Eigen::ComplexEigenSolver<complex_matrix> decomposition(check);
+                Eigen::ComplexEigenSolver<Matrix<N>> decomposition(check);
                 D.noalias() = decomposition.eigenvalues().cwiseSqrt();
                 V.noalias() = decomposition.eigenvectors();
                 W.noalias() = D.asDiagonal() * V.adjoint() * U2;
@@ -421,15 +588,15 @@ public:
         }
 
         // demultiplexing_time += (std::chrono::steady_clock::now() - start);
-        if (!(V*V.adjoint()).isApprox(Eigen::MatrixXd::Identity(V.rows(), V.rows()), 10e-3)) {
+        if (!(V*V.adjoint()).isApprox(RealMatrix<N>::Identity(V.rows(), V.rows()), 10e-3)) {
             QL_DOUT("Eigenvalue decomposition incorrect: V is not unitary, adjustments will be made");
-            Eigen::BDCSVD<complex_matrix> svd3(V.block(0,0,V.rows(),2), Eigen::ComputeFullU);
+            SVD<N> svd3(V.block(0,0,V.rows(),2), Eigen::ComputeFullU);
             V.block(0,0,V.rows(),2) = svd3.matrixU();
             svd3.compute(V(Eigen::all,Eigen::seq(Eigen::last-1,Eigen::last)), Eigen::ComputeFullU);
             V(Eigen::all,Eigen::seq(Eigen::last-1,Eigen::last)) = svd3.matrixU();
         }
 
-        complex_matrix Dtemp = D.asDiagonal();
+        Matrix<N> Dtemp = D.asDiagonal();
         if (!U1.isApprox(V*Dtemp*W, 10e-2) || !U2.isApprox(V*Dtemp.adjoint()*W, 10e-2)) {
             QL_EOUT("Demultiplexing not correct!");
             throw utils::Exception("Demultiplexing of unitary '"+ name+"' not correct! Failed at matrix U1: \n"+to_string(U1)+ "and matrix U2: \n" +to_string(U2) + "\nwhile they are: \n" + to_string(V*D.asDiagonal()*W) + "\nand \n" + to_string(V*D.conjugate().asDiagonal()*W), false);
@@ -440,8 +607,7 @@ public:
     Vec<Eigen::MatrixXd> genMk_lookuptable;
 
     // returns M^k = (-1)^(b_(i-1)*g_(i-1)), where * is bitwise inner product, g = binary gray code, b = binary code.
-    void genMk() {
-        Int numberqubits = uint64_log2(_matrix.rows());
+    void genMk(Int numberqubits) {
         for (Int n = 1; n <= numberqubits; n++) {
             Int size=1<<n;
             Eigen::MatrixXd Mk(size,size);
@@ -456,6 +622,16 @@ public:
         // return genMk_lookuptable[numberqubits-1];
     }
 
+    // the M^k lookup table for the fast path, generated once
+    static const Vec<Eigen::MatrixXd> &small_Mk_lookuptable() {
+        static const Vec<Eigen::MatrixXd> lookuptable = [] {
+            UnitaryDecomposer decomposer;
+            decomposer.genMk(3);
+            return decomposer.genMk_lookuptable;
+        }();
+        return lookuptable;
+    }
+
     // source: https://stackoverflow.com/questions/994593/how-to-do-an-integer-log2-in-c user Todd Lehman
     Int uint64_log2(uint64_t n) {
 #define S(k) if (n >= (UINT64_C(1) << k)) { i += k; n >>= k; }
@@ -476,34 +652,38 @@ public:
         }
     }
 
-    void multicontrolledY(const Eigen::Ref<const Eigen::VectorXcd> &ss, Int halfthesizeofthematrix) {
+    template <int N>
+    void multicontrolledY(const Eigen::Ref<const Vector<N>> &ss, Int halfthesizeofthematrix) {
         // auto start = std::chrono::steady_clock::now();
-        Eigen::VectorXd temp =  2*Eigen::asin(ss.array()).real();
-        Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> dec(genMk_lookuptable[uint64_log2(halfthesizeofthematrix)-1]);
-        Eigen::VectorXd tr = dec.solve(temp);
+        RealVector<N> temp =  2*Eigen::asin(ss.array()).real();
+        Eigen::Ref<const RealMatrix<N>> Mk = (*Mk_lookuptable)[uint64_log2(halfthesizeofthematrix)-1];
+        Eigen::CompleteOrthogonalDecomposition<RealMatrix<N>> dec(Mk);
+        RealVector<N> tr = dec.solve(temp);
         // Check is very approximate to account for low-precision input matrices
-        if (!temp.isApprox(genMk_lookuptable[uint64_log2(halfthesizeofthematrix)-1]*tr, 10e-2)) {
+        if (!temp.isApprox(Mk*tr, 10e-2)) {
             QL_EOUT("Multicontrolled Y not correct!");
             throw utils::Exception("Demultiplexing of unitary '"+ name+"' not correct! Failed at demultiplexing of matrix ss: \n"  + to_string(ss), false);
         }
 
-        instructionlist.insert(instructionlist.end(), &tr[0], &tr[halfthesizeofthematrix]);
+        instructionlist.insert(instructionlist.end(), tr.data(), tr.data() + halfthesizeofthematrix);
         // multiplexing_time += std::chrono::steady_clock::now() - start;
     }
 
-    void multicontrolledZ(const Eigen::Ref<const Eigen::VectorXcd> &D, Int halfthesizeofthematrix) {
+    template <int N>
+    void multicontrolledZ(const Eigen::Ref<const Vector<N>> &D, Int halfthesizeofthematrix) {
         // auto start = std::chrono::steady_clock::now();
 
-        Eigen::VectorXd temp =  (Complex(0,-2)*Eigen::log(D.array())).real();
-        Eigen::CompleteOrthogonalDecomposition<Eigen::MatrixXd> dec(genMk_lookuptable[uint64_log2(halfthesizeofthematrix)-1]);
-        Eigen::VectorXd tr = dec.solve(temp);
+        RealVector<N> temp =  (Complex(0,-2)*Eigen::log(D.array())).real();
+        Eigen::Ref<const RealMatrix<N>> Mk = (*Mk_lookuptable)[uint64_log2(halfthesizeofthematrix)-1];
+        Eigen::CompleteOrthogonalDecomposition<RealMatrix<N>> dec(Mk);
+        RealVector<N> tr = dec.solve(temp);
         // Check is very approximate to account for low-precision input matrices
-        if (!temp.isApprox(genMk_lookuptable[uint64_log2(halfthesizeofthematrix)-1]*tr, 10e-2)) {
+        if (!temp.isApprox(Mk*tr, 10e-2)) {
             QL_EOUT("Multicontrolled Z not correct!");
             throw utils::Exception("Demultiplexing of unitary '"+ name+"' not correct! Failed at demultiplexing of matrix D: \n"+ to_string(D), false);
         }
 
-        instructionlist.insert(instructionlist.end(), &tr[0], &tr[halfthesizeofthematrix]);
+        instructionlist.insert(instructionlist.end(), tr.data(), tr.data() + halfthesizeofthematrix);
         // multiplexing_time += std::chrono::steady_clock::now() - start;
 
     }
@@ -514,7 +694,58 @@ public:
     }
 };
 
+// Decomposition results of earlier unitaries, shared by all kernels and
+// programs of the process (option unitary_decomposition_cache). They are keyed
+// by a hash of the matrix elements; the matrix itself is kept to tell apart
+// different matrices with the same hash.
+struct CachedDecomposition {
+    Vec<Complex> array;
+    Vec<Complex> SU;
+    Real alpha;
+    Real beta;
+    Real gamma;
+    Vec<Real> instructionlist;
+};
+static std::mutex decomposition_cache_mutex;
+static Map<UInt, Vec<CachedDecomposition>> decomposition_cache;
+static UInt decomposition_cache_size = 0;
+
+// the cache is simply emptied when it would grow beyond this number of entries
+static const UInt DECOMPOSITION_CACHE_MAX = 1024;
+
+// FNV-1a hash over the bytes of the matrix elements
+static UInt hash_matrix(const Vec<Complex> &array) {
+    UInt h = 14695981039346656037ull;
+    auto bytes = reinterpret_cast<const unsigned char *>(array.data());
+    for (UInt i = 0; i < array.size() * sizeof(Complex); i++) {
+        h = (h ^ bytes[i]) * 1099511628211ull;
+    }
+    return h;
+}
+
 void unitary::decompose() {
+    Bool use_cache = options::get("unitary_decomposition_cache") == "yes";
+    UInt hash = 0;
+    if (use_cache) {
+        hash = hash_matrix(array);
+        std::lock_guard<std::mutex> lock(decomposition_cache_mutex);
+        auto it = decomposition_cache.find(hash);
+        if (it != decomposition_cache.end()) {
+            for (const auto &entry : it->second) {
+                if (entry.array == array) {
+                    QL_DOUT("reusing decomposition of unitary with the same matrix for: " << name);
+                    SU = entry.SU;
+                    alpha = entry.alpha;
+                    beta = entry.beta;
+                    gamma = entry.gamma;
+                    instructionlist = entry.instructionlist;
+                    is_decomposed = true;
+                    return;
+                }
+            }
+        }
+    }
+
     UnitaryDecomposer decomposer(name, array);
     decomposer.decompose();
     SU = decomposer.SU;
@@ -523,6 +754,16 @@ void unitary::decompose() {
     gamma = decomposer.gamma;
     is_decomposed = decomposer.is_decomposed;
     instructionlist = decomposer.instructionlist;
+
+    if (use_cache) {
+        std::lock_guard<std::mutex> lock(decomposition_cache_mutex);
+        if (decomposition_cache_size >= DECOMPOSITION_CACHE_MAX) {
+            decomposition_cache.clear();
+            decomposition_cache_size = 0;
+        }
+        decomposition_cache.set(hash).push_back({array, SU, alpha, beta, gamma, instructionlist});
+        decomposition_cache_size++;
+    }
 }
 
 Bool unitary::is_decompose_support_enabled() {
@@ -0,0 +1,115 @@
+/** \file
+ * Provides a region allocator for many small, long-lived objects.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "utils/num.h"
+#include "utils/vec.h"
+
+namespace ql {
+namespace utils {
+
+/**
+ * Region ("arena") allocator. Objects are constructed in large blocks of
+ * memory by bumping a pointer, so that allocating them costs almost nothing
+ * and objects that are allocated together are close together in memory.
+ * Objects cannot be freed individually; they are all destroyed, in reverse
+ * order of construction, when the arena is destroyed.
+ *
+ * make() may be called from several threads at once, e.g. by passes that run
+ * on kernels in parallel while those kernels, being copies of one another,
+ * share their arena. Destroying the arena is not synchronized.
+ */
+class Arena {
+private:
+
+    /**
+     * Size of the blocks, except for objects that don't fit in one.
+     */
+    static const UInt BLOCK_SIZE = 64 * 1024;
+
+    /**
+     * The blocks of memory, the last one being the one that is allocated from.
+     */
+    Vec<std::unique_ptr<char[]>> blocks;
+
+    /**
+     * Free space in the last block.
+     */
+    char *free_begin = nullptr;
+    char *free_end = nullptr;
+
+    /**
+     * Objects with a nontrivial destructor, with the function destroying them.
+     */
+    Vec<std::pair<void*, void(*)(void*)>> destructors;
+
+    /**
+     * Serializes make().
+     */
+    std::mutex mutex;
+
+    template <class T>
+    static void destroy(void *object) {
+        static_cast<T*>(object)->~T();
+    }
+
+    /**
+     * Returns size bytes of uninitialized memory aligned to align.
+     */
+    void *allocate(UInt size, UInt align) {
+        UInt space = free_end - free_begin;
+        void *p = free_begin;
+        if (!free_begin || !std::align(align, size, p, space)) {
+            UInt block_size = size + align > BLOCK_SIZE ? size + align : BLOCK_SIZE;
+            blocks.emplace_back(new char[block_size]);
+            free_begin = blocks.back().get();
+            free_end = free_begin + block_size;
+            space = block_size;
+            p = free_begin;
+            std::align(align, size, p, space);
+        }
+        free_begin = static_cast<char*>(p) + size;
+        return p;
+    }
+
+public:
+
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Destroys all objects constructed in the arena and frees its memory.
+     */
+    ~Arena() {
+        for (UInt i = destructors.size(); i-- > 0; ) {
+            destructors[i].second(destructors[i].first);
+        }
+    }
+
+    /**
+     * Constructs a T in the arena with the given constructor arguments.
+     */
+    template <class T, class... Args>
+    T *make(Args&&... args) {
+        std::lock_guard<std::mutex> lock(mutex);
+        void *p = allocate(sizeof(T), alignof(T));
+        T *object = new (p) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            destructors.emplace_back(object, &destroy<T>);
+        }
+        return object;
+    }
+
+};
+
+} // namespace utils
+} // namespace ql
@@ -109,9 +109,9 @@ void make_dirs(const Str &path) {
 /**
  * Tries to create a file (if it doesn't already exist) and opens it for
  * writing. If the directory that path is contained by does not exists, it is
- * first created.
+ * first created. Binary files are written without newline translation.
  */
-OutFile::OutFile(const Str &path) : ofs(), path(path) {
+OutFile::OutFile(const Str &path, bool binary) : ofs(), path(path) {
 
     // If the parent path does not exist yet, recursively try to create a
     // directory for it.
@@ -121,7 +121,7 @@ OutFile::OutFile(const Str &path) : ofs(), path(path) {
     }
 
     // Open the file.
-    ofs.open(path);
+    ofs.open(path, binary ? std::ios::out | std::ios::binary : std::ios::out);
     check();
 
 }
@@ -161,10 +161,11 @@ std::ofstream &OutFile::unwrap() {
 }
 
 /**
- * Tries to open a file for reading.
+ * Tries to open a file for reading. Binary files are read without newline
+ * translation.
  */
-InFile::InFile(const Str &path) : ifs(), path(path) {
-    ifs.open(path);
+InFile::InFile(const Str &path, bool binary) : ifs(), path(path) {
+    ifs.open(path, binary ? std::ios::in | std::ios::binary : std::ios::in);
     check();
 }
 
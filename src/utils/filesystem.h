@@ -32,7 +32,7 @@ private:
     std::ofstream ofs;
     Str path;
 public:
-    OutFile(const Str &path);
+    OutFile(const Str &path, bool binary = false);
     void write(const Str &content);
     void close();
     void check();
@@ -58,7 +58,7 @@ private:
     std::ifstream ifs;
     Str path;
 public:
-    InFile(const Str &path);
+    InFile(const Str &path, bool binary = false);
     Str read();
     void close();
     void check();
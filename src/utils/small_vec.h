@@ -0,0 +1,468 @@
+/** \file
+ * Provides a vector that stores a few elements inline, for the operands of
+ * gates.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include "utils/num.h"
+#include "utils/str.h"
+#include "utils/vec.h"
+#include "utils/exception.h"
+
+namespace ql {
+namespace utils {
+
+/**
+ * Vector of trivially copyable values that stores up to N of them in the
+ * object itself, and only allocates memory on the heap when it grows beyond
+ * that. Gates have one or two qubit operands, and are made by the million, so
+ * this saves an allocation per gate and keeps the operands next to the rest of
+ * the gate.
+ *
+ * The interface is the subset of Vec's that is used on operands. Like Vec's,
+ * operator[] is range-checked; it basically functions like at(). A SmallVec is
+ * made implicitly from a Vec, but converting it back with to_vec() is
+ * explicit, since that allocates.
+ */
+template <class T, UInt N>
+class SmallVec {
+private:
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVec can only hold trivially copyable values");
+    static_assert(N > 0, "SmallVec must have room for at least one value");
+
+    /**
+     * Number of values.
+     */
+    std::uint32_t count = 0;
+
+    /**
+     * Number of values there is room for; N while they are stored inline.
+     */
+    std::uint32_t cap = N;
+
+    /**
+     * The values when they are stored inline, or the heap memory they are
+     * stored in otherwise.
+     */
+    union {
+        T local[N];
+        T *heap;
+    };
+
+    /**
+     * Makes room for at least n values, moving them to the heap.
+     */
+    void grow(UInt n) {
+        UInt new_cap = 2 * (UInt)cap;
+        if (new_cap < n) {
+            new_cap = n;
+        }
+        if (new_cap > UINT32_MAX) {
+            throw ContainerException("SmallVec cannot hold " + std::to_string(n) + " values");
+        }
+        T *p = static_cast<T*>(::operator new(new_cap * sizeof(T)));
+        if (count) {
+            std::memcpy(p, data(), count * sizeof(T));
+        }
+        release();
+        heap = p;
+        cap = (std::uint32_t)new_cap;
+    }
+
+    /**
+     * Frees the heap memory, if any.
+     */
+    void release() {
+        if (cap > N) {
+            ::operator delete(heap);
+        }
+    }
+
+public:
+
+    // Member types expected by the standard library.
+    using value_type = T;
+    using size_type = UInt;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /**
+     * Constructs an empty vector.
+     */
+    SmallVec() {}
+
+    /**
+     * Constructs the vector with count value-initialized values.
+     */
+    explicit SmallVec(size_type count) {
+        resize(count);
+    }
+
+    /**
+     * Constructs the vector with count copies of value.
+     */
+    SmallVec(size_type count, const T &value) {
+        resize(count, value);
+    }
+
+    /**
+     * Constructs the vector with the contents of the range [first, last).
+     */
+    template <
+        typename InputIt,
+        typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type
+    >
+    SmallVec(InputIt first, InputIt last) {
+        assign(first, last);
+    }
+
+    /**
+     * Constructs the vector with the contents of the initializer list.
+     */
+    SmallVec(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+    }
+
+    /**
+     * Constructs the vector with the contents of the given Vec.
+     */
+    SmallVec(const Vec<T> &other) {
+        assign(other.begin(), other.end());
+    }
+
+    /**
+     * Copy constructor.
+     */
+    SmallVec(const SmallVec &other) {
+        assign(other.begin(), other.end());
+    }
+
+    /**
+     * Move constructor; takes over the heap memory of other, if any, and
+     * leaves other empty.
+     */
+    SmallVec(SmallVec &&other) noexcept {
+        take(other);
+    }
+
+    /**
+     * Destructor.
+     */
+    ~SmallVec() {
+        release();
+    }
+
+    /**
+     * Copy assignment.
+     */
+    SmallVec &operator=(const SmallVec &other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    /**
+     * Move assignment; takes over the heap memory of other, if any, and
+     * leaves other empty.
+     */
+    SmallVec &operator=(SmallVec &&other) noexcept {
+        if (this != &other) {
+            release();
+            cap = N;
+            take(other);
+        }
+        return *this;
+    }
+
+    /**
+     * Assigns the contents of the given Vec.
+     */
+    SmallVec &operator=(const Vec<T> &other) {
+        assign(other.begin(), other.end());
+        return *this;
+    }
+
+    /**
+     * Assigns the contents of the initializer list.
+     */
+    SmallVec &operator=(std::initializer_list<T> init) {
+        assign(init.begin(), init.end());
+        return *this;
+    }
+
+    /**
+     * Replaces the contents with those of the range [first, last).
+     */
+    template <
+        typename InputIt,
+        typename = typename std::enable_if<!std::is_integral<InputIt>::value>::type
+    >
+    void assign(InputIt first, InputIt last) {
+        count = 0;
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    /**
+     * Returns the contents as a Vec.
+     */
+    Vec<T> to_vec() const {
+        return Vec<T>(begin(), end());
+    }
+
+    T *data() {
+        return cap > N ? heap : local;
+    }
+
+    const T *data() const {
+        return cap > N ? heap : local;
+    }
+
+    size_type size() const {
+        return count;
+    }
+
+    Bool empty() const {
+        return count == 0;
+    }
+
+    size_type capacity() const {
+        return cap;
+    }
+
+    void reserve(size_type n) {
+        if (n > cap) {
+            grow(n);
+        }
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    void resize(size_type n, T value = T()) {
+        reserve(n);
+        T *p = data();
+        for (UInt i = count; i < n; i++) {
+            p[i] = value;
+        }
+        count = (std::uint32_t)n;
+    }
+
+    void push_back(const T &value) {
+        if (count == cap) {
+            T copy = value;     // value may refer to an element
+            grow(count + 1);
+            data()[count++] = copy;
+        } else {
+            data()[count++] = value;
+        }
+    }
+
+    template <class... Args>
+    void emplace_back(Args&&... args) {
+        push_back(T(std::forward<Args>(args)...));
+    }
+
+    void pop_back() {
+        if (count == 0) {
+            throw ContainerException("pop_back() called on empty SmallVec");
+        }
+        count--;
+    }
+
+    /**
+     * Inserts value before pos, returning an iterator to it.
+     */
+    iterator insert(const_iterator pos, const T &value) {
+        UInt index = pos - begin();
+        if (index > count) {
+            throw ContainerException("insert position is out of range");
+        }
+        T copy = value;
+        reserve(count + 1);
+        T *p = data();
+        std::memmove(p + index + 1, p + index, (count - index) * sizeof(T));
+        p[index] = copy;
+        count++;
+        return p + index;
+    }
+
+    /**
+     * Erases the values in [first, last), returning an iterator to the value
+     * after them.
+     */
+    iterator erase(const_iterator first, const_iterator last) {
+        UInt from = first - begin();
+        UInt to = last - begin();
+        if (from > to || to > count) {
+            throw ContainerException("erase range is out of range");
+        }
+        T *p = data();
+        std::memmove(p + from, p + to, (count - to) * sizeof(T));
+        count -= (std::uint32_t)(to - from);
+        return p + from;
+    }
+
+    /**
+     * Erases the value at pos, returning an iterator to the value after it.
+     */
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    /**
+     * Returns a reference to the value at the given index, with bounds
+     * checking. If index is not within the range of the container, an
+     * exception of type ContainerException is thrown.
+     */
+    reference at(size_type index) {
+        check(index);
+        return data()[index];
+    }
+
+    /**
+     * Returns a const reference to the value at the given index, with bounds
+     * checking. If index is not within the range of the container, an
+     * exception of type ContainerException is thrown.
+     */
+    const_reference at(size_type index) const {
+        check(index);
+        return data()[index];
+    }
+
+    reference operator[](size_type index) {
+        return at(index);
+    }
+
+    const_reference operator[](size_type index) const {
+        return at(index);
+    }
+
+    reference front() {
+        return at(0);
+    }
+
+    const_reference front() const {
+        return at(0);
+    }
+
+    reference back() {
+        return at(count - 1);
+    }
+
+    const_reference back() const {
+        return at(count - 1);
+    }
+
+    iterator begin() { return data(); }
+    const_iterator begin() const { return data(); }
+    const_iterator cbegin() const { return data(); }
+    iterator end() { return data() + count; }
+    const_iterator end() const { return data() + count; }
+    const_iterator cend() const { return data() + count; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    /**
+     * Returns a string representation of the entire contents of the vector,
+     * in the same layout as Vec::to_string().
+     */
+    Str to_string(
+        const Str &prefix = "[",
+        const Str &separator = ", ",
+        const Str &suffix = "]"
+    ) const {
+        std::ostringstream ss;
+        ss << prefix;
+        for (UInt i = 0; i < count; i++) {
+            if (i) {
+                ss << separator;
+            }
+            ss << data()[i];
+        }
+        ss << suffix;
+        return ss.str();
+    }
+
+    friend Bool operator==(const SmallVec &lhs, const SmallVec &rhs) {
+        return lhs.count == rhs.count && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    friend Bool operator!=(const SmallVec &lhs, const SmallVec &rhs) {
+        return !(lhs == rhs);
+    }
+
+    friend Bool operator<(const SmallVec &lhs, const SmallVec &rhs) {
+        return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+    friend Bool operator==(const SmallVec &lhs, const Vec<T> &rhs) {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    friend Bool operator!=(const SmallVec &lhs, const Vec<T> &rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+
+    void check(size_type index) const {
+        if (index >= count) {
+            throw ContainerException(
+                "index " + std::to_string(index) + " is out of range, "
+                "size is " + std::to_string(count)
+            );
+        }
+    }
+
+    /**
+     * Takes the contents of other, leaving it empty; this must be empty and
+     * without heap memory.
+     */
+    void take(SmallVec &other) {
+        count = other.count;
+        if (other.cap > N) {
+            heap = other.heap;
+            cap = other.cap;
+            other.cap = N;
+        } else {
+            std::memcpy(local, other.local, count * sizeof(T));
+        }
+        other.count = 0;
+    }
+
+};
+
+/**
+ * Stream << overload for SmallVec<>.
+ */
+template <class T, UInt N>
+std::ostream &operator<<(std::ostream &os, const SmallVec<T, N> &vec) {
+    os << vec.to_string();
+    return os;
+}
+
+} // namespace utils
+} // namespace ql
@@ -0,0 +1,316 @@
+/** \file
+ * Provides a simple work-stealing thread pool for data-parallel loops.
+ */
+
+#include "utils/thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace ql {
+namespace utils {
+
+namespace {
+
+/**
+ * A single for_each() call that is in flight.
+ */
+struct Group {
+
+    /**
+     * The loop body.
+     */
+    const std::function<void(UInt)> *fn;
+
+    /**
+     * Number of iterations that have not completed yet, protected by mutex.
+     */
+    UInt remaining;
+
+    /**
+     * Exceptions thrown by the iterations, indexed by iteration.
+     */
+    Vec<std::exception_ptr> exceptions;
+
+    /**
+     * Used to wake up the owner of the group when the last iteration
+     * completes.
+     */
+    std::mutex mutex;
+    std::condition_variable done;
+
+};
+
+/**
+ * A single iteration of a for_each() call.
+ */
+struct Task {
+    Group *group;
+    UInt index;
+};
+
+/**
+ * A mutex-protected task deque.
+ */
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+} // anonymous namespace
+
+/**
+ * Pool state shared between the pool object and its workers.
+ */
+struct ThreadPool::State {
+
+    /**
+     * Task deques. Deque i < workers.size() belongs to worker i; the last
+     * deque is the injection deque used by threads outside the pool.
+     */
+    Vec<std::unique_ptr<TaskQueue>> queues;
+
+    /**
+     * The worker threads.
+     */
+    Vec<std::thread> workers;
+
+    /**
+     * Number of tasks currently sitting in any of the deques, used to let
+     * idle workers sleep.
+     */
+    std::atomic<UInt> queued{0};
+
+    /**
+     * Set when the pool is being destroyed.
+     */
+    std::atomic<bool> stop{false};
+
+    /**
+     * Used to let idle workers sleep until work arrives.
+     */
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+
+    /**
+     * The pool the current thread is a worker of, if any, and its worker
+     * index.
+     */
+    static thread_local const State *current_pool;
+    static thread_local UInt current_worker;
+
+    /**
+     * Returns the index of the deque owned by the calling thread.
+     */
+    UInt own_queue() const;
+
+    /**
+     * Pushes the given tasks onto the deque of the calling thread and wakes
+     * up idle workers.
+     */
+    void push(const Vec<Task> &tasks);
+
+    /**
+     * Tries to take a task, first from the back of the own deque, then from
+     * the front of the others. Returns whether a task was found.
+     */
+    bool take(Task &task);
+
+    /**
+     * Executes the given task.
+     */
+    static void run(const Task &task);
+
+    /**
+     * Main loop of worker thread i.
+     */
+    void work(UInt i);
+
+};
+
+thread_local const ThreadPool::State *ThreadPool::State::current_pool = nullptr;
+thread_local UInt ThreadPool::State::current_worker = 0;
+
+UInt ThreadPool::State::own_queue() const {
+    if (current_pool == this) {
+        return current_worker;
+    }
+    return queues.size() - 1;
+}
+
+void ThreadPool::State::push(const Vec<Task> &tasks) {
+    // The counter is raised before the tasks become visible, such that it
+    // never drops below the actual number of queued tasks.
+    {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        queued += tasks.size();
+    }
+    auto &queue = *queues[own_queue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (const auto &task : tasks) {
+            queue.tasks.push_back(task);
+        }
+    }
+    idle.notify_all();
+}
+
+bool ThreadPool::State::take(Task &task) {
+    if (queued == 0) {
+        return false;
+    }
+    UInt own = own_queue();
+    {
+        auto &queue = *queues[own];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    for (UInt offset = 1; offset < queues.size(); offset++) {
+        auto &queue = *queues[(own + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::State::run(const Task &task) {
+    auto &group = *task.group;
+    try {
+        (*group.fn)(task.index);
+    } catch (...) {
+        group.exceptions[task.index] = std::current_exception();
+    }
+    // The counter is decremented under the lock, such that the owner, which
+    // checks it under the same lock, cannot destroy the group before this
+    // thread is done with it.
+    std::lock_guard<std::mutex> lock(group.mutex);
+    if (--group.remaining == 0) {
+        group.done.notify_all();
+    }
+}
+
+void ThreadPool::State::work(UInt i) {
+    current_pool = this;
+    current_worker = i;
+    Task task;
+    while (!stop) {
+        if (take(task)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        idle.wait(lock, [this]{ return stop || queued > 0; });
+    }
+}
+
+/**
+ * Constructs a pool that executes loops with the given total number of
+ * threads, including the thread calling for_each().
+ */
+ThreadPool::ThreadPool(UInt num_threads) : state(std::make_shared<State>()) {
+    UInt num_workers = num_threads > 1 ? num_threads - 1 : 0;
+    for (UInt i = 0; i <= num_workers; i++) {
+        state->queues.emplace_back(new TaskQueue());
+    }
+    auto s = state;
+    for (UInt i = 0; i < num_workers; i++) {
+        state->workers.emplace_back([s, i]{ s->work(i); });
+    }
+}
+
+/**
+ * Stops and joins all worker threads.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(state->idle_mutex);
+        state->stop = true;
+    }
+    state->idle.notify_all();
+    for (auto &worker : state->workers) {
+        worker.join();
+    }
+}
+
+/**
+ * Returns the total number of threads that loops are executed with, including
+ * the calling thread.
+ */
+UInt ThreadPool::size() const {
+    return state->workers.size() + 1;
+}
+
+/**
+ * Calls fn(i) for all i in [0, count), distributing the calls over the threads
+ * of the pool, and returns when all calls have completed.
+ */
+void ThreadPool::for_each(UInt count, const std::function<void(UInt)> &fn) {
+    if (state->workers.empty() || count <= 1) {
+        for (UInt i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    Group group;
+    group.fn = &fn;
+    group.remaining = count;
+    group.exceptions.resize(count);
+
+    // Push in reverse, such that the calling thread (which pops from the back)
+    // starts with the first iteration, while thieves take the last ones.
+    Vec<Task> tasks;
+    for (UInt i = count; i > 0; i--) {
+        tasks.push_back({&group, i - 1});
+    }
+    state->push(tasks);
+
+    // Help executing pending tasks until all iterations of this loop are
+    // done. This may also run tasks of other loops, which is what makes
+    // nesting safe.
+    Task task;
+    while (true) {
+        if (state->take(task)) {
+            State::run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(group.mutex);
+        if (group.remaining == 0) {
+            break;
+        }
+        group.done.wait_for(lock, std::chrono::microseconds(100));
+    }
+
+    for (const auto &e : group.exceptions) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+/**
+ * Returns the number of hardware threads available on this machine, or 1 when
+ * this cannot be determined.
+ */
+UInt ThreadPool::hardware_threads() {
+    UInt n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+} // namespace utils
+} // namespace ql
@@ -0,0 +1,88 @@
+/** \file
+ * Provides a simple work-stealing thread pool for data-parallel loops.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include "utils/num.h"
+#include "utils/vec.h"
+
+namespace ql {
+namespace utils {
+
+/**
+ * Work-stealing thread pool. The pool only exposes a data-parallel loop
+ * (for_each()) that blocks until all iterations have completed, so callers
+ * never deal with futures or task handles.
+ *
+ * Each worker thread has its own task deque; it pops from the back of its own
+ * deque (LIFO, keeping nested work local and cache-friendly) and steals from
+ * the front of the deques of the other threads (FIFO, taking the oldest and
+ * thus usually largest pieces of work). Threads that are not part of the pool
+ * push their work onto a shared injection deque. A thread that waits for its
+ * loop to complete keeps executing pending tasks in the meantime, so for_each()
+ * can be nested arbitrarily deep without deadlocking, even on a pool without
+ * any worker threads.
+ *
+ * Exceptions thrown by the loop body are captured per iteration. After all
+ * iterations have completed, the exception of the lowest iteration index is
+ * rethrown in the calling thread, such that behavior does not depend on the
+ * order in which iterations happened to be executed.
+ */
+class ThreadPool {
+private:
+
+    /**
+     * Opaque pool state, shared with the worker threads.
+     */
+    struct State;
+
+    /**
+     * The pool state. Kept in a shared_ptr such that worker threads can safely
+     * observe it up to the moment they are joined.
+     */
+    std::shared_ptr<State> state;
+
+public:
+
+    /**
+     * Constructs a pool that executes loops with the given total number of
+     * threads, including the thread calling for_each(). Thus, num_threads
+     * equal to 0 or 1 means no worker threads are created, and loops are
+     * executed sequentially in the calling thread.
+     */
+    explicit ThreadPool(UInt num_threads);
+
+    /**
+     * Stops and joins all worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Returns the total number of threads that loops are executed with,
+     * including the calling thread.
+     */
+    UInt size() const;
+
+    /**
+     * Calls fn(i) for all i in [0, count), distributing the calls over the
+     * threads of the pool, and returns when all calls have completed. fn may
+     * itself call for_each() on the same pool.
+     */
+    void for_each(UInt count, const std::function<void(UInt)> &fn);
+
+    /**
+     * Returns the number of hardware threads available on this machine, or 1
+     * when this cannot be determined.
+     */
+    static UInt hardware_threads();
+
+};
+
+} // namespace utils
+} // namespace ql
@@ -573,7 +573,7 @@ ImageOutput generateImage(const ql::quantum_program* program, const VisualizerCo
     }
 
     // Parse and validate the layout and instruction configuration file.
-    CircuitLayout layout = parseCircuitConfiguration(gates, configuration.visualizerConfigPath, program->platform.instruction_settings);
+    CircuitLayout layout = parseCircuitConfiguration(gates, configuration.visualizerConfigPath, *program->platform.instruction_settings);
     validateCircuitLayout(layout, configuration.visualizationType);
 
     // Calculate circuit properties.
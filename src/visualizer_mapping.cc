@@ -27,7 +27,7 @@ void visualizeMappingGraph(const quantum_program* program, const VisualizerConfi
 
     // Parse the topology if it exists in the platform configuration file.
     Topology topology;
-    const Bool parsedTopology = layout.getUseTopology() ? parseTopology(program->platform.topology, topology) : false;
+    const Bool parsedTopology = layout.getUseTopology() ? parseTopology(*program->platform.topology, topology) : false;
     if (parsedTopology) {
         QL_DOUT("Succesfully parsed topology.");
         QL_DOUT("xSize: " << topology.xSize);
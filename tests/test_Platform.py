@@ -27,5 +27,25 @@ class Test_platform(unittest.TestCase):
         platf = ql.Platform(platf_name, config_fn)
         self.assertEqual(platf.config_file, config_fn)
 
+    def test_platform_cache(self):
+        # a platform is reused while its configuration file is unchanged,
+        # and loaded again when it changes
+        config_fn = os.path.join(curdir, 'hardware_config_cc_light.json')
+        copy_fn = os.path.join(output_dir, 'test_platform_cache.json')
+        with open(config_fn) as f:
+            config = f.read()
+
+        with open(copy_fn, 'w') as f:
+            f.write(config)
+        platf = ql.Platform('starmon_platform', copy_fn)
+        self.assertEqual(platf.get_qubit_number(), 7)
+        platf = ql.Platform('starmon_platform', copy_fn)
+        self.assertEqual(platf.get_qubit_number(), 7)
+
+        with open(copy_fn, 'w') as f:
+            f.write(config.replace('"qubit_number": 7', '"qubit_number": 5', 1))
+        platf = ql.Platform('starmon_platform', copy_fn)
+        self.assertEqual(platf.get_qubit_number(), 5)
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,196 @@
+import os
+from utils import file_compare
+import unittest
+from openql import openql as ql
+
+curdir = os.path.dirname(os.path.realpath(__file__))
+output_dir = os.path.join(curdir, 'test_output')
+
+
+class Test_binary_ir(unittest.TestCase):
+
+    def setUp(self):
+        ql.initialize()
+        ql.set_option('output_dir', output_dir)
+        ql.set_option('log_level', 'LOG_WARNING')
+        ql.set_option('mapper', 'minextendrc')
+        ql.set_option('maptiebreak', 'first')
+
+    def build(self, name, platform, num_qubits):
+        p = ql.Program(name, platform, num_qubits, num_qubits)
+
+        k = ql.Kernel('init', platform, num_qubits, num_qubits)
+        for q in range(num_qubits):
+            k.prepz(q)
+        k.gate('x', [0])
+        k.gate('y', [2])
+        k.gate('cnot', [2, 6])
+        k.gate('cz', [1, 4])
+        k.gate('cnot', [0, 5])
+        p.add_kernel(k)
+
+        k = ql.Kernel('body', platform, num_qubits, num_qubits)
+        k.gate('rx90', [3])
+        k.gate('cnot', [3, 0])
+        k.gate('cz', [2, 5])
+        for q in range(num_qubits):
+            k.measure(q)
+        p.add_for(k, 3)
+        return p
+
+    # resuming a compilation from the checkpoint written after scheduling
+    # must give the same QISA as compiling without interruption
+    def test_resume_after_schedule(self):
+        config_fn = os.path.join(curdir, 'test_mapper_s7.json')
+        platform = ql.Platform('starmon', config_fn)
+        num_qubits = 7
+
+        pre = ['CCLPrepCodeGeneration', 'CCLDecomposePreSchedule', 'Map', 'RCSchedule']
+        post = ['LatencyAndBufferDelays', 'CCLDecomposePostSchedule', 'QisaCodeGeneration']
+
+        c = ql.Compiler('uninterruptedCompiler')
+        for name in pre + post:
+            c.add_pass(name)
+        p = self.build('test_binary_ir_uninterrupted', platform, num_qubits)
+        c.compile(p)
+
+        bir_fn = os.path.join(output_dir, 'test_binary_ir_checkpoint.bir')
+        c = ql.Compiler('checkpointCompiler')
+        for name in pre:
+            c.add_pass(name)
+        c.add_pass('BinaryWriter')
+        c.set_pass_option('BinaryWriter', 'binary_ir_file', bir_fn)
+        p = self.build('test_binary_ir_resumed', platform, num_qubits)
+        c.compile(p)
+
+        c = ql.Compiler('resumeCompiler')
+        c.add_pass('BinaryReader')
+        c.set_pass_option('BinaryReader', 'binary_ir_file', bir_fn)
+        for name in post:
+            c.add_pass(name)
+        p = ql.Program('test_binary_ir_resumed', platform, num_qubits, num_qubits)
+        c.compile(p)
+
+        self.assertTrue(file_compare(
+            os.path.join(output_dir, 'test_binary_ir_uninterrupted.qisa'),
+            os.path.join(output_dir, 'test_binary_ir_resumed.qisa')))
+
+    def test_program_round_trip(self):
+        config_fn = os.path.join(curdir, 'test_mapper_s7.json')
+        platform = ql.Platform('starmon', config_fn)
+        num_qubits = 7
+
+        p = self.build('test_binary_ir_round_trip', platform, num_qubits)
+        bir_fn = os.path.join(output_dir, p.name + '.bir')
+        p.write_binary_ir(bir_fn)
+
+        q = ql.Program('test_binary_ir_round_trip_read', platform, num_qubits, num_qubits)
+        q.read_binary_ir(bir_fn)
+
+        for prog in [p, q]:
+            c = ql.Compiler('writerCompiler')
+            c.add_pass_alias('Writer', 'lastqasmwriter')
+            c.compile(prog)
+        self.assertTrue(file_compare(
+            os.path.join(output_dir, p.name + '_last.qasm'),
+            os.path.join(output_dir, q.name + '_last.qasm')))
+
+        # a file written for another platform is rejected
+        config_fn = os.path.join(curdir, 'hardware_config_cc_light.json')
+        other = ql.Platform('seven_qubits_chip', config_fn)
+        r = ql.Program('test_binary_ir_other_platform', other, num_qubits, num_qubits)
+        with self.assertRaises(Exception):
+            r.read_binary_ir(bir_fn)
+
+    # corrupt files are rejected with an error instead of being read into
+    # kernels with out-of-range operands, or crashing on absurd counts
+    def test_corrupt_file(self):
+        config_fn = os.path.join(curdir, 'test_mapper_s7.json')
+        platform = ql.Platform('starmon', config_fn)
+        num_qubits = 7
+
+        p = self.build('test_binary_ir_corrupt', platform, num_qubits)
+        bir_fn = os.path.join(output_dir, p.name + '.bir')
+        p.write_binary_ir(bir_fn)
+        with open(bir_fn, 'rb') as f:
+            data = f.read()
+
+        def get_uint(pos):
+            value = 0
+            shift = 0
+            while True:
+                byte = data[pos]
+                pos += 1
+                value |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    return value, pos
+
+        def uint_bytes(value):
+            out = bytearray()
+            while value >= 0x80:
+                out.append((value & 0x7F) | 0x80)
+                value >>= 7
+            out.append(value)
+            return bytes(out)
+
+        def with_uint(pos, value):
+            _, end = get_uint(pos)
+            return data[:pos] + uint_bytes(value) + data[end:]
+
+        def skip(pos, n=1):
+            for _ in range(n):
+                _, pos = get_uint(pos)
+            return pos
+
+        # find the positions of the fields to corrupt, following the layout
+        # described in binary_ir.cc
+        nstrings, pos = get_uint(12)
+        for _ in range(nstrings):
+            size, pos = get_uint(pos)
+            pos += size
+        pos = skip(pos, 4)                      # platform name, qubits, cycle time; program name
+        program_qubits_pos = pos
+        pos = skip(pos, 3)                      # program qubit/creg/breg counts
+        sweep_points_pos = pos
+        nsweep_points, pos = get_uint(pos)
+        pos += 8 * nsweep_points
+        pos = skip(pos, 1)                      # number of kernels
+        pos = skip(pos, 7)                      # name, iterations, counts, type, cycles_valid
+        has_condition, pos = get_uint(pos)
+        self.assertEqual(has_condition, 0)
+        pos = skip(pos, 1)                      # gate condition
+        ncond_operands, pos = get_uint(pos)
+        pos = skip(pos, ncond_operands)
+        ngates_pos = pos
+        pos = skip(pos, 3)                      # number of gates; tag and name of the first gate
+        noperands, pos = get_uint(pos)
+        self.assertEqual(noperands, 1)
+        operand_pos = pos
+
+        corrupt_fn = os.path.join(output_dir, 'test_binary_ir_corrupt_modified.bir')
+        cases = [
+            ('truncated', data[:len(data) // 2], 'truncated or corrupt'),
+            ('version', data[:8] + bytes([7, 0, 0, 0]) + data[12:], 'format version 7'),
+            ('sweep point count', with_uint(sweep_points_pos, 1 << 40), 'truncated or corrupt'),
+            ('gate count', with_uint(ngates_pos, 1 << 40), 'truncated or corrupt'),
+            ('program qubits', with_uint(program_qubits_pos, num_qubits + 1), 'truncated or corrupt'),
+            ('operand', with_uint(operand_pos, num_qubits), 'truncated or corrupt'),
+        ]
+        for what, contents, message in cases:
+            with self.subTest(what):
+                with open(corrupt_fn, 'wb') as f:
+                    f.write(contents)
+                q = ql.Program('test_binary_ir_corrupt_read', platform, num_qubits, num_qubits)
+                with self.assertRaisesRegex(RuntimeError, message):
+                    q.read_binary_ir(corrupt_fn)
+
+        # the unmodified file still reads
+        with open(corrupt_fn, 'wb') as f:
+            f.write(data)
+        q = ql.Program('test_binary_ir_corrupt_read', platform, num_qubits, num_qubits)
+        q.read_binary_ir(corrupt_fn)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,4 +1,5 @@
 import os
+import re
 import unittest
 from openql import openql as ql
 from utils import file_compare
@@ -169,6 +170,48 @@ class Test_basic(unittest.TestCase):
 
         self.assertTrue( file_compare(QISA_fn, GOLD_fn) )
 
+    # more single qubit masks than there are S registers; registers must be
+    # reloaded in-line, and hold their initial masks again at kernel boundaries
+    def test_smis_register_reuse(self):
+        config_fn = os.path.join(curdir, 'hardware_config_cc_light.json')
+        platform = ql.Platform('seven_qubits_chip', config_fn)
+        num_qubits = platform.get_qubit_number()
+        p = ql.Program('test_smis_register_reuse', platform, num_qubits)
+
+        subsets = [[q for q in range(7) if s & (1 << q)] for s in range(1, 128)]
+        for kernel_name in ['aKernel', 'bKernel']:
+            k = ql.Kernel(kernel_name, platform, num_qubits)
+            for subset in subsets:
+                for q in subset:
+                    k.gate('x', [q])
+                k.wait(list(range(7)), 0)
+            p.add_kernel(k)
+
+        p.compile()
+
+        QISA_fn = os.path.join(output_dir, p.name+'.qisa')
+        registers = {}
+        initial = None
+        masks = []
+        with open(QISA_fn) as f:
+            for line in f:
+                line = line.strip()
+                m = re.match(r'smis (s\d+), \{(.*)\}', line)
+                if m:
+                    registers[m.group(1)] = [int(q) for q in m.group(2).split(',')]
+                    continue
+                if line.endswith(':'):
+                    if initial is None:
+                        initial = dict(registers)
+                    self.assertEqual(registers, initial)
+                    continue
+                m = re.match(r'\d+\s+x (s\d+)$', line)
+                if m:
+                    masks.append(registers[m.group(1)])
+
+        self.assertEqual(len(initial), 32)
+        self.assertEqual(masks, subsets + subsets)
+
 
     # two qubit mask generation test
     def test_smit(self):
@@ -646,6 +689,41 @@ class Test_advance(unittest.TestCase):
 
             self.assertTrue(file_compare(QISA_fn, GOLD_fn))
 
+    # the fused pass must give the same schedule as latency compensation followed by buffer insertion
+    def test_ccl_latencies_buffers_fused(self):
+        ql.set_option('output_dir', output_dir)
+        config_fn = os.path.join(curdir, 'test_cfg_cc_light_buffers_latencies.json')
+        platform  = ql.Platform('seven_qubits_chip', config_fn)
+        num_qubits = 7
+
+        qasm_fns = []
+        for fused in [False, True]:
+            c = ql.Compiler('postScheduleCompiler')
+            c.add_pass('RCSchedule')
+            if fused:
+                c.add_pass('LatencyAndBufferDelays')
+            else:
+                c.add_pass('LatencyCompensation')
+                c.add_pass('InsertBufferDelays')
+            c.add_pass_alias('Writer', 'lastqasmwriter')
+
+            k = ql.Kernel('aKernel', platform, num_qubits)
+            for q in [0, 3, 4, 5]:
+                k.gate('x', [q])
+                k.gate('y', [q])
+            k.gate('cz', [0, 2])
+            k.gate('x', [2])
+            k.gate('measure', [0])
+            k.gate('y', [5])
+            k.gate('measure', [4])
+
+            p = ql.Program('test_ccl_latencies_buffers_fused' + str(fused), platform, num_qubits)
+            p.add_kernel(k)
+            c.compile(p)
+            qasm_fns.append(os.path.join(output_dir, p.name + '_last.qasm'))
+
+        self.assertTrue(file_compare(qasm_fns[0], qasm_fns[1]))
+
 #     def test_single_qubit_flux_manual01(self):
 #         ql.set_option('output_dir', output_dir)
 #         ql.set_option('cz_mode', 'manual')
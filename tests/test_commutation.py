@@ -1,4 +1,5 @@
 import os
+import re
 from utils import file_compare
 import unittest
 from openql import openql as ql
@@ -777,5 +778,99 @@ class Test_commutation(unittest.TestCase):
 #        qasm_fn = os.path.join(output_dir, p.name+'_scheduled.qasm')
 #        self.assertTrue( file_compare(qasm_fn, gold_fn) )
 
+    # the bounded search of variations must find the same variation as enumerating all of them
+    def test_cnot_variations_bounded(self):
+        config_fn = os.path.join(curdir, conffile)
+        platf = ql.Platform("starmon", config_fn)
+        ql.set_option("scheduler", 'ALAP');
+
+        c = ql.Compiler("commuteCompiler")
+        c.add_pass("CommuteVariation")
+        c.add_pass_alias("Writer", "lastqasmwriter")
+
+        nqubits = 7
+        qasm_fns = []
+        for vary in ['yes', 'bounded']:
+            ql.set_option("scheduler_commute", 'yes');
+            ql.set_option("vary_commutations", vary);
+            ql.set_option("vary_commutations_threads", '4');
+
+            k = ql.Kernel("aKernel", platf, nqubits)
+            for j in range(7):
+                k.gate("x", [j])
+            k.gate("cnot", [0,2]);
+            k.gate("cnot", [0,3]);
+            k.gate("cnot", [1,3]);
+            k.gate("cnot", [1,4]);
+            k.gate("cnot", [2,0]);
+            k.gate("cnot", [2,5]);
+            for j in range(7):
+                k.gate("x", [j])
+
+            p = ql.Program("test_cnot_variations_" + vary, platf, nqubits)
+            p.add_kernel(k)
+            c.compile(p)
+            qasm_fns.append(os.path.join(output_dir, p.name + '_last.qasm'))
+
+        self.assertTrue( file_compare(qasm_fns[0], qasm_fns[1]) )
+
+    # with more variations than fit in a variation number, the bounded search must still apply
+    # the variation that it scheduled with the best depth
+    def test_cnot_variations_bounded_large(self):
+        config_fn = os.path.join(curdir, conffile)
+        platf = ql.Platform("starmon", config_fn)
+        ql.set_option("scheduler", 'ALAP');
+        ql.set_option("scheduler_commute", 'yes');
+        ql.set_option("vary_commutations", 'bounded');
+        ql.set_option("vary_commutations_threads", '4');
+        ql.set_option("vary_commutations_max_variations", '200');
+        ql.set_option("write_report_files", 'yes');
+
+        c = ql.Compiler("commuteCompiler")
+        c.add_pass("CommuteVariation")
+
+        nqubits = 7
+        k = ql.Kernel("aKernel", platf, nqubits)
+        for j in range(7):
+            k.gate("x", [j])
+        targets = [0, 1, 5, 6]
+        for i in range(24):
+            k.gate("cnot", [3, targets[i % 4]])
+        for j in [0, 1, 5, 6]:
+            k.gate("x", [j])
+
+        p = ql.Program("test_cnot_variations_bounded_large", platf, nqubits)
+        p.add_kernel(k)
+        c.compile(p)
+
+        report_fn = os.path.join(output_dir, p.name + '_CommuteVariation_out.report')
+        with open(report_fn) as f:
+            report = f.read()
+        latency = re.search(r'----- circuit_latency: (\d+)', report).group(1)
+        best_depth = re.search(r'----- best depth: (\d+)', report).group(1)
+        self.assertEqual(latency, best_depth)
+
+    # options changed by passes during a compilation don't leak out of it
+    def test_cnot_variations_options_kept(self):
+        config_fn = os.path.join(curdir, conffile)
+        platf = ql.Platform("starmon", config_fn)
+        ql.set_option("scheduler_commute", 'yes');
+        ql.set_option("vary_commutations", 'yes');
+
+        c = ql.Compiler("commuteCompiler")
+        c.add_pass("CommuteVariation")
+
+        nqubits = 7
+        k = ql.Kernel("aKernel", platf, nqubits)
+        k.gate("cnot", [0,2]);
+        k.gate("cnot", [0,3]);
+        k.gate("cnot", [1,3]);
+
+        p = ql.Program("test_cnot_variations_options_kept", platf, nqubits)
+        p.add_kernel(k)
+        c.compile(p)
+
+        self.assertEqual(ql.get_option("scheduler_commute"), 'yes')
+
 if __name__ == '__main__':
     unittest.main()
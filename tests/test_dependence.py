@@ -219,6 +219,33 @@ class Test_dependence(unittest.TestCase):
         qasm_fn = os.path.join(output_dir, p.name+'_scheduled.qasm')
         self.assertTrue( file_compare(qasm_fn, gold_fn) )
 
+    # the dependence graph as arrays only must give the same schedule as the lemon graph
+    def test_swap_multi_depgraph_arrays(self):
+        ql.set_option('scheduler_depgraph', 'arrays')
+
+        nqubits = 5
+
+        # populate kernel
+        k = ql.Kernel("aKernel", platf, nqubits)
+
+        # swap test with 2 qubit gates
+        k.gate("x", [0])
+        k.gate("x", [1])
+        k.gate("swap", [0, 1])
+        k.gate("cz", [0, 2])
+        k.gate("cz", [1, 4])
+
+        sweep_points = [2]
+
+        p = ql.Program("swap_multi_arrays", platf, nqubits)
+        p.set_sweep_points(sweep_points)
+        p.add_kernel(k)
+        p.compile()
+
+        gold_fn = curdir + '/golden/test_swap_multi_ASAP.qasm'
+        qasm_fn = os.path.join(output_dir, p.name+'_scheduled.qasm')
+        self.assertTrue( file_compare(qasm_fn, gold_fn) )
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -682,6 +682,81 @@ class Test_mapper(unittest.TestCase):
         qasm_fn = os.path.join(output_dir, prog_name+'_last.qasm')
         self.assertTrue(file_compare(qasm_fn, gold_fn))
 
+    # mapping the kernels of a program in parallel must give the same result as mapping them one after the other
+    def test_mapper_kernel_threads(self):
+        config = os.path.join(curdir, "test_mapper_s7.json")
+        num_qubits = 7
+        starmon = ql.Platform("starmon", config)
+
+        qasm_fns = []
+        for threads in ['1', '4']:
+            ql.set_option('kernel_threads', threads)
+            prog_name = "test_mapper_kernel_threads_" + threads
+            prog = ql.Program(prog_name, starmon, num_qubits, 0)
+            for n in range(8):
+                k = ql.Kernel("kernel_" + str(n), starmon, num_qubits, 0)
+                for i in range(20):
+                    a = (3*i + n) % num_qubits
+                    b = (5*i + n + 1) % num_qubits
+                    if a == b:
+                        b = (b + 1) % num_qubits
+                    k.gate("x", [a])
+                    k.gate("cnot", [a,b])
+                prog.add_kernel(k)
+            prog.compile()
+            qasm_fns.append(os.path.join(output_dir, prog_name+'_last.qasm'))
+
+        self.assertTrue(file_compare(qasm_fns[0], qasm_fns[1]))
+
+    # the mappers of the kernels of a program share the paths they enumerate;
+    # mapping a kernel with the paths cached by the other kernels must give the same result as mapping it alone
+    def test_mapper_path_cache(self):
+        config = os.path.join(curdir, "test_mapper_s17.json")
+        num_qubits = 17
+        starmon = ql.Platform("starmon", config)
+
+        def add_kernel(prog, n):
+            k = ql.Kernel("kernel_" + str(n), starmon, num_qubits, 0)
+            for i in range(20):
+                a = (3*i + n) % num_qubits
+                b = (5*i + 2*n + 1) % num_qubits
+                if a == b:
+                    b = (b + 1) % num_qubits
+                k.gate("x", [a])
+                k.gate("cnot", [a,b])
+            prog.add_kernel(k)
+
+        # the mapped circuit of the kernel with the given name in the given qasm file
+        def kernel_lines(qasm_fn, kernel_name):
+            lines = []
+            in_kernel = False
+            with open(qasm_fn) as f:
+                for line in f:
+                    line = line.rstrip()
+                    if line.startswith('.'):
+                        in_kernel = line == '.' + kernel_name
+                    elif in_kernel and line:
+                        lines.append(line)
+            return lines
+
+        nkernels = 8
+        prog_name = "test_mapper_path_cache"
+        prog = ql.Program(prog_name, starmon, num_qubits, 0)
+        for n in range(nkernels):
+            add_kernel(prog, n)
+        prog.compile()
+        qasm_fn = os.path.join(output_dir, prog_name+'_last.qasm')
+
+        for n in range(nkernels):
+            alone_name = prog_name + "_" + str(n)
+            alone = ql.Program(alone_name, starmon, num_qubits, 0)
+            add_kernel(alone, n)
+            alone.compile()
+            alone_fn = os.path.join(output_dir, alone_name+'_last.qasm')
+            kernel_name = "kernel_" + str(n)
+            self.assertNotEqual(kernel_lines(qasm_fn, kernel_name), [])
+            self.assertEqual(kernel_lines(qasm_fn, kernel_name), kernel_lines(alone_fn, kernel_name))
+
 
 
 if __name__ == '__main__':
@@ -0,0 +1,145 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+
+#include <openql.h>
+
+// names of the gates in circuit c, separated by spaces
+std::string
+names(const ql::circuit &c)
+{
+    std::string s;
+    for (auto gp : c) {
+        s += (s.empty() ? "" : " ") + gp->qasm();
+    }
+    return s;
+}
+
+void
+check(const std::string &what, const ql::circuit &c, const std::string &expected)
+{
+    std::string got = names(ql::rotation_fuse(c));
+    if (got != expected) {
+        throw std::runtime_error(what + ": expected '" + expected + "' but got '" + got + "'");
+    }
+}
+
+// small circuits of which the result of the rotation fuser is known
+void
+test_rotation_fuse()
+{
+    ql::quantum_platform platform("none", "test_cfg_none_simple.json");
+
+    {
+        ql::quantum_kernel k("interleaved", platform, 2, 0);
+        k.x(0); k.h(1); k.x(0);
+        check("interleaved", k.c, "h q[1]");
+    }
+    {
+        ql::quantum_kernel k("nested", platform, 2, 0);
+        k.h(0); k.x(0); k.x(0); k.h(0);
+        check("nested", k.c, "");
+    }
+    {
+        ql::quantum_kernel k("angles", platform, 2, 0);
+        k.rx(0, 0.3); k.rx(0, -0.3); k.ry(1, 1.0);
+        check("angles", k.c, "ry q[1], 1");
+    }
+    {
+        ql::quantum_kernel k("phase", platform, 2, 0);
+        k.x(0); k.y(0); k.x(0); k.y(0);
+        check("phase", k.c, "");
+    }
+    {
+        ql::quantum_kernel k("not_identity", platform, 2, 0);
+        k.s(0); k.s(0);
+        check("not_identity", k.c, "s q[0] s q[0]");
+    }
+    {
+        ql::quantum_kernel k("two_qubit", platform, 2, 0);
+        k.x(0); k.cnot(0, 1); k.x(0);
+        check("two_qubit", k.c, "x q[0] cnot q[0],q[1] x q[0]");
+    }
+    {
+        ql::quantum_kernel k("measure", platform, 2, 0);
+        k.x(1); k.measure(1); k.x(1); k.x(0); k.x(0);
+        check("measure", k.c, "x q[1] measure q[1] x q[1]");
+    }
+}
+
+// random circuit of n gates on nq qubits: mostly single-qubit gates, some cnots,
+// and every so often an inverse pair to be cancelled
+void
+random_circuit(ql::quantum_kernel &k, size_t n, size_t nq, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<> q(0, nq-1);
+    std::uniform_int_distribution<> op(0, 9);
+    while (k.c.size() < n) {
+        int o = op(gen);
+        int a = q(gen);
+        if (o < 2) {
+            int b = q(gen); while (b == a) b = q(gen);
+            k.cnot(a, b);
+        } else if (o < 4) {
+            k.x(a); k.x(a);
+        } else if (o < 5) {
+            k.t(a); k.tdag(a);
+        } else if (o < 6) {
+            k.h(a);
+        } else if (o < 7) {
+            k.s(a);
+        } else if (o < 8) {
+            k.y(a);
+        } else {
+            k.rz(a, 0.1*o);
+        }
+    }
+}
+
+// compare the time taken by the per-qubit rotation fuser and the sliding window one;
+// the latter is cubic in the number of gates, so it is only run on small kernels;
+// not part of the test, run with --bench
+void
+bench_rotation_fuse()
+{
+    ql::quantum_platform platform("none", "test_cfg_none_simple.json");
+    size_t nq = 17;
+
+    for (size_t n : {100, 200, 400, 1000, 10000, 100000}) {
+        ql::quantum_kernel k("bench", platform, nq, 0);
+        random_circuit(k, n, nq, n);
+
+        auto t0 = std::chrono::steady_clock::now();
+        ql::circuit fused = ql::rotation_fuse(k.c);
+        auto t1 = std::chrono::steady_clock::now();
+        std::cout << "gates=" << k.c.size()
+                  << " fuse: " << fused.size() << " gates in "
+                  << std::chrono::duration<double>(t1 - t0).count() << " s";
+
+        if (n <= 400) {
+            auto t2 = std::chrono::steady_clock::now();
+            ql::circuit merged = ql::rotation_merge_sliding_window(k.c);
+            auto t3 = std::chrono::steady_clock::now();
+            std::cout << "; sliding window: " << merged.size() << " gates in "
+                      << std::chrono::duration<double>(t3 - t2).count() << " s";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    ql::utils::logger::set_log_level("LOG_NOTHING");
+    ql::options::set("use_default_gates", "yes");
+
+    test_rotation_fuse();
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench_rotation_fuse();
+    }
+
+    return 0;
+}
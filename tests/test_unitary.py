@@ -30,6 +30,27 @@ def helper_regex(measurementstring):
 def helper_prob(qubitstate):
     return qubitstate.real**2+qubitstate.imag**2
 
+def helper_circuit_matrix(qasm, num_qubits):
+    # matrix of the rz, ry and cnot gates in qasm, in order, with qubit 0 as
+    # the least significant bit of the state index
+    d = 2**num_qubits
+    m = np.eye(d, dtype=complex)
+    for name, q0, q1, angle in re.findall(r'(rz|ry|cnot) q\[(\d+)\](?:,q\[(\d+)\]|, ([-0-9.e]+))', qasm):
+        q0 = int(q0)
+        if name == 'cnot':
+            g = np.zeros((d, d))
+            for x in range(d):
+                g[x ^ (1 << int(q1)) if (x >> q0) & 1 else x, x] = 1
+        else:
+            t = float(angle)
+            if name == 'rz':
+                g1 = np.diag([np.exp(-0.5j*t), np.exp(0.5j*t)])
+            else:
+                g1 = np.array([[np.cos(t/2), -np.sin(t/2)], [np.sin(t/2), np.cos(t/2)]])
+            g = np.kron(np.kron(np.eye(2**(num_qubits-1-q0)), g1), np.eye(2**q0))
+        m = g.dot(m)
+    return m
+
 @unittest.skipUnless(ql.Unitary.is_decompose_support_enabled(), "unitary decomposition support was disabled during OpenQL build")
 class Test_conjugated_kernel(unittest.TestCase):
 
@@ -1465,6 +1486,57 @@ class Test_conjugated_kernel(unittest.TestCase):
         self.assertAlmostEqual(0.0625*helper_prob((matrix[224] + matrix[225]+ matrix[226]+ matrix[227]+ matrix[228]+ matrix[229]+ matrix[230]+ matrix[231]+ matrix[232] + matrix[233]+ matrix[234]+ matrix[235]+ matrix[236]+ matrix[237]+ matrix[238]+ matrix[239])), helper_regex(c0)[14], 2)
         self.assertAlmostEqual(0.0625*helper_prob((matrix[240] + matrix[241]+ matrix[242]+ matrix[243]+ matrix[244]+ matrix[245]+ matrix[246]+ matrix[247]+ matrix[248] + matrix[249]+ matrix[250]+ matrix[251]+ matrix[252]+ matrix[253]+ matrix[254]+ matrix[255])), helper_regex(c0)[15], 2)
   
+    def test_unitary_decompose_cached_parallel(self):
+        # decomposing in parallel or taking the decomposition from the cache
+        # must give exactly the same program as decomposing it sequentially;
+        # only unitaries of 5 or more qubits are decomposed in parallel
+        num_qubits = 5
+        rng = np.random.RandomState(42)
+        q, r = np.linalg.qr(rng.randn(32, 32) + 1j*rng.randn(32, 32))
+        matrix = q.flatten()
+
+        def compile_qasm():
+            p = ql.Program('test_unitary_cached_parallel', platform, num_qubits)
+            k = ql.Kernel('akernel', platform, num_qubits)
+            u = ql.Unitary('u', matrix)
+            u.decompose()
+            k.gate(u, [0, 1, 2, 3, 4])
+            p.add_kernel(k)
+            p.compile()
+            with open(os.path.join(output_dir, p.name+'.qasm')) as f:
+                return f.read()
+
+        ql.set_option('unitary_decomposition_cache', 'no')
+        ql.set_option('unitary_decomposition_threads', '1')
+        sequential = compile_qasm()
+
+        ql.set_option('unitary_decomposition_cache', 'yes')
+        ql.set_option('unitary_decomposition_threads', '4')
+        self.assertEqual(sequential, compile_qasm())
+        self.assertEqual(sequential, compile_qasm())
+
+    def test_unitary_decompose_fixed_size(self):
+        # 1-, 2- and 3-qubit unitaries are decomposed with fixed-size
+        # matrices; the circuit must implement the unitary up to global phase
+        rng = np.random.RandomState(7)
+        for num_qubits in [1, 2, 3]:
+            d = 2**num_qubits
+            q, r = np.linalg.qr(rng.randn(d, d) + 1j*rng.randn(d, d))
+            matrix = q.flatten()
+
+            p = ql.Program('test_unitary_fixed_size_' + str(num_qubits), platform, num_qubits)
+            k = ql.Kernel('akernel', platform, num_qubits)
+            u = ql.Unitary('u', matrix)
+            u.decompose()
+            k.gate(u, list(range(num_qubits)))
+            p.add_kernel(k)
+            p.compile()
+            with open(os.path.join(output_dir, p.name+'.qasm')) as f:
+                circuit = helper_circuit_matrix(f.read(), num_qubits)
+
+            fidelity = abs(np.trace(q.conj().T.dot(circuit)))/d
+            self.assertAlmostEqual(fidelity, 1.0, 4)
+
 if __name__ == '__main__':
     unittest.main()
 